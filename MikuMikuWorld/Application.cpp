@@ -1,11 +1,19 @@
 ﻿#include "Application.h"
 #include "ApplicationConfiguration.h"
 #include "Colors.h"
+#include "GlyphCache.h"
 #include "IO.h"
+#include "ImGui/imgui_internal.h"
+#include "JobSystem.h"
 #include "Localization.h"
+#include "Profiler.h"
+#include "Rendering/ImageLoader.h"
 #include "ResourceManager.h"
+#include "TaskGraph.h"
 #include "Utilities.h"
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
 #include <json.hpp>
 #include <stdexcept>
 #include <thread>
@@ -15,6 +23,7 @@ namespace MikuMikuWorld
 	std::string Application::version;
 	std::string Application::appDir;
 	std::string Application::pendingLoadScoreFile;
+	std::string Application::startupTimings;
 	WindowState Application::windowState;
 
 	NoteTextures noteTextures{ -1, -1, -1, -1, -1 };
@@ -50,10 +59,19 @@ namespace MikuMikuWorld
 		imgui->setBaseTheme(config.baseTheme);
 		imgui->applyAccentColor(config.accentColor);
 
-		loadResources();
+		JobSystem::initialize();
+		JobSystem::setMainThreadWakeup(glfwPostEmptyEvent);
 
-		editor = std::make_unique<ScoreEditor>();
-		editor->loadPresets(appDir + "library");
+		TaskGraph graph;
+		loadResources(graph);
+		graph.run();
+
+		startupTimings = graph.formatTimings();
+		if (config.startupLogEnabled)
+		{
+			std::ofstream timingsFile(IO::mbToWideStr(appDir + "startup.log"));
+			timingsFile << startupTimings;
+		}
 
 		initialized = true;
 		return Result::Ok();
@@ -106,6 +124,7 @@ namespace MikuMikuWorld
 		if (initialized)
 		{
 			editor->uninitialize();
+			JobSystem::shutdown();
 			imgui->shutdown();
 			glfwDestroyWindow(window);
 			glfwTerminate();
@@ -173,20 +192,8 @@ namespace MikuMikuWorld
 		windowState.dragDropHandled = true;
 	}
 
-	void Application::update()
+	static float getPrimaryMonitorDpiScale()
 	{
-		if (config.language != language)
-		{
-			std::string locale =
-			    config.language == "auto" ? Utilities::getSystemLocale() : config.language;
-
-			// Try to set the selected language and fallback to default (en) on failure
-			if (!Localization::setLanguage(locale))
-				Localization::setLanguage("en");
-
-			language = config.language;
-		}
-
 		float dpiX = 1.0f, dpiY = 1.0f;
 		GLFWmonitor* mainMonitor = glfwGetPrimaryMonitor();
 		if (mainMonitor)
@@ -194,8 +201,36 @@ namespace MikuMikuWorld
 			glfwGetMonitorContentScale(mainMonitor, &dpiX, &dpiY);
 		}
 
-		float dpiScale = (dpiX + dpiY) * 0.5f;
-		if (dpiScale != windowState.lastDpiScale)
+		return (dpiX + dpiY) * 0.5f;
+	}
+
+	static std::string getLocale(const std::string& language)
+	{
+		return language == "auto" ? Utilities::getSystemLocale() : language;
+	}
+
+	void Application::updateLanguage()
+	{
+		if (config.language == language)
+			return;
+
+		std::string locale = getLocale(config.language);
+
+		// Try to set the selected language and fallback to default (en) on failure
+		if (!Localization::setLanguage(locale))
+			Localization::setLanguage("en");
+
+		language = config.language;
+	}
+
+	void Application::update()
+	{
+		Profiler::beginFrame();
+		updateLanguage();
+
+		// Rebuilding the atlas only rasterizes the glyphs requested so far, so this stays cheap
+		float dpiScale = getPrimaryMonitorDpiScale();
+		if (dpiScale != windowState.lastDpiScale || GlyphCache::isDirty())
 		{
 			imgui->buildFonts(dpiScale);
 			windowState.lastDpiScale = dpiScale;
@@ -203,8 +238,17 @@ namespace MikuMikuWorld
 
 		imgui->begin();
 
+		// Results of background jobs may open dialogs, so keep drawing until those settle
+		if (JobSystem::drainMainThread())
+			windowState.pendingFrames = idleRedrawFrames;
+
+		// Time spent blocked waiting for events is not frame time. Without this, playback started
+		// right after an idle period would run ahead of the music
+		if (windowState.resumingFromIdle)
+			ImGui::GetIO().DeltaTime = std::min(ImGui::GetIO().DeltaTime, 1.0f / 60.0f);
+
 		// Inform ImGui of dpi changes
-		ImGui::GetMainViewport()->DpiScale = dpiX;
+		ImGui::GetMainViewport()->DpiScale = dpiScale;
 		UI::updateBtnSizesDpiScaling(dpiScale);
 
 		if (!windowState.dragDropHandled)
@@ -304,53 +348,171 @@ namespace MikuMikuWorld
 
 		editor->update();
 
+		// Text drawn this frame asked for glyphs the atlas does not have yet, draw it again with
+		// them after the next rebuild
+		if (GlyphCache::isDirty())
+			windowState.pendingFrames = std::max(windowState.pendingFrames, 2);
+
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		imgui->draw(window);
-		glfwSwapBuffers(window);
+		{
+			PROFILE_SCOPE("glfwSwapBuffers");
+			glfwSwapBuffers(window);
+		}
+
+		Profiler::endFrame();
 	}
 
-	void Application::loadResources()
+	void Application::loadResources(TaskGraph& graph)
 	{
-		ResourceManager::loadShader(appDir + "res\\shaders\\basic2d");
+		using TaskID = TaskGraph::TaskID;
+		struct TextureFile
+		{
+			std::string filename;
+			TextureFilterMode minFilter = TextureFilterMode::Linear;
+			TextureFilterMode magFilter = TextureFilterMode::Linear;
+			ImageData image;
+		};
+
+		const TaskID shaders =
+		    graph.add("Compile shaders", TaskThread::Main,
+		              [this] { ResourceManager::loadShader(appDir + "res\\shaders\\basic2d"); });
+
 		const std::string texturesDir = appDir + "res\\textures\\";
-		ResourceManager::loadTexture(texturesDir + "notes1.png",
-		                             TextureFilterMode::LinearMipMapLinear,
-		                             TextureFilterMode::Linear);
-		ResourceManager::loadTexture(texturesDir + "notes2.png");
-		ResourceManager::loadTexture(texturesDir + "longNoteLine.png");
-		ResourceManager::loadTexture(texturesDir + "touchLine_eff.png");
-		ResourceManager::loadTexture(texturesDir + "guideColors.png");
-
-		ResourceManager::loadTexture(texturesDir + "timeline_select.png");
-		ResourceManager::loadTexture(texturesDir + "timeline_tap.png");
-		ResourceManager::loadTexture(texturesDir + "timeline_hold.png");
-		ResourceManager::loadTexture(texturesDir + "timeline_hold_step_normal.png");
-		ResourceManager::loadTexture(texturesDir + "timeline_hold_step_hidden.png");
-		ResourceManager::loadTexture(texturesDir + "timeline_hold_step_skip.png");
-		ResourceManager::loadTexture(texturesDir + "timeline_flick_default.png");
-		ResourceManager::loadTexture(texturesDir + "timeline_flick_left.png");
-		ResourceManager::loadTexture(texturesDir + "timeline_flick_right.png");
-		ResourceManager::loadTexture(texturesDir + "timeline_critical.png");
-		ResourceManager::loadTexture(texturesDir + "timeline_trace.png");
+		std::vector<std::string> textureNames{ "notes2.png",
+			                                   "longNoteLine.png",
+			                                   "touchLine_eff.png",
+			                                   "guideColors.png",
+			                                   "timeline_select.png",
+			                                   "timeline_tap.png",
+			                                   "timeline_hold.png",
+			                                   "timeline_hold_step_normal.png",
+			                                   "timeline_hold_step_hidden.png",
+			                                   "timeline_hold_step_skip.png",
+			                                   "timeline_flick_default.png",
+			                                   "timeline_flick_left.png",
+			                                   "timeline_flick_right.png",
+			                                   "timeline_critical.png",
+			                                   "timeline_trace.png" };
 		for (auto color : guideColors)
 			for (auto fade : fadeTypes)
-				ResourceManager::loadTexture(
-				    appDir + IO::formatString("res\\textures\\timeline_guide_%s_%s.png", color,
-				                              std::string(fade).substr(5).c_str()));
-		ResourceManager::loadTexture(texturesDir + "timeline_damage.png");
-		ResourceManager::loadTexture(texturesDir + "timeline_bpm.png");
-		ResourceManager::loadTexture(texturesDir + "timeline_time_signature.png");
-		ResourceManager::loadTexture(texturesDir + "timeline_hi_speed.png");
-		// Cache note textures indices
-		noteTextures.notes = ResourceManager::getTexture(NOTES_TEX);
-		noteTextures.holdPath = ResourceManager::getTexture(HOLD_PATH_TEX);
-		noteTextures.touchLine = ResourceManager::getTexture(TOUCH_LINE_TEX);
-		noteTextures.ccNotes = ResourceManager::getTexture(CC_NOTES_TEX);
-		noteTextures.guideColors = ResourceManager::getTexture(GUIDE_COLORS_TEX);
-
-		Localization::loadLanguages(appDir + "res\\i18n");
+				textureNames.push_back(IO::formatString("timeline_guide_%s_%s.png", color,
+				                                        std::string(fade).substr(5).c_str()));
+		textureNames.insert(textureNames.end(),
+		                    { "timeline_damage.png", "timeline_bpm.png",
+		                      "timeline_time_signature.png", "timeline_hi_speed.png" });
+
+		// A deque keeps each file in place while the tasks hold on to it
+		auto textureFiles = std::make_shared<std::deque<TextureFile>>();
+		textureFiles->push_back({ texturesDir + "notes1.png", TextureFilterMode::LinearMipMapLinear,
+		                          TextureFilterMode::Linear });
+		for (const auto& textureName : textureNames)
+			textureFiles->push_back({ texturesDir + textureName });
+
+		// Decode on the workers, then upload one after another so the texture indices keep the
+		// order of the list above
+		std::vector<TaskID> uploads;
+		for (TextureFile& file : *textureFiles)
+		{
+			const std::string name = IO::File::getFilename(file.filename);
+			const TaskID decode =
+			    graph.add("Decode " + name, TaskThread::Worker,
+			              [&file, textureFiles] { file.image = decodeImage(file.filename); });
+
+			std::vector<TaskID> dependencies{ decode };
+			if (!uploads.empty())
+				dependencies.push_back(uploads.back());
+
+			uploads.push_back(graph.add(
+			    "Upload " + name, TaskThread::Main,
+			    [&file, textureFiles]
+			    {
+				    ResourceManager::addTexture(file.filename, file.image, file.minFilter,
+				                                file.magFilter);
+				    file.image = {};
+			    },
+			    dependencies));
+		}
+
+		const TaskID textures = graph.add(
+		    "Cache note textures", TaskThread::Main,
+		    []
+		    {
+			    noteTextures.notes = ResourceManager::getTexture(NOTES_TEX);
+			    noteTextures.holdPath = ResourceManager::getTexture(HOLD_PATH_TEX);
+			    noteTextures.touchLine = ResourceManager::getTexture(TOUCH_LINE_TEX);
+			    noteTextures.ccNotes = ResourceManager::getTexture(CC_NOTES_TEX);
+			    noteTextures.guideColors = ResourceManager::getTexture(GUIDE_COLORS_TEX);
+		    },
+		    uploads);
+
+		// Only english and the selected language are read now, the others when they are selected.
+		// Parsing runs on the workers but interning the keys is main thread only
+		auto languageFiles = Localization::findLanguageFiles(appDir + "res\\i18n");
+		Localization::registerLanguageFiles(languageFiles);
+
+		const std::string locale = getLocale(config.language);
+		languageFiles.erase(std::remove_if(languageFiles.begin(), languageFiles.end(),
+		                                   [&locale](const auto& file)
+		                                   { return file.first != "en" && file.first != locale; }),
+		                    languageFiles.end());
+		auto languageEntries = std::make_shared<std::vector<LanguageEntries>>(languageFiles.size());
+		std::vector<TaskID> languageReads;
+		for (size_t i = 0; i < languageFiles.size(); ++i)
+		{
+			languageReads.push_back(graph.add(
+			    "Read language " + languageFiles[i].first, TaskThread::Worker,
+			    [languageEntries, i, filename = languageFiles[i].second]
+			    { (*languageEntries)[i] = Language::readEntries(filename); }));
+		}
+
+		const TaskID languages = graph.add(
+		    "Register languages", TaskThread::Main,
+		    [languageFiles, languageEntries]
+		    {
+			    for (size_t i = 0; i < languageFiles.size(); ++i)
+			    {
+				    Localization::add(std::make_unique<Language>(languageFiles[i].first.c_str(),
+				                                                 (*languageEntries)[i]));
+			    }
+		    },
+		    languageReads);
+
+		// The atlas starts with the glyphs of the selected language, anything else is rasterized
+		// when it is first requested
+		const TaskID glyphs = graph.add("Select language", TaskThread::Main,
+		                                [this]
+		                                {
+			                                updateLanguage();
+			                                imgui->updateGlyphRanges();
+		                                },
+		                                { languages });
+
+		// Nothing else touches ImGui until the graph has finished, so the atlas can be built on a
+		// worker. Only the texture upload needs the GL context.
+		const float dpiScale = getPrimaryMonitorDpiScale();
+		const TaskID fonts =
+		    graph.add("Rasterize fonts", TaskThread::Worker,
+		              [this, dpiScale] { imgui->rasterizeFonts(dpiScale); }, { glyphs });
+		graph.add(
+		    "Upload fonts", TaskThread::Main,
+		    [this, dpiScale]
+		    {
+			    imgui->uploadFonts();
+			    windowState.lastDpiScale = dpiScale;
+		    },
+		    { fonts });
+
+		// The editor decodes the sound effects across the workers itself
+		const TaskID editorCreated =
+		    graph.add("Create editor", TaskThread::Main,
+		              [this] { editor = std::make_unique<ScoreEditor>(); },
+		              { shaders, textures, languages });
+		// loadPresets reads and writes the preset files across the workers itself
+		graph.add("Load presets", TaskThread::Worker,
+		          [this] { editor->loadPresets(appDir + "library"); }, { editorCreated });
 	}
 
 	void Application::run()
@@ -368,16 +530,30 @@ namespace MikuMikuWorld
 		::SetWindowLongPtrW(hwnd, GWLP_WNDPROC, (LONG_PTR)wndProc);
 
 		windowState.windowHandle = hwnd;
-		windowState.windowTimerId =
-		    ::SetTimer(hwnd, reinterpret_cast<UINT_PTR>(&windowState.windowTimerId),
-		               USER_TIMER_MINIMUM, nullptr);
+		windowState.windowTimerId = reinterpret_cast<UINT_PTR>(&windowState.windowTimerId);
+		windowState.pendingFrames = idleRedrawFrames;
 
 		::DragAcceptFiles(hwnd, TRUE);
+		Profiler::setThreadName("Main");
 
 		while (!glfwWindowShouldClose(window))
 		{
-			glfwPollEvents();
+			// Block until the next event when nothing on screen changes by itself. Messages of the
+			// main window reset pendingFrames in wndProc, input of detached viewports is only seen
+			// in the ImGui event queue
+			const bool wasIdle = windowState.pendingFrames == 0 && !editor->isAnimating();
+			if (wasIdle)
+				glfwWaitEventsTimeout(idleWaitTimeout);
+			else
+				glfwPollEvents();
+
+			if (ImGui::GetCurrentContext()->InputEventsQueue.Size > 0)
+				windowState.pendingFrames = idleRedrawFrames;
+
+			windowState.resumingFromIdle = wasIdle;
+			windowState.idleFrame = wasIdle && windowState.pendingFrames == 0;
 			update();
+			windowState.pendingFrames = std::max(windowState.pendingFrames - 1, 0);
 		}
 
 		editor->savePresets(appDir + "library");
@@ -18,6 +18,7 @@ LRESULT CALLBACK wndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 namespace MikuMikuWorld
 {
 	class Result;
+	class TaskGraph;
 
 	struct WindowState
 	{
@@ -29,6 +30,9 @@ namespace MikuMikuWorld
 		bool shouldPickScore = false;
 		bool dragDropHandled = true;
 		bool windowDragging = false;
+		bool resumingFromIdle = false;
+		bool idleFrame = false;
+		int pendingFrames = 0;
 		float lastDpiScale = 0.0f;
 		void* windowHandle;
 		Vector2 position{};
@@ -58,8 +62,19 @@ namespace MikuMikuWorld
 
 	  public:
 		static WindowState windowState;
+
+		/// Frames drawn after the last window event before the application goes idle. ImGui needs
+		/// a few frames to settle layout and hover state after input.
+		static constexpr int idleRedrawFrames = 3;
+
+		/// Longest time to block for events while idle, keeping tooltips, text cursors and auto
+		/// save ticking
+		static constexpr double idleWaitTimeout = 0.25;
 		static std::string pendingLoadScoreFile;
 
+		/// Time each startup task took, shown in the debug window
+		static std::string startupTimings;
+
 		Application();
 
 		Result initialize(const std::string& root);
@@ -68,8 +83,9 @@ namespace MikuMikuWorld
 		void appendOpenFile(const std::string& filename);
 		void handlePendingOpenFiles();
 		void readSettings();
+		void updateLanguage();
 		void writeSettings();
-		void loadResources();
+		void loadResources(TaskGraph& graph);
 		void dispose();
 
 		GLFWwindow* getGlfwWindow() { return window; }
@@ -31,6 +31,7 @@ namespace MikuMikuWorld
 		version = jsonIO::tryGetValue<std::string>(config, "version", "1.0");
 		language = jsonIO::tryGetValue<std::string>(config, "language", "auto");
 		debugEnabled = jsonIO::tryGetValue<bool>(config, "debug", false);
+		startupLogEnabled = jsonIO::tryGetValue<bool>(config, "startup_log", false);
 
 		if (jsonIO::keyExists(config, "file"))
 		{
@@ -72,6 +73,8 @@ namespace MikuMikuWorld
 			laneOpacity = jsonIO::tryGetValue<float>(config["timeline"], "lane_opacity", 0.0f);
 			backgroundBrightness =
 			    jsonIO::tryGetValue<float>(config["timeline"], "background_brightness", 0.5f);
+			backgroundBlur =
+			    jsonIO::tryGetValue<float>(config["timeline"], "background_blur", 0.0f);
 			drawBackground = jsonIO::tryGetValue<bool>(config["timeline"], "draw_background", true);
 			backgroundImage =
 			    jsonIO::tryGetValue<std::string>(config["timeline"], "background_image", "");
@@ -155,6 +158,7 @@ namespace MikuMikuWorld
 		config["version"] = CONFIG_VERSION;
 		config["language"] = language;
 		config["debug"] = debugEnabled;
+		config["startup_log"] = startupLogEnabled;
 		config["file"]["minify_usc"] = minifyUsc;
 		config["file"]["show_sus_export"] = showSusExport;
 		config["window"]["position"] = { { "x", windowPos.x }, { "y", windowPos.y } };
@@ -172,6 +176,7 @@ namespace MikuMikuWorld
 			                   { "zoom", zoom },
 			                   { "lane_opacity", laneOpacity },
 			                   { "background_brightness", backgroundBrightness },
+			                   { "background_blur", backgroundBlur },
 			                   { "draw_background", drawBackground },
 			                   { "background_image", backgroundImage },
 			                   { "smooth_scrolling_enable", useSmoothScrolling },
@@ -243,6 +248,7 @@ namespace MikuMikuWorld
 		zoom = 2.0f;
 		laneOpacity = 0.6f;
 		backgroundBrightness = 0.5f;
+		backgroundBlur = 0.0f;
 		drawBackground = true;
 		backgroundImage = "";
 		useSmoothScrolling = true;
@@ -265,5 +271,6 @@ namespace MikuMikuWorld
 		seVolume = 1.0f;
 
 		debugEnabled = false;
+		startupLogEnabled = false;
 	}
 }
@@ -104,6 +104,7 @@ namespace MikuMikuWorld
 		bool matchNotesSizeToTimeline;
 		float laneOpacity;
 		float backgroundBrightness;
+		float backgroundBlur;
 		bool drawBackground;
 		std::string backgroundImage;
 		bool useSmoothScrolling;
@@ -124,6 +125,9 @@ namespace MikuMikuWorld
 		int seProfileIndex;
 		bool debugEnabled;
 
+		/// Writes the startup task timings to startup.log next to the configuration file
+		bool startupLogEnabled;
+
 		InputConfiguration input;
 
 		std::vector<std::string> recentFiles;
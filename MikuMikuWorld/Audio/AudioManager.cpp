@@ -1,5 +1,7 @@
 #include "../Application.h"
 #include "../IO.h"
+#include "../JobSystem.h"
+#include "../MemoryTracker.h"
 #include "../UI.h"
 
 // We need to add the implementation defines BEFORE including miniaudio's header
@@ -8,7 +10,7 @@
 #define DR_WAV_IMPLEMENTATION
 #define DR_FLAC_IMPLEMENTATION
 #include "AudioManager.h"
-#include <execution>
+#include <algorithm>
 
 #undef STB_VORBIS_HEADER_ONLY
 
@@ -16,6 +18,22 @@ namespace Audio
 {
 	namespace mmw = MikuMikuWorld;
 
+	// The engine passes these on to its resource manager, so decoded sound effects count too
+	static void* engineMalloc(size_t size, void*)
+	{
+		return mmw::MemoryTracker::allocate(mmw::MemoryCategory::AudioEngine, size);
+	}
+
+	static void* engineRealloc(void* block, size_t size, void*)
+	{
+		return mmw::MemoryTracker::reallocate(mmw::MemoryCategory::AudioEngine, block, size);
+	}
+
+	static void engineFree(void* block, void*)
+	{
+		mmw::MemoryTracker::deallocate(mmw::MemoryCategory::AudioEngine, block);
+	}
+
 	void AudioManager::initializeAudioEngine()
 	{
 		std::string err = "";
@@ -23,7 +41,10 @@ namespace Audio
 
 		try
 		{
-			result = ma_engine_init(nullptr, &engine);
+			ma_engine_config engineConfig = ma_engine_config_init();
+			engineConfig.allocationCallbacks = { nullptr, engineMalloc, engineRealloc, engineFree };
+
+			result = ma_engine_init(&engineConfig, &engine);
 			if (result != MA_SUCCESS)
 			{
 				err = "FATAL: Failed to start audio engine. Aborting.\n";
@@ -84,30 +105,31 @@ namespace Audio
 				sounds[index].pool.emplace(
 				    std::move(SoundPoolPair(mmw::SE_NAMES[i], std::make_unique<SoundPool>())));
 
-			std::for_each(std::execution::par, sounds[index].pool.begin(), sounds[index].pool.end(),
-			              [&](auto& s)
-			              {
-				              std::string filename = path + s.first.data() + ".mp3";
-				              size_t soundNameIndex = mmw::findArrayItem(
-				                  s.first.data(), mmw::SE_NAMES, mmw::arrayLength(mmw::SE_NAMES));
+			mmw::JobSystem::forEach(
+			    sounds[index].pool.begin(), sounds[index].pool.end(),
+			    [&](auto& s)
+			    {
+				    std::string filename = path + s.first.data() + ".mp3";
+				    size_t soundNameIndex = mmw::findArrayItem(s.first.data(), mmw::SE_NAMES,
+				                                               mmw::arrayLength(mmw::SE_NAMES));
 
-				              std::string name{};
-				              if (mmw::isArrayIndexInBounds(soundNameIndex, mmw::SE_NAMES))
-					              name = IO::formatString("%s_%02d", mmw::SE_NAMES[soundNameIndex],
-					                                      index + 1);
+				    std::string name{};
+				    if (mmw::isArrayIndexInBounds(soundNameIndex, mmw::SE_NAMES))
+					    name = IO::formatString("%s_%02d", mmw::SE_NAMES[soundNameIndex],
+					                            index + 1);
 
-				              s.second->initialize(name, filename, &engine, &soundEffectsGroup,
-				                                   soundEffectsFlags[soundNameIndex]);
-				              s.second->setVolume(soundEffectsVolumes[soundNameIndex]);
+				    s.second->initialize(name, filename, &engine, &soundEffectsGroup,
+				                         soundEffectsFlags[soundNameIndex]);
+				    s.second->setVolume(soundEffectsVolumes[soundNameIndex]);
 
-				              SoundInstance& debugSound =
-				                  debugSounds[soundNameIndex + (index * soundEffectsCount)];
-				              debugSound.name = name;
+				    SoundInstance& debugSound =
+				        debugSounds[soundNameIndex + (index * soundEffectsCount)];
+				    debugSound.name = name;
 
-				              ma_sound_init_from_file_w(&engine, IO::mbToWideStr(filename).c_str(),
-				                                        maSoundFlagsDecodeAsync, &soundEffectsGroup,
-				                                        nullptr, &debugSound.source);
-			              });
+				    ma_sound_init_from_file_w(&engine, IO::mbToWideStr(filename).c_str(),
+				                              maSoundFlagsDecodeAsync, &soundEffectsGroup, nullptr,
+				                              &debugSound.source);
+			    });
 
 			// Adjust hold SE loop times for gapless playback
 			ma_uint64 holdNrmDuration = sounds[index].pool[mmw::SE_CONNECT]->getDurationInFrames();
@@ -132,12 +154,14 @@ namespace Audio
 		ma_engine_uninit(&engine);
 	}
 
-	mmw::Result AudioManager::loadMusic(const std::string& filename)
+	void AudioManager::loadMusic(DecodedAudio& audio)
 	{
 		disposeMusic();
-		mmw::Result result = decodeAudioFile(filename, musicBuffer);
-		if (result.isOk())
+		if (audio.samples)
 		{
+			musicBuffer.initialize(audio.name, audio.sampleRate, audio.channelCount,
+			                       audio.frameCount, audio.samples.release());
+
 			// We want to always enable pitch here for miniaudio's resampler to work with playback
 			// speed
 			ma_sound_init_from_data_source(&engine, &musicBuffer.buffer,
@@ -146,8 +170,6 @@ namespace Audio
 			// Sync
 			setPlaybackSpeed(playbackSpeed, 0);
 		}
-
-		return result;
 	}
 
 	void AudioManager::playMusic(float currentTime)
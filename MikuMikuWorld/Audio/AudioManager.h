@@ -45,7 +45,9 @@ namespace Audio
 		float getAudioEngineAbsoluteTime() const;
 
 		void loadSoundEffects();
-		MikuMikuWorld::Result loadMusic(const std::string& filename);
+		/// Replaces the music with samples from decodeAudioFile. Without samples the music is only
+		/// disposed.
+		void loadMusic(DecodedAudio& audio);
 
 		void setMasterVolume(float volume);
 		float getMasterVolume() const;
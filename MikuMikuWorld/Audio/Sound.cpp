@@ -1,6 +1,7 @@
 #include "../IO.h"
 #include "../File.h"
 #include "../Math.h"
+#include "../MemoryTracker.h"
 #include "../Stopwatch.h"
 
 #define MINIAUDIO_IMPLEMENTATION
@@ -14,6 +15,9 @@ namespace Audio
 	void SoundBuffer::initialize(const std::string& name, ma_uint32 sampleRate,
 	                             ma_uint32 channelCount, ma_uint64 frameCount, int16_t* samples)
 	{
+		if (this->samples)
+			mmw::MemoryTracker::remove(mmw::MemoryCategory::Music, getSampleBytes());
+
 		this->name = name;
 		this->sampleFormat = ma_format_s16;
 		this->channelCount = channelCount;
@@ -21,6 +25,7 @@ namespace Audio
 		this->sampleRate = sampleRate;
 		this->samples = std::unique_ptr<int16_t[]>(samples);
 		this->effectiveSampleRate = sampleRate;
+		mmw::MemoryTracker::add(mmw::MemoryCategory::Music, getSampleBytes());
 
 		ma_audio_buffer_config bufferConfig = ma_audio_buffer_config_init(
 		    this->sampleFormat, channelCount, frameCount, this->samples.get(), nullptr);
@@ -30,6 +35,9 @@ namespace Audio
 
 	void SoundBuffer::dispose()
 	{
+		if (samples)
+			mmw::MemoryTracker::remove(mmw::MemoryCategory::Music, getSampleBytes());
+
 		name.clear();
 		ma_audio_buffer_uninit(&buffer);
 		samples.reset();
@@ -41,7 +49,17 @@ namespace Audio
 		effectiveSampleRate = 0;
 	}
 
-	mmw::Result decodeAudioFile(std::string filename, SoundBuffer& sound)
+	static void setDecodedAudio(DecodedAudio& audio, const std::string& name, ma_uint32 sampleRate,
+	                            ma_uint32 channelCount, ma_uint64 frameCount, int16_t* samples)
+	{
+		audio.name = name;
+		audio.sampleRate = sampleRate;
+		audio.channelCount = channelCount;
+		audio.frameCount = frameCount;
+		audio.samples.reset(samples);
+	}
+
+	mmw::Result decodeAudioFile(std::string filename, DecodedAudio& audio)
 	{
 		if (!IO::File::exists(filename))
 			return mmw::Result(mmw::ResultStatus::Error, "File not found");
@@ -69,8 +87,8 @@ namespace Audio
 			if (samples == nullptr)
 				return mmw::Result(mmw::ResultStatus::Error, "Failed to decode mp3");
 
-			sound.initialize(nameWithoutExtension, mp3Config.sampleRate, mp3Config.channels,
-			                 frameCount, samples);
+			setDecodedAudio(audio, nameWithoutExtension, mp3Config.sampleRate, mp3Config.channels,
+			                frameCount, samples);
 			return mmw::Result::Ok();
 		}
 		else if (fileExtension == ".wav")
@@ -83,7 +101,7 @@ namespace Audio
 			if (samples == nullptr)
 				return mmw::Result(mmw::ResultStatus::Error, "Failed to decode wav");
 
-			sound.initialize(nameWithoutExtension, sampleRate, channels, frameCount, samples);
+			setDecodedAudio(audio, nameWithoutExtension, sampleRate, channels, frameCount, samples);
 			return mmw::Result::Ok();
 		}
 		else if (fileExtension == ".flac")
@@ -96,7 +114,7 @@ namespace Audio
 			if (samples == nullptr)
 				return mmw::Result(mmw::ResultStatus::Error, "Failed to decode flac");
 
-			sound.initialize(nameWithoutExtension, sampleRate, channels, frameCount, samples);
+			setDecodedAudio(audio, nameWithoutExtension, sampleRate, channels, frameCount, samples);
 			return mmw::Result::Ok();
 		}
 		else if (fileExtension == ".ogg")
@@ -109,7 +127,7 @@ namespace Audio
 			if (samples == nullptr)
 				return mmw::Result(mmw::ResultStatus::Error, "Failed to decode ogg vorbis");
 
-			sound.initialize(nameWithoutExtension, sampleRate, channels, frameCount, samples);
+			setDecodedAudio(audio, nameWithoutExtension, sampleRate, channels, frameCount, samples);
 			return mmw::Result::Ok();
 		}
 
@@ -53,12 +53,25 @@ namespace Audio
 		{
 			return samples.get() != nullptr && sampleRate > 0 && frameCount > 0;
 		}
+
+		size_t getSampleBytes() const { return frameCount * channelCount * sizeof(int16_t); }
+	};
+
+	/// Samples of an audio file. Decoding does not touch the audio engine, so it can run on a
+	/// worker and the samples be handed to a SoundBuffer on the main thread.
+	struct DecodedAudio
+	{
+		std::string name;
+		ma_uint32 sampleRate{};
+		ma_uint32 channelCount{};
+		ma_uint64 frameCount{};
+		std::unique_ptr<int16_t[]> samples;
 	};
 
 	constexpr std::array<std::string_view, 4> supportedFileFormats = { ".mp3", ".wav", ".flac",
 		                                                               ".ogg" };
 
-	MikuMikuWorld::Result decodeAudioFile(std::string filename, SoundBuffer& sound);
+	MikuMikuWorld::Result decodeAudioFile(std::string filename, DecodedAudio& audio);
 	bool isSupportedFileFormat(const std::string_view& fileExtension);
 
 	struct SoundInstance
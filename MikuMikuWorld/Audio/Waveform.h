@@ -5,6 +5,7 @@
 
 #pragma once
 #include "../Math.h"
+#include "../MemoryTracker.h"
 #include "AudioManager.h"
 #include <stdint.h>
 #include <vector>
@@ -25,7 +26,9 @@ namespace Audio
 		size_t powerOfTwoSampleCount{};
 		double secondsPerSample{};
 		double samplesPerSecond{};
-		std::vector<int16_t> absoluteSamples;
+		std::vector<int16_t, MikuMikuWorld::TrackingAllocator<
+		                         int16_t, MikuMikuWorld::MemoryCategory::Waveform>>
+		    absoluteSamples;
 
 		double getDuration() const
 		{
@@ -96,12 +99,17 @@ namespace Audio
 		WaveformMip mips[maxMipLevels]{};
 		double durationInSeconds{};
 
+		/// Changes every time the samples are regenerated or cleared
+		uint32_t generation{};
+
 		bool isEmpty() const { return mips[0].powerOfTwoSampleCount == 0; }
 
 		void clear()
 		{
 			for (auto& mip : mips)
 				mip.clear();
+
+			++generation;
 		}
 
 		int getUsedMipCount() const
@@ -138,6 +146,7 @@ namespace Audio
 
 		void generateMipChainsFromSampleBuffer(const SoundBuffer& audioData, uint32_t channelIndex)
 		{
+			++generation;
 			if (!audioData.isValid())
 			{
 				durationInSeconds = 0;
@@ -1,32 +1,93 @@
 #include "Background.h"
 #include "Math.h"
+#include "Rendering/ImageBlur.h"
 #include "ResourceManager.h"
 #include "Rendering/Renderer.h"
 #include "Rendering/Framebuffer.h"
+#include <cmath>
 
 namespace MikuMikuWorld
 {
 	Background::Background()
-	    : blur{ 0.0f }, brightness{ 0.4f }, width{ 0 }, height{ 0 }, dirty{ false }
+	    : blur{ 0.0f }, brightness{ 0.4f }, width{ 0 }, height{ 0 }, dirty{ false },
+	      textureBlur{ 0.0f }, targetWidth{ 0 }, targetHeight{ 0 }, loadPending{ false }
 	{
 		framebuffer = std::make_unique<Framebuffer>(1, 1);
 	}
 
+	// Blur radius at full blur as a fraction of the longer side, so a blur looks the same whatever
+	// size the image was decoded at
+	constexpr float maxBlurRadius = 0.03f;
+
 	void Background::load(const std::string& filename)
 	{
 		this->filename = filename;
+		loader.cancel();
+		loadPending = false;
+
+		if (filename.empty() || !IO::File::exists(filename))
+		{
+			if (texture)
+			{
+				texture->dispose();
+				texture = nullptr;
+			}
+			image = {};
+			return;
+		}
+
+		loadPending = true;
+		startDecode();
+	}
+
+	void Background::startDecode()
+	{
+		// The target size is only known once the timeline has been laid out
+		if (targetWidth < 1 || targetHeight < 1)
+			return;
+
+		loader.load(filename, static_cast<int>(std::ceil(targetWidth)),
+		            static_cast<int>(std::ceil(targetHeight)));
+		loadPending = false;
+	}
+
+	void Background::update(Vector2 target)
+	{
+		targetWidth = target.x;
+		targetHeight = target.y;
+
+		// A downscaled image is decoded again once the timeline grows past it
+		const bool tooSmall = image.isValid() && image.width < image.sourceWidth &&
+		                      (image.width < targetWidth || image.height < targetHeight);
+		if (loadPending || (tooSmall && !loader.isLoading()))
+			startDecode();
+
+		if (!loader.poll(image))
+			return;
+
+		updateTexture();
+	}
+
+	void Background::updateTexture()
+	{
 		if (texture)
 		{
 			texture->dispose();
 			texture = nullptr;
 		}
 
-		if (filename.empty() || !IO::File::exists(filename))
+		textureBlur = blur;
+		if (!image.isValid())
 			return;
 
-		texture = std::make_unique<Texture>(filename);
-		framebuffer->resize(texture->getWidth(), texture->getHeight());
+		const int radius =
+		    static_cast<int>(blur * std::max(image.width, image.height) * maxBlurRadius);
+		if (radius > 0)
+			texture = std::make_unique<Texture>(filename, blurImageDownscaled(image, radius));
+		else
+			texture = std::make_unique<Texture>(filename, image);
 
+		framebuffer->resize(texture->getWidth(), texture->getHeight());
 		dirty = true;
 	}
 
@@ -74,7 +135,14 @@ namespace MikuMikuWorld
 
 	void Background::process(Renderer* renderer)
 	{
-		if (framebuffer == nullptr || texture == nullptr)
+		if (framebuffer == nullptr)
+			return;
+
+		// Only a new blur needs the image processed again, brightness is applied while drawing
+		if (textureBlur != blur)
+			updateTexture();
+
+		if (texture == nullptr)
 			return;
 
 		int s = ResourceManager::getShader("basic2d");
@@ -136,6 +204,7 @@ namespace MikuMikuWorld
 
 	void Background::dispose()
 	{
+		loader.cancel();
 		if (framebuffer)
 		{
 			framebuffer->dispose();
@@ -147,5 +216,6 @@ namespace MikuMikuWorld
 			texture->dispose();
 			texture = nullptr;
 		}
+		image = {};
 	}
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include "Rendering/ImageLoader.h"
 #include "Rendering/Texture.h"
 #include "Rendering/Framebuffer.h"
 #include <string>
@@ -16,6 +17,11 @@ namespace MikuMikuWorld
 		std::string filename;
 		std::unique_ptr<Texture> texture;
 		std::unique_ptr<Framebuffer> framebuffer;
+		ImageLoader loader;
+
+		// The decoded image, kept to blur again whenever the blur changes
+		ImageData image;
+		float textureBlur;
 
 		float blur;
 		float brightness;
@@ -26,12 +32,23 @@ namespace MikuMikuWorld
 		bool dirty;
 		bool useJacketBg;
 
+		// Size of the area the background covers, which decoded images are downscaled to
+		float targetWidth;
+		float targetHeight;
+		bool loadPending;
+
 		void resizeByRatio(float& w, float& h, const Vector2& tgt, bool vertical);
+		void startDecode();
+		void updateTexture();
 
 	  public:
 		Background();
 
+		/// Decodes the image in the background, the previous image stays until the new one is ready
 		void load(const std::string& filename);
+
+		/// Starts pending decodes for the target size and uploads finished ones each frame
+		void update(Vector2 target);
 		void resize(Vector2 target);
 		void process(Renderer* renderer);
 		void dispose();
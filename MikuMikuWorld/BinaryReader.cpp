@@ -1,5 +1,6 @@
 #include "BinaryReader.h"
 #include "IO.h"
+#include <cstring>
 
 namespace IO
 {
@@ -7,7 +8,7 @@ namespace IO
 	{
 		stream = NULL;
 		std::wstring wFilename = mbToWideStr(filename);
-		stream = _wfopen(wFilename.c_str(), L"rb");
+		stream = openFileStream(wFilename, L"rb");
 	}
 
 	BinaryReader::~BinaryReader() { close(); }
@@ -35,11 +36,20 @@ namespace IO
 
 	size_t BinaryReader::getStreamPosition() { return ftell(stream); }
 
+	bool BinaryReader::readValue(void* data, size_t size)
+	{
+		if (stream && fread(data, size, 1, stream) == 1)
+			return true;
+
+		memset(data, 0, size);
+		readPastEnd = true;
+		return false;
+	}
+
 	uint16_t BinaryReader::readUInt16()
 	{
 		uint16_t data = 0;
-		if (stream)
-			fread(&data, sizeof(uint16_t), 1, stream);
+		readValue(&data, sizeof(uint16_t));
 
 		return data;
 	}
@@ -47,8 +57,7 @@ namespace IO
 	uint32_t BinaryReader::readUInt32()
 	{
 		uint32_t data = 0;
-		if (stream)
-			fread(&data, sizeof(uint32_t), 1, stream);
+		readValue(&data, sizeof(uint32_t));
 
 		return data;
 	}
@@ -56,8 +65,7 @@ namespace IO
 	int16_t BinaryReader::readInt16()
 	{
 		int16_t data = 0;
-		if (stream)
-			fread(&data, sizeof(int16_t), 1, stream);
+		readValue(&data, sizeof(int16_t));
 
 		return data;
 	}
@@ -65,8 +73,7 @@ namespace IO
 	int32_t BinaryReader::readInt32()
 	{
 		int32_t data = 0;
-		if (stream)
-			fread(&data, sizeof(int32_t), 1, stream);
+		readValue(&data, sizeof(int32_t));
 
 		return data;
 	}
@@ -74,25 +81,29 @@ namespace IO
 	float BinaryReader::readSingle()
 	{
 		float data = 0;
-		if (stream)
-			fread(&data, sizeof(float), 1, stream);
+		readValue(&data, sizeof(float));
 
 		return data;
 	}
 
 	std::string BinaryReader::readString()
 	{
-		char c = 'a';
+		char c{};
 		std::string data = "";
-		if (stream)
-		{
-			while (c && !feof(stream))
-			{
-				fread(&c, sizeof(uint8_t), 1, stream);
-				if (c)
-					data += c;
-			}
-		}
+		while (readValue(&c, sizeof(uint8_t)) && c)
+			data += c;
+
+		return data;
+	}
+
+	std::vector<uint8_t> BinaryReader::readBytes(size_t count)
+	{
+		std::vector<uint8_t> data(count);
+		if (stream && count)
+			data.resize(fread(data.data(), sizeof(uint8_t), count, stream));
+		else
+			data.clear();
+
 		return data;
 	}
 
@@ -1,6 +1,7 @@
 #pragma once
 #include <stdio.h>
 #include <string>
+#include <vector>
 
 namespace IO
 {
@@ -8,12 +9,18 @@ namespace IO
 	{
 	  private:
 		FILE* stream;
+		bool readPastEnd{ false };
+
+		bool readValue(void* data, size_t size);
 
 	  public:
 		BinaryReader(const std::string& filename);
 		~BinaryReader();
 
 		bool isStreamValid();
+
+		/// Set once a read runs into the end of the file. Such reads return zero.
+		bool hasReadPastEnd() const { return readPastEnd; }
 		void close();
 
 		size_t getFileSize();
@@ -26,5 +33,8 @@ namespace IO
 		uint32_t readUInt32();
 		float readSingle();
 		std::string readString();
+
+		/// Reads up to count bytes, fewer if the file ends first
+		std::vector<uint8_t> readBytes(size_t count);
 	};
 }
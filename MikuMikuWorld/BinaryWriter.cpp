@@ -7,7 +7,7 @@ namespace IO
 	{
 		stream = NULL;
 		std::wstring wFilename = mbToWideStr(filename);
-		stream = _wfopen(wFilename.c_str(), L"wb");
+		stream = openFileStream(wFilename, L"wb");
 	}
 
 	BinaryWriter::~BinaryWriter() { close(); }
@@ -18,6 +18,8 @@ namespace IO
 	{
 		if (stream)
 			fclose(stream);
+
+		stream = NULL;
 	}
 
 	void BinaryWriter::flush()
@@ -67,7 +69,10 @@ namespace IO
 	{
 		uint8_t zero = 0;
 		if (stream)
-			fwrite(&zero, sizeof(uint8_t), length, stream);
+		{
+			for (size_t i = 0; i < length; ++i)
+				fwrite(&zero, sizeof(uint8_t), 1, stream);
+		}
 	}
 
 	void BinaryWriter::writeString(std::string data)
@@ -0,0 +1,225 @@
+#include "ChartLibrary.h"
+#include "File.h"
+#include "IO.h"
+#include "JobSystem.h"
+#include "JsonIO.h"
+#include "SusParser.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace nlohmann;
+
+namespace MikuMikuWorld
+{
+	constexpr int CHART_INDEX_VERSION = 1;
+
+	static std::string lowerExtension(const std::string& filename)
+	{
+		std::string extension = IO::File::getFileExtension(filename);
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		return extension;
+	}
+
+	bool ChartLibrary::isChartFile(const std::string& filename)
+	{
+		std::string extension = lowerExtension(filename);
+		return extension == MMWS_EXTENSION || extension == CC_MMWS_EXTENSION ||
+		       extension == SUS_EXTENSION;
+	}
+
+	ChartInfo ChartLibrary::readChartInfo(const std::string& filename)
+	{
+		ChartInfo info;
+		info.filename = filename;
+
+		if (lowerExtension(filename) == SUS_EXTENSION)
+		{
+			SusParser parser;
+			SUSMetadata metadata = parser.parseMetadata(filename);
+			info.summary.metadata.title = metadata.data["title"];
+			info.summary.metadata.artist = metadata.data["artist"];
+			info.summary.metadata.author = metadata.data["designer"];
+			info.summary.metadata.musicOffset = metadata.waveOffset * 1000;
+			info.hasCounts = false;
+		}
+		else
+		{
+			info.summary = readScoreSummary(filename);
+			info.hasCounts = true;
+		}
+
+		return info;
+	}
+
+	void ChartLibrary::scan(const std::string& directory)
+	{
+		namespace fs = std::filesystem;
+
+		std::wstring wDirectory = IO::mbToWideStr(directory);
+		std::error_code error;
+		if (!fs::is_directory(wDirectory, error))
+		{
+			charts.clear();
+			return;
+		}
+
+		std::unordered_map<std::string, ChartInfo> previous;
+		previous.reserve(charts.size());
+		for (ChartInfo& chart : charts)
+			previous.emplace(chart.filename, std::move(chart));
+
+		std::vector<ChartInfo> found;
+		std::vector<size_t> pending;
+		for (auto it = fs::recursive_directory_iterator(
+		         wDirectory, fs::directory_options::skip_permission_denied, error);
+		     it != fs::recursive_directory_iterator(); it.increment(error))
+		{
+			if (error || !it->is_regular_file(error))
+				continue;
+
+			std::string filename = IO::wideStringToMb(it->path().wstring());
+			if (!isChartFile(filename))
+				continue;
+
+			// A file that vanished or cannot be read since it was listed is left out
+			const int64_t writeTime = it->last_write_time(error).time_since_epoch().count();
+			if (error)
+				continue;
+
+			const uint64_t fileSize = it->file_size(error);
+			if (error)
+				continue;
+
+			auto cached = previous.find(filename);
+			if (cached != previous.end() && cached->second.writeTime == writeTime &&
+			    cached->second.fileSize == fileSize)
+			{
+				found.push_back(std::move(cached->second));
+				continue;
+			}
+
+			pending.push_back(found.size());
+			found.push_back({ filename, writeTime, fileSize });
+		}
+
+		std::vector<uint8_t> failed(found.size());
+		JobSystem::forEach(pending.begin(), pending.end(),
+		                   [&](size_t index)
+		                   {
+			                   ChartInfo& chart = found[index];
+			                   try
+			                   {
+				                   ChartInfo info = readChartInfo(chart.filename);
+				                   chart.summary = std::move(info.summary);
+				                   chart.hasCounts = info.hasCounts;
+			                   }
+			                   catch (...)
+			                   {
+				                   failed[index] = true;
+			                   }
+		                   });
+
+		charts.clear();
+		charts.reserve(found.size());
+		for (size_t i = 0; i < found.size(); ++i)
+		{
+			if (!failed[i])
+				charts.push_back(std::move(found[i]));
+		}
+
+		std::sort(charts.begin(), charts.end(), [](const ChartInfo& a, const ChartInfo& b)
+		          { return a.filename < b.filename; });
+	}
+
+	bool ChartLibrary::loadIndex(const std::string& filename)
+	{
+		std::wstring wFilename = IO::mbToWideStr(filename);
+		if (!std::filesystem::exists(wFilename))
+			return false;
+
+		json index;
+		try
+		{
+			std::ifstream indexFile{ std::filesystem::path(wFilename) };
+			indexFile >> index;
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+
+		if (jsonIO::tryGetValue<int>(index, "version", 0) != CHART_INDEX_VERSION ||
+		    !jsonIO::arrayHasData(index, "charts"))
+			return false;
+
+		charts.clear();
+		for (const auto& entry : index["charts"])
+		{
+			ChartInfo chart;
+			chart.filename = jsonIO::tryGetValue<std::string>(entry, "filename", "");
+			chart.writeTime = jsonIO::tryGetValue<int64_t>(entry, "write_time", 0);
+			chart.fileSize = jsonIO::tryGetValue<uint64_t>(entry, "file_size", 0);
+			chart.hasCounts = jsonIO::tryGetValue<bool>(entry, "has_counts", false);
+
+			ScoreSummary& summary = chart.summary;
+			summary.metadata.title = jsonIO::tryGetValue<std::string>(entry, "title", "");
+			summary.metadata.artist = jsonIO::tryGetValue<std::string>(entry, "artist", "");
+			summary.metadata.author = jsonIO::tryGetValue<std::string>(entry, "author", "");
+			summary.metadata.musicFile = jsonIO::tryGetValue<std::string>(entry, "music", "");
+			summary.metadata.jacketFile = jsonIO::tryGetValue<std::string>(entry, "jacket", "");
+			summary.metadata.musicOffset = jsonIO::tryGetValue<float>(entry, "music_offset", 0);
+			summary.metadata.laneExtension = jsonIO::tryGetValue<int>(entry, "lane_extension", 0);
+			summary.tapCount = jsonIO::tryGetValue<int>(entry, "taps", 0);
+			summary.holdCount = jsonIO::tryGetValue<int>(entry, "holds", 0);
+			summary.stepCount = jsonIO::tryGetValue<int>(entry, "steps", 0);
+			summary.damageCount = jsonIO::tryGetValue<int>(entry, "damages", 0);
+			summary.lastTick = jsonIO::tryGetValue<int>(entry, "last_tick", 0);
+			summary.duration = jsonIO::tryGetValue<float>(entry, "duration", 0);
+
+			if (!chart.filename.empty())
+				charts.push_back(std::move(chart));
+		}
+
+		return true;
+	}
+
+	void ChartLibrary::saveIndex(const std::string& filename) const
+	{
+		json entries = json::array();
+		for (const ChartInfo& chart : charts)
+		{
+			const ScoreSummary& summary = chart.summary;
+			entries.push_back({ { "filename", chart.filename },
+			                    { "write_time", chart.writeTime },
+			                    { "file_size", chart.fileSize },
+			                    { "has_counts", chart.hasCounts },
+			                    { "title", summary.metadata.title },
+			                    { "artist", summary.metadata.artist },
+			                    { "author", summary.metadata.author },
+			                    { "music", summary.metadata.musicFile },
+			                    { "jacket", summary.metadata.jacketFile },
+			                    { "music_offset", summary.metadata.musicOffset },
+			                    { "lane_extension", summary.metadata.laneExtension },
+			                    { "taps", summary.tapCount },
+			                    { "holds", summary.holdCount },
+			                    { "steps", summary.stepCount },
+			                    { "damages", summary.damageCount },
+			                    { "last_tick", summary.lastTick },
+			                    { "duration", summary.duration } });
+		}
+
+		json index;
+		index["version"] = CHART_INDEX_VERSION;
+		index["charts"] = entries;
+
+		std::ofstream indexFile(std::filesystem::path(IO::mbToWideStr(filename)));
+		if (!indexFile.is_open())
+			throw std::runtime_error("Failed to open " + filename + " for writing");
+
+		indexFile << index;
+		indexFile.close();
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "Score.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	/// Library entry of a chart file
+	struct ChartInfo
+	{
+		std::string filename;
+		int64_t writeTime{};
+		uint64_t fileSize{};
+		ScoreSummary summary{};
+
+		/// SUS files are only read up to their header, so their notes are not counted
+		bool hasCounts{};
+	};
+
+	/// Lists the charts of a directory from their metadata. Files are read in parallel and
+	/// entries of unchanged files are reused from the previous scan or the index file.
+	class ChartLibrary
+	{
+	  private:
+		std::vector<ChartInfo> charts;
+
+	  public:
+		static bool isChartFile(const std::string& filename);
+		static ChartInfo readChartInfo(const std::string& filename);
+
+		/// Replaces the charts with the ones found in directory and its subdirectories
+		void scan(const std::string& directory);
+
+		bool loadIndex(const std::string& filename);
+
+		/// Throws if the index file cannot be written
+		void saveIndex(const std::string& filename) const;
+
+		const std::vector<ChartInfo>& getCharts() const { return charts; }
+	};
+}
@@ -0,0 +1,763 @@
+#include "EditJournal.h"
+#include "IO.h"
+#include "Profiler.h"
+#include "Utilities.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+namespace MikuMikuWorld
+{
+	constexpr uint32_t journalSignature = 0x4A574D4D; // MMWJ
+	constexpr uint32_t journalVersion = 1;
+	constexpr const char* journalExtension = ".journal";
+
+	enum class JournalTag : uint8_t
+	{
+		Note,
+		EraseNote,
+		Hold,
+		EraseHold,
+		HiSpeed,
+		EraseHiSpeed,
+		TempoChanges,
+		TimeSignatures,
+		Skills,
+		Fever,
+		Layers,
+		Waypoints,
+		Metadata,
+		TagCount
+	};
+
+	static uint32_t checksum(const std::string& data)
+	{
+		uint32_t hash = 2166136261u;
+		for (unsigned char c : data)
+			hash = (hash ^ c) * 16777619u;
+
+		return hash;
+	}
+
+	class JournalWriter
+	{
+	  private:
+		std::string& buffer;
+
+	  public:
+		JournalWriter(std::string& buffer) : buffer{ buffer } {}
+
+		template <typename T> void write(T value)
+		{
+			buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		void writeTag(JournalTag tag) { write<uint8_t>((uint8_t)tag); }
+
+		void writeString(const std::string& value)
+		{
+			write<uint32_t>(value.size());
+			buffer.append(value);
+		}
+
+		void writeNote(const Note& note)
+		{
+			writeTag(JournalTag::Note);
+			write<int32_t>(note.ID);
+			write<uint8_t>((uint8_t)note.getType());
+			write<int32_t>(note.tick);
+			write<float>(note.lane);
+			write<float>(note.width);
+			write<uint8_t>(note.critical | note.friction << 1);
+			write<uint8_t>((uint8_t)note.flick);
+			write<int32_t>(note.layer);
+			write<int32_t>(note.parentID);
+		}
+
+		void writeHold(const HoldNote& hold)
+		{
+			writeTag(JournalTag::Hold);
+			write<int32_t>(hold.start.ID);
+			write<uint8_t>((uint8_t)hold.start.ease);
+			write<uint8_t>((uint8_t)hold.startType);
+			write<uint8_t>((uint8_t)hold.endType);
+			write<uint8_t>((uint8_t)hold.fadeType);
+			write<uint8_t>((uint8_t)hold.guideColor);
+			write<int32_t>(hold.end);
+			write<uint32_t>(hold.steps.size());
+			for (const HoldStep& step : hold.steps)
+			{
+				write<int32_t>(step.ID);
+				write<uint8_t>((uint8_t)step.type);
+				write<uint8_t>((uint8_t)step.ease);
+			}
+		}
+
+		void writeHiSpeed(const HiSpeedChange& hiSpeed)
+		{
+			writeTag(JournalTag::HiSpeed);
+			write<int32_t>(hiSpeed.ID);
+			write<int32_t>(hiSpeed.tick);
+			write<float>(hiSpeed.speed);
+			write<int32_t>(hiSpeed.layer);
+		}
+
+		void writeErase(JournalTag tag, id_t id)
+		{
+			writeTag(tag);
+			write<int32_t>(id);
+		}
+
+		void writeTempoChanges(const std::vector<Tempo>& tempoChanges)
+		{
+			writeTag(JournalTag::TempoChanges);
+			write<uint32_t>(tempoChanges.size());
+			for (const Tempo& tempo : tempoChanges)
+			{
+				write<int32_t>(tempo.tick);
+				write<float>(tempo.bpm);
+			}
+		}
+
+		void writeMetadata(const ScoreMetadata& metadata)
+		{
+			writeTag(JournalTag::Metadata);
+			writeString(metadata.title);
+			writeString(metadata.artist);
+			writeString(metadata.author);
+			writeString(metadata.musicFile);
+			writeString(metadata.jacketFile);
+			write<float>(metadata.musicOffset);
+			write<int32_t>(metadata.laneExtension);
+		}
+
+		void writeTimeSignatures(const std::map<int, TimeSignature>& timeSignatures)
+		{
+			writeTag(JournalTag::TimeSignatures);
+			write<uint32_t>(timeSignatures.size());
+			for (const auto& [_, ts] : timeSignatures)
+			{
+				write<int32_t>(ts.measure);
+				write<int32_t>(ts.numerator);
+				write<int32_t>(ts.denominator);
+			}
+		}
+	};
+
+	class JournalReader
+	{
+	  private:
+		const std::string& buffer;
+		size_t position{};
+
+	  public:
+		JournalReader(const std::string& buffer) : buffer{ buffer } {}
+
+		bool atEnd() const { return position >= buffer.size(); }
+
+		template <typename T> T read()
+		{
+			if (buffer.size() - position < sizeof(T))
+				throw std::runtime_error("Unexpected end of journal record");
+
+			T value{};
+			memcpy(&value, buffer.data() + position, sizeof(T));
+			position += sizeof(T);
+			return value;
+		}
+
+		template <typename T> T readEnum(size_t count)
+		{
+			uint8_t value = read<uint8_t>();
+			if (value >= count)
+				throw std::runtime_error("Invalid value in journal record");
+
+			return (T)value;
+		}
+
+		uint32_t readCount()
+		{
+			uint32_t count = read<uint32_t>();
+			if (count > buffer.size() - position)
+				throw std::runtime_error("Invalid count in journal record");
+
+			return count;
+		}
+
+		std::string readString()
+		{
+			uint32_t length = readCount();
+			std::string value = buffer.substr(position, length);
+			position += length;
+			return value;
+		}
+	};
+
+	static bool isSameNote(const Note& a, const Note& b)
+	{
+		return a.getType() == b.getType() && a.tick == b.tick && a.lane == b.lane &&
+		       a.width == b.width && a.critical == b.critical && a.friction == b.friction &&
+		       a.flick == b.flick && a.layer == b.layer && a.parentID == b.parentID;
+	}
+
+	static bool isSameMetadata(const ScoreMetadata& a, const ScoreMetadata& b)
+	{
+		return std::tie(a.title, a.artist, a.author, a.musicFile, a.jacketFile, a.musicOffset,
+		                a.laneExtension) == std::tie(b.title, b.artist, b.author, b.musicFile,
+		                                             b.jacketFile, b.musicOffset, b.laneExtension);
+	}
+
+	static bool isSameStep(const HoldStep& a, const HoldStep& b)
+	{
+		return a.ID == b.ID && a.type == b.type && a.ease == b.ease;
+	}
+
+	static bool isSameHold(const HoldNote& a, const HoldNote& b)
+	{
+		return isSameStep(a.start, b.start) && a.end == b.end && a.startType == b.startType &&
+		       a.endType == b.endType && a.fadeType == b.fadeType &&
+		       a.guideColor == b.guideColor &&
+		       std::equal(a.steps.begin(), a.steps.end(), b.steps.begin(), b.steps.end(),
+		                  isSameStep);
+	}
+
+	static bool isSameHiSpeed(const HiSpeedChange& a, const HiSpeedChange& b)
+	{
+		return a.tick == b.tick && a.speed == b.speed && a.layer == b.layer;
+	}
+
+	/// Writes upserts for the entities that differ between from and to and erases for the ones
+	/// missing from to
+	template <typename Map, typename Same, typename WriteValue>
+	static void diffEntities(const Map& from, const Map& to, JournalTag eraseTag, Same same,
+	                         WriteValue writeValue, JournalWriter& writer)
+	{
+		for (const auto& [id, value] : to)
+		{
+			auto it = from.find(id);
+			if (it == from.end() || !same(it->second, value))
+				writeValue(value);
+		}
+
+		for (const auto& [id, _] : from)
+		{
+			if (to.find(id) == to.end())
+				writer.writeErase(eraseTag, id);
+		}
+	}
+
+	/// Note IDs in the order serializeScore writes the notes, which is also the order
+	/// deserializeScore and the importers create them in
+	static std::vector<id_t> getNoteOrder(const Score& score)
+	{
+		std::vector<id_t> order;
+		order.reserve(score.notes.size());
+		for (const auto& [id, note] : score.notes)
+		{
+			if (note.getType() == NoteType::Tap)
+				order.push_back(id);
+		}
+
+		for (const auto& [id, hold] : score.holdNotes)
+		{
+			order.push_back(hold.start.ID);
+			for (const HoldStep& step : hold.steps)
+				order.push_back(step.ID);
+			order.push_back(hold.end);
+		}
+
+		for (const auto& [id, note] : score.notes)
+		{
+			if (note.getType() == NoteType::Damage)
+				order.push_back(id);
+		}
+
+		return order;
+	}
+
+	EditJournal::~EditJournal() { close(false); }
+
+	std::string EditJournal::getJournalFilename(const std::string& workingFilename)
+	{
+		return workingFilename + journalExtension;
+	}
+
+	bool EditJournal::isInUse(const std::string& journalFilename)
+	{
+		// Opening for writing fails while the owner holds the journal with writes denied
+		FILE* file = IO::openSharedFileStream(IO::mbToWideStr(journalFilename), L"r+b", false);
+		if (file)
+		{
+			fclose(file);
+			return false;
+		}
+
+		std::error_code error;
+		return std::filesystem::exists(IO::mbToWideStr(journalFilename), error);
+	}
+
+	void EditJournal::checkpoint(const std::string& journalFilename,
+	                             const std::string& baseFilename, const Score& score)
+	{
+		PROFILE_SCOPE("EditJournal::checkpoint");
+		close(journalFilename != filename);
+
+		// Deny writes to other processes so another instance can tell the journal is in use,
+		// and cannot truncate it, while this one is running
+		filename = journalFilename;
+		stream = IO::openSharedFileStream(IO::mbToWideStr(filename), L"wb", true);
+		if (!stream)
+			return;
+
+		metadata = score.metadata;
+
+		std::string header;
+		JournalWriter writer(header);
+		writer.write<uint32_t>(journalSignature);
+		writer.write<uint32_t>(journalVersion);
+		writer.writeString(baseFilename);
+
+		std::vector<id_t> noteOrder = getNoteOrder(score);
+		writer.write<uint32_t>(noteOrder.size());
+		for (id_t id : noteOrder)
+			writer.write<int32_t>(id);
+
+		writer.write<uint32_t>(score.hiSpeedChanges.size());
+		for (const auto& [id, hiSpeed] : score.hiSpeedChanges)
+		{
+			writer.write<int32_t>(id);
+			writer.write<int32_t>(hiSpeed.tick);
+			writer.write<float>(hiSpeed.speed);
+			writer.write<int32_t>(hiSpeed.layer);
+		}
+
+		appendRecord(header);
+	}
+
+	void EditJournal::close(bool remove)
+	{
+		if (stream)
+		{
+			fclose(stream);
+			stream = nullptr;
+		}
+
+		if (remove && filename.size())
+		{
+			std::error_code error;
+			std::filesystem::remove(IO::mbToWideStr(filename), error);
+		}
+	}
+
+	void EditJournal::appendRecord(const std::string& payload)
+	{
+		if (!stream || payload.empty())
+			return;
+
+		uint32_t frame[2] = { static_cast<uint32_t>(payload.size()), checksum(payload) };
+		fwrite(frame, sizeof(frame), 1, stream);
+		fwrite(payload.data(), 1, payload.size(), stream);
+		fflush(stream);
+	}
+
+	void EditJournal::recordChange(const Score& from, const Score& to)
+	{
+		if (!stream)
+			return;
+
+		std::string record;
+		JournalWriter writer(record);
+		diffEntities(
+		    from.notes, to.notes, JournalTag::EraseNote, isSameNote,
+		    [&writer](const Note& note) { writer.writeNote(note); }, writer);
+		diffEntities(
+		    from.holdNotes, to.holdNotes, JournalTag::EraseHold, isSameHold,
+		    [&writer](const HoldNote& hold) { writer.writeHold(hold); }, writer);
+		diffEntities(
+		    from.hiSpeedChanges, to.hiSpeedChanges, JournalTag::EraseHiSpeed, isSameHiSpeed,
+		    [&writer](const HiSpeedChange& hiSpeed) { writer.writeHiSpeed(hiSpeed); }, writer);
+
+		if (!std::equal(from.tempoChanges.begin(), from.tempoChanges.end(),
+		                to.tempoChanges.begin(), to.tempoChanges.end(),
+		                [](const Tempo& a, const Tempo& b)
+		                { return a.tick == b.tick && a.bpm == b.bpm; }))
+			writer.writeTempoChanges(to.tempoChanges);
+
+		if (!std::equal(from.timeSignatures.begin(), from.timeSignatures.end(),
+		                to.timeSignatures.begin(), to.timeSignatures.end(),
+		                [](const auto& a, const auto& b)
+		                {
+			                return a.second.measure == b.second.measure &&
+			                       a.second.numerator == b.second.numerator &&
+			                       a.second.denominator == b.second.denominator;
+		                }))
+			writer.writeTimeSignatures(to.timeSignatures);
+
+		std::vector<int> fromSkills, toSkills;
+		for (const auto& [_, skill] : from.skills)
+			fromSkills.push_back(skill.tick);
+		for (const auto& [_, skill] : to.skills)
+			toSkills.push_back(skill.tick);
+
+		std::sort(fromSkills.begin(), fromSkills.end());
+		std::sort(toSkills.begin(), toSkills.end());
+		if (fromSkills != toSkills)
+		{
+			writer.writeTag(JournalTag::Skills);
+			writer.write<uint32_t>(toSkills.size());
+			for (int tick : toSkills)
+				writer.write<int32_t>(tick);
+		}
+
+		if (from.fever.startTick != to.fever.startTick || from.fever.endTick != to.fever.endTick)
+		{
+			writer.writeTag(JournalTag::Fever);
+			writer.write<int32_t>(to.fever.startTick);
+			writer.write<int32_t>(to.fever.endTick);
+		}
+
+		if (!std::equal(from.layers.begin(), from.layers.end(), to.layers.begin(),
+		                to.layers.end(), [](const Layer& a, const Layer& b)
+		                { return a.name == b.name && a.hidden == b.hidden; }))
+		{
+			writer.writeTag(JournalTag::Layers);
+			writer.write<uint32_t>(to.layers.size());
+			for (const Layer& layer : to.layers)
+			{
+				writer.writeString(layer.name);
+				writer.write<uint8_t>(layer.hidden);
+			}
+		}
+
+		if (!std::equal(from.waypoints.begin(), from.waypoints.end(), to.waypoints.begin(),
+		                to.waypoints.end(), [](const Waypoint& a, const Waypoint& b)
+		                { return a.name == b.name && a.tick == b.tick; }))
+		{
+			writer.writeTag(JournalTag::Waypoints);
+			writer.write<uint32_t>(to.waypoints.size());
+			for (const Waypoint& waypoint : to.waypoints)
+			{
+				writer.writeString(waypoint.name);
+				writer.write<int32_t>(waypoint.tick);
+			}
+		}
+
+		if (!isSameMetadata(from.metadata, to.metadata))
+			writer.writeMetadata(to.metadata);
+
+		appendRecord(record);
+	}
+
+	void EditJournal::recordChange(const ScoreDelta& delta, bool undo)
+	{
+		if (!stream)
+			return;
+
+		std::string record;
+		JournalWriter writer(record);
+		for (const auto& change : delta.notes)
+		{
+			const std::optional<Note>& image = undo ? change.before : change.after;
+			if (image)
+				writer.writeNote(*image);
+			else
+				writer.writeErase(JournalTag::EraseNote, change.id);
+		}
+
+		for (const auto& change : delta.holdNotes)
+		{
+			const std::optional<HoldNote>& image = undo ? change.before : change.after;
+			if (image)
+				writer.writeHold(*image);
+			else
+				writer.writeErase(JournalTag::EraseHold, change.id);
+		}
+
+		for (const auto& change : delta.hiSpeedChanges)
+		{
+			const std::optional<HiSpeedChange>& image = undo ? change.before : change.after;
+			if (image)
+				writer.writeHiSpeed(*image);
+			else
+				writer.writeErase(JournalTag::EraseHiSpeed, change.id);
+		}
+
+		if (delta.tempoChangesBefore)
+			writer.writeTempoChanges(undo ? *delta.tempoChangesBefore : *delta.tempoChangesAfter);
+
+		if (delta.timeSignaturesBefore)
+			writer.writeTimeSignatures(undo ? *delta.timeSignaturesBefore
+			                                : *delta.timeSignaturesAfter);
+
+		appendRecord(record);
+	}
+
+	void EditJournal::recordMetadata(const ScoreMetadata& metadata)
+	{
+		if (!stream || isSameMetadata(this->metadata, metadata))
+			return;
+
+		std::string record;
+		JournalWriter writer(record);
+		writer.writeMetadata(metadata);
+		appendRecord(record);
+		this->metadata = metadata;
+	}
+
+	bool EditJournal::read(const std::string& journalFilename, JournalContents& contents)
+	{
+		FILE* file = IO::openFileStream(IO::mbToWideStr(journalFilename), L"rb");
+		if (!file)
+			return false;
+
+		std::string data;
+		char chunk[4096];
+		size_t length;
+		while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0)
+			data.append(chunk, length);
+		fclose(file);
+
+		std::vector<std::string> records;
+		size_t position = 0;
+		while (data.size() - position >= sizeof(uint32_t) * 2)
+		{
+			uint32_t frame[2];
+			memcpy(frame, data.data() + position, sizeof(frame));
+			position += sizeof(frame);
+			if (frame[0] > data.size() - position)
+				break;
+
+			std::string payload = data.substr(position, frame[0]);
+			if (checksum(payload) != frame[1])
+				break;
+
+			position += frame[0];
+			records.push_back(std::move(payload));
+		}
+
+		if (records.empty())
+			return false;
+
+		try
+		{
+			JournalReader reader(records.front());
+			if (reader.read<uint32_t>() != journalSignature ||
+			    reader.read<uint32_t>() != journalVersion)
+				return false;
+
+			contents.baseFilename = reader.readString();
+			contents.noteIDs.resize(reader.readCount());
+			for (id_t& id : contents.noteIDs)
+				id = reader.read<int32_t>();
+
+			contents.hiSpeedChanges.resize(reader.readCount());
+			for (HiSpeedChange& hiSpeed : contents.hiSpeedChanges)
+			{
+				hiSpeed.ID = reader.read<int32_t>();
+				hiSpeed.tick = reader.read<int32_t>();
+				hiSpeed.speed = reader.read<float>();
+				hiSpeed.layer = reader.read<int32_t>();
+			}
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+
+		contents.records.assign(std::make_move_iterator(records.begin() + 1),
+		                        std::make_move_iterator(records.end()));
+		return true;
+	}
+
+	void EditJournal::replay(const JournalContents& contents, Score& score)
+	{
+		// The journal refers to entities by the IDs of the session that wrote it, so pair them
+		// with the IDs the base file was loaded with before applying anything
+		std::vector<id_t> noteOrder = getNoteOrder(score);
+		if (noteOrder.size() != contents.noteIDs.size())
+			throw std::runtime_error("The score file was modified after the journal was written.");
+
+		std::unordered_map<id_t, id_t> noteIDs;
+		for (size_t i = 0; i < noteOrder.size(); ++i)
+			noteIDs[contents.noteIDs[i]] = noteOrder[i];
+
+		// Hi-speed changes are kept in an unordered map so match them by value instead
+		std::multimap<std::tuple<int, int, float>, id_t> loadedHiSpeeds;
+		for (const auto& [id, hiSpeed] : score.hiSpeedChanges)
+			loadedHiSpeeds.emplace(std::make_tuple(hiSpeed.tick, hiSpeed.layer, hiSpeed.speed), id);
+
+		std::unordered_map<id_t, id_t> hiSpeedIDs;
+		for (const HiSpeedChange& hiSpeed : contents.hiSpeedChanges)
+		{
+			auto it =
+			    loadedHiSpeeds.find(std::make_tuple(hiSpeed.tick, hiSpeed.layer, hiSpeed.speed));
+			if (it == loadedHiSpeeds.end())
+				throw std::runtime_error(
+				    "The score file was modified after the journal was written.");
+
+			hiSpeedIDs[hiSpeed.ID] = it->second;
+			loadedHiSpeeds.erase(it);
+		}
+
+		// Entities created after the checkpoint get fresh IDs in this session
+		auto noteID = [&noteIDs](id_t id)
+		{
+			auto it = noteIDs.find(id);
+			return it != noteIDs.end() ? it->second : noteIDs[id] = Note::getNextID();
+		};
+
+		auto hiSpeedID = [&hiSpeedIDs](id_t id)
+		{
+			auto it = hiSpeedIDs.find(id);
+			return it != hiSpeedIDs.end() ? it->second : hiSpeedIDs[id] = getNextHiSpeedID();
+		};
+
+		for (const std::string& record : contents.records)
+		{
+			JournalReader reader(record);
+			while (!reader.atEnd())
+			{
+				switch (reader.readEnum<JournalTag>((size_t)JournalTag::TagCount))
+				{
+				case JournalTag::Note:
+				{
+					id_t id = noteID(reader.read<int32_t>());
+					Note note(reader.readEnum<NoteType>((size_t)NoteType::Damage + 1));
+					note.ID = id;
+					note.tick = reader.read<int32_t>();
+					note.lane = reader.read<float>();
+					note.width = reader.read<float>();
+					uint8_t flags = reader.read<uint8_t>();
+					note.critical = flags & 1;
+					note.friction = flags & 2;
+					note.flick = reader.readEnum<FlickType>((size_t)FlickType::FlickTypeCount);
+					note.layer = reader.read<int32_t>();
+					id_t parentID = reader.read<int32_t>();
+					if (note.getType() == NoteType::HoldMid || note.getType() == NoteType::HoldEnd)
+						note.parentID = noteID(parentID);
+
+					score.notes[id] = note;
+					break;
+				}
+				case JournalTag::Hold:
+				{
+					HoldNote hold;
+					hold.start.ID = noteID(reader.read<int32_t>());
+					hold.start.type = HoldStepType::Normal;
+					hold.start.ease = reader.readEnum<EaseType>((size_t)EaseType::EaseTypeCount);
+					hold.startType = reader.readEnum<HoldNoteType>(arrayLength(holdTypes));
+					hold.endType = reader.readEnum<HoldNoteType>(arrayLength(holdTypes));
+					hold.fadeType = reader.readEnum<FadeType>(arrayLength(fadeTypes));
+					hold.guideColor =
+					    reader.readEnum<GuideColor>((size_t)GuideColor::GuideColorCount);
+					hold.end = noteID(reader.read<int32_t>());
+					hold.steps.resize(reader.readCount());
+					for (HoldStep& step : hold.steps)
+					{
+						step.ID = noteID(reader.read<int32_t>());
+						step.type =
+						    reader.readEnum<HoldStepType>((size_t)HoldStepType::HoldStepTypeCount);
+						step.ease = reader.readEnum<EaseType>((size_t)EaseType::EaseTypeCount);
+					}
+
+					score.holdNotes[hold.start.ID] = hold;
+					break;
+				}
+				case JournalTag::HiSpeed:
+				{
+					id_t id = hiSpeedID(reader.read<int32_t>());
+					int tick = reader.read<int32_t>();
+					float speed = reader.read<float>();
+					int layer = reader.read<int32_t>();
+					score.hiSpeedChanges[id] = { id, tick, speed, layer };
+					break;
+				}
+				case JournalTag::EraseNote:
+					score.notes.erase(noteID(reader.read<int32_t>()));
+					break;
+				case JournalTag::EraseHold:
+					score.holdNotes.erase(noteID(reader.read<int32_t>()));
+					break;
+				case JournalTag::EraseHiSpeed:
+					score.hiSpeedChanges.erase(hiSpeedID(reader.read<int32_t>()));
+					break;
+				case JournalTag::TempoChanges:
+				{
+					score.tempoChanges.resize(reader.readCount());
+					for (Tempo& tempo : score.tempoChanges)
+					{
+						tempo.tick = reader.read<int32_t>();
+						tempo.bpm = reader.read<float>();
+					}
+					break;
+				}
+				case JournalTag::TimeSignatures:
+				{
+					score.timeSignatures.clear();
+					uint32_t count = reader.readCount();
+					for (uint32_t i = 0; i < count; ++i)
+					{
+						int measure = reader.read<int32_t>();
+						int numerator = reader.read<int32_t>();
+						int denominator = reader.read<int32_t>();
+						score.timeSignatures[measure] = { measure, numerator, denominator };
+					}
+					break;
+				}
+				case JournalTag::Skills:
+				{
+					score.skills.clear();
+					uint32_t count = reader.readCount();
+					for (uint32_t i = 0; i < count; ++i)
+					{
+						id_t id = getNextSkillID();
+						score.skills.emplace(id, SkillTrigger{ id, reader.read<int32_t>() });
+					}
+					break;
+				}
+				case JournalTag::Fever:
+					score.fever.startTick = reader.read<int32_t>();
+					score.fever.endTick = reader.read<int32_t>();
+					break;
+				case JournalTag::Layers:
+				{
+					score.layers.resize(reader.readCount());
+					for (Layer& layer : score.layers)
+					{
+						layer.name = reader.readString();
+						layer.hidden = reader.read<uint8_t>();
+					}
+					break;
+				}
+				case JournalTag::Waypoints:
+				{
+					score.waypoints.resize(reader.readCount());
+					for (Waypoint& waypoint : score.waypoints)
+					{
+						waypoint.name = reader.readString();
+						waypoint.tick = reader.read<int32_t>();
+					}
+					break;
+				}
+				case JournalTag::Metadata:
+				{
+					ScoreMetadata& metadata = score.metadata;
+					metadata.title = reader.readString();
+					metadata.artist = reader.readString();
+					metadata.author = reader.readString();
+					metadata.musicFile = reader.readString();
+					metadata.jacketFile = reader.readString();
+					metadata.musicOffset = reader.read<float>();
+					metadata.laneExtension = reader.read<int32_t>();
+					break;
+				}
+				default:
+					throw std::runtime_error("Invalid journal record");
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "HistoryManager.h"
+#include "Score.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	/// Contents of a journal file read back for recovery
+	struct JournalContents
+	{
+		std::string baseFilename;
+		std::vector<id_t> noteIDs;
+		std::vector<HiSpeedChange> hiSpeedChanges;
+		std::vector<std::string> records;
+	};
+
+	/// Append-only log of the edits made since the score was last written in full. Each committed
+	/// edit is appended as a small binary record, so a crash loses nothing that a replay over the
+	/// last full save cannot restore.
+	class EditJournal
+	{
+	  private:
+		std::string filename;
+		FILE* stream{};
+		// Metadata as of the last record, metadata edits do not go through the history
+		ScoreMetadata metadata{};
+
+		void appendRecord(const std::string& payload);
+
+	  public:
+		EditJournal() = default;
+		EditJournal(const EditJournal&) = delete;
+		EditJournal& operator=(const EditJournal&) = delete;
+		~EditJournal();
+
+		/// Starts a new journal on top of baseFilename, the last full save of score. An empty
+		/// base name stands for a new score.
+		void checkpoint(const std::string& journalFilename, const std::string& baseFilename,
+		                const Score& score);
+		void close(bool remove);
+		bool isOpen() const { return stream != nullptr; }
+		const std::string& getFilename() const { return filename; }
+
+		void recordChange(const Score& from, const Score& to);
+		void recordChange(const ScoreDelta& delta, bool undo);
+
+		/// Appends the metadata if it differs from what the journal last recorded
+		void recordMetadata(const ScoreMetadata& metadata);
+
+		static std::string getJournalFilename(const std::string& workingFilename);
+
+		/// Whether another editor instance still has the journal open for writing
+		static bool isInUse(const std::string& journalFilename);
+
+		/// Reads every complete record of a journal, ignoring a torn record at the end
+		static bool read(const std::string& journalFilename, JournalContents& contents);
+
+		/// Applies the records of a journal to the score loaded from its base file
+		static void replay(const JournalContents& contents, Score& score);
+	};
+}
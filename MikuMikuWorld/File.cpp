@@ -1,6 +1,5 @@
 #include "File.h"
 #include "IO.h"
-#include <Windows.h>
 #include <algorithm>
 #include <ctime>
 #include <stdio.h>
@@ -8,6 +7,13 @@
 #include <stdlib.h>
 #include <filesystem>
 #include <chrono>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cstring>
+#endif
 
 namespace IO
 {
@@ -32,7 +38,7 @@ namespace IO
 		if (stream)
 			close();
 
-		stream = _wfopen(filename.c_str(), mode);
+		stream = openFileStream(filename, mode);
 		if (!stream)
 			std::wcerr << L"Failed to open file: " << filename << std::endl;
 	}
@@ -62,7 +68,11 @@ namespace IO
 	std::chrono::time_point<std::chrono::system_clock> File::getLastWriteTime() const
 	{
 		struct stat fileStat;
+#ifdef _WIN32
 		fstat(_fileno(stream), &fileStat);
+#else
+		fstat(fileno(stream), &fileStat);
+#endif
 		auto time = fileStat.st_mtime;
 
 		return std::chrono::system_clock::from_time_t(time);
@@ -198,6 +208,7 @@ namespace IO
 		return std::filesystem::exists(path);
 	}
 
+#ifdef _WIN32
 	FileDialogResult FileDialog::showFileDialog(DialogType type, DialogSelectType selectType)
 	{
 		std::wstring wTitle = mbToWideStr(title);
@@ -270,6 +281,13 @@ namespace IO
 
 		return outputFilename.empty() ? FileDialogResult::Cancel : FileDialogResult::OK;
 	}
+#else
+	FileDialogResult FileDialog::showFileDialog([[maybe_unused]] DialogType type,
+	                                            [[maybe_unused]] DialogSelectType selectType)
+	{
+		return FileDialogResult::Error;
+	}
+#endif
 
 	FileDialogResult FileDialog::openFile()
 	{
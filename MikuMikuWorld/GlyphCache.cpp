@@ -0,0 +1,68 @@
+#include "GlyphCache.h"
+#include "ImGui/imgui_internal.h"
+#include "Language.h"
+
+namespace MikuMikuWorld
+{
+	ImFontGlyphRangesBuilder GlyphCache::resident;
+	size_t GlyphCache::residentCount = 0;
+	bool GlyphCache::dirty = true;
+
+	// Latin is small enough to keep resident for text that is drawn without being requested
+	static const ImWchar defaultRanges[] = {
+		0x0020, 0x00FF, // Basic Latin and Latin-1 Supplement
+		0xFFFD, 0xFFFD, // Replacement character
+		0,
+	};
+
+	void GlyphCache::request(ImWchar c)
+	{
+		if (!residentCount)
+		{
+			resident.AddRanges(defaultRanges);
+			for (const ImWchar* range = defaultRanges; range[0]; range += 2)
+				residentCount += range[1] - range[0] + 1;
+		}
+
+		if (c < 0x20 || resident.GetBit(c))
+			return;
+
+		resident.SetBit(c);
+		++residentCount;
+		dirty = true;
+	}
+
+	void GlyphCache::request(std::string_view text)
+	{
+		const char* it = text.data();
+		const char* end = it + text.size();
+		while (it < end)
+		{
+			unsigned int c = 0;
+			it += ImTextCharFromUtf8(&c, it, end);
+			if (c <= IM_UNICODE_CODEPOINT_MAX)
+				request(static_cast<ImWchar>(c));
+		}
+	}
+
+	void GlyphCache::request(const Language& language)
+	{
+		// The null characters between the strings are below the printable range and skipped
+		for (const Language* it = &language; it; it = it->getFallback())
+			request(it->getStringData());
+	}
+
+	bool GlyphCache::isDirty() { return dirty; }
+
+	void GlyphCache::buildRanges(ImVector<ImWchar>& ranges)
+	{
+		// Makes sure the default ranges are resident before the first request
+		request(ImWchar(' '));
+
+		ranges.clear();
+		resident.BuildRanges(&ranges);
+		dirty = false;
+	}
+
+	size_t GlyphCache::getResidentCount() { return residentCount; }
+}
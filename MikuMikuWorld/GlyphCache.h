@@ -0,0 +1,34 @@
+#pragma once
+#include "ImGui/imgui.h"
+#include <string_view>
+
+namespace MikuMikuWorld
+{
+	class Language;
+
+	/// Tracks the characters the UI shows so the font atlas only rasterizes those instead of
+	/// whole scripts. Requesting characters that are already resident costs a bit lookup each, so
+	/// text can be requested every time it is drawn. Main thread only.
+	class GlyphCache
+	{
+	  private:
+		static ImFontGlyphRangesBuilder resident;
+		static size_t residentCount;
+		static bool dirty;
+
+		static void request(ImWchar c);
+
+	  public:
+		static void request(std::string_view text);
+
+		/// Requests every string of a language, including the ones it takes from its fallback
+		static void request(const Language& language);
+
+		/// True when characters were requested since the ranges were last built
+		static bool isDirty();
+
+		/// Writes the ranges of every resident character for ImFontAtlas::AddFont
+		static void buildRanges(ImVector<ImWchar>& ranges);
+		static size_t getResidentCount();
+	};
+}
@@ -1,38 +1,306 @@
 #include "HistoryManager.h"
+#include "MemoryTracker.h"
+#include <algorithm>
 
 namespace MikuMikuWorld
 {
-	Score HistoryManager::undo()
+	static size_t getHistoryMemoryUsage(const History& history)
 	{
-		History history = undoHistory.top();
-		redoHistory.push(history);
-		undoHistory.pop();
+		size_t bytes = getMemoryUsage(history.description);
+		if (history.prev)
+			bytes += getMemoryUsage(*history.prev);
+
+		if (history.curr)
+			bytes += getMemoryUsage(*history.curr);
+
+		const ScoreDelta& delta = history.delta;
+		bytes += getMemoryUsage(delta.notes) + getMemoryUsage(delta.holdNotes) +
+		         getMemoryUsage(delta.hiSpeedChanges);
+
+		for (const auto& change : delta.holdNotes)
+		{
+			if (change.before)
+				bytes += getMemoryUsage(*change.before);
+
+			if (change.after)
+				bytes += getMemoryUsage(*change.after);
+		}
+
+		for (const auto* tempoChanges : { &delta.tempoChangesBefore, &delta.tempoChangesAfter })
+		{
+			if (*tempoChanges)
+				bytes += getMemoryUsage(**tempoChanges);
+		}
 
-		return history.prev;
+		for (const auto* timeSignatures :
+		     { &delta.timeSignaturesBefore, &delta.timeSignaturesAfter })
+		{
+			if (*timeSignatures)
+				bytes += getMemoryUsage(**timeSignatures);
+		}
+
+		return bytes;
 	}
 
-	Score HistoryManager::redo()
+	template <typename Map, typename T>
+	static void applyImages(Map& map, const std::vector<EntityChange<T>>& changes, bool undo)
 	{
-		History history = redoHistory.top();
-		undoHistory.push(history);
-		redoHistory.pop();
+		for (const auto& change : changes)
+		{
+			const std::optional<T>& image = undo ? change.before : change.after;
+			if (image)
+				map[change.id] = *image;
+			else
+				map.erase(change.id);
+		}
+	}
+
+	static bool isSameImage(const Note& a, const Note& b)
+	{
+		return a.getType() == b.getType() && a.ID == b.ID && a.parentID == b.parentID &&
+		       a.tick == b.tick && a.lane == b.lane && a.width == b.width &&
+		       a.critical == b.critical && a.friction == b.friction && a.flick == b.flick &&
+		       a.layer == b.layer;
+	}
+
+	static bool isSameStep(const HoldStep& a, const HoldStep& b)
+	{
+		return a.ID == b.ID && a.type == b.type && a.ease == b.ease;
+	}
+
+	static bool isSameImage(const HoldNote& a, const HoldNote& b)
+	{
+		return isSameStep(a.start, b.start) && a.end == b.end && a.startType == b.startType &&
+		       a.endType == b.endType && a.fadeType == b.fadeType &&
+		       a.guideColor == b.guideColor &&
+		       std::equal(a.steps.begin(), a.steps.end(), b.steps.begin(), b.steps.end(),
+		                  isSameStep);
+	}
+
+	static bool isSameImage(const HiSpeedChange& a, const HiSpeedChange& b)
+	{
+		return a.ID == b.ID && a.tick == b.tick && a.speed == b.speed && a.layer == b.layer;
+	}
+
+	static bool isSameTempoChanges(const std::vector<Tempo>& a, const std::vector<Tempo>& b)
+	{
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+		                  [](const Tempo& x, const Tempo& y)
+		                  { return x.tick == y.tick && x.bpm == y.bpm; });
+	}
+
+	static bool isSameTimeSignatures(const std::map<int, TimeSignature>& a,
+	                                 const std::map<int, TimeSignature>& b)
+	{
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+		                  [](const auto& x, const auto& y)
+		                  {
+			                  return x.first == y.first &&
+			                         x.second.measure == y.second.measure &&
+			                         x.second.numerator == y.second.numerator &&
+			                         x.second.denominator == y.second.denominator;
+		                  });
+	}
+
+	template <typename Map, typename T>
+	static std::vector<EntityChange<T>>
+	collectChanges(const Map& map, std::unordered_map<id_t, std::optional<T>>& before)
+	{
+		std::vector<EntityChange<T>> changes;
+		changes.reserve(before.size());
+		for (auto& [id, image] : before)
+		{
+			auto it = map.find(id);
+			std::optional<T> after;
+			if (it != map.end())
+				after = it->second;
+
+			// Created and deleted within the same edit, or touched but left unchanged
+			if (!image && !after)
+				continue;
+
+			if (image && after && isSameImage(*image, *after))
+				continue;
+
+			changes.push_back({ id, std::move(image), std::move(after) });
+		}
+
+		return changes;
+	}
+
+	bool ScoreDelta::isEmpty() const
+	{
+		return notes.empty() && holdNotes.empty() && hiSpeedChanges.empty() &&
+		       !tempoChangesBefore && !timeSignaturesBefore;
+	}
+
+	void ScoreDelta::apply(Score& score, bool undo) const
+	{
+		applyImages(score.notes, notes, undo);
+		applyImages(score.holdNotes, holdNotes, undo);
+		applyImages(score.hiSpeedChanges, hiSpeedChanges, undo);
+
+		if (tempoChangesBefore)
+			score.tempoChanges = undo ? *tempoChangesBefore : *tempoChangesAfter;
+
+		if (timeSignaturesBefore)
+			score.timeSignatures = undo ? *timeSignaturesBefore : *timeSignaturesAfter;
+	}
+
+	void EditTransaction::begin()
+	{
+		discard();
+		active = true;
+	}
 
-		return history.curr;
+	void EditTransaction::discard()
+	{
+		notes.clear();
+		holdNotes.clear();
+		hiSpeedChanges.clear();
+		tempoChanges.reset();
+		timeSignatures.reset();
+		active = false;
+	}
+
+	ScoreDelta EditTransaction::commit(const Score& score)
+	{
+		ScoreDelta delta{};
+		delta.notes = collectChanges(score.notes, notes);
+		delta.holdNotes = collectChanges(score.holdNotes, holdNotes);
+		delta.hiSpeedChanges = collectChanges(score.hiSpeedChanges, hiSpeedChanges);
+		if (tempoChanges && !isSameTempoChanges(*tempoChanges, score.tempoChanges))
+		{
+			delta.tempoChangesBefore = std::move(tempoChanges);
+			delta.tempoChangesAfter = score.tempoChanges;
+		}
+
+		if (timeSignatures && !isSameTimeSignatures(*timeSignatures, score.timeSignatures))
+		{
+			delta.timeSignaturesBefore = std::move(timeSignatures);
+			delta.timeSignaturesAfter = score.timeSignatures;
+		}
+
+		discard();
+		return delta;
+	}
+
+	void EditTransaction::touchNote(const Score& score, id_t id)
+	{
+		if (notes.find(id) != notes.end())
+			return;
+
+		auto it = score.notes.find(id);
+		notes[id] = it != score.notes.end() ? std::optional<Note>{ it->second } : std::nullopt;
+	}
+
+	void EditTransaction::touchHold(const Score& score, id_t id)
+	{
+		if (holdNotes.find(id) != holdNotes.end())
+			return;
+
+		auto it = score.holdNotes.find(id);
+		if (it == score.holdNotes.end())
+		{
+			holdNotes[id] = std::nullopt;
+			return;
+		}
+
+		const HoldNote& hold = it->second;
+		holdNotes[id] = hold;
+		touchNote(score, hold.start.ID);
+		touchNote(score, hold.end);
+		for (const HoldStep& step : hold.steps)
+			touchNote(score, step.ID);
+	}
+
+	void EditTransaction::touchHiSpeed(const Score& score, id_t id)
+	{
+		if (hiSpeedChanges.find(id) != hiSpeedChanges.end())
+			return;
+
+		auto it = score.hiSpeedChanges.find(id);
+		hiSpeedChanges[id] =
+		    it != score.hiSpeedChanges.end() ? std::optional<HiSpeedChange>{ it->second }
+		                                     : std::nullopt;
+	}
+
+	void EditTransaction::touchTempoChanges(const Score& score)
+	{
+		if (!tempoChanges)
+			tempoChanges = score.tempoChanges;
+	}
+
+	void EditTransaction::touchTimeSignatures(const Score& score)
+	{
+		if (!timeSignatures)
+			timeSignatures = score.timeSignatures;
+	}
+
+	const History& HistoryManager::undo(Score& score)
+	{
+		History& history = undoHistory.top();
+		if (history.prev)
+			score = *history.prev;
+		else
+			history.delta.apply(score, true);
+
+		redoHistory.push(std::move(history));
+		undoHistory.pop();
+		return redoHistory.top();
+	}
+
+	const History& HistoryManager::redo(Score& score)
+	{
+		History& history = redoHistory.top();
+		if (history.curr)
+			score = *history.curr;
+		else
+			history.delta.apply(score, false);
+
+		undoHistory.push(std::move(history));
+		redoHistory.pop();
+		return undoHistory.top();
 	}
 
 	void HistoryManager::pushHistory(const std::string& description, const Score& prev,
 	                                 const Score& curr)
 	{
-		History history{ description, prev, curr };
-		pushHistory(history);
+		History history;
+		history.description = description;
+		history.prev = prev;
+		history.curr = curr;
+		pushHistory(std::move(history));
+	}
+
+	void HistoryManager::pushHistory(const std::string& description, ScoreDelta delta)
+	{
+		if (delta.isEmpty())
+			return;
+
+		History history;
+		history.description = description;
+		history.delta = std::move(delta);
+		pushHistory(std::move(history));
 	}
 
-	void HistoryManager::pushHistory(const History& history)
+	void HistoryManager::pushHistory(History history)
 	{
-		undoHistory.push(history);
+		const size_t bytes = getHistoryMemoryUsage(history);
+		memoryUsage += bytes;
+		MemoryTracker::add(MemoryCategory::History, bytes);
+		undoHistory.push(std::move(history));
 
 		while (!redoHistory.empty())
-			redoHistory.pop();
+			popRedo();
+	}
+
+	void HistoryManager::popRedo()
+	{
+		const size_t bytes = getHistoryMemoryUsage(redoHistory.top());
+		memoryUsage -= bytes;
+		MemoryTracker::remove(MemoryCategory::History, bytes);
+		redoHistory.pop();
 	}
 
 	void HistoryManager::clear()
@@ -42,6 +310,9 @@ namespace MikuMikuWorld
 
 		while (!redoHistory.empty())
 			redoHistory.pop();
+
+		MemoryTracker::remove(MemoryCategory::History, memoryUsage);
+		memoryUsage = 0;
 	}
 
 	bool HistoryManager::hasUndo() const { return undoHistory.size(); }
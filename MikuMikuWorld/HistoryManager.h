@@ -1,17 +1,68 @@
 #pragma once
 #include <stack>
 #include <map>
+#include <optional>
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include "Score.h"
 
 namespace MikuMikuWorld
 {
+	/// Before and after images of one entity. An empty image means the entity did not exist.
+	template <typename T> struct EntityChange
+	{
+		id_t id;
+		std::optional<T> before;
+		std::optional<T> after;
+	};
+
+	/// The entities changed by one edit, enough to move the score either way across it
+	struct ScoreDelta
+	{
+		std::vector<EntityChange<Note>> notes;
+		std::vector<EntityChange<HoldNote>> holdNotes;
+		std::vector<EntityChange<HiSpeedChange>> hiSpeedChanges;
+		std::optional<std::vector<Tempo>> tempoChangesBefore, tempoChangesAfter;
+		std::optional<std::map<int, TimeSignature>> timeSignaturesBefore, timeSignaturesAfter;
+
+		/// Whether the edit changed nothing, commit drops touched entities that are unchanged
+		bool isEmpty() const;
+		void apply(Score& score, bool undo) const;
+	};
+
+	/// Either a pair of full score snapshots or a delta of the touched entities
 	struct History
 	{
 		std::string description;
-		Score prev;
-		Score curr;
+		std::optional<Score> prev;
+		std::optional<Score> curr;
+		ScoreDelta delta{};
+	};
+
+	/// Records before-images of the entities an edit touches so the history only keeps those
+	/// instead of two copies of the whole score
+	class EditTransaction
+	{
+	  private:
+		std::unordered_map<id_t, std::optional<Note>> notes;
+		std::unordered_map<id_t, std::optional<HoldNote>> holdNotes;
+		std::unordered_map<id_t, std::optional<HiSpeedChange>> hiSpeedChanges;
+		std::optional<std::vector<Tempo>> tempoChanges;
+		std::optional<std::map<int, TimeSignature>> timeSignatures;
+		bool active{ false };
+
+	  public:
+		void begin();
+		void discard();
+		ScoreDelta commit(const Score& score);
+		bool isActive() const { return active; }
+
+		void touchNote(const Score& score, id_t id);
+		void touchHold(const Score& score, id_t id);
+		void touchHiSpeed(const Score& score, id_t id);
+		void touchTempoChanges(const Score& score);
+		void touchTimeSignatures(const Score& score);
 	};
 
 	class HistoryManager
@@ -19,20 +70,28 @@ namespace MikuMikuWorld
 	  private:
 		std::stack<History> undoHistory;
 		std::stack<History> redoHistory;
+		size_t memoryUsage{};
+
+		void popRedo();
 
 	  public:
-		Score undo();
-		Score redo();
+		/// Moves the score across the top entry and returns that entry
+		const History& undo(Score& score);
+		const History& redo(Score& score);
 
 		int undoCount() const;
 		int redoCount() const;
 		std::string peekUndo() const;
 		std::string peekRedo() const;
 
-		void pushHistory(const History& history);
+		void pushHistory(History history);
 		void pushHistory(const std::string& description, const Score& prev, const Score& curr);
+		void pushHistory(const std::string& description, ScoreDelta delta);
 		void clear();
 		bool hasUndo() const;
 		bool hasRedo() const;
+
+		/// Estimated bytes held by the undo and redo entries
+		size_t getMemoryUsage() const { return memoryUsage; }
 	};
 }
\ No newline at end of file
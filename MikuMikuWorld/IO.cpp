@@ -1,9 +1,19 @@
 #include "IO.h"
-#include <Windows.h>
 #include <algorithm>
+#include <cctype>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <share.h>
+#else
+#include <codecvt>
+#include <iostream>
+#include <locale>
+#endif
 
 namespace IO
 {
+#ifdef _WIN32
 	MessageBoxResult messageBox(std::string title, std::string message, MessageBoxButtons buttons,
 	                            MessageBoxIcon icon, void* parentWindow)
 	{
@@ -65,6 +75,16 @@ namespace IO
 			return MessageBoxResult::None;
 		}
 	}
+#else
+	MessageBoxResult messageBox(std::string title, std::string message, MessageBoxButtons buttons,
+	                            [[maybe_unused]] MessageBoxIcon icon,
+	                            [[maybe_unused]] void* parentWindow)
+	{
+		// Without a desktop there is nobody to answer, so report and take the safe choice
+		std::cerr << title << ": " << message << std::endl;
+		return buttons == MessageBoxButtons::Ok ? MessageBoxResult::Ok : MessageBoxResult::Cancel;
+	}
+#endif
 
 	char* reverse(char* str)
 	{
@@ -131,7 +151,8 @@ namespace IO
 		if (str.empty())
 			return false;
 
-		return std::all_of(str.begin() + (str.at(0) == '-' ? 1 : 0), str.end(), std::isdigit);
+		return std::all_of(str.begin() + (str.at(0) == '-' ? 1 : 0), str.end(),
+		                   [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; });
 	}
 
 	std::string trim(const std::string& line)
@@ -172,6 +193,7 @@ namespace IO
 		return values;
 	}
 
+#ifdef _WIN32
 	std::string wideStringToMb(const std::wstring& str)
 	{
 		int size = WideCharToMultiByte(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0, NULL, NULL);
@@ -190,8 +212,117 @@ namespace IO
 		return wResult;
 	}
 
+	FILE* openFileStream(const std::wstring& filename, const wchar_t* mode)
+	{
+		return _wfopen(filename.c_str(), mode);
+	}
+
+	FILE* openSharedFileStream(const std::wstring& filename, const wchar_t* mode, bool denyWrite)
+	{
+		return _wfsopen(filename.c_str(), mode, denyWrite ? _SH_DENYWR : _SH_DENYNO);
+	}
+#else
+	std::string wideStringToMb(const std::wstring& str)
+	{
+		std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+		return converter.to_bytes(str);
+	}
+
+	std::wstring mbToWideStr(const std::string& str)
+	{
+		std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+		return converter.from_bytes(str);
+	}
+
+	FILE* openFileStream(const std::wstring& filename, const wchar_t* mode)
+	{
+		std::string mbMode(mode, mode + wcslen(mode));
+		return fopen(wideStringToMb(filename).c_str(), mbMode.c_str());
+	}
+
+	FILE* openSharedFileStream(const std::wstring& filename, const wchar_t* mode,
+	                           [[maybe_unused]] bool denyWrite)
+	{
+		return openFileStream(filename, mode);
+	}
+#endif
+
 	std::string concat(const char* s1, const char* s2, const char* join)
 	{
 		return std::string(s1).append(join).append(s2);
 	}
+
+	constexpr const char base64Digits[] =
+	    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	std::string base64Encode(const std::string_view& data)
+	{
+		std::string text;
+		text.reserve((data.size() + 2) / 3 * 4);
+
+		size_t i = 0;
+		for (; i + 2 < data.size(); i += 3)
+		{
+			uint32_t block =
+			    (uint8_t)data[i] << 16 | (uint8_t)data[i + 1] << 8 | (uint8_t)data[i + 2];
+			text.push_back(base64Digits[(block >> 18) & 0x3f]);
+			text.push_back(base64Digits[(block >> 12) & 0x3f]);
+			text.push_back(base64Digits[(block >> 6) & 0x3f]);
+			text.push_back(base64Digits[block & 0x3f]);
+		}
+
+		size_t remaining = data.size() - i;
+		if (remaining)
+		{
+			uint32_t block = (uint8_t)data[i] << 16;
+			if (remaining == 2)
+				block |= (uint8_t)data[i + 1] << 8;
+
+			text.push_back(base64Digits[(block >> 18) & 0x3f]);
+			text.push_back(base64Digits[(block >> 12) & 0x3f]);
+			text.push_back(remaining == 2 ? base64Digits[(block >> 6) & 0x3f] : '=');
+			text.push_back('=');
+		}
+
+		return text;
+	}
+
+	bool base64Decode(const std::string_view& text, std::string& data)
+	{
+		int8_t values[256];
+		std::fill(std::begin(values), std::end(values), -1);
+		for (int i = 0; i < 64; ++i)
+			values[(uint8_t)base64Digits[i]] = i;
+
+		data.clear();
+		data.reserve(text.size() / 4 * 3);
+
+		uint32_t block = 0;
+		int bits = 0;
+		for (char c : text)
+		{
+			if (c == '=' || c == '\r' || c == '\n')
+				continue;
+
+			int8_t value = values[(uint8_t)c];
+			if (value < 0)
+				return false;
+
+			block = block << 6 | value;
+			bits += 6;
+			if (bits >= 8)
+			{
+				bits -= 8;
+				data.push_back((char)((block >> bits) & 0xff));
+			}
+		}
+
+		return true;
+	}
+
+#ifdef _WIN32
+	uint32_t getClipboardSequenceNumber() { return GetClipboardSequenceNumber(); }
+#else
+	uint32_t getClipboardSequenceNumber() { return 0; }
+#endif
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <cstdio>
 #include <string>
 #include <vector>
 #include <stdexcept>
@@ -54,8 +55,22 @@ namespace IO
 	std::wstring mbToWideStr(const std::string& str);
 	std::wstring ansiMbToWideStr(const std::string& str);
 
+	/// fopen taking a wide filename so non-ASCII paths open on every platform
+	FILE* openFileStream(const std::wstring& filename, const wchar_t* mode);
+
+	/// openFileStream that can deny other handles write access while the stream is open.
+	/// Elsewhere than on Windows the file is opened without any sharing restriction.
+	FILE* openSharedFileStream(const std::wstring& filename, const wchar_t* mode, bool denyWrite);
+
 	std::string concat(const char* s1, const char* s2, const char* join = "");
 
+	std::string base64Encode(const std::string_view& data);
+	bool base64Decode(const std::string_view& text, std::string& data);
+
+	/// Changes every time the system clipboard contents are replaced.
+	/// Always 0 on platforms without a clipboard sequence number.
+	uint32_t getClipboardSequenceNumber();
+
 	template <typename... Args> std::string formatString(const char* format, Args... args)
 	{
 		size_t length = std::snprintf(nullptr, 0, format, args...) + 1;
@@ -5,6 +5,9 @@
 #include "../Depends/glad/include/glad/glad.h"
 #include "../Depends/GLFW/include/GLFW/glfw3.h"
 #include "File.h"
+#include "GlyphCache.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
 #include "UI.h"
 #include "Utilities.h"
 #include "IconsFontAwesome5.h"
@@ -12,11 +15,24 @@
 
 namespace MikuMikuWorld
 {
+	static void* imguiAlloc(size_t size, void*)
+	{
+		return MemoryTracker::allocate(MemoryCategory::ImGui, size);
+	}
+
+	static void imguiFree(void* block, void*)
+	{
+		MemoryTracker::deallocate(MemoryCategory::ImGui, block);
+	}
+
 	ImGuiManager::ImGuiManager() {}
 
 	Result ImGuiManager::initialize(GLFWwindow* window)
 	{
 		IMGUI_CHECKVERSION();
+
+		// Must be set before the context is created. The font atlas is most of what ImGui holds
+		ImGui::SetAllocatorFunctions(imguiAlloc, imguiFree);
 		ImGui::CreateContext();
 
 		configFilename = Application::getAppDir() + IMGUI_CONFIG_FILENAME;
@@ -150,6 +166,7 @@ namespace MikuMikuWorld
 
 	void ImGuiManager::begin()
 	{
+		PROFILE_SCOPE("ImGuiManager::begin");
 		ImGui_ImplOpenGL3_NewFrame();
 		ImGui_ImplGlfw_NewFrame();
 		ImGui::NewFrame();
@@ -164,6 +181,7 @@ namespace MikuMikuWorld
 
 	void ImGuiManager::draw(GLFWwindow* window)
 	{
+		PROFILE_SCOPE("ImGuiManager::draw");
 		ImGui::Render();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
@@ -178,29 +196,32 @@ namespace MikuMikuWorld
 
 	void ImGuiManager::loadFont(const std::string& filename, float size)
 	{
-		if (!IO::File::exists(filename))
+		// The font file is kept in memory so rebuilding the atlas does not read it again
+		if (filename != fontFilename)
+		{
+			if (!IO::File::exists(filename))
+				return;
+
+			IO::File file(filename, "rb");
+			MemoryTracker::remove(MemoryCategory::ImGui, fontData.size());
+			fontData = file.readAllBytes();
+			fontFilename = filename;
+			MemoryTracker::add(MemoryCategory::ImGui, fontData.size());
+		}
+
+		if (fontData.empty())
 			return;
 
 		static ImFontConfig fontConfig{};
 		fontConfig.PixelSnapH = true;
 		fontConfig.OversampleH = 1;
 		fontConfig.RasterizerMultiply = 1.05f;
+		fontConfig.FontDataOwnedByAtlas = false;
 
-		ImFontGlyphRangesBuilder rangeBuilder;
-		static ImVector<ImWchar> ranges;
-		rangeBuilder.AddRanges(ImGui::GetIO().Fonts->GetGlyphRangesDefault());
-		rangeBuilder.AddRanges(ImGui::GetIO().Fonts->GetGlyphRangesJapanese());
-		rangeBuilder.AddRanges(ImGui::GetIO().Fonts->GetGlyphRangesKorean());
-		rangeBuilder.AddRanges(ImGui::GetIO().Fonts->GetGlyphRangesCyrillic());
-		rangeBuilder.AddRanges(ImGui::GetIO().Fonts->GetGlyphRangesVietnamese());
-		// rangeBuilder.AddRanges(ImGui::GetIO().Fonts->GetGlyphRangesChineseFull());
-		// rangeBuilder.AddRanges(ImGui::GetIO().Fonts->GetGlyphRangesThai());
-		// rangeBuilder.AddRanges(ImGui::GetIO().Fonts->GetGlyphRangesGreek());
-		rangeBuilder.BuildRanges(&ranges);
-
-		auto font = ImGui::GetIO().Fonts->AddFontFromFileTTF(filename.c_str(), (int)size,
-		                                                     &fontConfig, ranges.Data);
-		ImGui::GetIO().Fonts->Build();
+		// Only the resident glyphs are rasterized, see GlyphCache
+		ImGui::GetIO().Fonts->AddFontFromMemoryTTF(fontData.data(),
+		                                           static_cast<int>(fontData.size()), (int)size,
+		                                           &fontConfig, glyphRanges.Data);
 	}
 
 	void ImGuiManager::loadIconFont(const std::string& filename, int start, int end, float size)
@@ -219,6 +240,15 @@ namespace MikuMikuWorld
 	}
 
 	void ImGuiManager::buildFonts(float dpiScale)
+	{
+		updateGlyphRanges();
+		rasterizeFonts(dpiScale);
+		uploadFonts();
+	}
+
+	void ImGuiManager::updateGlyphRanges() { GlyphCache::buildRanges(glyphRanges); }
+
+	void ImGuiManager::rasterizeFonts(float dpiScale)
 	{
 		// clear existing fonts on rebuild
 		ImGuiIO& io = ImGui::GetIO();
@@ -230,7 +260,22 @@ namespace MikuMikuWorld
 		loadFont(Application::getAppDir() + "res/fonts/NotoSansCJK-Regular.ttc", 16 * dpiScale);
 		loadIconFont(Application::getAppDir() + "res/fonts/fa-solid-900.ttf", ICON_MIN_FA,
 		             ICON_MAX_FA, 12 * dpiScale);
+
+		// The backend converts to RGBA when uploading, do it here so the upload is only the copy
+		unsigned char* pixels{};
+		int width{}, height{};
+		io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+	}
+
+	void ImGuiManager::uploadFonts()
+	{
+		ImGuiIO& io = ImGui::GetIO();
+		ImGui_ImplOpenGL3_DestroyFontsTexture();
 		ImGui_ImplOpenGL3_CreateFontsTexture();
+
+		MemoryTracker::remove(MemoryCategory::Textures, fontTextureBytes);
+		fontTextureBytes = static_cast<size_t>(io.Fonts->TexWidth) * io.Fonts->TexHeight * 4;
+		MemoryTracker::add(MemoryCategory::Textures, fontTextureBytes);
 	}
 
 	void ImGuiManager::initializeLayout()
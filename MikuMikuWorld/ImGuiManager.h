@@ -1,5 +1,6 @@
 #include "UI.h"
 #include <string>
+#include <vector>
 
 struct GLFWwindow;
 
@@ -15,6 +16,11 @@ namespace MikuMikuWorld
 		BaseTheme theme{};
 		int accentColor{ 1 };
 		float styleScale{ 1.0f };
+		size_t fontTextureBytes{};
+
+		std::string fontFilename{};
+		std::vector<uint8_t> fontData{};
+		ImVector<ImWchar> glyphRanges{};
 
 	  public:
 		ImGuiManager();
@@ -26,6 +32,14 @@ namespace MikuMikuWorld
 		void loadFont(const std::string& filename, float size);
 		void loadIconFont(const std::string& filename, int start, int end, float size);
 		void buildFonts(float dpiScale = 1.0f);
+
+		/// Takes the characters requested from GlyphCache so far for the next rasterizeFonts
+		void updateGlyphRanges();
+
+		/// Builds the font atlas pixels without touching GL, so it can run on a worker while
+		/// nothing else uses ImGui
+		void rasterizeFonts(float dpiScale);
+		void uploadFonts();
 		void draw(GLFWwindow* window);
 
 		void setBaseTheme(BaseTheme theme);
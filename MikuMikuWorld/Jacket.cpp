@@ -2,6 +2,7 @@
 #include "ResourceManager.h"
 #include "ImGuiManager.h"
 #include "File.h"
+#include "GlyphCache.h"
 #include "Math.h"
 #include <algorithm>
 
@@ -16,6 +17,8 @@ namespace MikuMikuWorld
 	void Jacket::load(const std::string& filename)
 	{
 		this->filename = filename;
+		GlyphCache::request(filename);
+		loader.cancel();
 		if (texture)
 		{
 			texture->dispose();
@@ -25,11 +28,13 @@ namespace MikuMikuWorld
 		if (filename.empty() || !IO::File::exists(filename))
 			return;
 
-		texture = std::make_unique<Texture>(filename);
+		// Nothing larger than the preview is ever shown
+		loader.load(filename, static_cast<int>(imageSize.x), static_cast<int>(imageSize.y));
 	}
 
 	void Jacket::clear()
 	{
+		loader.cancel();
 		if (texture)
 		{
 			texture->dispose();
@@ -41,7 +46,11 @@ namespace MikuMikuWorld
 
 	void Jacket::draw()
 	{
-		if (texture == nullptr)
+		ImageData image;
+		if (loader.poll(image) && image.isValid())
+			texture = std::make_unique<Texture>(filename, image);
+
+		if (texture == nullptr && !loader.isLoading())
 			return;
 
 		if (ImGui::IsItemHovered() && GImGui->HoveredIdTimer > 0.3f)
@@ -55,10 +64,19 @@ namespace MikuMikuWorld
 			ImGui::SetNextWindowBgAlpha(color.w);
 
 			ImGui::BeginTooltip();
-			ImGui::GetWindowDrawList()->AddImage(
-			    (void*)texture->getID(), ImGui::GetWindowPos() + imageOffset,
-			    ImGui::GetWindowPos() + imageOffset + imageSize, ImVec2{ 0.0, 0.0f },
-			    ImVec2{ 1.0f, 1.0f }, ImGui::ColorConvertFloat4ToU32(color));
+			const ImVec2 imagePos = ImGui::GetWindowPos() + imageOffset;
+			if (texture)
+			{
+				ImGui::GetWindowDrawList()->AddImage(
+				    (void*)texture->getID(), imagePos, imagePos + imageSize, ImVec2{ 0.0, 0.0f },
+				    ImVec2{ 1.0f, 1.0f }, ImGui::ColorConvertFloat4ToU32(color));
+			}
+			else
+			{
+				// Placeholder while the image is still decoding
+				ImGui::GetWindowDrawList()->AddRectFilled(
+				    imagePos, imagePos + imageSize, ImGui::GetColorU32(ImGuiCol_FrameBg, color.w));
+			}
 			ImGui::EndTooltip();
 		}
 	}
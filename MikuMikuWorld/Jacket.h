@@ -1,4 +1,5 @@
 #pragma once
+#include "Rendering/ImageLoader.h"
 #include "Rendering/Texture.h"
 #include "ImGui/imgui.h"
 #include <memory>
@@ -11,10 +12,12 @@ namespace MikuMikuWorld
 	  private:
 		std::string filename;
 		std::unique_ptr<Texture> texture;
+		ImageLoader loader;
 
 	  public:
 		Jacket();
 
+		/// Decodes the image in the background, draw shows a placeholder until it is uploaded
 		void load(const std::string& filename);
 		void draw();
 		void clear();
@@ -0,0 +1,361 @@
+#include "JobSystem.h"
+#include "IO.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	constexpr size_t jobPriorityCount = static_cast<size_t>(JobPriority::JobPriorityCount);
+	constexpr size_t notWorker = SIZE_MAX;
+
+	struct QueuedJob
+	{
+		JobSystem::Job job;
+		std::shared_ptr<CancellationToken::State> token;
+		JobGroup* group{};
+	};
+
+	/// The owning worker pushes and pops at the back, thieves take from the front so they get the
+	/// oldest and usually largest piece of work
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<QueuedJob> jobs[jobPriorityCount];
+	};
+
+	static std::vector<std::unique_ptr<WorkerQueue>> queues;
+	static std::vector<std::thread> workers;
+	static std::atomic<size_t> queuedJobs[jobPriorityCount]{};
+	static std::atomic<size_t> nextQueue{};
+	static std::atomic<bool> stopping{};
+
+	static std::mutex sleepMutex;
+	static std::condition_variable sleepCondition;
+
+	/// Wakes group waiters when a job is queued or a group finishes. Uses sleepMutex.
+	static std::condition_variable waitCondition;
+
+	static std::mutex mainThreadMutex;
+	static std::vector<JobSystem::Job> mainThreadJobs;
+	static void (*mainThreadWakeup)(){};
+
+	static thread_local size_t workerIndex = notWorker;
+
+	static bool popJob(WorkerQueue& queue, size_t priority, bool back, QueuedJob& job)
+	{
+		std::lock_guard lock{ queue.mutex };
+		std::deque<QueuedJob>& jobs = queue.jobs[priority];
+		if (jobs.empty())
+			return false;
+
+		if (back)
+		{
+			job = std::move(jobs.back());
+			jobs.pop_back();
+		}
+		else
+		{
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		queuedJobs[priority].fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	static bool hasQueuedJobs(JobPriority lowest)
+	{
+		for (size_t priority = 0; priority <= static_cast<size_t>(lowest); ++priority)
+		{
+			if (queuedJobs[priority].load(std::memory_order_relaxed) > 0)
+				return true;
+		}
+
+		return false;
+	}
+
+	/// Takes the most urgent job, preferring the calling worker's own queue within a priority
+	static bool takeJob(QueuedJob& job, JobPriority lowest)
+	{
+		const size_t count = queues.size();
+		if (count == 0 || !hasQueuedJobs(lowest))
+			return false;
+
+		const size_t own = workerIndex;
+		for (size_t priority = 0; priority <= static_cast<size_t>(lowest); ++priority)
+		{
+			if (own != notWorker && popJob(*queues[own], priority, true, job))
+				return true;
+
+			const size_t start = own != notWorker ? own + 1 : 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				const size_t victim = (start + i) % count;
+				if (victim != own && popJob(*queues[victim], priority, false, job))
+					return true;
+			}
+		}
+
+		return false;
+	}
+
+	void JobSystem::runJob(QueuedJob& job)
+	{
+		if (!job.token || !job.token->cancelled.load(std::memory_order_relaxed))
+		{
+			PROFILE_SCOPE("Job");
+			try
+			{
+				job.job();
+			}
+			catch (...)
+			{
+				failJob(job, std::current_exception());
+			}
+		}
+
+		if (job.group)
+			finishGroupJob(*job.group);
+	}
+
+	void JobSystem::failJob(QueuedJob& job, std::exception_ptr exception)
+	{
+		if (job.group)
+		{
+			std::lock_guard lock{ job.group->exceptionMutex };
+			if (!job.group->exception)
+				job.group->exception = exception;
+		}
+		else if (job.token)
+		{
+			std::lock_guard lock{ job.token->mutex };
+			if (!job.token->exception)
+				job.token->exception = exception;
+		}
+		else
+		{
+			// Nobody waits for the job, so only log what went wrong
+			try
+			{
+				std::rethrow_exception(exception);
+			}
+			catch (const std::exception& error)
+			{
+				std::cerr << "Background job failed: " << error.what() << std::endl;
+			}
+			catch (...)
+			{
+				std::cerr << "Background job failed" << std::endl;
+			}
+		}
+	}
+
+	void JobSystem::finishGroupJob(JobGroup& group)
+	{
+		// The waiter may destroy the group as soon as the count reaches zero
+		if (group.pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+
+		// Taking the lock makes sure a waiter that saw unfinished jobs is already asleep
+		{
+			std::lock_guard lock{ sleepMutex };
+		}
+		waitCondition.notify_all();
+	}
+
+	void JobSystem::workerLoop(size_t index)
+	{
+		workerIndex = index;
+		Profiler::setThreadName(IO::formatString("Worker %zu", index + 1));
+
+		while (!stopping.load(std::memory_order_relaxed))
+		{
+			QueuedJob job;
+			if (takeJob(job, JobPriority::Low))
+			{
+				runJob(job);
+				continue;
+			}
+
+			std::unique_lock lock{ sleepMutex };
+			sleepCondition.wait(lock,
+			                    []
+			                    {
+				                    return stopping.load(std::memory_order_relaxed) ||
+				                           hasQueuedJobs(JobPriority::Low);
+			                    });
+		}
+	}
+
+	void JobSystem::pushJob(QueuedJob&& job, JobPriority priority)
+	{
+		if (job.group)
+		{
+			job.group->pending.fetch_add(1, std::memory_order_relaxed);
+
+			std::atomic<uint8_t>& lowest = job.group->lowestPriority;
+			uint8_t current = lowest.load(std::memory_order_relaxed);
+			while (static_cast<uint8_t>(priority) > current &&
+			       !lowest.compare_exchange_weak(current, static_cast<uint8_t>(priority),
+			                                     std::memory_order_relaxed))
+			{
+			}
+		}
+
+		if (queues.empty())
+		{
+			runJob(job);
+			return;
+		}
+
+		// Work spawned by a worker stays local until another worker steals it
+		size_t index = workerIndex;
+		if (index == notWorker)
+			index = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+		{
+			WorkerQueue& queue = *queues[index];
+			std::lock_guard lock{ queue.mutex };
+			queuedJobs[static_cast<size_t>(priority)].fetch_add(1, std::memory_order_relaxed);
+			queue.jobs[static_cast<size_t>(priority)].push_back(std::move(job));
+		}
+
+		// Taking the lock orders the new count before a worker that is about to sleep checks it
+		{
+			std::lock_guard lock{ sleepMutex };
+		}
+		sleepCondition.notify_one();
+		waitCondition.notify_all();
+	}
+
+	void JobGroup::wait()
+	{
+		auto lowest = [this]
+		{ return static_cast<JobPriority>(lowestPriority.load(std::memory_order_relaxed)); };
+
+		while (!isDone())
+		{
+			if (JobSystem::runPendingJob(lowest()))
+				continue;
+
+			// Nothing to help with, sleep until the group finishes or another job is queued
+			std::unique_lock lock{ sleepMutex };
+			waitCondition.wait(lock, [&] { return isDone() || hasQueuedJobs(lowest()); });
+		}
+
+		std::exception_ptr failure;
+		{
+			std::lock_guard lock{ exceptionMutex };
+			std::swap(failure, exception);
+		}
+
+		if (failure)
+			std::rethrow_exception(failure);
+	}
+
+	void JobSystem::initialize(size_t threadCount)
+	{
+		if (!workers.empty())
+			return;
+
+		if (threadCount == 0)
+			threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+		stopping.store(false, std::memory_order_relaxed);
+		for (size_t i = 0; i < threadCount; ++i)
+			queues.push_back(std::make_unique<WorkerQueue>());
+
+		for (size_t i = 0; i < threadCount; ++i)
+			workers.emplace_back(workerLoop, i);
+	}
+
+	void JobSystem::shutdown()
+	{
+		{
+			std::lock_guard lock{ sleepMutex };
+			stopping.store(true, std::memory_order_relaxed);
+		}
+		sleepCondition.notify_all();
+
+		for (std::thread& worker : workers)
+			worker.join();
+
+		// Jobs that never started still release anyone waiting on their group
+		for (auto& queue : queues)
+		{
+			for (auto& jobs : queue->jobs)
+			{
+				for (QueuedJob& job : jobs)
+				{
+					if (job.group)
+						finishGroupJob(*job.group);
+				}
+			}
+		}
+
+		workers.clear();
+		queues.clear();
+		for (auto& count : queuedJobs)
+			count.store(0, std::memory_order_relaxed);
+
+		std::lock_guard lock{ mainThreadMutex };
+		mainThreadJobs.clear();
+	}
+
+	size_t JobSystem::getThreadCount() { return workers.size(); }
+
+	void JobSystem::schedule(Job job, JobPriority priority, JobGroup* group)
+	{
+		pushJob({ std::move(job), nullptr, group }, priority);
+	}
+
+	void JobSystem::schedule(Job job, JobPriority priority, const CancellationToken& token,
+	                         JobGroup* group)
+	{
+		pushJob({ std::move(job), token.state, group }, priority);
+	}
+
+	bool JobSystem::runPendingJob(JobPriority lowest)
+	{
+		QueuedJob job;
+		if (!takeJob(job, lowest))
+			return false;
+
+		runJob(job);
+		return true;
+	}
+
+	void JobSystem::setMainThreadWakeup(void (*wakeup)()) { mainThreadWakeup = wakeup; }
+
+	void JobSystem::runOnMainThread(Job job)
+	{
+		{
+			std::lock_guard lock{ mainThreadMutex };
+			mainThreadJobs.push_back(std::move(job));
+		}
+
+		if (mainThreadWakeup)
+			mainThreadWakeup();
+	}
+
+	bool JobSystem::drainMainThread()
+	{
+		std::vector<Job> jobs;
+		{
+			std::lock_guard lock{ mainThreadMutex };
+			jobs.swap(mainThreadJobs);
+		}
+
+		// Functions queued while draining wait for the next frame
+		for (Job& job : jobs)
+			job();
+
+		return !jobs.empty();
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace MikuMikuWorld
+{
+	enum class JobPriority : uint8_t
+	{
+		High,
+		Normal,
+		Low,
+		JobPriorityCount
+	};
+
+	struct QueuedJob;
+
+	/// Lets the owner of a job stop it. Copies share the same flag, a job that is cancelled before
+	/// it starts is dropped and a running job may poll isCancelled to return early.
+	class CancellationToken
+	{
+	  private:
+		struct State
+		{
+			std::atomic<bool> cancelled{};
+			std::mutex mutex;
+			std::exception_ptr exception;
+		};
+
+		std::shared_ptr<State> state{ std::make_shared<State>() };
+
+		friend class JobSystem;
+		friend struct QueuedJob;
+
+	  public:
+		void cancel() { state->cancelled.store(true, std::memory_order_relaxed); }
+		bool isCancelled() const { return state->cancelled.load(std::memory_order_relaxed); }
+
+		/// Exception thrown by a job scheduled with this token outside of a group, if any
+		std::exception_ptr getException() const
+		{
+			std::lock_guard lock{ state->mutex };
+			return state->exception;
+		}
+	};
+
+	/// Counts the unfinished jobs scheduled with it
+	class JobGroup
+	{
+	  private:
+		std::atomic<size_t> pending{};
+		std::atomic<uint8_t> lowestPriority{};
+		std::mutex exceptionMutex;
+		std::exception_ptr exception;
+
+		friend class JobSystem;
+
+	  public:
+		bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+		/// Runs queued jobs on the calling thread until every job of the group has finished, and
+		/// sleeps while there is nothing to run. Jobs less urgent than the group's own are left
+		/// alone so a wait is not stuck behind them. Rethrows the first exception of a job.
+		void wait();
+	};
+
+	/// One bounded pool of worker threads shared by all background work. Every worker owns a
+	/// queue per priority that it takes new work from, idle workers steal the oldest job of another
+	/// worker's queue. Results that touch the UI are handed back with runOnMainThread.
+	class JobSystem
+	{
+	  private:
+		static void pushJob(QueuedJob&& job, JobPriority priority);
+		static void runJob(QueuedJob& job);
+		static void failJob(QueuedJob& job, std::exception_ptr exception);
+		static void finishGroupJob(JobGroup& group);
+		static void workerLoop(size_t index);
+
+	  public:
+		using Job = std::function<void()>;
+
+		/// Starts threadCount workers, or one less than the number of cores when 0
+		static void initialize(size_t threadCount = 0);
+
+		/// Drops the jobs that have not started and joins the workers
+		static void shutdown();
+
+		static size_t getThreadCount();
+
+		/// Queues a job for the workers. Without workers the job runs on the calling thread.
+		/// An exception thrown by the job goes to its group, or else its token. A job with neither
+		/// has nobody to report to, so the exception is logged.
+		static void schedule(Job job, JobPriority priority = JobPriority::Normal,
+		                     JobGroup* group = nullptr);
+		static void schedule(Job job, JobPriority priority, const CancellationToken& token,
+		                     JobGroup* group = nullptr);
+
+		/// Runs function on every element in parallel and returns once all of them are done
+		template <typename It, typename Function>
+		static void forEach(It first, It last, Function function,
+		                    JobPriority priority = JobPriority::High)
+		{
+			JobGroup group;
+			for (It it = first; it != last; ++it)
+				schedule([&function, it] { function(*it); }, priority, &group);
+
+			group.wait();
+		}
+
+		/// Runs one queued job of at least the given priority on the calling thread. Returns false
+		/// if there was none.
+		static bool runPendingJob(JobPriority lowest = JobPriority::Low);
+
+		/// Called whenever a function is queued for the main thread, so an idle main loop wakes up
+		static void setMainThreadWakeup(void (*wakeup)());
+
+		/// Queues a function for the next drainMainThread call
+		static void runOnMainThread(Job job);
+
+		/// Runs the functions queued by runOnMainThread. Called once per frame by the main loop.
+		/// Returns true if any function ran.
+		static bool drainMainThread();
+	};
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "Math.h"
+#include "NoteSelection.h"
 #include "Score.h"
 #include <json.hpp>
 #include <unordered_set>
@@ -54,7 +55,7 @@ namespace jsonIO
 	nlohmann::json noteToJson(const mmw::Note& note);
 
 	nlohmann::json noteSelectionToJson(const mmw::Score& score,
-	                                   const std::unordered_set<mmw::id_t>& selection,
+	                                   const mmw::NoteSelection& selection,
 	                                   const std::unordered_set<mmw::id_t>& hiSpeedSelection,
 	                                   int baseTick);
 }
@@ -1,14 +1,14 @@
 #include "Language.h"
+#include "Localization.h"
 #include "IO.h"
 #include "File.h"
+#include <algorithm>
 #include <iostream>
 
 using namespace IO;
 
 namespace MikuMikuWorld
 {
-	static std::string empty;
-
 	Language::Language(const char* code, const std::string& filename)
 	{
 		this->code = code;
@@ -19,20 +19,53 @@ namespace MikuMikuWorld
 	                   const std::unordered_map<std::string, std::string>& strings)
 	{
 		this->code = code;
-		this->strings = strings;
+		for (const auto& [key, value] : strings)
+			setString(key, value);
+	}
+
+	Language::Language(const char* code, const LanguageEntries& entries)
+	{
+		this->code = code;
+
+		size_t bytes = 0;
+		for (const auto& [key, value] : entries)
+			bytes += value.size() + 1;
+
+		data.reserve(bytes);
+		for (const auto& [key, value] : entries)
+			setString(key, value);
+	}
+
+	void Language::setString(std::string_view key, std::string_view value)
+	{
+		const StringID id = Localization::intern(key);
+		if (id >= offsets.size())
+			offsets.resize(id + 1, noString);
+
+		// A key defined twice keeps its last value, the earlier one stays unused in data
+		offsets[id] = static_cast<uint32_t>(data.size());
+		data.append(value);
+		data.push_back('\0');
 	}
 
 	void Language::read(const std::string& filename)
 	{
+		LanguageEntries entries = readEntries(filename);
+		for (const auto& [key, value] : entries)
+			setString(key, value);
+	}
+
+	LanguageEntries Language::readEntries(const std::string& filename)
+	{
+		LanguageEntries entries;
 		if (!File::exists(filename))
-			return;
+			return entries;
 
 		File f(filename, "r, ccs=UNICODE");
 		std::vector<std::string> lines = f.readAllLines();
-
 		f.close();
-		strings.reserve(lines.size());
 
+		entries.reserve(lines.size());
 		for (auto& line : lines)
 		{
 			line = trim(line);
@@ -40,22 +73,47 @@ namespace MikuMikuWorld
 				continue;
 
 			std::pair<std::string, std::string> values = split_first(line, ",");
-			strings[trim(values.first)] = trim(values.second);
+			entries.emplace_back(trim(values.first), trim(values.second));
 		}
+
+		return entries;
+	}
+
+	void Language::resolve(const Language* fallback)
+	{
+		this->fallback = fallback != this ? fallback : nullptr;
 	}
 
 	const char* Language::getCode() const { return code.c_str(); }
 
-	const bool Language::containsString(const std::string& key)
+	bool Language::containsString(StringID id) const
+	{
+		return id >= 0 && id < offsets.size() && offsets[id] != noString;
+	}
+
+	const char* Language::getString(StringID id) const
 	{
-		return strings.find(key) != strings.end();
+		if (containsString(id))
+			return data.c_str() + offsets[id];
+
+		return fallback ? fallback->getString(id) : nullptr;
 	}
 
-	const char* Language::getString(const std::string& key) const
+	const char* Language::getString(std::string_view key) const
 	{
-		const auto& it = strings.find(key);
+		const char* str = getString(Localization::findStringID(key));
 
 		// imgui dies if the window/header title is empty
-		return it != strings.end() ? it->second.c_str() : key.c_str();
+		return str ? str : Localization::getKey(Localization::intern(key));
+	}
+
+	std::string_view Language::getStringData() const { return data; }
+
+	const Language* Language::getFallback() const { return fallback; }
+
+	size_t Language::getMemoryUsage() const
+	{
+		return sizeof(Language) + code.capacity() + data.capacity() +
+		       offsets.capacity() * sizeof(uint32_t);
 	}
 }
\ No newline at end of file
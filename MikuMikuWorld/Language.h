@@ -1,22 +1,56 @@
 #pragma once
+#include <cstdint>
 #include <unordered_map>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace MikuMikuWorld
 {
+	/// Index of an interned localization key. See Localization::intern.
+	using StringID = int;
+
+	/// Key and value pairs of a language file in file order
+	using LanguageEntries = std::vector<std::pair<std::string, std::string>>;
+
 	class Language
 	{
 	  private:
 		std::string code;
-		std::unordered_map<std::string, std::string> strings;
+
+		// Every translated string back to back, each followed by a null terminator. Offsets are
+		// indexed by StringID and hold noString for strings this language does not translate
+		std::string data;
+		std::vector<uint32_t> offsets;
+		const Language* fallback{};
+
+		static constexpr uint32_t noString = UINT32_MAX;
+
+		void setString(std::string_view key, std::string_view value);
 
 	  public:
 		Language(const char* code, const std::string& filename);
 		Language(const char* code, const std::unordered_map<std::string, std::string>& strings);
+		Language(const char* code, const LanguageEntries& entries);
 
 		void read(const std::string& filename);
+
+		/// Parses a language file without interning its keys, so it can run on any thread
+		static LanguageEntries readEntries(const std::string& filename);
+
+		/// Strings missing from this language are taken from fallback
+		void resolve(const Language* fallback);
+
 		const char* getCode() const;
-		const bool containsString(const std::string& key);
-		const char* getString(const std::string& key) const;
+		bool containsString(StringID id) const;
+
+		/// Returns nullptr when neither this language nor its fallback has the string
+		const char* getString(StringID id) const;
+		const char* getString(std::string_view key) const;
+
+		/// The translated strings of this language separated by null characters
+		std::string_view getStringData() const;
+		const Language* getFallback() const;
+		size_t getMemoryUsage() const;
 	};
-}
\ No newline at end of file
+}
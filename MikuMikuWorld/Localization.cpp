@@ -1,12 +1,17 @@
 #include "Localization.h"
+#include "GlyphCache.h"
 #include "IO.h"
 #include "File.h"
+#include "MemoryTracker.h"
+#include <algorithm>
 #include <filesystem>
 
 namespace MikuMikuWorld
 {
-	static std::string empty;
-
+	std::deque<std::string> Localization::keys;
+	std::unordered_map<std::string_view, StringID> Localization::stringIDs;
+	std::map<std::string, std::string> Localization::languageFiles;
+	std::map<std::string, std::string> Localization::languageNames;
 	std::unordered_map<std::string, std::unique_ptr<Language>> Localization::languages;
 	Language* Localization::currentLanguage = nullptr;
 
@@ -15,35 +20,143 @@ namespace MikuMikuWorld
 		if (!IO::File::exists(filename))
 			return;
 
-		languages[code] = std::make_unique<Language>(code, filename);
+		add(std::make_unique<Language>(code, filename));
+	}
+
+	void Localization::add(std::unique_ptr<Language> language)
+	{
+		// Every language falls back to english for the strings it does not translate
+		const std::string code = language->getCode();
+		const bool isDefault = code == "en";
+		auto defaultIt = languages.find("en");
+		if (!isDefault && defaultIt != languages.end())
+			language->resolve(defaultIt->second.get());
+
+		std::unique_ptr<Language>& entry = languages[code];
+		const bool replacesCurrent = entry && entry.get() == currentLanguage;
+		if (entry)
+			MemoryTracker::remove(MemoryCategory::Localization, entry->getMemoryUsage());
+
+		MemoryTracker::add(MemoryCategory::Localization, language->getMemoryUsage());
+		entry = std::move(language);
+		languageNames.erase(code);
+		if (replacesCurrent)
+		{
+			currentLanguage = entry.get();
+			GlyphCache::request(*currentLanguage);
+		}
+		if (isDefault)
+		{
+			const Language* defaultLanguage = languages.at(code).get();
+			for (auto& [_, other] : languages)
+			{
+				if (other.get() != defaultLanguage)
+					other->resolve(defaultLanguage);
+			}
+		}
 	}
 
 	bool Localization::setLanguage(const std::string& code)
 	{
 		auto it = Localization::languages.find(code);
 		if (it == Localization::languages.end())
-			return false;
+		{
+			auto fileIt = languageFiles.find(code);
+			if (fileIt == languageFiles.end())
+				return false;
+
+			load(code.c_str(), fileIt->second);
+			it = Localization::languages.find(code);
+			if (it == Localization::languages.end())
+				return false;
+		}
 
 		Localization::currentLanguage = it->second.get();
+		GlyphCache::request(*currentLanguage);
 		return true;
 	}
 
-	const char* getString(const std::string& key)
+	StringID Localization::intern(std::string_view key)
+	{
+		auto it = stringIDs.find(key);
+		if (it != stringIDs.end())
+			return it->second;
+
+		// The map views the stored keys, which a deque never moves
+		const StringID id = static_cast<StringID>(keys.size());
+		stringIDs.emplace(keys.emplace_back(key), id);
+		return id;
+	}
+
+	StringID Localization::findStringID(std::string_view key)
+	{
+		auto it = stringIDs.find(key);
+		return it != stringIDs.end() ? it->second : -1;
+	}
+
+	const char* Localization::getKey(StringID id)
+	{
+		return id >= 0 && id < keys.size() ? keys[id].c_str() : "";
+	}
+
+	const char* getString(std::string_view key) { return getString(Localization::intern(key)); }
+
+	const char* getString(StringID id)
 	{
-		if (!Localization::currentLanguage)
-			return key.c_str();
+		const char* str = Localization::currentLanguage
+		                      ? Localization::currentLanguage->getString(id)
+		                      : nullptr;
 
-		if (!Localization::currentLanguage->containsString(key))
-			return Localization::languages["en"]->getString(key);
+		return str ? str : Localization::getKey(id);
+	}
 
-		return Localization::currentLanguage->getString(key);
+	void Localization::registerLanguageFiles(
+	    const std::vector<std::pair<std::string, std::string>>& files)
+	{
+		for (const auto& [code, filename] : files)
+			languageFiles[code] = filename;
 	}
 
-	void Localization::loadLanguages(const std::string& path)
+	const std::map<std::string, std::string>& Localization::getLanguageFiles()
 	{
+		return languageFiles;
+	}
+
+	const std::string& Localization::getLanguageName(const std::string& code)
+	{
+		auto it = languageNames.find(code);
+		if (it != languageNames.end())
+			return it->second;
+
+		std::string& name = languageNames[code];
+		name = code;
+
+		auto languageIt = languages.find(code);
+		auto fileIt = languageFiles.find(code);
+		if (languageIt != languages.end())
+		{
+			name = languageIt->second->getString("language_name");
+		}
+		else if (fileIt != languageFiles.end())
+		{
+			// Names are shown for every language in the settings, without loading any of them
+			for (const auto& [key, value] : Language::readEntries(fileIt->second))
+			{
+				if (key == "language_name")
+					name = value;
+			}
+		}
+
+		return name;
+	}
+
+	std::vector<std::pair<std::string, std::string>>
+	Localization::findLanguageFiles(const std::string& path)
+	{
+		std::vector<std::pair<std::string, std::string>> files;
 		std::wstring wPath = IO::mbToWideStr(path);
 		if (!std::filesystem::exists(wPath))
-			return;
+			return files;
 
 		std::vector<std::filesystem::path> filePaths;
 		for (const auto& file : std::filesystem::directory_iterator(wPath))
@@ -54,11 +167,17 @@ namespace MikuMikuWorld
 				filePaths.push_back(file.path());
 		}
 
+		// Load english first so the other languages can fall back to it
+		std::stable_partition(filePaths.begin(), filePaths.end(),
+		                      [](const std::filesystem::path& filePath)
+		                      { return filePath.stem().wstring() == L"en"; });
+
 		for (const auto& filePath : filePaths)
 		{
-			auto countryCode = IO::wideStringToMb(filePath.stem().wstring());
-			auto path = IO::wideStringToMb(filePath.wstring());
-			Localization::load(countryCode.c_str(), path.c_str());
+			files.emplace_back(IO::wideStringToMb(filePath.stem().wstring()),
+			                   IO::wideStringToMb(filePath.wstring()));
 		}
+
+		return files;
 	}
 }
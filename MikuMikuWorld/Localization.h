@@ -1,5 +1,7 @@
 #pragma once
 #include "Language.h"
+#include <deque>
+#include <map>
 #include <memory>
 
 namespace MikuMikuWorld
@@ -7,14 +9,48 @@ namespace MikuMikuWorld
 	class Localization
 	{
 	  private:
+		static std::deque<std::string> keys;
+		static std::unordered_map<std::string_view, StringID> stringIDs;
+
+		// Every language that can be selected by code, loaded or not
+		static std::map<std::string, std::string> languageFiles;
+		static std::map<std::string, std::string> languageNames;
+
 	  public:
+		/// Languages that have been loaded so far
 		static std::unordered_map<std::string, std::unique_ptr<Language>> languages;
 		static Language* currentLanguage;
 
 		static void load(const char* code, const std::string& filename);
+
+		/// Loads the language first if it was only registered
 		static bool setLanguage(const std::string& key);
-		static void loadLanguages(const std::string& path);
+
+		/// Makes languages available to setLanguage without reading them
+		static void
+		registerLanguageFiles(const std::vector<std::pair<std::string, std::string>>& files);
+		static const std::map<std::string, std::string>& getLanguageFiles();
+
+		/// Reads only the name of a language that has not been loaded
+		static const std::string& getLanguageName(const std::string& code);
+
+		/// Registers a language and resolves the english fallback between it and the others.
+		/// Replacing the current language keeps it selected.
+		static void add(std::unique_ptr<Language> language);
+
+		/// Returns the language code and path of every csv file in path, english first
+		static std::vector<std::pair<std::string, std::string>>
+		findLanguageFiles(const std::string& path);
+
+		/// Returns the ID of a localization key, assigning the next free one to keys never seen
+		/// before. IDs index the flat string table of every language.
+		static StringID intern(std::string_view key);
+
+		/// Returns -1 for keys that were never interned
+		static StringID findStringID(std::string_view key);
+		static const char* getKey(StringID id);
 	};
 
-	const char* getString(const std::string& key);
+	const char* getString(std::string_view key);
+	const char* getString(StringID id);
 }
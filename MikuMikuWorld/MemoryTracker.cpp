@@ -0,0 +1,94 @@
+#include "MemoryTracker.h"
+#include <cstdlib>
+
+namespace MikuMikuWorld
+{
+	constexpr size_t memoryCategoryCount = static_cast<size_t>(MemoryCategory::MemoryCategoryCount);
+	static_assert(sizeof(memoryCategoryNames) / sizeof(const char*) == memoryCategoryCount,
+	              "Every memory category needs a name");
+
+	// Keeps the blocks handed out by allocate aligned like malloc's
+	constexpr size_t blockHeaderSize = alignof(std::max_align_t);
+
+	static std::atomic<size_t> liveBytes[memoryCategoryCount]{};
+	static std::atomic<size_t> peakBytes[memoryCategoryCount]{};
+
+	static void updatePeak(size_t index, size_t bytes)
+	{
+		size_t peak = peakBytes[index].load(std::memory_order_relaxed);
+		while (bytes > peak &&
+		       !peakBytes[index].compare_exchange_weak(peak, bytes, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	void MemoryTracker::add(MemoryCategory category, size_t bytes)
+	{
+		const size_t index = static_cast<size_t>(category);
+		updatePeak(index, liveBytes[index].fetch_add(bytes, std::memory_order_relaxed) + bytes);
+	}
+
+	void MemoryTracker::remove(MemoryCategory category, size_t bytes)
+	{
+		liveBytes[static_cast<size_t>(category)].fetch_sub(bytes, std::memory_order_relaxed);
+	}
+
+	void MemoryTracker::set(MemoryCategory category, size_t bytes)
+	{
+		const size_t index = static_cast<size_t>(category);
+		liveBytes[index].store(bytes, std::memory_order_relaxed);
+		updatePeak(index, bytes);
+	}
+
+	MemoryUsage MemoryTracker::getUsage(MemoryCategory category)
+	{
+		const size_t index = static_cast<size_t>(category);
+		return { liveBytes[index].load(std::memory_order_relaxed),
+			     peakBytes[index].load(std::memory_order_relaxed) };
+	}
+
+	void MemoryTracker::resetPeaks()
+	{
+		for (size_t index = 0; index < memoryCategoryCount; ++index)
+			peakBytes[index].store(liveBytes[index].load(std::memory_order_relaxed),
+			                       std::memory_order_relaxed);
+	}
+
+	void* MemoryTracker::allocate(MemoryCategory category, size_t size)
+	{
+		char* block = static_cast<char*>(malloc(size + blockHeaderSize));
+		if (!block)
+			return nullptr;
+
+		*reinterpret_cast<size_t*>(block) = size;
+		add(category, size);
+		return block + blockHeaderSize;
+	}
+
+	void* MemoryTracker::reallocate(MemoryCategory category, void* block, size_t size)
+	{
+		if (!block)
+			return allocate(category, size);
+
+		char* header = static_cast<char*>(block) - blockHeaderSize;
+		const size_t oldSize = *reinterpret_cast<size_t*>(header);
+		char* newHeader = static_cast<char*>(realloc(header, size + blockHeaderSize));
+		if (!newHeader)
+			return nullptr;
+
+		*reinterpret_cast<size_t*>(newHeader) = size;
+		remove(category, oldSize);
+		add(category, size);
+		return newHeader + blockHeaderSize;
+	}
+
+	void MemoryTracker::deallocate(MemoryCategory category, void* block)
+	{
+		if (!block)
+			return;
+
+		char* header = static_cast<char*>(block) - blockHeaderSize;
+		remove(category, *reinterpret_cast<size_t*>(header));
+		free(header);
+	}
+}
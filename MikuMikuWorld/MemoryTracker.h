@@ -0,0 +1,121 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	enum class MemoryCategory : uint8_t
+	{
+		Score,
+		History,
+		PasteData,
+		Presets,
+		Music,
+		Waveform,
+		AudioEngine,
+		Textures,
+		ImGui,
+		Localization,
+		MemoryCategoryCount
+	};
+
+	constexpr const char* memoryCategoryNames[] = {
+		"Score",         "Undo History", "Paste Data", "Presets", "Music",
+		"Waveform",      "Audio Engine", "Textures",   "ImGui",   "Localization",
+	};
+
+	struct MemoryUsage
+	{
+		size_t bytes{};
+		size_t peakBytes{};
+	};
+
+	/// Live and peak byte counts per subsystem. Allocators and library allocation callbacks report
+	/// every block, while owners without a hook report a measured size whenever they change.
+	class MemoryTracker
+	{
+	  public:
+		static void add(MemoryCategory category, size_t bytes);
+		static void remove(MemoryCategory category, size_t bytes);
+
+		/// Replaces the count of a category that is measured rather than tracked per allocation
+		static void set(MemoryCategory category, size_t bytes);
+
+		static MemoryUsage getUsage(MemoryCategory category);
+		static void resetPeaks();
+
+		/// malloc style functions for libraries that accept allocation callbacks. Each block is
+		/// prefixed with its size so frees can be counted.
+		static void* allocate(MemoryCategory category, size_t size);
+		static void* reallocate(MemoryCategory category, void* block, size_t size);
+		static void deallocate(MemoryCategory category, void* block);
+	};
+
+	/// std::allocator that counts its blocks towards a category
+	template <typename T, MemoryCategory Category> class TrackingAllocator
+	{
+	  public:
+		using value_type = T;
+
+		template <typename U> struct rebind
+		{
+			using other = TrackingAllocator<U, Category>;
+		};
+
+		TrackingAllocator() = default;
+		template <typename U> TrackingAllocator(const TrackingAllocator<U, Category>&) {}
+
+		T* allocate(size_t count)
+		{
+			T* block = std::allocator<T>{}.allocate(count);
+			MemoryTracker::add(Category, count * sizeof(T));
+			return block;
+		}
+
+		void deallocate(T* block, size_t count)
+		{
+			MemoryTracker::remove(Category, count * sizeof(T));
+			std::allocator<T>{}.deallocate(block, count);
+		}
+
+		template <typename U> bool operator==(const TrackingAllocator<U, Category>&) const
+		{
+			return true;
+		}
+
+		template <typename U> bool operator!=(const TrackingAllocator<U, Category>&) const
+		{
+			return false;
+		}
+	};
+
+	/// Heap footprints of standard containers, for owners that are measured. Node based
+	/// containers are estimated from their element count.
+	template <typename T, typename A> size_t getMemoryUsage(const std::vector<T, A>& vector)
+	{
+		return vector.capacity() * sizeof(T);
+	}
+
+	inline size_t getMemoryUsage(const std::string& string)
+	{
+		// Short strings live inside the object
+		return string.capacity() > 15 ? string.capacity() + 1 : 0;
+	}
+
+	template <typename K, typename V> size_t getMemoryUsage(const std::map<K, V>& map)
+	{
+		return map.size() * (sizeof(std::pair<const K, V>) + 4 * sizeof(void*));
+	}
+
+	template <typename K, typename V> size_t getMemoryUsage(const std::unordered_map<K, V>& map)
+	{
+		return map.size() * (sizeof(std::pair<const K, V>) + 2 * sizeof(void*)) +
+		       map.bucket_count() * sizeof(void*);
+	}
+}
@@ -6,7 +6,11 @@
 
 namespace MikuMikuWorld
 {
-	int nextID = 1;
+	// Each thread walks its own chain so a score built on one thread gets consecutive links of
+	// it, as when scores are loaded one at a time. Sharing the chain between threads loading
+	// concurrently would spread a score over a span long enough for the chain to repeat an ID.
+	// Scores must therefore be edited on the thread that created them.
+	thread_local int nextID = 1;
 
 	int Note::getNextID()
 	{
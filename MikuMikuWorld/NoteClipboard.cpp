@@ -0,0 +1,527 @@
+#include "NoteClipboard.h"
+#include "IO.h"
+#include "MemoryTracker.h"
+#include "Utilities.h"
+#include <cstring>
+#include <type_traits>
+
+using json = nlohmann::json;
+
+namespace MikuMikuWorld
+{
+	// Written by builds that put only the binary payload on the clipboard
+	constexpr const char* binaryClipboardSignature = "MikuMikuWorld binary clipboard\n";
+	constexpr const char* binaryClipboardKey = "{\"binary\":\"";
+	constexpr uint32_t binaryClipboardVersion = 1;
+
+	size_t getMemoryUsage(const PasteData& data)
+	{
+		size_t bytes = data.notes.getMemoryUsage() + data.holds.getMemoryUsage() +
+		               data.damages.getMemoryUsage() + getMemoryUsage(data.hiSpeedChanges) +
+		               getMemoryUsage(data.items);
+
+		for (const auto& [id, hold] : data.holds)
+			bytes += getMemoryUsage(hold);
+
+		return bytes;
+	}
+
+	/// Unsigned integer with the size of T, holding its bits while they are byte swapped
+	template <typename T>
+	using ClipboardBits = std::conditional_t<
+	    sizeof(T) == 1, uint8_t,
+	    std::conditional_t<sizeof(T) == 2, uint16_t,
+	                       std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+
+	class ClipboardWriter
+	{
+	  private:
+		std::string& buffer;
+
+	  public:
+		ClipboardWriter(std::string& buffer) : buffer{ buffer } {}
+
+		template <typename T> void write(T value)
+		{
+			ClipboardBits<T> bits;
+			memcpy(&bits, &value, sizeof(T));
+			for (size_t i = 0; i < sizeof(T); ++i)
+				buffer.push_back(static_cast<char>(bits >> (i * 8) & 0xff));
+		}
+
+		void writeNote(const Note& note, int baseTick)
+		{
+			write<int32_t>(note.tick - baseTick);
+			write<float>(note.lane);
+			write<float>(note.width);
+			write<uint8_t>(note.critical | note.friction << 1);
+			write<uint8_t>((uint8_t)note.flick);
+		}
+	};
+
+	class ClipboardReader
+	{
+	  private:
+		const std::string& buffer;
+		size_t position{};
+		bool valid{ true };
+
+	  public:
+		ClipboardReader(const std::string& buffer) : buffer{ buffer } {}
+
+		bool isValid() const { return valid; }
+
+		template <typename T> T read()
+		{
+			T value{};
+			if (!valid || buffer.size() - position < sizeof(T))
+			{
+				valid = false;
+				return value;
+			}
+
+			ClipboardBits<T> bits{};
+			for (size_t i = 0; i < sizeof(T); ++i)
+				bits |= static_cast<ClipboardBits<T>>(
+				            static_cast<uint8_t>(buffer[position + i]))
+				        << (i * 8);
+
+			memcpy(&value, &bits, sizeof(T));
+			position += sizeof(T);
+			return value;
+		}
+
+		/// Reads an enum value, invalidating the reader if it is out of range
+		template <typename T> T readEnum(size_t count)
+		{
+			uint8_t value = read<uint8_t>();
+			if (value >= count)
+				valid = false;
+
+			return valid ? (T)value : T{};
+		}
+
+		/// Reads an element count, which cannot exceed the remaining payload size
+		uint32_t readCount()
+		{
+			uint32_t count = read<uint32_t>();
+			if (count > buffer.size() - position)
+				valid = false;
+
+			return valid ? count : 0;
+		}
+
+		/// Reads a note applying the same per-type rules as jsonIO::jsonToNote
+		Note readNote(NoteType type)
+		{
+			Note note(type);
+			note.tick = read<int32_t>();
+			note.lane = read<float>();
+			note.width = read<float>();
+
+			uint8_t flags = read<uint8_t>();
+			FlickType flick = readEnum<FlickType>(arrayLength(flickTypes));
+			if (note.getType() != NoteType::HoldMid)
+			{
+				note.critical = flags & 1;
+				note.friction = flags & 2;
+			}
+
+			if (!note.hasEase())
+				note.flick = flick;
+
+			return note;
+		}
+	};
+
+	std::string selectionToClipboardPayload(const Score& score, const NoteSelection& selection,
+	                                        const std::unordered_set<id_t>& hiSpeedSelection,
+	                                        int baseTick)
+	{
+		std::unordered_set<id_t> selectedNotes;
+		std::unordered_set<id_t> selectedHolds;
+		std::unordered_set<id_t> selectedDamages;
+
+		for (id_t id : selection)
+		{
+			auto it = score.notes.find(id);
+			if (it == score.notes.end())
+				continue;
+
+			const Note& note = it->second;
+			switch (note.getType())
+			{
+			case NoteType::Tap:
+				selectedNotes.insert(note.ID);
+				break;
+			case NoteType::Hold:
+				selectedHolds.insert(note.ID);
+				break;
+			case NoteType::HoldMid:
+			case NoteType::HoldEnd:
+				selectedHolds.insert(note.parentID);
+				break;
+			case NoteType::Damage:
+				selectedDamages.insert(note.ID);
+				break;
+			default:
+				break;
+			}
+		}
+
+		std::string buffer;
+		ClipboardWriter writer(buffer);
+		writer.write<uint32_t>(binaryClipboardVersion);
+
+		writer.write<uint32_t>(selectedNotes.size());
+		for (id_t id : selectedNotes)
+			writer.writeNote(score.notes.at(id), baseTick);
+
+		writer.write<uint32_t>(selectedDamages.size());
+		for (id_t id : selectedDamages)
+			writer.writeNote(score.notes.at(id), baseTick);
+
+		writer.write<uint32_t>(selectedHolds.size());
+		for (id_t id : selectedHolds)
+		{
+			const HoldNote& hold = score.holdNotes.at(id);
+			writer.writeNote(score.notes.at(hold.start.ID), baseTick);
+			writer.write<uint8_t>((uint8_t)hold.start.ease);
+			writer.write<uint8_t>((uint8_t)hold.startType);
+			writer.writeNote(score.notes.at(hold.end), baseTick);
+			writer.write<uint8_t>((uint8_t)hold.endType);
+			writer.write<uint8_t>((uint8_t)hold.fadeType);
+			writer.write<uint8_t>((uint8_t)hold.guideColor);
+
+			writer.write<uint32_t>(hold.steps.size());
+			for (const auto& step : hold.steps)
+			{
+				writer.writeNote(score.notes.at(step.ID), baseTick);
+				writer.write<uint8_t>((uint8_t)step.type);
+				writer.write<uint8_t>((uint8_t)step.ease);
+			}
+		}
+
+		writer.write<uint32_t>(hiSpeedSelection.size());
+		for (id_t id : hiSpeedSelection)
+		{
+			const HiSpeedChange& hiSpeed = score.hiSpeedChanges.at(id);
+			writer.write<int32_t>(hiSpeed.tick - baseTick);
+			writer.write<float>(hiSpeed.speed);
+		}
+
+		return buffer;
+	}
+
+	std::string clipboardText(const nlohmann::json& data, const std::string& payload)
+	{
+		// Keys are dumped in sorted order and the payload key sorts before every key of a
+		// selection, so readClipboardPayload finds it right after the signature. Base64 needs
+		// no escaping inside a JSON string.
+		json text = data;
+		text["binary"] = IO::base64Encode(payload);
+
+		std::string clipboard{ clipboardSignature };
+		clipboard.append(text.dump());
+		return clipboard;
+	}
+
+	bool readClipboardPayload(std::string_view text, std::string& payload)
+	{
+		if (IO::startsWith(text, binaryClipboardSignature))
+			return IO::base64Decode(text.substr(strlen(binaryClipboardSignature)), payload);
+
+		if (!IO::startsWith(text, clipboardSignature))
+			return false;
+
+		text.remove_prefix(strlen(clipboardSignature));
+		if (!IO::startsWith(text, binaryClipboardKey))
+			return false;
+
+		text.remove_prefix(strlen(binaryClipboardKey));
+		const size_t end = text.find('"');
+		return end != std::string_view::npos && IO::base64Decode(text.substr(0, end), payload);
+	}
+
+	/// Clears what the hold types do not allow on the pasted start and end notes. Shared by the
+	/// text and binary paste so both place the same notes.
+	static void normalizePastedHold(const HoldNote& hold, Note& start, Note& end)
+	{
+		if (hold.isGuide())
+		{
+			start.friction = end.friction = false;
+			end.flick = FlickType::None;
+		}
+		else
+		{
+			if (hold.startType == HoldNoteType::Hidden)
+				start.friction = false;
+
+			if (hold.endType == HoldNoteType::Hidden)
+			{
+				end.friction = false;
+				end.flick = FlickType::None;
+			}
+		}
+
+		end.critical = start.critical || ((end.isFlick() || end.friction) && end.critical);
+	}
+
+	static void clearPasteData(PasteData& pasteData)
+	{
+		pasteData.notes.clear();
+		pasteData.damages.clear();
+		pasteData.holds.clear();
+		pasteData.hiSpeedChanges.clear();
+	}
+
+	void jsonToPasteData(const json& data, int layer, PasteData& pasteData)
+	{
+		int baseId = 0;
+		clearPasteData(pasteData);
+
+		if (jsonIO::arrayHasData(data, "notes"))
+		{
+			for (const auto& entry : data["notes"])
+			{
+				Note note = jsonIO::jsonToNote(entry, NoteType::Tap);
+				note.ID = baseId++;
+				note.layer = layer;
+
+				pasteData.notes[note.ID] = note;
+			}
+		}
+
+		if (jsonIO::arrayHasData(data, "damages"))
+		{
+			for (const auto& entry : data["damages"])
+			{
+				Note note = jsonIO::jsonToNote(entry, NoteType::Damage);
+				note.ID = baseId++;
+				note.layer = layer;
+
+				pasteData.damages[note.ID] = note;
+			}
+		}
+
+		if (jsonIO::arrayHasData(data, "holds"))
+		{
+			for (const auto& entry : data["holds"])
+			{
+				if (!jsonIO::keyExists(entry, "start") || !jsonIO::keyExists(entry, "end"))
+					continue;
+
+				Note start = jsonIO::jsonToNote(entry["start"], NoteType::Hold);
+				start.ID = baseId++;
+				start.layer = layer;
+
+				Note end = jsonIO::jsonToNote(entry["end"], NoteType::HoldEnd);
+				end.ID = baseId++;
+				end.parentID = start.ID;
+				end.layer = layer;
+
+				std::string startEase =
+				    jsonIO::tryGetValue<std::string>(entry["start"], "ease", "linear");
+
+				HoldNote hold;
+				hold.start = { start.ID, HoldStepType::Normal,
+					           (EaseType)findArrayItem(startEase.c_str(), easeTypes,
+					                                   arrayLength(easeTypes)) };
+				hold.end = end.ID;
+				for (size_t i = 0; i < arrayLength(fadeTypes); ++i)
+				{
+					if (entry["fade"] == fadeTypes[i])
+					{
+						hold.fadeType = (FadeType)i;
+						break;
+					}
+				}
+				for (size_t i = 0; i < arrayLength(guideColors); ++i)
+				{
+					if (entry["guide"] == guideColors[i])
+					{
+						hold.guideColor = (GuideColor)i;
+						break;
+					}
+				}
+				if (jsonIO::keyExists(entry, "steps"))
+				{
+					hold.steps.reserve(entry["steps"].size());
+					for (const auto& step : entry["steps"])
+					{
+						Note mid = jsonIO::jsonToNote(step, NoteType::HoldMid);
+						mid.critical = start.critical;
+						mid.ID = baseId++;
+						mid.parentID = start.ID;
+						mid.layer = layer;
+						pasteData.notes[mid.ID] = mid;
+
+						std::string midType =
+						    jsonIO::tryGetValue<std::string>(step, "type", "normal");
+						std::string midEase =
+						    jsonIO::tryGetValue<std::string>(step, "ease", "linear");
+						int stepTypeIndex =
+						    findArrayItem(midType.c_str(), stepTypes, arrayLength(stepTypes));
+						int easeTypeIndex =
+						    findArrayItem(midEase.c_str(), easeTypes, arrayLength(easeTypes));
+
+						// Maintain compatibility with old step type names
+						if (stepTypeIndex == -1)
+						{
+							stepTypeIndex = 0;
+							if (midType == "invisible")
+								stepTypeIndex = 1;
+							if (midType == "ignored")
+								stepTypeIndex = 2;
+						}
+
+						// Maintain compatibility with old ease type names
+						if (easeTypeIndex == -1)
+						{
+							easeTypeIndex = 0;
+							if (midEase == "in")
+								easeTypeIndex = 1;
+							if (midEase == "out")
+								easeTypeIndex = 2;
+						}
+
+						hold.steps.push_back(
+						    { mid.ID, (HoldStepType)stepTypeIndex, (EaseType)easeTypeIndex });
+					}
+				}
+
+				std::string startType =
+				    jsonIO::tryGetValue<std::string>(entry["start"], "type", "normal");
+				std::string endType =
+				    jsonIO::tryGetValue<std::string>(entry["end"], "type", "normal");
+
+				if (startType == "guide" || endType == "guide")
+				{
+					hold.startType = hold.endType = HoldNoteType::Guide;
+				}
+				else
+				{
+					if (startType == "hidden")
+						hold.startType = HoldNoteType::Hidden;
+
+					if (endType == "hidden")
+						hold.endType = HoldNoteType::Hidden;
+				}
+
+				normalizePastedHold(hold, start, end);
+				pasteData.notes[start.ID] = start;
+				pasteData.notes[end.ID] = end;
+				pasteData.holds[hold.start.ID] = hold;
+			}
+		}
+
+		int hiSpeedID = 0;
+
+		if (jsonIO::arrayHasData(data, "hiSpeedChanges"))
+		{
+			for (const auto& entry : data["hiSpeedChanges"])
+			{
+				HiSpeedChange hs;
+				hs.ID = hiSpeedID++;
+				hs.tick = entry["tick"];
+				hs.speed = entry["speed"];
+
+				pasteData.hiSpeedChanges[hs.ID] = hs;
+			}
+		}
+
+	}
+
+	bool binaryToPasteData(const std::string& payload, int layer, PasteData& pasteData)
+	{
+		clearPasteData(pasteData);
+
+		ClipboardReader reader(payload);
+		if (reader.read<uint32_t>() != binaryClipboardVersion)
+			return false;
+
+		int baseId = 0;
+		uint32_t noteCount = reader.readCount();
+		for (uint32_t i = 0; i < noteCount; ++i)
+		{
+			Note note = reader.readNote(NoteType::Tap);
+			note.ID = baseId++;
+			note.layer = layer;
+
+			pasteData.notes[note.ID] = note;
+		}
+
+		uint32_t damageCount = reader.readCount();
+		for (uint32_t i = 0; i < damageCount; ++i)
+		{
+			Note note = reader.readNote(NoteType::Damage);
+			note.ID = baseId++;
+			note.layer = layer;
+
+			pasteData.damages[note.ID] = note;
+		}
+
+		uint32_t holdCount = reader.readCount();
+		for (uint32_t i = 0; i < holdCount && reader.isValid(); ++i)
+		{
+			Note start = reader.readNote(NoteType::Hold);
+			start.ID = baseId++;
+			start.layer = layer;
+
+			HoldNote hold;
+			hold.start = { start.ID, HoldStepType::Normal,
+				           reader.readEnum<EaseType>(arrayLength(easeTypes)) };
+			hold.startType = reader.readEnum<HoldNoteType>(arrayLength(holdTypes));
+
+			Note end = reader.readNote(NoteType::HoldEnd);
+			end.ID = baseId++;
+			end.parentID = start.ID;
+			end.layer = layer;
+
+			hold.end = end.ID;
+			hold.endType = reader.readEnum<HoldNoteType>(arrayLength(holdTypes));
+			hold.fadeType = reader.readEnum<FadeType>(arrayLength(fadeTypes));
+			hold.guideColor = reader.readEnum<GuideColor>(arrayLength(guideColors));
+			if (hold.isGuide())
+				hold.startType = hold.endType = HoldNoteType::Guide;
+
+			uint32_t stepCount = reader.readCount();
+			hold.steps.reserve(stepCount);
+			for (uint32_t j = 0; j < stepCount; ++j)
+			{
+				Note mid = reader.readNote(NoteType::HoldMid);
+				mid.critical = start.critical;
+				mid.ID = baseId++;
+				mid.parentID = start.ID;
+				mid.layer = layer;
+				pasteData.notes[mid.ID] = mid;
+
+				HoldStepType stepType = reader.readEnum<HoldStepType>(arrayLength(stepTypes));
+				EaseType ease = reader.readEnum<EaseType>(arrayLength(easeTypes));
+				hold.steps.push_back({ mid.ID, stepType, ease });
+			}
+
+			normalizePastedHold(hold, start, end);
+			pasteData.notes[start.ID] = start;
+			pasteData.notes[end.ID] = end;
+			pasteData.holds[hold.start.ID] = hold;
+		}
+
+		int hiSpeedID = 0;
+		uint32_t hiSpeedCount = reader.readCount();
+		for (uint32_t i = 0; i < hiSpeedCount; ++i)
+		{
+			HiSpeedChange hs;
+			hs.ID = hiSpeedID++;
+			hs.tick = reader.read<int32_t>();
+			hs.speed = reader.read<float>();
+
+			pasteData.hiSpeedChanges[hs.ID] = hs;
+		}
+
+		if (!reader.isValid())
+			clearPasteData(pasteData);
+
+		return reader.isValid();
+	}
+}
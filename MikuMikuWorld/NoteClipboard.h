@@ -0,0 +1,66 @@
+#pragma once
+#include "JsonIO.h"
+#include "NoteSelection.h"
+#include "Score.h"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	constexpr const char* clipboardSignature = "MikuMikuWorld clipboard\n";
+
+	/// A tap, damage or hold of the paste payload and the ticks it spans
+	struct PasteItem
+	{
+		int startTick{};
+		int endTick{};
+		NoteType type{};
+		id_t id{};
+	};
+
+	struct PasteData
+	{
+		SlotMap<id_t, Note> notes;
+		SlotMap<id_t, HoldNote> holds;
+		SlotMap<id_t, Note> damages;
+		std::unordered_map<id_t, HiSpeedChange> hiSpeedChanges;
+
+		/// Every drawable item of the payload sorted by start tick
+		std::vector<PasteItem> items;
+
+		/// Changes whenever a new payload is prepared
+		uint32_t revision{};
+		bool pasting{ false };
+		int offsetTicks{};
+		int offsetLane{};
+		int midLane{};
+		int minLaneOffset{};
+		int maxLaneOffset{};
+	};
+
+	/// Estimated heap bytes held by the paste payload
+	size_t getMemoryUsage(const PasteData& data);
+
+	/// Binary counterpart of jsonIO::noteSelectionToJson. Values are little-endian.
+	std::string selectionToClipboardPayload(const Score& score, const NoteSelection& selection,
+	                                        const std::unordered_set<id_t>& hiSpeedSelection,
+	                                        int baseTick);
+
+	/// Clipboard text of a payload: the JSON text that older builds and other tools paste,
+	/// with the binary payload of the same notes as its first key
+	std::string clipboardText(const nlohmann::json& data, const std::string& payload);
+
+	/// Finds the binary payload of clipboard text without parsing its JSON
+	bool readClipboardPayload(std::string_view text, std::string& payload);
+
+	/// Replaces the notes, damages, holds and hi-speed changes of pasteData with those of a
+	/// JSON payload, placed on layer
+	void jsonToPasteData(const nlohmann::json& data, int layer, PasteData& pasteData);
+
+	/// Binary counterpart of jsonToPasteData. An invalid payload leaves pasteData empty and
+	/// returns false.
+	bool binaryToPasteData(const std::string& payload, int layer, PasteData& pasteData);
+}
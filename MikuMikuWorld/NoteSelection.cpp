@@ -0,0 +1,163 @@
+#include "NoteSelection.h"
+#include <algorithm>
+
+namespace MikuMikuWorld
+{
+	void NoteSelection::Iterator::skipUnset()
+	{
+		const uint32_t size = static_cast<uint32_t>(selection->keys.size());
+		while (index < size)
+		{
+			const uint64_t word = selection->bits[index / wordBits] >> (index % wordBits);
+			if (word == 0)
+			{
+				// Nothing else is selected in this word
+				index = (index / wordBits + 1) * wordBits;
+				continue;
+			}
+
+			if ((word & 1) && selection->isLive(index))
+				return;
+
+			++index;
+		}
+
+		index = size;
+	}
+
+	void NoteSelection::set(uint32_t index, id_t id)
+	{
+		if (index >= keys.size())
+		{
+			keys.resize(index + 1);
+			bits.resize((keys.size() + wordBits - 1) / wordBits);
+		}
+
+		uint64_t& word = bits[index / wordBits];
+		const uint64_t mask = uint64_t{ 1 } << (index % wordBits);
+		selectedCount += (word & mask) == 0;
+		word |= mask;
+		keys[index] = id;
+		summaryValid = false;
+	}
+
+	void NoteSelection::reset(uint32_t index)
+	{
+		bits[index / wordBits] &= ~(uint64_t{ 1 } << (index % wordBits));
+		--selectedCount;
+		summaryValid = false;
+	}
+
+	bool NoteSelection::insert(id_t id)
+	{
+		SlotHandle handle = score->notes.handle(id);
+		if (!handle.isValid() || (isSet(handle.index) && keys[handle.index] == id))
+			return false;
+
+		set(handle.index, id);
+		return true;
+	}
+
+	size_t NoteSelection::erase(id_t id)
+	{
+		SlotHandle handle = score->notes.handle(id);
+		if (!handle.isValid() || !isSet(handle.index) || keys[handle.index] != id)
+			return 0;
+
+		reset(handle.index);
+		return 1;
+	}
+
+	void NoteSelection::clear()
+	{
+		std::fill(bits.begin(), bits.end(), 0);
+		selectedCount = 0;
+		summary = {};
+		summaryValid = true;
+	}
+
+	NoteSelection::iterator NoteSelection::find(id_t id) const
+	{
+		return contains(id) ? iterator{ this, score->notes.handle(id).index } : end();
+	}
+
+	bool NoteSelection::contains(id_t id) const
+	{
+		SlotHandle handle = score->notes.handle(id);
+		return handle.isValid() && isSet(handle.index) && keys[handle.index] == id;
+	}
+
+	void NoteSelection::selectAll()
+	{
+		clear();
+		for (auto it = score->notes.begin(); it != score->notes.end(); ++it)
+			set(it.handle().index, it->first);
+	}
+
+	void NoteSelection::invalidate()
+	{
+		for (uint32_t w = 0; w < bits.size(); ++w)
+		{
+			uint32_t index = w * wordBits;
+			for (uint64_t word = bits[w]; word != 0; word >>= 1, ++index)
+			{
+				if ((word & 1) && !isLive(index))
+					reset(index);
+			}
+		}
+
+		summaryValid = false;
+	}
+
+	const SelectionSummary& NoteSelection::getSummary() const
+	{
+		if (!summaryValid)
+			updateSummary();
+
+		return summary;
+	}
+
+	void NoteSelection::updateSummary() const
+	{
+		summary = {};
+		for (id_t id : *this)
+		{
+			const Note& note = score->notes.at(id);
+			switch (note.getType())
+			{
+			case NoteType::Tap:
+				++summary.taps;
+				break;
+			case NoteType::Damage:
+				++summary.damages;
+				break;
+			case NoteType::HoldMid:
+				++summary.holdMids;
+				break;
+			case NoteType::Hold:
+			case NoteType::HoldEnd:
+			{
+				const bool isStart = note.getType() == NoteType::Hold;
+				if (isStart)
+					++summary.holdStarts;
+				else
+					++summary.holdEnds;
+
+				auto hold = score->holdNotes.find(isStart ? note.ID : note.parentID);
+				if (hold == score->holdNotes.end())
+					break;
+
+				if (hold->second.isGuide())
+					++summary.guideHoldEndpoints;
+				else
+					++summary.normalHoldEndpoints;
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		summaryValid = true;
+	}
+}
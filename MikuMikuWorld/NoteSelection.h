@@ -0,0 +1,133 @@
+#pragma once
+#include "Score.h"
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	/// Number of selected notes of each kind
+	struct SelectionSummary
+	{
+		size_t taps{};
+		size_t damages{};
+		size_t holdStarts{};
+		size_t holdMids{};
+		size_t holdEnds{};
+
+		/// Starts and ends of holds, split by whether the hold is a guide
+		size_t normalHoldEndpoints{};
+		size_t guideHoldEndpoints{};
+
+		size_t holdNotes() const { return holdStarts + holdMids + holdEnds; }
+		size_t eases() const { return holdStarts + holdMids; }
+		size_t flickables() const { return taps + holdEnds; }
+	};
+
+	/// Set of selected note IDs stored as a bitset over the slots of the score's note map.
+	/// Membership tests and select all do not hash note IDs, and the per kind summary is only
+	/// recounted after the selection or the score changes.
+	class NoteSelection
+	{
+	  private:
+		static constexpr uint32_t wordBits = 64;
+
+		const Score* score{};
+		std::vector<uint64_t> bits;
+		std::vector<id_t> keys;
+		size_t selectedCount{};
+
+		mutable SelectionSummary summary{};
+		mutable bool summaryValid{ true };
+
+		bool isSet(uint32_t index) const
+		{
+			return index < keys.size() && (bits[index / wordBits] >> (index % wordBits)) & 1;
+		}
+
+		bool isLive(uint32_t index) const { return score->notes.slotHolds(index, keys[index]); }
+		void set(uint32_t index, id_t id);
+		void reset(uint32_t index);
+		void updateSummary() const;
+
+	  public:
+		using value_type = id_t;
+		using size_type = size_t;
+
+		class Iterator
+		{
+		  private:
+			const NoteSelection* selection{};
+			uint32_t index{};
+
+			/// Moves to the next set bit whose note still exists
+			void skipUnset();
+
+			friend class NoteSelection;
+
+		  public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = id_t;
+			using difference_type = std::ptrdiff_t;
+			using reference = const id_t&;
+			using pointer = const id_t*;
+
+			Iterator() = default;
+			Iterator(const NoteSelection* selection, uint32_t index)
+			    : selection{ selection }, index{ index }
+			{
+				skipUnset();
+			}
+
+			reference operator*() const { return selection->keys[index]; }
+			pointer operator->() const { return &selection->keys[index]; }
+
+			Iterator& operator++()
+			{
+				++index;
+				skipUnset();
+				return *this;
+			}
+
+			Iterator operator++(int)
+			{
+				Iterator it = *this;
+				++(*this);
+				return it;
+			}
+
+			bool operator==(const Iterator& other) const { return index == other.index; }
+			bool operator!=(const Iterator& other) const { return index != other.index; }
+		};
+
+		using iterator = Iterator;
+		using const_iterator = Iterator;
+
+		explicit NoteSelection(const Score& score) : score{ &score } {}
+
+		iterator begin() const { return { this, 0 }; }
+		iterator end() const { return { this, static_cast<uint32_t>(keys.size()) }; }
+
+		size_t size() const { return selectedCount; }
+		bool empty() const { return selectedCount == 0; }
+
+		/// Selects a note of the score. Returns false if the note is already selected or does not
+		/// exist.
+		bool insert(id_t id);
+		size_t erase(id_t id);
+		void clear();
+
+		iterator find(id_t id) const;
+		bool contains(id_t id) const;
+		size_t count(id_t id) const { return contains(id); }
+
+		/// Selects every note of the score
+		void selectAll();
+
+		/// Must be called after the score changes. Drops notes that no longer exist and recounts
+		/// the summary on next use.
+		void invalidate();
+
+		const SelectionSummary& getSummary() const;
+	};
+}
@@ -2,9 +2,10 @@
 #include "Application.h"
 #include "File.h"
 #include "IO.h"
+#include "JobSystem.h"
 #include "JsonIO.h"
+#include "MemoryTracker.h"
 #include "Utilities.h"
-#include <execution>
 #include <filesystem>
 #include <fstream>
 
@@ -12,6 +13,40 @@ using nlohmann::json;
 
 namespace MikuMikuWorld
 {
+	static size_t getJsonMemoryUsage(const json& value)
+	{
+		switch (value.type())
+		{
+		case json::value_t::string:
+			return sizeof(json::string_t) + getMemoryUsage(value.get_ref<const json::string_t&>());
+
+		case json::value_t::array:
+		{
+			const json::array_t& array = value.get_ref<const json::array_t&>();
+			size_t bytes = sizeof(json::array_t) + getMemoryUsage(array);
+			for (const json& element : array)
+				bytes += getJsonMemoryUsage(element);
+
+			return bytes;
+		}
+
+		case json::value_t::object:
+		{
+			// Each member is a map node holding the key and the value
+			const json::object_t& object = value.get_ref<const json::object_t&>();
+			size_t bytes = sizeof(json::object_t) +
+			               object.size() * (sizeof(json::object_t::value_type) + 4 * sizeof(void*));
+			for (const auto& [key, member] : object)
+				bytes += getMemoryUsage(key) + getJsonMemoryUsage(member);
+
+			return bytes;
+		}
+
+		default:
+			return 0;
+		}
+	}
+
 	NotesPreset::NotesPreset(id_t _id, std::string _name) : ID{ _id }, name{ _name } {}
 
 	NotesPreset::NotesPreset() : ID{ static_cast<id_t>(-1) }, name{ "" }, description{ "" } {}
@@ -87,24 +122,24 @@ namespace MikuMikuWorld
 		std::vector<Result> warnings;
 		std::vector<Result> errors;
 
-		std::for_each(std::execution::par, filenames.begin(), filenames.end(),
-		              [this, &warnings, &errors, &m2](const auto& filename)
-		              {
-			              int id = nextPresetID++;
-
-			              NotesPreset preset(id, "");
-			              Result result = preset.read(filename);
-			              {
-				              std::lock_guard<std::mutex> lock{ m2 };
-
-				              if (result.getStatus() == ResultStatus::Success)
-					              presets.emplace(id, std::move(preset));
-				              else if (result.getStatus() == ResultStatus::Warning)
-					              warnings.push_back(result);
-				              else if (result.getStatus() == ResultStatus::Error)
-					              errors.push_back(result);
-			              }
-		              });
+		JobSystem::forEach(filenames.begin(), filenames.end(),
+		                   [this, &warnings, &errors, &m2](const auto& filename)
+		                   {
+			                   int id = nextPresetID++;
+
+			                   NotesPreset preset(id, "");
+			                   Result result = preset.read(filename);
+			                   {
+				                   std::lock_guard<std::mutex> lock{ m2 };
+
+				                   if (result.getStatus() == ResultStatus::Success)
+					                   presets.emplace(id, std::move(preset));
+				                   else if (result.getStatus() == ResultStatus::Warning)
+					                   warnings.push_back(result);
+				                   else if (result.getStatus() == ResultStatus::Error)
+					                   errors.push_back(result);
+			                   }
+		                   });
 
 		if (errors.size())
 		{
@@ -124,6 +159,8 @@ namespace MikuMikuWorld
 			IO::messageBox(APP_NAME, message, IO::MessageBoxButtons::Ok,
 			               IO::MessageBoxIcon::Warning);
 		}
+
+		updateMemoryUsage();
 	}
 
 	void PresetManager::savePresets(const std::string& path)
@@ -142,25 +179,25 @@ namespace MikuMikuWorld
 				std::filesystem::remove(wFullPath);
 		}
 
-		std::for_each(std::execution::par, createPresets.begin(), createPresets.end(),
-		              [this, &libPath](int id)
-		              {
-			              if (presets.find(id) != presets.end())
-			              {
-				              NotesPreset& preset = presets.at(id);
-
-				              // filename without extension
-				              // we will add the extension later after determining what the final
-				              // filename should be
-				              std::string filename =
-				                  (libPath / fixFilename(preset.getName())).u8string();
-				              preset.write(filename, false);
-			              }
-		              });
+		JobSystem::forEach(createPresets.begin(), createPresets.end(),
+		                   [this, &libPath](int id)
+		                   {
+			                   if (presets.find(id) != presets.end())
+			                   {
+				                   NotesPreset& preset = presets.at(id);
+
+				                   // filename without extension
+				                   // we will add the extension later after determining what the
+				                   // final filename should be
+				                   std::string filename =
+				                       (libPath / fixFilename(preset.getName())).u8string();
+				                   preset.write(filename, false);
+			                   }
+		                   });
 	}
 
 	void PresetManager::createPreset(const Score& score,
-	                                 const std::unordered_set<id_t>& selectedNotes,
+	                                 const NoteSelection& selectedNotes,
 	                                 const std::unordered_set<id_t>& selectedHiSpeedChanges,
 	                                 const std::string& name, const std::string& desc)
 	{
@@ -182,6 +219,7 @@ namespace MikuMikuWorld
 
 		presets[preset.getID()] = preset;
 		createPresets.push_back(preset.getID());
+		updateMemoryUsage();
 	}
 
 	void PresetManager::removePreset(int id)
@@ -194,6 +232,19 @@ namespace MikuMikuWorld
 			deletePresets.push_back(preset.getFilename());
 
 		presets.erase(id);
+		updateMemoryUsage();
+	}
+
+	void PresetManager::updateMemoryUsage() const
+	{
+		size_t bytes = getMemoryUsage(presets);
+		for (const auto& [id, preset] : presets)
+		{
+			bytes += getMemoryUsage(preset.name) + getMemoryUsage(preset.description) +
+			         getJsonMemoryUsage(preset.data);
+		}
+
+		MemoryTracker::set(MemoryCategory::Presets, bytes);
 	}
 
 	std::string PresetManager::fixFilename(const std::string& name)
@@ -42,13 +42,15 @@ namespace MikuMikuWorld
 		std::vector<int> createPresets;
 		std::vector<std::string> deletePresets;
 
+		void updateMemoryUsage() const;
+
 	  public:
 		std::unordered_map<int, NotesPreset> presets;
 
 		void loadPresets(const std::string& path);
 		void savePresets(const std::string& path);
 
-		void createPreset(const Score& score, const std::unordered_set<id_t>& selectedNotes,
+		void createPreset(const Score& score, const NoteSelection& selectedNotes,
 		                  const std::unordered_set<id_t>& selectedHiSpeedChanges,
 		                  const std::string& name, const std::string& desc);
 
@@ -0,0 +1,253 @@
+#include "Profiler.h"
+#include "IO.h"
+#include <algorithm>
+#include <deque>
+#include <json.hpp>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace MikuMikuWorld
+{
+	static_assert((Profiler::eventCapacity & (Profiler::eventCapacity - 1)) == 0,
+	              "The event capacity must be a power of two");
+
+	/// One zone of a ring buffer. The index is 0 while the owner writes the slot, so a reader can
+	/// tell whether the fields it copied belong to a single zone.
+	struct ProfilerEventSlot
+	{
+		/// Position of the zone in its thread's buffer plus one
+		std::atomic<uint64_t> index{};
+		std::atomic<const char*> name{};
+		std::atomic<uint64_t> begin{};
+		std::atomic<uint64_t> end{};
+		std::atomic<uint32_t> depth{};
+	};
+
+	/// Ring buffer of one thread's zones. Only the owning thread writes to it, readers copy the
+	/// zones behind the published count and drop the ones overwritten while copying.
+	struct ProfilerThreadBuffer
+	{
+		std::unique_ptr<ProfilerEventSlot[]> events{
+			new ProfilerEventSlot[Profiler::eventCapacity]
+		};
+		std::atomic<uint64_t> count{};
+		uint32_t depth{};
+		uint32_t id{};
+		std::string name;
+		bool active{};
+	};
+
+	static std::mutex buffersMutex;
+	static std::vector<std::unique_ptr<ProfilerThreadBuffer>> buffers;
+
+	static std::mutex framesMutex;
+	static std::deque<ProfileFrame> frames;
+	static ProfilerThreadBuffer* frameThread{};
+	static uint64_t frameBegin{};
+	static uint32_t frameDepth{};
+	static bool frameStarted{};
+
+	std::atomic<bool> Profiler::enabled{ false };
+
+	/// Hands the thread's buffer back when the thread exits so short lived threads reuse buffers
+	/// instead of adding new ones
+	class ProfilerThreadSlot
+	{
+	  public:
+		ProfilerThreadBuffer* buffer{};
+
+		~ProfilerThreadSlot()
+		{
+			if (!buffer)
+				return;
+
+			std::lock_guard lock{ buffersMutex };
+			buffer->active = false;
+			buffer->depth = 0;
+		}
+	};
+
+	static thread_local ProfilerThreadSlot threadSlot;
+
+	static ProfilerThreadBuffer& getThreadBuffer()
+	{
+		if (threadSlot.buffer)
+			return *threadSlot.buffer;
+
+		std::lock_guard lock{ buffersMutex };
+		auto it = std::find_if(buffers.begin(), buffers.end(),
+		                       [](const auto& buffer) { return !buffer->active; });
+		if (it == buffers.end())
+		{
+			buffers.push_back(std::make_unique<ProfilerThreadBuffer>());
+			buffers.back()->id = static_cast<uint32_t>(buffers.size());
+			it = buffers.end() - 1;
+		}
+
+		ProfilerThreadBuffer* buffer = it->get();
+		buffer->active = true;
+		buffer->name = IO::formatString("Thread %u", buffer->id);
+		threadSlot.buffer = buffer;
+		return *buffer;
+	}
+
+	/// Appends the zones of buffer that end after from and start before to
+	static void copyEvents(const ProfilerThreadBuffer& buffer, uint64_t from, uint64_t to,
+	                       std::vector<ProfileEvent>& events)
+	{
+		constexpr uint64_t mask = Profiler::eventCapacity - 1;
+		const uint64_t count = buffer.count.load(std::memory_order_acquire);
+		const uint64_t first =
+		    count > Profiler::eventCapacity ? count - Profiler::eventCapacity : 0;
+
+		// Zones are stored in the order they end, so walk back until they end before from
+		std::vector<ProfileEvent> copied;
+		for (uint64_t i = count; i > first; --i)
+		{
+			// Slots are overwritten oldest first, so once this zone is gone the older ones are too
+			const ProfilerEventSlot& slot = buffer.events[(i - 1) & mask];
+			if (slot.index.load(std::memory_order_acquire) != i)
+				break;
+
+			const ProfileEvent event{ slot.name.load(std::memory_order_relaxed),
+				                      slot.begin.load(std::memory_order_relaxed),
+				                      slot.end.load(std::memory_order_relaxed),
+				                      slot.depth.load(std::memory_order_relaxed) };
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.index.load(std::memory_order_relaxed) != i)
+				break;
+
+			if (event.end < from)
+				break;
+
+			if (event.begin <= to)
+				copied.push_back(event);
+		}
+
+		events.insert(events.end(), copied.rbegin(), copied.rend());
+	}
+
+	void Profiler::setEnabled(bool enable) { enabled.store(enable, std::memory_order_relaxed); }
+
+	void Profiler::setThreadName(const std::string& name)
+	{
+		ProfilerThreadBuffer& buffer = getThreadBuffer();
+		std::lock_guard lock{ buffersMutex };
+		buffer.name = name;
+	}
+
+	uint32_t Profiler::beginZone() { return getThreadBuffer().depth++; }
+
+	void Profiler::endZone(const char* name, uint64_t begin, uint32_t depth)
+	{
+		ProfilerThreadBuffer& buffer = getThreadBuffer();
+		const uint64_t count = buffer.count.load(std::memory_order_relaxed);
+		const uint64_t end = now();
+
+		ProfilerEventSlot& slot = buffer.events[count & (eventCapacity - 1)];
+		slot.index.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.name.store(name, std::memory_order_relaxed);
+		slot.begin.store(begin, std::memory_order_relaxed);
+		slot.end.store(end, std::memory_order_relaxed);
+		slot.depth.store(depth, std::memory_order_relaxed);
+		slot.index.store(count + 1, std::memory_order_release);
+		buffer.count.store(count + 1, std::memory_order_release);
+		buffer.depth = depth;
+	}
+
+	void Profiler::beginFrame()
+	{
+		frameStarted = isEnabled();
+		if (!frameStarted)
+			return;
+
+		frameThread = &getThreadBuffer();
+		frameDepth = beginZone();
+		frameBegin = now();
+	}
+
+	void Profiler::endFrame()
+	{
+		if (!frameStarted)
+			return;
+
+		endZone("Frame", frameBegin, frameDepth);
+		frameStarted = false;
+
+		std::lock_guard lock{ framesMutex };
+		frames.push_back({ frameBegin, now() });
+		if (frames.size() > frameCapacity)
+			frames.pop_front();
+	}
+
+	std::vector<ProfileFrame> Profiler::getFrames()
+	{
+		std::lock_guard lock{ framesMutex };
+		return { frames.begin(), frames.end() };
+	}
+
+	std::vector<ProfileEvent> Profiler::getFrameEvents(uint64_t begin, uint64_t end)
+	{
+		std::vector<ProfileEvent> events;
+		if (!frameThread)
+			return events;
+
+		copyEvents(*frameThread, begin, end, events);
+		std::stable_sort(events.begin(), events.end(),
+		                 [](const ProfileEvent& a, const ProfileEvent& b) {
+			                 return a.begin < b.begin || (a.begin == b.begin && a.depth < b.depth);
+		                 });
+
+		return events;
+	}
+
+	void Profiler::writeChromeTrace(const std::string& filename, uint64_t begin, uint64_t end)
+	{
+		std::vector<std::pair<uint32_t, std::string>> threads;
+		std::vector<std::vector<ProfileEvent>> threadEvents;
+		{
+			std::lock_guard lock{ buffersMutex };
+			for (const auto& buffer : buffers)
+			{
+				threads.emplace_back(buffer->id, buffer->name);
+				copyEvents(*buffer, begin, end, threadEvents.emplace_back());
+			}
+		}
+
+		std::string trace = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		for (const auto& [id, name] : threads)
+		{
+			trace += IO::formatString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+			                          "\"args\":{\"name\":%s}},\n",
+			                          id, nlohmann::json(name).dump().c_str());
+		}
+
+		// Chrome trace timestamps are in microseconds
+		for (size_t t = 0; t < threads.size(); ++t)
+		{
+			for (const ProfileEvent& event : threadEvents[t])
+			{
+				trace += IO::formatString(
+				    "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,"
+				    "\"dur\":%.3f},\n",
+				    event.name, threads[t].first,
+				    static_cast<int64_t>(event.begin - begin) / 1e3,
+				    (event.end - event.begin) / 1e3);
+			}
+		}
+
+		// Drop the trailing comma of the last event
+		if (trace[trace.size() - 2] == ',')
+			trace.erase(trace.size() - 2, 1);
+		trace += "]}\n";
+
+		FILE* stream = IO::openFileStream(IO::mbToWideStr(filename), L"wb");
+		if (!stream)
+			throw std::runtime_error("Failed to open " + filename);
+
+		fwrite(trace.data(), 1, trace.size(), stream);
+		fclose(stream);
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+/// Records the enclosing scope as a profiler zone. The name must be a string literal.
+#define PROFILE_SCOPE(name) \
+	MikuMikuWorld::ProfileScope PROFILE_CONCAT(profileScope, __LINE__) { name }
+
+namespace MikuMikuWorld
+{
+	/// A finished zone. Times are in profiler ticks, see Profiler::now.
+	struct ProfileEvent
+	{
+		const char* name{};
+		uint64_t begin{};
+		uint64_t end{};
+		uint32_t depth{};
+	};
+
+	struct ProfileFrame
+	{
+		uint64_t begin{};
+		uint64_t end{};
+	};
+
+	/// Collects zones of every thread into per thread ring buffers. Recording only touches the
+	/// calling thread's buffer, so zones can be placed in hot paths and on worker threads.
+	class Profiler
+	{
+	  private:
+		static std::atomic<bool> enabled;
+
+	  public:
+		/// Number of zones kept per thread. At 60 FPS this holds about a minute of frames.
+		static constexpr size_t eventCapacity = 1 << 16;
+		static constexpr size_t frameCapacity = 1024;
+
+		static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+		static void setEnabled(bool enable);
+
+		/// Profiler ticks are steady_clock nanoseconds
+		static uint64_t now()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			           std::chrono::steady_clock::now().time_since_epoch())
+			    .count();
+		}
+
+		static double toMilliseconds(uint64_t ticks) { return ticks / 1e6; }
+
+		/// Name shown for the calling thread in exported traces
+		static void setThreadName(const std::string& name);
+
+		static uint32_t beginZone();
+		static void endZone(const char* name, uint64_t begin, uint32_t depth);
+
+		/// Frames are recorded as a zone named "Frame" by the thread that calls these
+		static void beginFrame();
+		static void endFrame();
+
+		/// Most recent frames, oldest first
+		static std::vector<ProfileFrame> getFrames();
+
+		/// Zones of the thread recording the frames that overlap begin and end, ordered by start
+		static std::vector<ProfileEvent> getFrameEvents(uint64_t begin, uint64_t end);
+
+		/// Writes the zones of every thread between begin and end in the Chrome trace event format,
+		/// which can be opened in chrome://tracing or Perfetto
+		static void writeChromeTrace(const std::string& filename, uint64_t begin, uint64_t end);
+	};
+
+	class ProfileScope
+	{
+	  private:
+		const char* name;
+		uint64_t begin{};
+		uint32_t depth{};
+
+	  public:
+		explicit ProfileScope(const char* name)
+		    : name{ Profiler::isEnabled() ? name : nullptr }
+		{
+			if (this->name)
+			{
+				depth = Profiler::beginZone();
+				begin = Profiler::now();
+			}
+		}
+
+		~ProfileScope()
+		{
+			if (name)
+				Profiler::endZone(name, begin, depth);
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	};
+}
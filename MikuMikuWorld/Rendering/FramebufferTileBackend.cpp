@@ -0,0 +1,50 @@
+#include "FramebufferTileBackend.h"
+#include "../ImGui/imgui_impl_opengl3.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+namespace MikuMikuWorld
+{
+	void FramebufferTileBackend::resize(size_t slot, int width, int height)
+	{
+		if (slot >= framebuffers.size())
+			framebuffers.resize(slot + 1);
+
+		if (!framebuffers[slot])
+			framebuffers[slot] = std::make_unique<Framebuffer>(width, height);
+		else
+			framebuffers[slot]->resize(width, height);
+	}
+
+	void FramebufferTileBackend::render(size_t slot, ImDrawList* drawList, int width, int height)
+	{
+		Framebuffer& framebuffer = *framebuffers[slot];
+		framebuffer.bind();
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		ImDrawData drawData{};
+		drawData.Valid = true;
+		drawData.CmdListsCount = 1;
+		drawData.CmdLists = &drawList;
+		drawData.TotalIdxCount = drawList->IdxBuffer.Size;
+		drawData.TotalVtxCount = drawList->VtxBuffer.Size;
+		drawData.DisplayPos = { 0.0f, 0.0f };
+		drawData.DisplaySize = { static_cast<float>(width), static_cast<float>(height) };
+		drawData.FramebufferScale = { 1.0f, 1.0f };
+		ImGui_ImplOpenGL3_RenderDrawData(&drawData);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	ImTextureID FramebufferTileBackend::getTexture(size_t slot) const
+	{
+		return (ImTextureID)framebuffers[slot]->getTexture();
+	}
+
+	void FramebufferTileBackend::setPremultipliedBlend(const ImDrawList* parentList,
+	                                                   const ImDrawCmd* cmd)
+	{
+		glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "Framebuffer.h"
+#include "TileCache.h"
+#include <memory>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	/// Renders tiles into OpenGL framebuffers through the ImGui OpenGL backend
+	class FramebufferTileBackend : public TileBackend
+	{
+	  private:
+		std::vector<std::unique_ptr<Framebuffer>> framebuffers;
+
+	  public:
+		void resize(size_t slot, int width, int height) override;
+		void render(size_t slot, ImDrawList* drawList, int width, int height) override;
+		ImTextureID getTexture(size_t slot) const override;
+
+		/// Tiles hold premultiplied colors, so they must be composited with this blend mode.
+		/// Use as an ImDrawList callback before adding the tile images.
+		static void setPremultipliedBlend(const ImDrawList* parentList, const ImDrawCmd* cmd);
+	};
+}
@@ -0,0 +1,188 @@
+#include "ImageBlur.h"
+#include "../JobSystem.h"
+#include "../Profiler.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MMW_BLUR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace MikuMikuWorld
+{
+	constexpr int blurPasses = 3;
+	constexpr int blurRowsPerJob = 32;
+	constexpr int blurColumnsPerJob = 64;
+
+	// A downscaled blur shrinks the image until its radius is about this many pixels
+	constexpr int downscaledBlurRadius = 2;
+
+#ifdef MMW_BLUR_SSE2
+	/// Running sum of the four channels of a pixel, one channel per lane
+	struct PixelSum
+	{
+		__m128i value = _mm_setzero_si128();
+
+		static __m128i load(const uint8_t* pixel)
+		{
+			int32_t bytes;
+			memcpy(&bytes, pixel, sizeof(bytes));
+
+			const __m128i zero = _mm_setzero_si128();
+			return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero);
+		}
+
+		void add(const uint8_t* pixel) { value = _mm_add_epi32(value, load(pixel)); }
+		void subtract(const uint8_t* pixel) { value = _mm_sub_epi32(value, load(pixel)); }
+
+		void store(uint8_t* pixel, __m128 scale) const
+		{
+			__m128i result = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(value), scale));
+			result = _mm_packs_epi32(result, result);
+			result = _mm_packus_epi16(result, result);
+
+			const int32_t bytes = _mm_cvtsi128_si32(result);
+			memcpy(pixel, &bytes, sizeof(bytes));
+		}
+	};
+
+	using BlurScale = __m128;
+	static BlurScale getBlurScale(int radius) { return _mm_set1_ps(1.0f / (radius * 2 + 1)); }
+#else
+	struct PixelSum
+	{
+		int32_t value[4]{};
+
+		void add(const uint8_t* pixel)
+		{
+			for (int c = 0; c < 4; ++c)
+				value[c] += pixel[c];
+		}
+
+		void subtract(const uint8_t* pixel)
+		{
+			for (int c = 0; c < 4; ++c)
+				value[c] -= pixel[c];
+		}
+
+		void store(uint8_t* pixel, float scale) const
+		{
+			for (int c = 0; c < 4; ++c)
+				pixel[c] = static_cast<uint8_t>(value[c] * scale + 0.5f);
+		}
+	};
+
+	using BlurScale = float;
+	static BlurScale getBlurScale(int radius) { return 1.0f / (radius * 2 + 1); }
+#endif
+
+	static void blurRows(const uint8_t* source, uint8_t* target, int width, int firstRow,
+	                     int lastRow, int radius)
+	{
+		const BlurScale scale = getBlurScale(radius);
+		for (int y = firstRow; y < lastRow; ++y)
+		{
+			const uint8_t* row = source + static_cast<size_t>(y) * width * 4;
+			uint8_t* output = target + static_cast<size_t>(y) * width * 4;
+			auto pixel = [row, width](int x) { return row + std::clamp(x, 0, width - 1) * 4; };
+
+			PixelSum sum;
+			for (int x = -radius; x <= radius; ++x)
+				sum.add(pixel(x));
+
+			for (int x = 0; x < width; ++x)
+			{
+				sum.store(output + x * 4, scale);
+				sum.add(pixel(x + radius + 1));
+				sum.subtract(pixel(x - radius));
+			}
+		}
+	}
+
+	/// Walks down a strip of columns keeping one running sum per column, so every step reads whole
+	/// rows of memory
+	static void blurColumns(const uint8_t* source, uint8_t* target, int width, int height,
+	                        int firstColumn, int lastColumn, int radius)
+	{
+		const BlurScale scale = getBlurScale(radius);
+		const size_t stride = static_cast<size_t>(width) * 4;
+		auto row = [source, height, stride](int y)
+		{ return source + std::clamp(y, 0, height - 1) * stride; };
+
+		std::vector<PixelSum> sums(lastColumn - firstColumn);
+		for (int y = -radius; y <= radius; ++y)
+		{
+			const uint8_t* pixels = row(y);
+			for (int x = firstColumn; x < lastColumn; ++x)
+				sums[x - firstColumn].add(pixels + x * 4);
+		}
+
+		for (int y = 0; y < height; ++y)
+		{
+			const uint8_t* incoming = row(y + radius + 1);
+			const uint8_t* outgoing = row(y - radius);
+			uint8_t* output = target + y * stride;
+
+			for (int x = firstColumn; x < lastColumn; ++x)
+			{
+				PixelSum& sum = sums[x - firstColumn];
+				sum.store(output + x * 4, scale);
+				sum.add(incoming + x * 4);
+				sum.subtract(outgoing + x * 4);
+			}
+		}
+	}
+
+	void blurImage(ImageData& image, int radius)
+	{
+		if (radius < 1 || !image.isValid())
+			return;
+
+		PROFILE_SCOPE("blurImage");
+
+		std::vector<int> rowStarts;
+		for (int y = 0; y < image.height; y += blurRowsPerJob)
+			rowStarts.push_back(y);
+
+		std::vector<int> columnStarts;
+		for (int x = 0; x < image.width; x += blurColumnsPerJob)
+			columnStarts.push_back(x);
+
+		std::vector<uint8_t> buffer(image.pixels.size());
+		for (int pass = 0; pass < blurPasses; ++pass)
+		{
+			JobSystem::forEach(rowStarts.begin(), rowStarts.end(),
+			                   [&](int first)
+			                   {
+				                   blurRows(image.pixels.data(), buffer.data(), image.width, first,
+				                            std::min(first + blurRowsPerJob, image.height), radius);
+			                   });
+
+			JobSystem::forEach(columnStarts.begin(), columnStarts.end(),
+			                   [&](int first)
+			                   {
+				                   blurColumns(buffer.data(), image.pixels.data(), image.width,
+				                               image.height, first,
+				                               std::min(first + blurColumnsPerJob, image.width),
+				                               radius);
+			                   });
+		}
+	}
+
+	ImageData blurImageDownscaled(const ImageData& image, int radius)
+	{
+		const int factor = std::max(1, radius / downscaledBlurRadius);
+		if (factor == 1)
+		{
+			ImageData result = image;
+			blurImage(result, radius);
+			return result;
+		}
+
+		ImageData result = downscaleImage(image, std::max(1, image.width / factor),
+		                                  std::max(1, image.height / factor));
+		blurImage(result, radius / factor);
+		return result;
+	}
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "ImageLoader.h"
+
+namespace MikuMikuWorld
+{
+	/// Approximates a gaussian blur with three box blur passes. Each pass runs the rows and then
+	/// the columns as running sums, split across the job system. Edges are extended.
+	void blurImage(ImageData& image, int radius);
+
+	/// Blurs a copy of image scaled down until the blur radius is only a few pixels wide. A heavy
+	/// blur removes the detail the full size would keep, so the smaller result can be drawn
+	/// stretched at no visible cost.
+	ImageData blurImageDownscaled(const ImageData& image, int radius);
+}
@@ -0,0 +1,125 @@
+#include "ImageLoader.h"
+#include "../Profiler.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <cmath>
+
+namespace MikuMikuWorld
+{
+	ImageData decodeImage(const std::string& filename, int coverWidth, int coverHeight)
+	{
+		PROFILE_SCOPE("decodeImage");
+
+		ImageData image;
+		int channels{};
+		stbi_uc* data = stbi_load(filename.c_str(), &image.width, &image.height, &channels, 4);
+		if (!data)
+			return {};
+
+		image.sourceWidth = image.width;
+		image.sourceHeight = image.height;
+		image.pixels.assign(data, data + static_cast<size_t>(image.width) * image.height * 4);
+		stbi_image_free(data);
+
+		if (coverWidth < 1 || coverHeight < 1)
+			return image;
+
+		const float scale = std::max(static_cast<float>(coverWidth) / image.width,
+		                             static_cast<float>(coverHeight) / image.height);
+		if (scale >= 1.0f)
+			return image;
+
+		const int width = std::max(1, static_cast<int>(std::ceil(image.width * scale)));
+		const int height = std::max(1, static_cast<int>(std::ceil(image.height * scale)));
+		return downscaleImage(image, width, height);
+	}
+
+	ImageData downscaleImage(const ImageData& image, int width, int height)
+	{
+		PROFILE_SCOPE("downscaleImage");
+
+		ImageData result;
+		result.width = width;
+		result.height = height;
+		result.sourceWidth = image.sourceWidth;
+		result.sourceHeight = image.sourceHeight;
+		result.pixels.resize(static_cast<size_t>(width) * height * 4);
+
+		// Column spans are the same for every row
+		std::vector<int> columnStarts(width + 1);
+		for (int x = 0; x <= width; ++x)
+			columnStarts[x] = static_cast<int>(static_cast<int64_t>(x) * image.width / width);
+
+		for (int y = 0; y < height; ++y)
+		{
+			const int y0 = static_cast<int>(static_cast<int64_t>(y) * image.height / height);
+			const int y1 = std::max(
+			    y0 + 1, static_cast<int>(static_cast<int64_t>(y + 1) * image.height / height));
+
+			for (int x = 0; x < width; ++x)
+			{
+				const int x0 = columnStarts[x];
+				const int x1 = std::max(x0 + 1, columnStarts[x + 1]);
+
+				uint32_t sum[4]{};
+				for (int sy = y0; sy < y1; ++sy)
+				{
+					const uint8_t* pixel =
+					    &image.pixels[(static_cast<size_t>(sy) * image.width + x0) * 4];
+					for (int sx = x0; sx < x1; ++sx, pixel += 4)
+					{
+						sum[0] += pixel[0];
+						sum[1] += pixel[1];
+						sum[2] += pixel[2];
+						sum[3] += pixel[3];
+					}
+				}
+
+				const uint32_t count = (x1 - x0) * (y1 - y0);
+				uint8_t* target = &result.pixels[(static_cast<size_t>(y) * width + x) * 4];
+				for (int c = 0; c < 4; ++c)
+					target[c] = static_cast<uint8_t>((sum[c] + count / 2) / count);
+			}
+		}
+
+		return result;
+	}
+
+	void ImageLoader::load(const std::string& filename, int coverWidth, int coverHeight)
+	{
+		cancel();
+
+		request = std::make_shared<Request>();
+		token = CancellationToken{};
+		JobSystem::schedule(
+		    [request = request, token = token, filename, coverWidth, coverHeight]
+		    {
+			    request->image = decodeImage(filename, coverWidth, coverHeight);
+			    if (token.isCancelled())
+				    return;
+
+			    // Handing the flag over on the main thread also wakes the UI to pick the image up
+			    JobSystem::runOnMainThread([request] { request->ready = true; });
+		    },
+		    JobPriority::Normal, token);
+	}
+
+	void ImageLoader::cancel()
+	{
+		if (!request)
+			return;
+
+		token.cancel();
+		request = nullptr;
+	}
+
+	bool ImageLoader::poll(ImageData& image)
+	{
+		if (!request || !request->ready)
+			return false;
+
+		image = std::move(request->image);
+		request = nullptr;
+		return true;
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "../JobSystem.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	/// RGBA pixels decoded from an image file
+	struct ImageData
+	{
+		int width{};
+		int height{};
+
+		/// Size of the file before it was downscaled
+		int sourceWidth{};
+		int sourceHeight{};
+
+		std::vector<uint8_t> pixels;
+
+		bool isValid() const { return width > 0 && height > 0; }
+	};
+
+	/// Decodes an image file and shrinks it as far as it still covers coverWidth by coverHeight,
+	/// keeping the aspect ratio. A cover size of 0 keeps the full resolution. Safe to call from any
+	/// thread, a file that fails to decode returns an empty image.
+	ImageData decodeImage(const std::string& filename, int coverWidth = 0, int coverHeight = 0);
+
+	/// Averages the source pixels under each target pixel
+	ImageData downscaleImage(const ImageData& image, int width, int height);
+
+	/// Decodes one image at a time on the job system so large files do not stall the UI. Starting a
+	/// new load or cancelling drops the result of the previous one.
+	class ImageLoader
+	{
+	  private:
+		struct Request
+		{
+			ImageData image;
+			bool ready{};
+		};
+
+		std::shared_ptr<Request> request;
+		CancellationToken token;
+
+	  public:
+		void load(const std::string& filename, int coverWidth, int coverHeight);
+		void cancel();
+
+		inline bool isLoading() const { return request != nullptr; }
+
+		/// Moves the decoded image out once it has been handed back to the main thread. Returns
+		/// false while the image is still decoding or if nothing was loaded.
+		bool poll(ImageData& image);
+	};
+}
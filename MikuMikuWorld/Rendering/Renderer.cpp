@@ -1,4 +1,5 @@
 #include "Renderer.h"
+#include "../Profiler.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <algorithm>
@@ -151,6 +152,12 @@ namespace MikuMikuWorld
 			q.vertices[i].uv = uvCoords[i];
 		}
 
+		if (captureTarget)
+		{
+			captureTarget->push_back(q);
+			return;
+		}
+
 		quads.push_back(q);
 
 		++numQuads;
@@ -158,6 +165,26 @@ namespace MikuMikuWorld
 		numIndices += 6;
 	}
 
+	void Renderer::beginCapture(std::vector<Quad>& target) { captureTarget = &target; }
+
+	void Renderer::endCapture() { captureTarget = nullptr; }
+
+	void Renderer::drawQuads(const Quad* source, size_t count, const Vector2& offset)
+	{
+		const DirectX::XMMATRIX translation =
+		    DirectX::XMMatrixTranslation(offset.x, offset.y, 0.0f);
+		for (size_t i = 0; i < count; ++i)
+		{
+			Quad q = source[i];
+			q.matrix = DirectX::XMMatrixMultiply(q.matrix, translation);
+			quads.push_back(q);
+		}
+
+		numQuads += count;
+		numVertices += count * 4;
+		numIndices += count * 6;
+	}
+
 	void Renderer::resetRenderStats()
 	{
 		numIndices = 0;
@@ -181,6 +208,7 @@ namespace MikuMikuWorld
 
 	void Renderer::endBatch()
 	{
+		PROFILE_SCOPE("Renderer::endBatch");
 		numBatchVertices = numVertices;
 		numBatchQuads = numQuads;
 
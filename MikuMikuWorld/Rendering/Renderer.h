@@ -28,6 +28,7 @@ namespace MikuMikuWorld
 		unsigned int vao, vbo, ebo;
 		int texID;
 		bool batchStarted;
+		std::vector<Quad>* captureTarget{};
 
 		void init();
 		void resetRenderStats();
@@ -56,6 +57,13 @@ namespace MikuMikuWorld
 		              const std::array<DirectX::XMVECTOR, 4>& uv, const DirectX::XMMATRIX& m,
 		              const DirectX::XMVECTOR& col, int tex, int z);
 
+		/// Stores the quads drawn until endCapture in target instead of adding them to the batch
+		void beginCapture(std::vector<Quad>& target);
+		void endCapture();
+
+		/// Adds count captured quads to the batch, translated by offset
+		void drawQuads(const Quad* source, size_t count, const Vector2& offset);
+
 		void bindTexture(int tex);
 		void beginBatch();
 		void endBatch();
@@ -1,5 +1,7 @@
 #include "../File.h"
 #include "../IO.h"
+#include "../MemoryTracker.h"
+#include "ImageLoader.h"
 #include "Texture.h"
 #include <glad/glad.h>
 #include "GLFW/glfw3.h"
@@ -21,7 +23,38 @@ namespace MikuMikuWorld
 		this->filename = filename;
 		name = File::getFilenameWithoutExtension(filename);
 		read(filename, min, mag);
+		loadSprites();
+	}
+
+	Texture::Texture(const std::string& filename, TextureFilterMode filter)
+	    : Texture(filename, filter, filter)
+	{
+	}
+
+	Texture::Texture(const std::string& filename, const ImageData& image, TextureFilterMode filter)
+	{
+		this->filename = filename;
+		name = File::getFilenameWithoutExtension(filename);
+		width = image.width;
+		height = image.height;
+		upload(image.isValid() ? image.pixels.data() : nullptr, filter, filter);
 
+		sprites.push_back(Sprite(name, 0, 0, width, height));
+	}
+
+	Texture::Texture(const std::string& filename, const ImageData& image, TextureFilterMode min,
+	                 TextureFilterMode mag)
+	{
+		this->filename = filename;
+		name = File::getFilenameWithoutExtension(filename);
+		width = image.width;
+		height = image.height;
+		upload(image.isValid() ? image.pixels.data() : nullptr, min, mag);
+		loadSprites();
+	}
+
+	void Texture::loadSprites()
+	{
 		std::string sprSheet = File::getFilepath(filename) + "spr/" + name + ".txt";
 		if (File::exists(sprSheet))
 		{
@@ -33,14 +66,19 @@ namespace MikuMikuWorld
 		}
 	}
 
-	Texture::Texture(const std::string& filename, TextureFilterMode filter)
-	    : Texture(filename, filter, filter)
+	void Texture::bind() const { glBindTexture(GL_TEXTURE_2D, glID); }
+
+	// RGBA pixels plus a full mip chain, which adds a third of the base level
+	static size_t getTextureBytes(int width, int height)
 	{
+		return static_cast<size_t>(width) * height * 4 * 4 / 3;
 	}
 
-	void Texture::bind() const { glBindTexture(GL_TEXTURE_2D, glID); }
-
-	void Texture::dispose() const { glDeleteTextures(1, &glID); }
+	void Texture::dispose() const
+	{
+		glDeleteTextures(1, &glID);
+		MemoryTracker::remove(MemoryCategory::Textures, getTextureBytes(width, height));
+	}
 
 	void Texture::readSprites(const std::string& filename)
 	{
@@ -71,14 +109,26 @@ namespace MikuMikuWorld
 	void Texture::read(const std::string& filename, TextureFilterMode minFilter,
 	                   TextureFilterMode magFilter)
 	{
-		glGenTextures(1, &glID);
-		glBindTexture(GL_TEXTURE_2D, glID);
-
 		int nrChannels;
 		stbi_set_flip_vertically_on_load(0);
 		auto data = stbi_load(filename.c_str(), &width, &height, &nrChannels, 4);
+		if (!data)
+			width = height = 0;
 
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		upload(data, minFilter, magFilter);
+		free(data);
+	}
+
+	void Texture::upload(const void* pixels, TextureFilterMode minFilter,
+	                     TextureFilterMode magFilter)
+	{
+		glGenTextures(1, &glID);
+		glBindTexture(GL_TEXTURE_2D, glID);
+
+		MemoryTracker::add(MemoryCategory::Textures, getTextureBytes(width, height));
+
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+		             pixels);
 		glGenerateMipmap(GL_TEXTURE_2D);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -86,6 +136,5 @@ namespace MikuMikuWorld
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (GLint)magFilter);
 
 		glBindTexture(GL_TEXTURE_2D, 0);
-		free(data);
 	}
 }
@@ -7,6 +7,8 @@
 
 namespace MikuMikuWorld
 {
+	struct ImageData;
+
 	enum class WrapMode
 	{
 		Clamp,
@@ -33,6 +35,8 @@ namespace MikuMikuWorld
 		unsigned int glID;
 
 		Sprite parseSprite(const IO::File& f, const std::string& line);
+		void upload(const void* pixels, TextureFilterMode minFilter, TextureFilterMode magFilter);
+		void loadSprites();
 
 	  public:
 		std::vector<Sprite> sprites;
@@ -41,6 +45,14 @@ namespace MikuMikuWorld
 		Texture(const std::string& filename, TextureFilterMode filter);
 		Texture(const std::string& filename);
 
+		/// Uploads pixels that were decoded ahead of time, see decodeImage
+		Texture(const std::string& filename, const ImageData& image,
+		        TextureFilterMode filter = TextureFilterMode::Linear);
+
+		/// Same as above but also reads the sprite sheet next to filename like a loaded texture
+		Texture(const std::string& filename, const ImageData& image, TextureFilterMode min,
+		        TextureFilterMode mag);
+
 		inline int getWidth() const { return width; }
 		inline int getHeight() const { return height; }
 		inline unsigned int getID() const { return glID; }
@@ -0,0 +1,103 @@
+#include "TileCache.h"
+#include <algorithm>
+
+namespace MikuMikuWorld
+{
+	TileCache::TileCache(std::unique_ptr<TileBackend> backend, int tileHeight)
+	    : backend{ std::move(backend) }, drawList{ ImGui::GetDrawListSharedData() },
+	      tileHeight{ tileHeight }
+	{
+	}
+
+	void TileCache::validate(uint64_t key, int width)
+	{
+		if (this->key == key && tileWidth == width)
+			return;
+
+		this->key = key;
+		if (tileWidth != width)
+		{
+			tileWidth = width;
+			for (size_t slot = 0; slot < tiles.size(); ++slot)
+				backend->resize(slot, tileWidth, tileHeight);
+		}
+
+		invalidate();
+	}
+
+	void TileCache::invalidate()
+	{
+		for (auto& tile : tiles)
+			tile.valid = false;
+	}
+
+	size_t TileCache::findSlot(int index, int firstIndex, int lastIndex)
+	{
+		size_t freeSlot = tiles.size();
+		for (size_t slot = 0; slot < tiles.size(); ++slot)
+		{
+			const Tile& tile = tiles[slot];
+			if (tile.valid && tile.index == index)
+				return slot;
+
+			// Prefer the least recently used tile that is not needed this frame
+			const bool inUse =
+			    tile.valid && tile.index >= firstIndex && tile.index <= lastIndex;
+			if (!inUse && (freeSlot == tiles.size() || !tile.valid ||
+			               (tiles[freeSlot].valid && tile.lastUsed < tiles[freeSlot].lastUsed)))
+				freeSlot = slot;
+		}
+
+		// Keep a couple of spare tiles around so scrolling back and forth does not redraw
+		const size_t maxTiles = static_cast<size_t>(lastIndex - firstIndex + 1) + 2;
+		if (freeSlot == tiles.size() || (tiles[freeSlot].valid && tiles.size() < maxTiles))
+		{
+			freeSlot = tiles.size();
+			tiles.push_back({});
+			backend->resize(freeSlot, tileWidth, tileHeight);
+		}
+
+		return freeSlot;
+	}
+
+	void TileCache::update(int firstIndex, int lastIndex, const DrawTileFunction& draw)
+	{
+		++frame;
+		if (tileWidth <= 0 || tileHeight <= 0)
+			return;
+
+		for (int index = firstIndex; index <= lastIndex; ++index)
+		{
+			const size_t slot = findSlot(index, firstIndex, lastIndex);
+			Tile& tile = tiles[slot];
+			tile.lastUsed = frame;
+			if (tile.valid && tile.index == index)
+				continue;
+
+			drawList._ResetForNewFrame();
+			drawList.PushTextureID(ImGui::GetIO().Fonts->TexID);
+			const ImVec2 tileSize{ static_cast<float>(tileWidth), static_cast<float>(tileHeight) };
+			drawList.PushClipRect({ 0.0f, 0.0f }, tileSize);
+			draw(&drawList, index);
+			drawList.PopClipRect();
+			drawList.PopTextureID();
+			drawList._PopUnusedDrawCmd();
+
+			backend->render(slot, &drawList, tileWidth, tileHeight);
+			tile.index = index;
+			tile.valid = true;
+			++renderCount;
+		}
+	}
+
+	ImTextureID TileCache::getTexture(int index) const
+	{
+		for (size_t slot = 0; slot < tiles.size(); ++slot)
+		{
+			if (tiles[slot].valid && tiles[slot].index == index)
+				return backend->getTexture(slot);
+		}
+
+		return nullptr;
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "../ImGui/imgui.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	/// Storage for the rendered tiles of a TileCache. Tiles are addressed by slot, and a slot is
+	/// reused for another tile once its contents scroll out of view.
+	class TileBackend
+	{
+	  public:
+		virtual ~TileBackend() = default;
+
+		virtual void resize(size_t slot, int width, int height) = 0;
+		virtual void render(size_t slot, ImDrawList* drawList, int width, int height) = 0;
+		virtual ImTextureID getTexture(size_t slot) const = 0;
+	};
+
+	/// Caches content that only changes with its key as a vertical strip of fixed size tiles.
+	/// Scrolling only draws tiles that come into view, and a key change redraws everything.
+	class TileCache
+	{
+	  private:
+		struct Tile
+		{
+			int index{};
+			bool valid{ false };
+			uint64_t lastUsed{};
+		};
+
+		std::unique_ptr<TileBackend> backend;
+		std::vector<Tile> tiles;
+		ImDrawList drawList;
+		uint64_t key{};
+		uint64_t frame{};
+		int tileWidth{};
+		int tileHeight{};
+		size_t renderCount{};
+
+		size_t findSlot(int index, int firstIndex, int lastIndex);
+
+	  public:
+		using DrawTileFunction = std::function<void(ImDrawList* drawList, int index)>;
+
+		TileCache(std::unique_ptr<TileBackend> backend, int tileHeight);
+
+		/// Drops every tile when the key or the tile width changes
+		void validate(uint64_t key, int width);
+		void invalidate();
+
+		/// Makes sure tiles firstIndex to lastIndex are rendered, drawing missing ones with draw.
+		/// A tile with index n is drawn in its own coordinate space from (0, 0) to
+		/// (width, tileHeight).
+		void update(int firstIndex, int lastIndex, const DrawTileFunction& draw);
+
+		/// Returns the texture of a tile made available by the last update
+		ImTextureID getTexture(int index) const;
+
+		inline int getTileWidth() const { return tileWidth; }
+		inline int getTileHeight() const { return tileHeight; }
+		inline size_t getTileCount() const { return tiles.size(); }
+
+		/// Number of tiles rendered since the cache was created
+		inline size_t getRenderCount() const { return renderCount; }
+	};
+}
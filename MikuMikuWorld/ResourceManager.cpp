@@ -1,5 +1,6 @@
 #include "ResourceManager.h"
 #include "IO.h"
+#include "Rendering/ImageLoader.h"
 #include <filesystem>
 
 namespace MikuMikuWorld
@@ -27,6 +28,22 @@ namespace MikuMikuWorld
 		textures.push_back(tex);
 	}
 
+	void ResourceManager::addTexture(const std::string& filename, const ImageData& image,
+	                                 TextureFilterMode minFilter, TextureFilterMode magFilter)
+	{
+		if (!image.isValid())
+		{
+			printf("ERROR: ResourceManager::addTexture() Could not load texture file %s\n",
+			       filename.c_str());
+			return;
+		}
+
+		if (getTextureByFilename(filename) != -1)
+			return;
+
+		textures.emplace_back(filename, image, minFilter, magFilter);
+	}
+
 	int ResourceManager::getTexture(const std::string& name)
 	{
 		for (int i = 0; i < textures.size(); ++i)
@@ -14,6 +14,11 @@ namespace MikuMikuWorld
 		static void loadTexture(const std::string& filename,
 		                        TextureFilterMode minFilter = TextureFilterMode::Linear,
 		                        TextureFilterMode magFilter = TextureFilterMode::Linear);
+
+		/// Uploads a texture decoded ahead of time with decodeImage, see loadTexture
+		static void addTexture(const std::string& filename, const ImageData& image,
+		                       TextureFilterMode minFilter = TextureFilterMode::Linear,
+		                       TextureFilterMode magFilter = TextureFilterMode::Linear);
 		static int getTexture(const std::string& name);
 		static int getTextureByFilename(const std::string& filename);
 
@@ -5,14 +5,17 @@
 #include "Constants.h"
 #include "File.h"
 #include "IO.h"
+#include "MemoryTracker.h"
+#include <algorithm>
 #include <unordered_set>
 
 using namespace IO;
 
 namespace MikuMikuWorld
 {
-	id_t nextSkillID = 1;
-	id_t nextHiSpeedID = 1;
+	// Per thread like the note IDs, see Note::getNextID
+	thread_local id_t nextSkillID = 1;
+	thread_local id_t nextHiSpeedID = 1;
 	id_t getNextSkillID()
 	{
 		uint8_t data[sizeof(id_t)];
@@ -233,7 +236,7 @@ namespace MikuMikuWorld
 		Score score;
 		BinaryReader reader(filename);
 		if (!reader.isStreamValid())
-			return score;
+			throw std::runtime_error("Failed to open file.");
 
 		std::string signature = reader.readString();
 		if (signature != "MMWS" && signature != "CCMMWS")
@@ -398,10 +401,237 @@ namespace MikuMikuWorld
 			}
 		}
 
+		if (reader.hasReadPastEnd())
+			throw std::runtime_error("Unexpected end of MMWS file.");
+
 		reader.close();
 		return score;
 	}
 
+	/// Reads the fields of a score file loaded in memory. Reading past the end of the data
+	/// invalidates the reader instead of throwing.
+	class ScoreSummaryReader
+	{
+	  private:
+		std::vector<uint8_t> data;
+		size_t position{};
+		bool valid{ true };
+
+	  public:
+		ScoreSummaryReader(std::vector<uint8_t> data) : data{ std::move(data) } {}
+
+		bool isValid() const { return valid; }
+		size_t getRemaining() const { return data.size() - position; }
+
+		void seek(size_t pos)
+		{
+			if (pos > data.size())
+				valid = false;
+			else
+				position = pos;
+		}
+
+		void skip(size_t count) { seek(position + count); }
+
+		template <typename T> T read()
+		{
+			T value{};
+			if (!valid || getRemaining() < sizeof(T))
+			{
+				valid = false;
+				return value;
+			}
+
+			memcpy(&value, data.data() + position, sizeof(T));
+			position += sizeof(T);
+			return value;
+		}
+
+		std::string readString()
+		{
+			const auto begin = data.begin() + position;
+			const auto end = std::find(begin, data.end(), 0);
+			if (end == data.end())
+			{
+				valid = false;
+				return {};
+			}
+
+			position += std::distance(begin, end) + 1;
+			return std::string(begin, end);
+		}
+
+		/// Reads an element count, which cannot exceed the records left in the data
+		uint32_t readCount(size_t minRecordSize)
+		{
+			uint32_t count = read<uint32_t>();
+			if (count > getRemaining() / minRecordSize)
+				valid = false;
+
+			return valid ? count : 0;
+		}
+	};
+
+	/// Size of a note written by writeNote
+	static size_t noteRecordSize(NoteType type, int cyanvasVersion)
+	{
+		// tick, lane, width and flags followed by the layer and flick when present
+		size_t size = sizeof(uint32_t) * 4;
+		if (cyanvasVersion >= 4)
+			size += sizeof(uint32_t);
+		if (type != NoteType::Hold && type != NoteType::HoldMid)
+			size += sizeof(uint32_t);
+
+		return size;
+	}
+
+	/// Skips over a note written by writeNote and returns its tick
+	static int skipNote(ScoreSummaryReader& reader, NoteType type, int cyanvasVersion)
+	{
+		int tick = reader.read<uint32_t>();
+		reader.skip(noteRecordSize(type, cyanvasVersion) - sizeof(uint32_t));
+		return tick;
+	}
+
+	ScoreSummary readScoreSummary(const std::string& filename)
+	{
+		std::vector<uint8_t> data;
+		{
+			BinaryReader file(filename);
+			if (!file.isStreamValid())
+				throw std::runtime_error("Failed to open file.");
+
+			data = file.readBytes(file.getFileSize());
+		}
+
+		ScoreSummary summary;
+		ScoreSummaryReader reader(std::move(data));
+
+		std::string signature = reader.readString();
+		if (signature != "MMWS" && signature != "CCMMWS")
+			throw std::runtime_error("Not a MMWS file.");
+
+		bool isCyanvas = signature == "CCMMWS";
+
+		int version = reader.read<uint16_t>();
+		int cyanvasVersion = reader.read<uint16_t>();
+		if (isCyanvas && cyanvasVersion == 0)
+			cyanvasVersion = 1;
+
+		uint32_t metadataAddress{};
+		uint32_t eventsAddress{};
+		uint32_t tapsAddress{};
+		uint32_t holdsAddress{};
+		uint32_t damagesAddress{};
+		if (version > 2)
+		{
+			metadataAddress = reader.read<uint32_t>();
+			eventsAddress = reader.read<uint32_t>();
+			tapsAddress = reader.read<uint32_t>();
+			holdsAddress = reader.read<uint32_t>();
+			if (isCyanvas)
+				damagesAddress = reader.read<uint32_t>();
+
+			reader.seek(metadataAddress);
+		}
+
+		ScoreMetadata& metadata = summary.metadata;
+		metadata.title = reader.readString();
+		metadata.author = reader.readString();
+		metadata.artist = reader.readString();
+		metadata.musicFile = reader.readString();
+		metadata.musicOffset = reader.read<float>();
+		if (version > 1)
+			metadata.jacketFile = reader.readString();
+		if (cyanvasVersion >= 1)
+			metadata.laneExtension = reader.read<uint32_t>();
+
+		if (version > 2)
+			reader.seek(eventsAddress);
+
+		// Only the tempo changes are needed for the duration, the other events are skipped
+		reader.skip(reader.readCount(sizeof(uint32_t) * 3) * sizeof(uint32_t) * 3);
+
+		std::vector<Tempo> tempoChanges;
+		uint32_t tempoCount = reader.readCount(sizeof(uint32_t) * 2);
+		tempoChanges.reserve(tempoCount);
+		for (uint32_t i = 0; i < tempoCount; ++i)
+		{
+			int tick = reader.read<uint32_t>();
+			float bpm = reader.read<float>();
+			tempoChanges.push_back({ tick, bpm });
+		}
+
+		if (tempoChanges.empty())
+			tempoChanges.push_back(Tempo());
+
+		if (version > 2)
+		{
+			const size_t hiSpeedSize = sizeof(uint32_t) * (cyanvasVersion >= 4 ? 3 : 2);
+			reader.skip(reader.readCount(hiSpeedSize) * hiSpeedSize);
+		}
+
+		if (version > 1)
+		{
+			reader.skip(reader.readCount(sizeof(uint32_t)) * sizeof(uint32_t));
+			reader.skip(sizeof(uint32_t) * 2);
+		}
+
+		if (version > 2)
+			reader.seek(tapsAddress);
+
+		const size_t tapSize = noteRecordSize(NoteType::Tap, cyanvasVersion);
+		summary.tapCount = reader.readCount(tapSize);
+		for (int i = 0; i < summary.tapCount; ++i)
+			summary.lastTick =
+			    std::max(summary.lastTick, skipNote(reader, NoteType::Tap, cyanvasVersion));
+
+		if (version > 2)
+			reader.seek(holdsAddress);
+
+		const size_t stepSize = noteRecordSize(NoteType::HoldMid, cyanvasVersion);
+		summary.holdCount = reader.readCount(noteRecordSize(NoteType::Hold, cyanvasVersion));
+		for (int i = 0; i < summary.holdCount && reader.isValid(); ++i)
+		{
+			if (version > 3)
+				reader.skip(sizeof(uint32_t));
+
+			// start, ease and the fade type and guide color of newer versions
+			skipNote(reader, NoteType::Hold, cyanvasVersion);
+			reader.skip(sizeof(uint32_t));
+			if (cyanvasVersion >= 2)
+				reader.skip(sizeof(uint32_t));
+			if (cyanvasVersion >= 3)
+				reader.skip(sizeof(uint32_t));
+
+			// steps are followed by their type and ease
+			uint32_t stepCount = reader.readCount(stepSize);
+			reader.skip(stepCount * (stepSize + sizeof(uint32_t) * 2));
+			summary.stepCount += stepCount;
+
+			summary.lastTick =
+			    std::max(summary.lastTick, skipNote(reader, NoteType::HoldEnd, cyanvasVersion));
+		}
+
+		if (cyanvasVersion >= 1)
+		{
+			if (version > 2)
+				reader.seek(damagesAddress);
+
+			summary.damageCount =
+			    reader.readCount(noteRecordSize(NoteType::Damage, cyanvasVersion));
+			for (int i = 0; i < summary.damageCount; ++i)
+				summary.lastTick = std::max(summary.lastTick,
+				                            skipNote(reader, NoteType::Damage, cyanvasVersion));
+		}
+
+		if (!reader.isValid())
+			throw std::runtime_error("Unexpected end of MMWS file.");
+
+		summary.duration = accumulateDuration(summary.lastTick, TICKS_PER_BEAT, tempoChanges);
+		return summary;
+	}
+
 	void serializeScore(const Score& score, const std::string& filename)
 	{
 		BinaryWriter writer(filename);
@@ -535,4 +765,30 @@ namespace MikuMikuWorld
 		writer.flush();
 		writer.close();
 	}
+
+	size_t getMemoryUsage(const HoldNote& hold) { return getMemoryUsage(hold.steps); }
+
+	size_t getMemoryUsage(const Score& score)
+	{
+		const ScoreMetadata& metadata = score.metadata;
+		size_t bytes = getMemoryUsage(metadata.title) + getMemoryUsage(metadata.artist) +
+		               getMemoryUsage(metadata.author) + getMemoryUsage(metadata.musicFile) +
+		               getMemoryUsage(metadata.jacketFile);
+
+		bytes += score.notes.getMemoryUsage() + score.holdNotes.getMemoryUsage();
+		for (const auto& [id, hold] : score.holdNotes)
+			bytes += getMemoryUsage(hold);
+
+		bytes += getMemoryUsage(score.tempoChanges) + getMemoryUsage(score.timeSignatures) +
+		         getMemoryUsage(score.hiSpeedChanges) + getMemoryUsage(score.skills);
+
+		bytes += getMemoryUsage(score.layers) + getMemoryUsage(score.waypoints);
+		for (const Layer& layer : score.layers)
+			bytes += getMemoryUsage(layer.name);
+
+		for (const Waypoint& waypoint : score.waypoints)
+			bytes += getMemoryUsage(waypoint.name);
+
+		return bytes;
+	}
 }
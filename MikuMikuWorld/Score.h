@@ -1,6 +1,7 @@
 #pragma once
 #include "Constants.h"
 #include "Note.h"
+#include "SlotMap.h"
 #include "Tempo.h"
 #include <cstdint>
 #include <map>
@@ -60,8 +61,8 @@ namespace MikuMikuWorld
 	struct Score
 	{
 		ScoreMetadata metadata;
-		std::unordered_map<id_t, Note> notes;
-		std::unordered_map<id_t, HoldNote> holdNotes;
+		SlotMap<id_t, Note> notes;
+		SlotMap<id_t, HoldNote> holdNotes;
 		std::vector<Tempo> tempoChanges;
 		std::map<int, TimeSignature> timeSignatures;
 		std::unordered_map<id_t, HiSpeedChange> hiSpeedChanges;
@@ -74,6 +75,26 @@ namespace MikuMikuWorld
 		Score();
 	};
 
+	/// Metadata and note counts of a score file
+	struct ScoreSummary
+	{
+		ScoreMetadata metadata{};
+		int tapCount{};
+		int holdCount{};
+		int stepCount{};
+		int damageCount{};
+		int lastTick{};
+		float duration{};
+	};
+
+	/// Throws when the file cannot be opened or ends before the data it declares
 	Score deserializeScore(const std::string& filename);
+
+	/// Reads the metadata of a score file and counts its notes without creating them
+	ScoreSummary readScoreSummary(const std::string& filename);
 	void serializeScore(const Score& score, const std::string& filename);
+
+	/// Estimated heap bytes owned by a hold or a score, for memory accounting
+	size_t getMemoryUsage(const HoldNote& hold);
+	size_t getMemoryUsage(const Score& score);
 }
@@ -1,11 +1,16 @@
 #include "ScoreContext.h"
 #include "Constants.h"
+#include "GlyphCache.h"
 #include "IO.h"
+#include "MemoryTracker.h"
 #include "UI.h"
 #include "Utilities.h"
 #include "Math.h"
 #include <stdio.h>
+#include <cstring>
+#include <functional>
 #include <map>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -14,8 +19,6 @@ using namespace IO;
 
 namespace MikuMikuWorld
 {
-	constexpr const char* clipboardSignature = "MikuMikuWorld clipboard\n";
-
 	void ScoreContext::setStep(HoldStepType type)
 	{
 		if (selectedNotes.empty())
@@ -479,184 +482,36 @@ namespace MikuMikuWorld
 			                 .tick);
 		}
 
-		json data =
-		    jsonIO::noteSelectionToJson(score, selectedNotes, selectedHiSpeedChanges, minTick);
-
-		std::string clipboard{ clipboardSignature };
-		clipboard.append(data.dump());
+		std::string payload =
+		    selectionToClipboardPayload(score, selectedNotes, selectedHiSpeedChanges, minTick);
+		const std::string clipboard = clipboardText(
+		    jsonIO::noteSelectionToJson(score, selectedNotes, selectedHiSpeedChanges, minTick),
+		    payload);
 
 		ImGui::SetClipboardText(clipboard.c_str());
+
+		clipboardCache.payload = std::move(payload);
+		clipboardCache.sequenceNumber = IO::getClipboardSequenceNumber();
+		clipboardCache.textHash = std::hash<std::string_view>{}(clipboard);
+		clipboardCache.valid = true;
 	}
 
 	void ScoreContext::cancelPaste() { pasteData.pasting = false; }
 
 	void ScoreContext::doPasteData(const json& data, bool flip)
 	{
-		int baseId = 0;
-		pasteData.notes.clear();
-		pasteData.damages.clear();
-		pasteData.holds.clear();
-		pasteData.hiSpeedChanges.clear();
-
-		if (jsonIO::arrayHasData(data, "notes"))
-		{
-			for (const auto& entry : data["notes"])
-			{
-				Note note = jsonIO::jsonToNote(entry, NoteType::Tap);
-				note.ID = baseId++;
-				note.layer = selectedLayer;
-
-				pasteData.notes[note.ID] = note;
-			}
-		}
-
-		if (jsonIO::arrayHasData(data, "damages"))
-		{
-			for (const auto& entry : data["damages"])
-			{
-				Note note = jsonIO::jsonToNote(entry, NoteType::Damage);
-				note.ID = baseId++;
-				note.layer = selectedLayer;
-
-				pasteData.damages[note.ID] = note;
-			}
-		}
-
-		if (jsonIO::arrayHasData(data, "holds"))
-		{
-			for (const auto& entry : data["holds"])
-			{
-				if (!jsonIO::keyExists(entry, "start") || !jsonIO::keyExists(entry, "end"))
-					continue;
-
-				Note start = jsonIO::jsonToNote(entry["start"], NoteType::Hold);
-				start.ID = baseId++;
-				start.layer = selectedLayer;
-				pasteData.notes[start.ID] = start;
-
-				Note end = jsonIO::jsonToNote(entry["end"], NoteType::HoldEnd);
-				end.ID = baseId++;
-				end.parentID = start.ID;
-				end.critical = start.critical || ((end.isFlick() || end.friction) && end.critical);
-				end.layer = selectedLayer;
-				pasteData.notes[end.ID] = end;
-
-				std::string startEase =
-				    jsonIO::tryGetValue<std::string>(entry["start"], "ease", "linear");
-
-				HoldNote hold;
-				hold.start = { start.ID, HoldStepType::Normal,
-					           (EaseType)findArrayItem(startEase.c_str(), easeTypes,
-					                                   arrayLength(easeTypes)) };
-				hold.end = end.ID;
-				for (int i = 0; i < arrayLength(fadeTypes); ++i)
-				{
-					if (entry["fade"] == fadeTypes[i])
-					{
-						hold.fadeType = (FadeType)i;
-						break;
-					}
-				}
-				for (int i = 0; i < arrayLength(guideColors); ++i)
-				{
-					if (entry["guide"] == guideColors[i])
-					{
-						hold.guideColor = (GuideColor)i;
-						break;
-					}
-				}
-				if (jsonIO::keyExists(entry, "steps"))
-				{
-					hold.steps.reserve(entry["steps"].size());
-					for (const auto& step : entry["steps"])
-					{
-						Note mid = jsonIO::jsonToNote(step, NoteType::HoldMid);
-						mid.critical = start.critical;
-						mid.ID = baseId++;
-						mid.parentID = start.ID;
-						mid.layer = selectedLayer;
-						pasteData.notes[mid.ID] = mid;
-
-						std::string midType =
-						    jsonIO::tryGetValue<std::string>(step, "type", "normal");
-						std::string midEase =
-						    jsonIO::tryGetValue<std::string>(step, "ease", "linear");
-						int stepTypeIndex =
-						    findArrayItem(midType.c_str(), stepTypes, arrayLength(stepTypes));
-						int easeTypeIndex =
-						    findArrayItem(midEase.c_str(), easeTypes, arrayLength(easeTypes));
-
-						// Maintain compatibility with old step type names
-						if (stepTypeIndex == -1)
-						{
-							stepTypeIndex = 0;
-							if (midType == "invisible")
-								stepTypeIndex = 1;
-							if (midType == "ignored")
-								stepTypeIndex = 2;
-						}
-
-						// Maintain compatibility with old ease type names
-						if (easeTypeIndex == -1)
-						{
-							easeTypeIndex = 0;
-							if (midEase == "in")
-								easeTypeIndex = 1;
-							if (midEase == "out")
-								easeTypeIndex = 2;
-						}
-
-						hold.steps.push_back(
-						    { mid.ID, (HoldStepType)stepTypeIndex, (EaseType)easeTypeIndex });
-					}
-				}
-
-				std::string startType =
-				    jsonIO::tryGetValue<std::string>(entry["start"], "type", "normal");
-				std::string endType =
-				    jsonIO::tryGetValue<std::string>(entry["end"], "type", "normal");
-
-				if (startType == "guide" || endType == "guide")
-				{
-					hold.startType = hold.endType = HoldNoteType::Guide;
-					start.friction = end.friction = false;
-					end.flick = FlickType::None;
-				}
-				else
-				{
-					if (startType == "hidden")
-					{
-						hold.startType = HoldNoteType::Hidden;
-						start.friction = false;
-					}
-
-					if (endType == "hidden")
-					{
-						hold.endType = HoldNoteType::Hidden;
-						end.friction = false;
-						end.flick = FlickType::None;
-					}
-				}
-
-				pasteData.holds[hold.start.ID] = hold;
-			}
-		}
-
-		int hiSpeedID = 0;
-
-		if (jsonIO::arrayHasData(data, "hiSpeedChanges"))
-		{
-			for (const auto& entry : data["hiSpeedChanges"])
-			{
-				HiSpeedChange hs;
-				hs.ID = hiSpeedID++;
-				hs.tick = entry["tick"];
-				hs.speed = entry["speed"];
+		jsonToPasteData(data, selectedLayer, pasteData);
+		preparePasteData(flip);
+	}
 
-				pasteData.hiSpeedChanges[hs.ID] = hs;
-			}
-		}
+	void ScoreContext::doPasteBinary(const std::string& payload, bool flip)
+	{
+		binaryToPasteData(payload, selectedLayer, pasteData);
+		preparePasteData(flip);
+	}
 
+	void ScoreContext::preparePasteData(bool flip)
+	{
 		if (flip)
 		{
 			for (auto& [_, note] : pasteData.notes)
@@ -695,6 +550,28 @@ namespace MikuMikuWorld
 			pasteData.maxLaneOffset = MAX_LANE + score.metadata.laneExtension - rightmostLane;
 			pasteData.midLane = (left + right) / 2;
 		}
+
+		pasteData.items.clear();
+		for (const auto& [id, note] : pasteData.notes)
+		{
+			if (note.getType() == NoteType::Tap)
+				pasteData.items.push_back({ note.tick, note.tick, NoteType::Tap, id });
+		}
+
+		for (const auto& [id, note] : pasteData.damages)
+			pasteData.items.push_back({ note.tick, note.tick, NoteType::Damage, id });
+
+		for (const auto& [id, hold] : pasteData.holds)
+		{
+			const int startTick = pasteData.notes.at(hold.start.ID).tick;
+			const int endTick = pasteData.notes.at(hold.end).tick;
+			pasteData.items.push_back({ std::min(startTick, endTick),
+			                            std::max(startTick, endTick), NoteType::Hold, id });
+		}
+
+		std::sort(pasteData.items.begin(), pasteData.items.end(),
+		          [](const PasteItem& a, const PasteItem& b) { return a.startTick < b.startTick; });
+		++pasteData.revision;
 	}
 
 	void ScoreContext::confirmPaste()
@@ -757,12 +634,10 @@ namespace MikuMikuWorld
 		// select newly pasted notes
 		selectedNotes.clear();
 		selectedHiSpeedChanges.clear();
-		std::transform(pasteData.notes.begin(), pasteData.notes.end(),
-		               std::inserter(selectedNotes, selectedNotes.end()),
-		               [this](const auto& it) { return it.second.ID; });
-		std::transform(pasteData.damages.begin(), pasteData.damages.end(),
-		               std::inserter(selectedNotes, selectedNotes.end()),
-		               [this](const auto& it) { return it.second.ID; });
+		for (const auto& [_, note] : pasteData.notes)
+			selectedNotes.insert(note.ID);
+		for (const auto& [_, note] : pasteData.damages)
+			selectedNotes.insert(note.ID);
 		std::transform(pasteData.hiSpeedChanges.begin(), pasteData.hiSpeedChanges.end(),
 		               std::inserter(selectedHiSpeedChanges, selectedHiSpeedChanges.end()),
 		               [this](const auto& it) { return it.second.ID; });
@@ -773,11 +648,36 @@ namespace MikuMikuWorld
 
 	void ScoreContext::paste(bool flip)
 	{
+		// Skip reading and decoding the system clipboard if it still holds our last copy
+		const uint32_t sequenceNumber = IO::getClipboardSequenceNumber();
+		if (clipboardCache.valid && sequenceNumber != 0 &&
+		    clipboardCache.sequenceNumber == sequenceNumber)
+		{
+			doPasteBinary(clipboardCache.payload, flip);
+			return;
+		}
+
 		const char* clipboardDataPtr = ImGui::GetClipboardText();
 		if (clipboardDataPtr == nullptr)
 			return;
 
+		// Without a sequence number the text has to be read, but the decode is still skipped
+		if (clipboardCache.valid && sequenceNumber == 0 &&
+		    clipboardCache.textHash == std::hash<std::string_view>{}(clipboardDataPtr))
+		{
+			doPasteBinary(clipboardCache.payload, flip);
+			return;
+		}
+
+		// Text copied by older builds or written by other tools only has the JSON
 		std::string clipboardData(clipboardDataPtr);
+		std::string payload;
+		if (readClipboardPayload(clipboardData, payload))
+		{
+			doPasteBinary(payload, flip);
+			return;
+		}
+
 		if (!startsWith(clipboardData, clipboardSignature))
 			return;
 
@@ -1106,14 +1006,14 @@ namespace MikuMikuWorld
 
 		sortHoldSteps(score, hold);
 		sortHoldSteps(score, newHold);
+		score.notes[newSlideEnd.ID] = newSlideEnd;
+		score.notes[newSlideStart.ID] = newSlideStart;
+		score.holdNotes[newSlideStart.ID] = newHold;
+
 		selectedNotes.clear();
 		selectedHiSpeedChanges.clear();
 		selectedNotes.insert(newSlideStart.ID);
 		selectedNotes.insert(newSlideEnd.ID);
-
-		score.notes[newSlideEnd.ID] = newSlideEnd;
-		score.notes[newSlideStart.ID] = newSlideStart;
-		score.holdNotes[newSlideStart.ID] = newHold;
 		pushHistory("Split hold", prev, score);
 	}
 
@@ -1368,16 +1268,16 @@ namespace MikuMikuWorld
 	{
 		if (history.hasUndo())
 		{
-			score = history.undo();
-			clearSelection();
-
-			UI::setWindowTitle((workingData.filename.size()
-			                        ? File::getFilename(workingData.filename)
-			                        : windowUntitled) +
-			                   "*");
-			upToDate = false;
+			discardTransaction();
+			const History& entry = history.undo(score);
+			if (entry.prev)
+				journal.recordChange(*entry.curr, *entry.prev);
+			else
+				journal.recordChange(entry.delta, true);
 
-			scoreStats.calculateStats(score);
+			clearSelection();
+			requestNameGlyphs();
+			markModified();
 		}
 	}
 
@@ -1385,53 +1285,92 @@ namespace MikuMikuWorld
 	{
 		if (history.hasRedo())
 		{
-			score = history.redo();
+			discardTransaction();
+			const History& entry = history.redo(score);
+			if (entry.prev)
+				journal.recordChange(*entry.prev, *entry.curr);
+			else
+				journal.recordChange(entry.delta, false);
+
 			clearSelection();
+			requestNameGlyphs();
+			markModified();
+		}
+	}
 
-			UI::setWindowTitle((workingData.filename.size()
-			                        ? File::getFilename(workingData.filename)
-			                        : windowUntitled) +
-			                   "*");
-			upToDate = false;
+	void ScoreContext::requestNameGlyphs() const
+	{
+		for (const Layer& layer : score.layers)
+			GlyphCache::request(layer.name);
 
-			scoreStats.calculateStats(score);
-		}
+		for (const Waypoint& waypoint : score.waypoints)
+			GlyphCache::request(waypoint.name);
 	}
 
 	void ScoreContext::pushHistory(std::string description, const Score& prev, const Score& curr)
 	{
 		history.pushHistory(description, prev, curr);
+		journal.recordChange(prev, curr);
+		markModified();
+	}
+
+	void ScoreContext::beginTransaction() { transaction.begin(); }
 
+	void ScoreContext::touchNote(id_t id) { transaction.touchNote(score, id); }
+
+	void ScoreContext::touchHold(id_t id) { transaction.touchHold(score, id); }
+
+	void ScoreContext::touchHiSpeed(id_t id) { transaction.touchHiSpeed(score, id); }
+
+	void ScoreContext::touchTempoChanges() { transaction.touchTempoChanges(score); }
+
+	void ScoreContext::touchTimeSignatures() { transaction.touchTimeSignatures(score); }
+
+	void ScoreContext::commitTransaction(const std::string& description)
+	{
+		if (!transaction.isActive())
+			return;
+
+		ScoreDelta delta = transaction.commit(score);
+		if (delta.isEmpty())
+			return;
+
+		journal.recordChange(delta, false);
+		history.pushHistory(description, std::move(delta));
+		markModified();
+	}
+
+	void ScoreContext::discardTransaction() { transaction.discard(); }
+
+	void ScoreContext::markModified()
+	{
 		UI::setWindowTitle((workingData.filename.size() ? File::getFilename(workingData.filename)
 		                                                : windowUntitled) +
 		                   "*");
 		scoreStats.calculateStats(score);
+		selectedNotes.invalidate();
 
 		upToDate = false;
 	}
 
 	bool ScoreContext::selectionHasEase() const
 	{
-		return std::any_of(selectedNotes.begin(), selectedNotes.end(),
-		                   [this](const int id) { return score.notes.at(id).hasEase(); });
+		return selectedNotes.getSummary().eases() > 0;
 	}
 
 	bool ScoreContext::selectionHasHold() const
 	{
-		return std::any_of(selectedNotes.begin(), selectedNotes.end(),
-						   [this](int id) { return score.notes.at(id).getType() == NoteType::Hold; });
+		return selectedNotes.getSummary().holdStarts > 0;
 	}
 
 	bool ScoreContext::selectionHasStep() const
 	{
-		return std::any_of(selectedNotes.begin(), selectedNotes.end(), [this](const int id)
-		                   { return score.notes.at(id).getType() == NoteType::HoldMid; });
+		return selectedNotes.getSummary().holdMids > 0;
 	}
 
 	bool ScoreContext::selectionHasFlickable() const
 	{
-		return std::any_of(selectedNotes.begin(), selectedNotes.end(),
-		                   [this](const int id) { return score.notes.at(id).canFlick(); });
+		return selectedNotes.getSummary().flickables() > 0;
 	}
 
 	bool ScoreContext::selectionCanConnect() const
@@ -1455,33 +1394,11 @@ namespace MikuMikuWorld
 
 	bool ScoreContext::selectionCanChangeHoldType() const
 	{
-		return std::any_of(
-		    selectedNotes.begin(), selectedNotes.end(),
-		    [this](const int id)
-		    {
-			    const Note& note = score.notes.at(id);
-			    if (note.getType() == NoteType::Hold || note.getType() == NoteType::HoldEnd)
-				    return !score.holdNotes
-				                .at(note.getType() == NoteType::Hold ? note.ID : note.parentID)
-				                .isGuide();
-
-			    return false;
-		    });
+		return selectedNotes.getSummary().normalHoldEndpoints > 0;
 	}
 
 	bool ScoreContext::selectionCanChangeFadeType() const
 	{
-		return std::any_of(
-		    selectedNotes.begin(), selectedNotes.end(),
-		    [this](const int id)
-		    {
-			    const Note& note = score.notes.at(id);
-			    if (note.getType() == NoteType::Hold || note.getType() == NoteType::HoldEnd)
-				    return score.holdNotes
-				        .at(note.getType() == NoteType::Hold ? note.ID : note.parentID)
-				        .isGuide();
-
-			    return false;
-		    });
+		return selectedNotes.getSummary().guideHoldEndpoints > 0;
 	}
 }
@@ -2,9 +2,12 @@
 #include "Audio/AudioManager.h"
 #include "Audio/Waveform.h"
 #include "Constants.h"
+#include "EditJournal.h"
 #include "HistoryManager.h"
 #include "Jacket.h"
 #include "JsonIO.h"
+#include "NoteClipboard.h"
+#include "NoteSelection.h"
 #include "Score.h"
 #include "ScoreStats.h"
 #include "TimelineMode.h"
@@ -55,18 +58,14 @@ namespace MikuMikuWorld
 		}
 	};
 
-	struct PasteData
+	/// Last clipboard payload copied by this editor, reused while the clipboard is unchanged
+	struct ClipboardCache
 	{
-		std::unordered_map<id_t, Note> notes;
-		std::unordered_map<id_t, HoldNote> holds;
-		std::unordered_map<id_t, Note> damages;
-		std::unordered_map<id_t, HiSpeedChange> hiSpeedChanges;
-		bool pasting{ false };
-		int offsetTicks{};
-		int offsetLane{};
-		int midLane{};
-		int minLaneOffset{};
-		int maxLaneOffset{};
+		std::string payload;
+		uint32_t sequenceNumber{};
+		// Compared instead of the sequence number on platforms that have none
+		size_t textHash{};
+		bool valid{ false };
 	};
 
 	class ScoreContext
@@ -76,9 +75,12 @@ namespace MikuMikuWorld
 		EditorScoreData workingData;
 		ScoreStats scoreStats;
 		HistoryManager history;
+		EditJournal journal;
 		Audio::AudioManager audio;
 		PasteData pasteData{};
-		std::unordered_set<id_t> selectedNotes;
+		ClipboardCache clipboardCache{};
+		EditTransaction transaction{};
+		NoteSelection selectedNotes{ score };
 		std::unordered_set<id_t> selectedHiSpeedChanges;
 
 		Audio::WaveformMipChain waveformL, waveformR;
@@ -94,17 +96,7 @@ namespace MikuMikuWorld
 			return selectedNotes.size() > 0 || selectedHiSpeedChanges.size() > 0;
 		}
 
-		bool hasHoldInSelection() const
-		{
-			for (id_t id : selectedNotes)
-			{
-				const Note& n = score.notes.at(id);
-				if (n.getType() == NoteType::Hold || n.getType() == NoteType::HoldMid ||
-				    n.getType() == NoteType::HoldEnd)
-					return true;
-			}
-			return false;
-		}
+		bool hasHoldInSelection() const { return selectedNotes.getSummary().holdNotes() > 0; }
 
 		std::unordered_set<int> getHoldsFromSelection()
 		{
@@ -133,16 +125,11 @@ namespace MikuMikuWorld
 		bool selectionCanConnect() const;
 		bool selectionCanChangeHoldType() const;
 		bool selectionCanChangeFadeType() const;
-		inline bool isNoteSelected(const Note& note)
+		inline bool isNoteSelected(const Note& note) const
 		{
-			return selectedNotes.find(note.ID) != selectedNotes.end();
-		}
-		inline void selectAll()
-		{
-			selectedNotes.clear();
-			for (auto& it : score.notes)
-				selectedNotes.insert(it.first);
+			return selectedNotes.contains(note.ID);
 		}
+		inline void selectAll() { selectedNotes.selectAll(); }
 		inline void clearSelection() { selectedNotes.clear(); }
 
 		void setStep(HoldStepType step);
@@ -162,6 +149,8 @@ namespace MikuMikuWorld
 		void paste(bool flip);
 		void duplicateSelection(bool flip);
 		void doPasteData(const nlohmann::json& data, bool flip);
+		void doPasteBinary(const std::string& payload, bool flip);
+		void preparePasteData(bool flip);
 		void cancelPaste();
 		void confirmPaste();
 		void shrinkSelection(Direction direction);
@@ -181,6 +170,24 @@ namespace MikuMikuWorld
 
 		void undo();
 		void redo();
+
+		/// Requests the glyphs of the layer and waypoint names, which the timeline can draw before
+		/// any window does. Call whenever the score is replaced.
+		void requestNameGlyphs() const;
 		void pushHistory(std::string description, const Score& prev, const Score& current);
+
+		/// Starts recording an edit. Call a touch function before changing an entity so that only
+		/// the touched entities are stored in the history on commit.
+		void beginTransaction();
+		void touchNote(id_t id);
+		void touchHold(id_t id);
+		void touchHiSpeed(id_t id);
+		void touchTempoChanges();
+		void touchTimeSignatures();
+		void commitTransaction(const std::string& description);
+		void discardTransaction();
+
+	  private:
+		void markModified();
 	};
 }
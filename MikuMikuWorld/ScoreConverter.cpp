@@ -5,15 +5,121 @@
 #include "Score.h"
 #include <algorithm>
 #include <array>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <ostream>
 #include <unordered_set>
 
 using json = nlohmann::json;
 
 namespace MikuMikuWorld
 {
-	std::string ScoreConverter::noteKey(const SUSNote& note)
+	enum SusNoteFlags : uint16_t
 	{
-		return IO::formatString("%d-%d", note.tick, note.lane);
+		SUS_NOTE_CRITICAL = 1 << 0,
+		SUS_NOTE_STEP_IGNORE = 1 << 1,
+		SUS_NOTE_EASE_IN = 1 << 2,
+		SUS_NOTE_EASE_OUT = 1 << 3,
+		SUS_NOTE_SLIDE = 1 << 4,
+		SUS_NOTE_FRICTION = 1 << 5,
+		SUS_NOTE_HIDDEN_HOLD = 1 << 6,
+		SUS_NOTE_CRITICAL_TRACE_EMITTED = 1 << 7
+	};
+
+	/// Open addressing table holding the SUS attributes of every (tick, lane) position.
+	/// Replaces one string-keyed set per attribute when correlating the SUS note streams.
+	class SusNoteFlagTable
+	{
+	  private:
+		struct Slot
+		{
+			uint64_t key;
+			uint16_t flags;
+			FlickType flick;
+			bool used;
+		};
+
+		std::vector<Slot> slots;
+		size_t count{};
+
+		static size_t hash(uint64_t key)
+		{
+			key ^= key >> 33;
+			key *= 0xff51afd7ed558ccdULL;
+			key ^= key >> 33;
+			key *= 0xc4ceb9fe1a85ec53ULL;
+			key ^= key >> 33;
+			return static_cast<size_t>(key);
+		}
+
+		size_t findSlot(uint64_t key) const
+		{
+			const size_t mask = slots.size() - 1;
+			size_t index = hash(key) & mask;
+			while (slots[index].used && slots[index].key != key)
+				index = (index + 1) & mask;
+
+			return index;
+		}
+
+		void grow()
+		{
+			std::vector<Slot> oldSlots(slots.size() * 2, Slot{});
+			oldSlots.swap(slots);
+			for (const Slot& slot : oldSlots)
+				if (slot.used)
+					slots[findSlot(slot.key)] = slot;
+		}
+
+		Slot& obtain(uint64_t key)
+		{
+			// Keep the load factor at or below 1/2
+			if ((count + 1) * 2 > slots.size())
+				grow();
+
+			Slot& slot = slots[findSlot(key)];
+			if (!slot.used)
+			{
+				slot = Slot{ key, 0, FlickType::None, true };
+				++count;
+			}
+
+			return slot;
+		}
+
+	  public:
+		explicit SusNoteFlagTable(size_t expectedKeys)
+		{
+			size_t capacity = 16;
+			while (capacity < expectedKeys * 2)
+				capacity *= 2;
+
+			slots.resize(capacity, Slot{});
+		}
+
+		void set(uint64_t key, uint16_t flags) { obtain(key).flags |= flags; }
+		void setFlick(uint64_t key, FlickType flick) { obtain(key).flick = flick; }
+
+		uint16_t flags(uint64_t key) const
+		{
+			const Slot& slot = slots[findSlot(key)];
+			return slot.used ? slot.flags : 0;
+		}
+
+		FlickType flick(uint64_t key) const
+		{
+			const Slot& slot = slots[findSlot(key)];
+			return slot.used ? slot.flick : FlickType::None;
+		}
+
+		bool has(uint64_t key, uint16_t flag) const { return (flags(key) & flag) != 0; }
+	};
+
+	uint64_t ScoreConverter::noteKey(const SUSNote& note)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(note.tick)) << 32) |
+		       static_cast<uint32_t>(note.lane);
 	}
 
 	std::string ScoreConverter::noteKey(const Note& note)
@@ -51,17 +157,15 @@ namespace MikuMikuWorld
 		for (const auto& group : sus.hiSpeedGroups)
 			hiSpeedGroupNames.push_back(group.name);
 
-		std::unordered_map<std::string, FlickType> flicks;
-		std::unordered_set<std::string> criticals;
-		std::unordered_set<std::string> stepIgnore;
-		std::unordered_set<std::string> easeIns;
-		std::unordered_set<std::string> easeOuts;
-		std::unordered_set<std::string> slideKeys;
-		std::unordered_set<std::string> frictions;
-		std::unordered_set<std::string> hiddenHolds;
+		size_t slideNoteCount = 0;
+		for (const SUSNoteStream* slides : { &sus.slides, &sus.guides })
+			for (const auto& slide : *slides)
+				slideNoteCount += slide.size();
 
-		for (const auto& slides : { sus.slides, sus.guides })
-			for (const auto& slide : slides)
+		SusNoteFlagTable noteFlags(sus.taps.size() + sus.directionals.size() + slideNoteCount);
+
+		for (const SUSNoteStream* slides : { &sus.slides, &sus.guides })
+			for (const auto& slide : *slides)
 			{
 				for (const auto& note : slide)
 				{
@@ -71,31 +175,31 @@ namespace MikuMikuWorld
 					case 2:
 					case 3:
 					case 5:
-						slideKeys.insert(noteKey(note));
+						noteFlags.set(noteKey(note), SUS_NOTE_SLIDE);
 					}
 				}
 			}
 
 		for (const auto& dir : sus.directionals)
 		{
-			const std::string key = noteKey(dir);
+			const uint64_t key = noteKey(dir);
 			switch (dir.type)
 			{
 			case 1:
-				flicks.insert_or_assign(key, FlickType::Default);
+				noteFlags.setFlick(key, FlickType::Default);
 				break;
 			case 3:
-				flicks.insert_or_assign(key, FlickType::Left);
+				noteFlags.setFlick(key, FlickType::Left);
 				break;
 			case 4:
-				flicks.insert_or_assign(key, FlickType::Right);
+				noteFlags.setFlick(key, FlickType::Right);
 				break;
 			case 2:
-				easeIns.insert(key);
+				noteFlags.set(key, SUS_NOTE_EASE_IN);
 				break;
 			case 5:
 			case 6:
-				easeOuts.insert(key);
+				noteFlags.set(key, SUS_NOTE_EASE_OUT);
 				break;
 			default:
 				break;
@@ -104,48 +208,44 @@ namespace MikuMikuWorld
 
 		for (const auto& tap : sus.taps)
 		{
-			const std::string key = noteKey(tap);
+			const uint64_t key = noteKey(tap);
 			switch (tap.type)
 			{
 			case 2:
-				criticals.insert(key);
+				noteFlags.set(key, SUS_NOTE_CRITICAL);
 				break;
 			case 3:
-				stepIgnore.insert(key);
+				noteFlags.set(key, SUS_NOTE_STEP_IGNORE);
 				break;
 			case 4:
-				hiddenHolds.insert(key);
+				noteFlags.set(key, SUS_NOTE_HIDDEN_HOLD);
 				break;
 			case 5:
-				frictions.insert(key);
+				noteFlags.set(key, SUS_NOTE_FRICTION);
 				break;
 			case 6:
-				criticals.insert(key);
-				frictions.insert(key);
+				noteFlags.set(key, SUS_NOTE_CRITICAL | SUS_NOTE_FRICTION);
 				break;
 			case 7:
-				hiddenHolds.insert(key);
+				noteFlags.set(key, SUS_NOTE_HIDDEN_HOLD);
 				break;
 			case 8:
-				hiddenHolds.insert(key);
-				criticals.insert(key);
+				noteFlags.set(key, SUS_NOTE_HIDDEN_HOLD | SUS_NOTE_CRITICAL);
 				break;
 			default:
 				break;
 			}
 		}
 
-		std::unordered_map<id_t, Note> notes;
+		SlotMap<id_t, Note> notes;
 		notes.reserve(sus.taps.size());
 
-		std::unordered_map<id_t, HoldNote> holds;
+		SlotMap<id_t, HoldNote> holds;
 		holds.reserve(sus.slides.size());
 
 		std::unordered_map<id_t, SkillTrigger> skills;
 		Fever fever{ -1, -1 };
 
-		std::unordered_set<std::string> cyanvasStyleCriticalTraces;
-
 		// Cyanvas extension: disable fever and skills
 
 		for (const auto& note : sus.taps)
@@ -170,10 +270,11 @@ namespace MikuMikuWorld
 			if (!sus.sideLane && (note.lane - 2 < MIN_LANE || note.lane - 2 > MAX_LANE))
 				continue;
 
-			const std::string key = noteKey(note);
+			const uint64_t key = noteKey(note);
+			const uint16_t flags = noteFlags.flags(key);
 
 			// Conflict with skip slide steps and hidden holds
-			if (slideKeys.find(key) != slideKeys.end())
+			if (flags & SUS_NOTE_SLIDE)
 				continue;
 
 			Note n;
@@ -187,17 +288,16 @@ namespace MikuMikuWorld
 			else
 			{
 				n = Note(NoteType::Tap, note.tick, note.lane - 2, note.width);
-				n.critical = criticals.find(key) != criticals.end();
-				n.friction = frictions.find(key) != frictions.end() ||
-				             stepIgnore.find(key) != stepIgnore.end();
-				n.flick = flicks.find(key) != flicks.end() ? flicks[key] : FlickType::None;
+				n.critical = flags & SUS_NOTE_CRITICAL;
+				n.friction = flags & (SUS_NOTE_FRICTION | SUS_NOTE_STEP_IGNORE);
+				n.flick = noteFlags.flick(key);
 				if (n.critical && n.friction)
 				{
-					if (cyanvasStyleCriticalTraces.find(key) != cyanvasStyleCriticalTraces.end())
+					if (flags & SUS_NOTE_CRITICAL_TRACE_EMITTED)
 					{
 						continue;
 					}
-					cyanvasStyleCriticalTraces.insert(key);
+					noteFlags.set(key, SUS_NOTE_CRITICAL_TRACE_EMITTED);
 				}
 			}
 			n.layer = std::distance(
@@ -215,7 +315,7 @@ namespace MikuMikuWorld
 			for (const auto& slide : slides)
 			{
 				bool isGuide = isGuideSlides;
-				const std::string key = noteKey(slide[0]);
+				const uint64_t key = noteKey(slide[0]);
 
 				auto start = std::find_if(slide.begin(), slide.end(), [](const SUSNote& a)
 				                          { return a.type == 1 || a.type == 2; });
@@ -223,7 +323,7 @@ namespace MikuMikuWorld
 				if (start == slide.end() || slide.size() < 2)
 					continue;
 
-				bool critical = criticals.find(key) != criticals.end();
+				bool critical = noteFlags.has(key, SUS_NOTE_CRITICAL);
 
 				HoldNote hold;
 				int startID = Note::getNextID();
@@ -231,14 +331,15 @@ namespace MikuMikuWorld
 
 				for (const auto& note : slide)
 				{
-					const std::string key = noteKey(note);
+					const uint64_t key = noteKey(note);
+					const uint16_t flags = noteFlags.flags(key);
 
 					EaseType ease = EaseType::Linear;
-					if (easeIns.find(key) != easeIns.end())
+					if (flags & SUS_NOTE_EASE_IN)
 					{
 						ease = EaseType::EaseIn;
 					}
-					else if (easeOuts.find(key) != easeOuts.end())
+					else if (flags & SUS_NOTE_EASE_OUT)
 					{
 						ease = EaseType::EaseOut;
 					}
@@ -256,8 +357,8 @@ namespace MikuMikuWorld
 						                            hiSpeedGroupNames.end(), note.hiSpeedGroup));
 						n.ID = startID;
 
-						if (isGuide || (hiddenHolds.find(noteKey(note)) != hiddenHolds.end() &&
-						                stepIgnore.find(key) != stepIgnore.end()))
+						if (isGuide ||
+						    ((flags & SUS_NOTE_HIDDEN_HOLD) && (flags & SUS_NOTE_STEP_IGNORE)))
 						{
 							isGuide = true;
 							if (critical)
@@ -268,11 +369,9 @@ namespace MikuMikuWorld
 						}
 						else
 						{
-							n.friction = frictions.find(noteKey(note)) != frictions.end() ||
-							             stepIgnore.find(key) != stepIgnore.end();
-							hold.startType = hiddenHolds.find(noteKey(note)) != hiddenHolds.end()
-							                     ? HoldNoteType::Hidden
-							                     : HoldNoteType::Normal;
+							n.friction = flags & (SUS_NOTE_FRICTION | SUS_NOTE_STEP_IGNORE);
+							hold.startType = (flags & SUS_NOTE_HIDDEN_HOLD) ? HoldNoteType::Hidden
+							                                                : HoldNoteType::Normal;
 						}
 
 						notes[n.ID] = n;
@@ -283,7 +382,7 @@ namespace MikuMikuWorld
 					case 2:
 					{
 						Note n(NoteType::HoldEnd, note.tick, note.lane - 2, note.width);
-						n.critical = (critical ? true : (criticals.find(key) != criticals.end()));
+						n.critical = critical || (flags & SUS_NOTE_CRITICAL);
 						n.layer =
 						    std::distance(hiSpeedGroupNames.begin(),
 						                  std::find(hiSpeedGroupNames.begin(),
@@ -294,19 +393,15 @@ namespace MikuMikuWorld
 						if (isGuide)
 						{
 							hold.endType = HoldNoteType::Guide;
-							hold.fadeType = hiddenHolds.find(noteKey(note)) != hiddenHolds.end()
-							                    ? FadeType::None
-							                    : FadeType::Out;
+							hold.fadeType =
+							    (flags & SUS_NOTE_HIDDEN_HOLD) ? FadeType::None : FadeType::Out;
 						}
 						else
 						{
-							n.flick =
-							    flicks.find(key) != flicks.end() ? flicks[key] : FlickType::None;
-							n.friction = frictions.find(noteKey(note)) != frictions.end() ||
-							             stepIgnore.find(key) != stepIgnore.end();
-							hold.endType = hiddenHolds.find(noteKey(note)) != hiddenHolds.end()
-							                   ? HoldNoteType::Hidden
-							                   : HoldNoteType::Normal;
+							n.flick = noteFlags.flick(key);
+							n.friction = flags & (SUS_NOTE_FRICTION | SUS_NOTE_STEP_IGNORE);
+							hold.endType = (flags & SUS_NOTE_HIDDEN_HOLD) ? HoldNoteType::Hidden
+							                                              : HoldNoteType::Normal;
 						}
 
 						notes[n.ID] = n;
@@ -332,7 +427,7 @@ namespace MikuMikuWorld
 
 						HoldStepType type =
 						    note.type == 3 ? HoldStepType::Normal : HoldStepType::Hidden;
-						if (stepIgnore.find(key) != stepIgnore.end())
+						if (flags & SUS_NOTE_STEP_IGNORE)
 						{
 							type = HoldStepType::Skip;
 						}
@@ -394,8 +489,8 @@ namespace MikuMikuWorld
 
 		Score score;
 		score.metadata = metadata;
-		score.notes = notes;
-		score.holdNotes = holds;
+		score.notes = std::move(notes);
+		score.holdNotes = std::move(holds);
 		score.tempoChanges = tempos;
 		score.timeSignatures = timeSignatures;
 		score.layers = layers;
@@ -630,560 +725,750 @@ namespace MikuMikuWorld
 			        bpms,     barlengths, hiSpeedGroup, laneOffset };
 	}
 
-	json ScoreConverter::scoreToUsc(const Score& score)
+	/// Writes JSON straight to a stream with the same layout as nlohmann::json::dump.
+	/// Object keys must be written in sorted order to match the output of a json object.
+	class JsonStreamWriter
+	{
+	  private:
+		std::ostream& stream;
+		int indent;
+		int depth{};
+		bool empty{ true };
+		bool afterKey{};
+
+		void beginValue()
+		{
+			if (afterKey)
+			{
+				afterKey = false;
+				return;
+			}
+
+			if (depth == 0)
+				return;
+
+			if (!empty)
+				stream.put(',');
+
+			newLine();
+			empty = false;
+		}
+
+		void newLine()
+		{
+			if (indent < 0)
+				return;
+
+			stream.put('\n');
+			for (int i = 0; i < depth * indent; ++i)
+				stream.put(' ');
+		}
+
+		void beginContainer(char open)
+		{
+			beginValue();
+			stream.put(open);
+			++depth;
+			empty = true;
+		}
+
+		void endContainer(char close)
+		{
+			--depth;
+			if (!empty)
+				newLine();
+
+			stream.put(close);
+			empty = false;
+		}
+
+	  public:
+		JsonStreamWriter(std::ostream& stream, int indent) : stream{ stream }, indent{ indent } {}
+
+		void beginObject() { beginContainer('{'); }
+		void endObject() { endContainer('}'); }
+		void beginArray() { beginContainer('['); }
+		void endArray() { endContainer(']'); }
+
+		void key(const char* name)
+		{
+			beginValue();
+			stream.put('"');
+			stream << name;
+			stream << (indent < 0 ? "\":" : "\": ");
+			afterKey = true;
+		}
+
+		template <typename T> void value(const T& v)
+		{
+			beginValue();
+			stream << json(v);
+		}
+
+		template <typename T> void field(const char* name, const T& v)
+		{
+			key(name);
+			value(v);
+		}
+	};
+
+	/// SAX handler for USC files that only materializes one entry of usc.objects at a time.
+	/// The rest of the document is built as usual with usc.objects left empty.
+	/// Stops with "Invalid version" as soon as a top level version other than 2 is read.
+	class UscSaxReader : public nlohmann::json_sax<json>
 	{
-		json vusc;
-		json usc;
+	  private:
+		std::function<void(const json&)> onObject;
+		std::string lastKey;
+		std::vector<json*> stack;
+		json* usc{};
+		json* objects{};
+		json object;
+
+		json* add(json&& v)
+		{
+			if (stack.empty())
+			{
+				document = std::move(v);
+				return &document;
+			}
+
+			json& parent = *stack.back();
+			if (parent.is_array())
+			{
+				parent.push_back(std::move(v));
+				return &parent.back();
+			}
+
+			json& member = parent[lastKey];
+			member = std::move(v);
+			return &member;
+		}
 
-		usc["offset"] = score.metadata.musicOffset / -1000.0f;
+		bool scalar(json&& v)
+		{
+			if (stack.size() == 1 && lastKey == "version" && v != 2)
+				throw std::runtime_error("Invalid version");
 
-		std::vector<json> objects;
+			if (!stack.empty() && stack.back() == objects)
+				onObject(v);
+			else
+				add(std::move(v));
+
+			return true;
+		}
+
+		bool beginContainer(json&& container)
+		{
+			if (!stack.empty() && stack.back() == objects)
+			{
+				object = std::move(container);
+				stack.push_back(&object);
+				return true;
+			}
+
+			const bool isObject = container.is_object();
+			const bool isArray = container.is_array();
+			json* parent = stack.empty() ? nullptr : stack.back();
+			json* added = add(std::move(container));
+			if (stack.size() == 1 && lastKey == "usc" && isObject)
+				usc = added;
+			else if (parent && parent == usc && lastKey == "objects" && isArray)
+				objects = added;
+
+			stack.push_back(added);
+			return true;
+		}
+
+		bool endContainer()
+		{
+			stack.pop_back();
+			if (!stack.empty() && stack.back() == objects)
+			{
+				onObject(object);
+				object = nullptr;
+			}
+
+			return true;
+		}
+
+	  public:
+		json document;
+
+		UscSaxReader(std::function<void(const json&)> onObject) : onObject{ std::move(onObject) }
+		{
+		}
+
+		bool null() override { return scalar(nullptr); }
+		bool boolean(bool val) override { return scalar(val); }
+		bool number_integer(number_integer_t val) override { return scalar(val); }
+		bool number_unsigned(number_unsigned_t val) override { return scalar(val); }
+		bool number_float(number_float_t val, const string_t&) override { return scalar(val); }
+		bool string(string_t& val) override { return scalar(std::move(val)); }
+		bool binary(binary_t& val) override { return scalar(json::binary(std::move(val))); }
+
+		bool start_object(std::size_t) override { return beginContainer(json::object()); }
+		bool end_object() override { return endContainer(); }
+		bool start_array(std::size_t) override { return beginContainer(json::array()); }
+		bool end_array() override { return endContainer(); }
+
+		bool key(string_t& val) override
+		{
+			lastKey = std::move(val);
+			return true;
+		}
+
+		bool parse_error(std::size_t, const std::string&,
+		                 const nlohmann::detail::exception& ex) override
+		{
+			throw std::runtime_error(ex.what());
+		}
+	};
+
+	static const char* uscDirection(FlickType flick)
+	{
+		return flick == FlickType::Default ? "up" : flick == FlickType::Left ? "left" : "right";
+	}
+
+	static const char* uscJudgeType(HoldNoteType type, bool friction)
+	{
+		return type == HoldNoteType::Hidden ? "none" : friction ? "trace" : "normal";
+	}
+
+	void ScoreConverter::scoreToUsc(const Score& score, std::ostream& stream, int indent)
+	{
+		JsonStreamWriter writer(stream, indent);
+		writer.beginObject();
+		writer.key("usc");
+		writer.beginObject();
+		writer.key("objects");
+		writer.beginArray();
 
 		for (const auto& bpm : score.tempoChanges)
 		{
-			json obj;
-			obj["type"] = "bpm";
-			obj["beat"] = bpm.tick / (double)TICKS_PER_BEAT;
-			obj["bpm"] = bpm.bpm;
-			objects.push_back(obj);
+			writer.beginObject();
+			writer.field("beat", bpm.tick / (double)TICKS_PER_BEAT);
+			writer.field("bpm", bpm.bpm);
+			writer.field("type", "bpm");
+			writer.endObject();
 		}
 
 		for (int i = 0; i < score.layers.size(); ++i)
 		{
-			json timeScaleGroup;
-			timeScaleGroup["type"] = "timeScaleGroup";
-			std::vector<json> timeScaleObjects;
+			writer.beginObject();
+			writer.key("changes");
+			writer.beginArray();
 			for (const auto& [_, hs] : score.hiSpeedChanges)
 			{
 				if (hs.layer != i)
 				{
 					continue;
 				}
-				json obj;
-				obj["beat"] = hs.tick / (double)TICKS_PER_BEAT;
-				obj["timeScale"] = hs.speed;
-				timeScaleObjects.push_back(obj);
+				writer.beginObject();
+				writer.field("beat", hs.tick / (double)TICKS_PER_BEAT);
+				writer.field("timeScale", hs.speed);
+				writer.endObject();
 			}
-			timeScaleGroup["changes"] = timeScaleObjects;
-			objects.push_back(timeScaleGroup);
+			writer.endArray();
+			writer.field("type", "timeScaleGroup");
+			writer.endObject();
 		}
 
 		for (const auto& [_, note] : score.notes)
 		{
 			if (note.getType() == NoteType::Tap)
 			{
-				json obj;
-				obj["type"] = "single";
-				obj["beat"] = note.tick / (double)TICKS_PER_BEAT;
-				obj["size"] = note.width / 2.0;
-				obj["lane"] = note.lane - 6 + (note.width / 2.0);
-				obj["critical"] = note.critical;
-				obj["trace"] = note.friction;
+				writer.beginObject();
+				writer.field("beat", note.tick / (double)TICKS_PER_BEAT);
+				writer.field("critical", note.critical);
 				if (note.flick != FlickType::None)
 				{
-					obj["direction"] = note.flick == FlickType::Default ? "up"
-					                   : note.flick == FlickType::Left  ? "left"
-					                                                    : "right";
+					writer.field("direction", uscDirection(note.flick));
 				}
-				obj["timeScaleGroup"] = note.layer;
-				objects.push_back(obj);
+				writer.field("lane", note.lane - 6 + (note.width / 2.0));
+				writer.field("size", note.width / 2.0);
+				writer.field("timeScaleGroup", note.layer);
+				writer.field("trace", note.friction);
+				writer.field("type", "single");
+				writer.endObject();
 			}
 			else if (note.getType() == NoteType::Damage)
 			{
-				json obj;
-				obj["type"] = "damage";
-				obj["beat"] = note.tick / (double)TICKS_PER_BEAT;
-				obj["size"] = note.width / 2.0;
-				obj["lane"] = note.lane - 6 + (note.width / 2.0);
-				obj["timeScaleGroup"] = note.layer;
-				objects.push_back(obj);
+				writer.beginObject();
+				writer.field("beat", note.tick / (double)TICKS_PER_BEAT);
+				writer.field("lane", note.lane - 6 + (note.width / 2.0));
+				writer.field("size", note.width / 2.0);
+				writer.field("timeScaleGroup", note.layer);
+				writer.field("type", "damage");
+				writer.endObject();
 			}
 		}
+
 		for (const auto& [_, note] : score.holdNotes)
 		{
-			json obj;
+			auto& start = score.notes.at(note.start.ID);
+			auto& end = score.notes.at(note.end);
+			writer.beginObject();
 			if (note.isGuide())
 			{
-				obj["type"] = "guide";
-				auto& start = score.notes.at(note.start.ID);
-				obj["color"] = guideColors[(int)note.guideColor];
-				obj["fade"] = note.fadeType == FadeType::None ? "none"
-				              : note.fadeType == FadeType::In ? "in"
-				                                              : "out";
-
-				std::vector<json> steps;
-				steps.reserve(note.steps.size() + 1);
-
-				json startStep;
-				startStep["beat"] = start.tick / (double)TICKS_PER_BEAT;
-				startStep["size"] = start.width / 2.0;
-				startStep["lane"] = start.lane - 6 + (start.width / 2.0);
-				startStep["ease"] = easeNames[(int)note.start.ease];
-				startStep["timeScaleGroup"] = start.layer;
-				steps.push_back(startStep);
+				writer.field("color", guideColors[(int)note.guideColor]);
+				writer.field("fade", note.fadeType == FadeType::None ? "none"
+				                     : note.fadeType == FadeType::In ? "in"
+				                                                     : "out");
+				writer.key("midpoints");
+				writer.beginArray();
+
+				writer.beginObject();
+				writer.field("beat", start.tick / (double)TICKS_PER_BEAT);
+				writer.field("ease", easeNames[(int)note.start.ease]);
+				writer.field("lane", start.lane - 6 + (start.width / 2.0));
+				writer.field("size", start.width / 2.0);
+				writer.field("timeScaleGroup", start.layer);
+				writer.endObject();
 
 				for (const auto& step : note.steps)
 				{
-					json stepObj;
 					auto& stepNote = score.notes.at(step.ID);
-					stepObj["beat"] = stepNote.tick / (double)TICKS_PER_BEAT;
-					stepObj["size"] = stepNote.width / 2.0;
-					stepObj["lane"] = stepNote.lane - 6 + (stepNote.width / 2.0);
-					stepObj["ease"] = easeNames[(int)step.ease];
-					stepObj["timeScaleGroup"] = stepNote.layer;
-					steps.push_back(stepObj);
+					writer.beginObject();
+					writer.field("beat", stepNote.tick / (double)TICKS_PER_BEAT);
+					writer.field("ease", easeNames[(int)step.ease]);
+					writer.field("lane", stepNote.lane - 6 + (stepNote.width / 2.0));
+					writer.field("size", stepNote.width / 2.0);
+					writer.field("timeScaleGroup", stepNote.layer);
+					writer.endObject();
 				}
 
-				json endStep;
-				auto& end = score.notes.at(note.end);
-				endStep["beat"] = end.tick / (double)TICKS_PER_BEAT;
-				endStep["size"] = end.width / 2.0;
-				endStep["lane"] = end.lane - 6 + (end.width / 2.0);
-				endStep["ease"] = "linear";
-				endStep["timeScaleGroup"] = end.layer;
-				steps.push_back(endStep);
-
-				obj["midpoints"] = steps;
-				objects.push_back(obj);
+				writer.beginObject();
+				writer.field("beat", end.tick / (double)TICKS_PER_BEAT);
+				writer.field("ease", "linear");
+				writer.field("lane", end.lane - 6 + (end.width / 2.0));
+				writer.field("size", end.width / 2.0);
+				writer.field("timeScaleGroup", end.layer);
+				writer.endObject();
+
+				writer.endArray();
+				writer.field("type", "guide");
+				writer.endObject();
 				continue;
 			}
-			obj["type"] = "slide";
-			auto& start = score.notes.at(note.start.ID);
-			obj["critical"] = start.critical;
-
-			std::vector<json> steps;
-			steps.reserve(note.steps.size() + 1);
-			json startStep;
-			startStep["type"] = "start";
-			startStep["beat"] = start.tick / (double)TICKS_PER_BEAT;
-			startStep["size"] = start.width / 2.0;
-			startStep["lane"] = start.lane - 6 + (start.width / 2.0);
-			startStep["critical"] = start.critical;
-			startStep["ease"] = easeNames[(int)note.start.ease];
-			startStep["judgeType"] = note.startType == HoldNoteType::Hidden ? "none"
-			                         : start.friction                       ? "trace"
-			                                                                : "normal";
-			startStep["timeScaleGroup"] = start.layer;
-			steps.push_back(startStep);
+
+			writer.key("connections");
+			writer.beginArray();
+
+			writer.beginObject();
+			writer.field("beat", start.tick / (double)TICKS_PER_BEAT);
+			writer.field("critical", start.critical);
+			writer.field("ease", easeNames[(int)note.start.ease]);
+			writer.field("judgeType", uscJudgeType(note.startType, start.friction));
+			writer.field("lane", start.lane - 6 + (start.width / 2.0));
+			writer.field("size", start.width / 2.0);
+			writer.field("timeScaleGroup", start.layer);
+			writer.field("type", "start");
+			writer.endObject();
 
 			for (const auto& step : note.steps)
 			{
-				json stepObj;
 				auto& stepNote = score.notes.at(step.ID);
-				stepObj["type"] = step.type == HoldStepType::Skip ? "attach" : "tick";
-				stepObj["beat"] = stepNote.tick / (double)TICKS_PER_BEAT;
-				stepObj["size"] = stepNote.width / 2.0;
-				stepObj["lane"] = stepNote.lane - 6 + (stepNote.width / 2.0);
+				writer.beginObject();
+				writer.field("beat", stepNote.tick / (double)TICKS_PER_BEAT);
 				if (step.type != HoldStepType::Hidden)
 				{
-					stepObj["critical"] = stepNote.critical;
+					writer.field("critical", stepNote.critical);
 				}
-				stepObj["ease"] = easeNames[(int)step.ease];
-				stepObj["timeScaleGroup"] = stepNote.layer;
-				steps.push_back(stepObj);
+				writer.field("ease", easeNames[(int)step.ease]);
+				writer.field("lane", stepNote.lane - 6 + (stepNote.width / 2.0));
+				writer.field("size", stepNote.width / 2.0);
+				writer.field("timeScaleGroup", stepNote.layer);
+				writer.field("type", step.type == HoldStepType::Skip ? "attach" : "tick");
+				writer.endObject();
 			}
 
-			json endStep;
-			auto& end = score.notes.at(note.end);
-			endStep["type"] = "end";
-			endStep["beat"] = end.tick / (double)TICKS_PER_BEAT;
-			endStep["size"] = end.width / 2.0;
-			endStep["lane"] = end.lane - 6 + (end.width / 2.0);
-			endStep["critical"] = end.critical;
-			endStep["judgeType"] = note.endType == HoldNoteType::Hidden ? "none"
-			                       : end.friction                       ? "trace"
-			                                                            : "normal";
+			writer.beginObject();
+			writer.field("beat", end.tick / (double)TICKS_PER_BEAT);
+			writer.field("critical", end.critical);
 			if (end.flick != FlickType::None)
 			{
-				endStep["direction"] = end.flick == FlickType::Default ? "up"
-				                       : end.flick == FlickType::Left  ? "left"
-				                                                       : "right";
+				writer.field("direction", uscDirection(end.flick));
 			}
-			endStep["timeScaleGroup"] = end.layer;
-			steps.push_back(endStep);
-
-			obj["connections"] = steps;
-			objects.push_back(obj);
+			writer.field("judgeType", uscJudgeType(note.endType, end.friction));
+			writer.field("lane", end.lane - 6 + (end.width / 2.0));
+			writer.field("size", end.width / 2.0);
+			writer.field("timeScaleGroup", end.layer);
+			writer.field("type", "end");
+			writer.endObject();
+
+			writer.endArray();
+			writer.field("critical", start.critical);
+			writer.field("type", "slide");
+			writer.endObject();
 		}
 
-		usc["objects"] = objects;
-
-		vusc["version"] = 2;
-		vusc["usc"] = usc;
-		return vusc;
+		writer.endArray();
+		writer.field("offset", score.metadata.musicOffset / -1000.0f);
+		writer.endObject();
+		writer.field("version", 2);
+		writer.endObject();
 	}
 
-	Score ScoreConverter::uscToScore(const json& vusc)
+	static void uscObjectToScore(const json& obj, Score& score)
 	{
-		Score score;
-		if (vusc["version"] != 2)
+		if (obj["type"] == "bpm")
 		{
-			throw std::runtime_error("Invalid version");
+			score.tempoChanges.push_back(Tempo{
+			    (int)(obj["beat"].get<double>() * TICKS_PER_BEAT), obj["bpm"].get<float>() });
 		}
-		json usc = vusc["usc"];
-		score.layers.clear();
-		score.hiSpeedChanges.clear();
-		score.tempoChanges.clear();
+		else if (obj["type"] == "timeScaleGroup")
+		{
+			int index = score.layers.size();
+			score.layers.push_back(Layer{ IO::formatString("#%d", index) });
+			for (const auto& change : obj["changes"])
+			{
+				id_t id = Note::getNextID();
+				score.hiSpeedChanges[id] =
+				    HiSpeedChange{ id, (int)(change["beat"].get<double>() * TICKS_PER_BEAT),
+					               change["timeScale"].get<float>(), index };
+			}
+		}
+		else if (obj["type"] == "single")
+		{
+			Note note(NoteType::Tap);
+			note.tick = obj["beat"].get<double>() * TICKS_PER_BEAT;
+			note.width = obj["size"].get<float>() * 2;
+			note.lane = obj["lane"].get<float>() + 6 - obj["size"].get<float>();
+			note.critical = obj["critical"].get<bool>();
+			note.friction = obj["trace"].get<bool>();
+			if (obj.contains("direction"))
+			{
+				std::string dir = obj["direction"].get<std::string>();
+				note.flick = dir == "up"     ? FlickType::Default
+				             : dir == "left" ? FlickType::Left
+				                             : FlickType::Right;
+			}
+			else
+			{
+				note.flick = FlickType::None;
+			}
+			note.layer = obj["timeScaleGroup"].get<int>();
+			note.ID = Note::getNextID();
+			score.notes[note.ID] = note;
+		}
+		else if (obj["type"] == "damage")
+		{
+			Note note(NoteType::Damage);
+			note.tick = obj["beat"].get<double>() * TICKS_PER_BEAT;
+			note.width = obj["size"].get<float>() * 2;
+			note.lane = obj["lane"].get<float>() + 6 - obj["size"].get<float>();
+			note.layer = obj["timeScaleGroup"].get<int>();
+			note.ID = Note::getNextID();
+			score.notes[note.ID] = note;
+		}
+		else if (obj["type"] == "guide")
+		{
+			HoldNote hold;
 
-		score.metadata.musicOffset = usc["offset"].get<float>() * -1000.0f;
+			auto color = obj["color"].get<std::string>();
 
-		for (const auto& obj : usc["objects"].get<std::vector<json>>())
-		{
-			if (obj["type"] == "bpm")
+			if (color == "neutral")
 			{
-				score.tempoChanges.push_back(Tempo{
-				    (int)(obj["beat"].get<double>() * TICKS_PER_BEAT), obj["bpm"].get<float>() });
+				hold.guideColor = GuideColor::Neutral;
 			}
-			else if (obj["type"] == "timeScaleGroup")
+			else if (color == "red")
 			{
-				int index = score.layers.size();
-				score.layers.push_back(Layer{ IO::formatString("#%d", index) });
-				for (const auto& change : obj["changes"])
-				{
-					id_t id = Note::getNextID();
-					score.hiSpeedChanges[id] =
-					    HiSpeedChange{ id, (int)(change["beat"].get<double>() * TICKS_PER_BEAT),
-						               change["timeScale"].get<float>(), index };
-				}
+				hold.guideColor = GuideColor::Red;
 			}
-			else if (obj["type"] == "single")
+			else if (color == "green")
 			{
-				Note note(NoteType::Tap);
-				note.tick = obj["beat"].get<double>() * TICKS_PER_BEAT;
-				note.width = obj["size"].get<float>() * 2;
-				note.lane = obj["lane"].get<float>() + 6 - obj["size"].get<float>();
-				note.critical = obj["critical"].get<bool>();
-				note.friction = obj["trace"].get<bool>();
-				if (obj.contains("direction"))
-				{
-					std::string dir = obj["direction"].get<std::string>();
-					note.flick = dir == "up"     ? FlickType::Default
-					             : dir == "left" ? FlickType::Left
-					                             : FlickType::Right;
-				}
-				else
-				{
-					note.flick = FlickType::None;
-				}
-				note.layer = obj["timeScaleGroup"].get<int>();
-				note.ID = Note::getNextID();
-				score.notes[note.ID] = note;
+				hold.guideColor = GuideColor::Green;
 			}
-			else if (obj["type"] == "damage")
+			else if (color == "blue")
 			{
-				Note note(NoteType::Damage);
-				note.tick = obj["beat"].get<double>() * TICKS_PER_BEAT;
-				note.width = obj["size"].get<float>() * 2;
-				note.lane = obj["lane"].get<float>() + 6 - obj["size"].get<float>();
-				note.layer = obj["timeScaleGroup"].get<int>();
-				note.ID = Note::getNextID();
-				score.notes[note.ID] = note;
+				hold.guideColor = GuideColor::Blue;
 			}
-			else if (obj["type"] == "guide")
+			else if (color == "yellow")
 			{
-				HoldNote hold;
-
-				auto color = obj["color"].get<std::string>();
+				hold.guideColor = GuideColor::Yellow;
+			}
+			else if (color == "purple")
+			{
+				hold.guideColor = GuideColor::Purple;
+			}
+			else if (color == "cyan")
+			{
+				hold.guideColor = GuideColor::Cyan;
+			}
+			else if (color == "black")
+			{
+				hold.guideColor = GuideColor::Black;
+			}
+			hold.fadeType = obj["fade"].get<std::string>() == "none" ? FadeType::None
+			                : obj["fade"].get<std::string>() == "in" ? FadeType::In
+			                                                         : FadeType::Out;
 
-				if (color == "neutral")
-				{
-					hold.guideColor = GuideColor::Neutral;
-				}
-				else if (color == "red")
-				{
-					hold.guideColor = GuideColor::Red;
-				}
-				else if (color == "green")
-				{
-					hold.guideColor = GuideColor::Green;
-				}
-				else if (color == "blue")
-				{
-					hold.guideColor = GuideColor::Blue;
-				}
-				else if (color == "yellow")
+			for (size_t i = 0; i < obj["midpoints"].size(); i++)
+			{
+				const auto& step = obj["midpoints"][i];
+				if (i == 0)
 				{
-					hold.guideColor = GuideColor::Yellow;
+					Note startNote(NoteType::Hold);
+					startNote.tick = step["beat"].get<double>() * TICKS_PER_BEAT;
+					startNote.lane = step["lane"].get<float>() + 6 - step["size"].get<float>();
+					startNote.layer = step["timeScaleGroup"].get<int>();
+					startNote.ID = Note::getNextID();
+					startNote.width = step["size"].get<float>() * 2;
+					score.notes[startNote.ID] = startNote;
+					hold.start.ID = startNote.ID;
+
+					std::string ease = jsonIO::tryGetValue(step, "ease", std::string("linear"));
+					if (ease == "in")
+					{
+						hold.start.ease = EaseType::EaseIn;
+					}
+					else if (ease == "out")
+					{
+						hold.start.ease = EaseType::EaseOut;
+					}
+					else if (ease == "inout")
+					{
+						hold.start.ease = EaseType::EaseInOut;
+					}
+					else if (ease == "outin")
+					{
+						hold.start.ease = EaseType::EaseOutIn;
+					}
+					else
+					{
+						hold.start.ease = EaseType::Linear;
+					}
+					hold.startType = HoldNoteType::Guide;
 				}
-				else if (color == "purple")
+				else if (i == obj["midpoints"].size() - 1)
 				{
-					hold.guideColor = GuideColor::Purple;
+					Note endNote(NoteType::HoldEnd);
+					endNote.tick = step["beat"].get<double>() * TICKS_PER_BEAT;
+					endNote.lane = step["lane"].get<float>() + 6 - step["size"].get<float>();
+					endNote.layer = step["timeScaleGroup"].get<int>();
+					endNote.ID = Note::getNextID();
+					endNote.parentID = hold.start.ID;
+					endNote.width = step["size"].get<float>() * 2;
+					score.notes[endNote.ID] = endNote;
+					hold.end = endNote.ID;
+					hold.endType = HoldNoteType::Guide;
 				}
-				else if (color == "cyan")
+				else
 				{
-					hold.guideColor = GuideColor::Cyan;
+					HoldStep s;
+					Note mid(NoteType::HoldMid);
+					mid.tick = step["beat"].get<double>() * TICKS_PER_BEAT;
+					mid.lane = step["lane"].get<float>() + 6 - step["size"].get<float>();
+					mid.layer = step["timeScaleGroup"].get<int>();
+					mid.ID = Note::getNextID();
+					mid.parentID = hold.start.ID;
+					mid.width = step["size"].get<float>() * 2;
+					score.notes[mid.ID] = mid;
+					s.ID = mid.ID;
+
+					std::string ease = jsonIO::tryGetValue(step, "ease", std::string("linear"));
+					if (ease == "in")
+					{
+						s.ease = EaseType::EaseIn;
+					}
+					else if (ease == "out")
+					{
+						s.ease = EaseType::EaseOut;
+					}
+					else if (ease == "inout")
+					{
+						s.ease = EaseType::EaseInOut;
+					}
+					else if (ease == "outin")
+					{
+						s.ease = EaseType::EaseOutIn;
+					}
+					else
+					{
+						s.ease = EaseType::Linear;
+					}
+					s.type = HoldStepType::Hidden;
+					hold.steps.push_back(s);
 				}
-				else if (color == "black")
+			}
+			score.holdNotes[hold.start.ID] = hold;
+		}
+		else if (obj["type"] == "slide")
+		{
+			HoldNote hold;
+			hold.fadeType = FadeType::None;
+
+			auto connections = obj["connections"].get<std::vector<json>>();
+			std::stable_sort(connections.begin(), connections.end(),
+			                 [](const json& a, const json& b)
+			                 {
+				                 if (a["type"] == "start")
+				                 {
+					                 return true;
+				                 }
+				                 else if (b["type"] == "start")
+				                 {
+					                 return false;
+				                 }
+				                 else if (a["type"] == "end")
+				                 {
+					                 return false;
+				                 }
+				                 else if (b["type"] == "end")
+				                 {
+					                 return true;
+				                 }
+				                 return a["beat"].get<double>() < b["beat"].get<float>();
+			                 });
+
+			bool isCritical = false;
+			for (const auto& step : connections)
+			{
+				auto type = step["type"].get<std::string>();
+				if (type == "start")
 				{
-					hold.guideColor = GuideColor::Black;
-				}
-				hold.fadeType = obj["fade"].get<std::string>() == "none" ? FadeType::None
-				                : obj["fade"].get<std::string>() == "in" ? FadeType::In
-				                                                         : FadeType::Out;
+					Note startNote(NoteType::Hold);
+					startNote.tick = step["beat"].get<double>() * TICKS_PER_BEAT;
+					startNote.lane = step["lane"].get<float>() + 6 - step["size"].get<float>();
+					startNote.layer = step["timeScaleGroup"].get<int>();
+					startNote.critical = step["critical"].get<bool>();
+					isCritical = startNote.critical;
+					startNote.width = step["size"].get<float>() * 2;
+					if (step["judgeType"].get<std::string>() == "trace")
+					{
+						startNote.friction = true;
+						hold.startType = HoldNoteType::Normal;
+					}
+					else if (step["judgeType"].get<std::string>() == "none")
+					{
+						hold.startType = HoldNoteType::Hidden;
+					}
+					else
+					{
+						hold.startType = HoldNoteType::Normal;
+					}
+					startNote.ID = Note::getNextID();
+					score.notes[startNote.ID] = startNote;
+					hold.start.ID = startNote.ID;
 
-				for (int i = 0; i < obj["midpoints"].size(); i++)
+					std::string ease = jsonIO::tryGetValue(step, "ease", std::string("linear"));
+					if (ease == "in")
+					{
+						hold.start.ease = EaseType::EaseIn;
+					}
+					else if (ease == "out")
+					{
+						hold.start.ease = EaseType::EaseOut;
+					}
+					else if (ease == "inout")
+					{
+						hold.start.ease = EaseType::EaseInOut;
+					}
+					else if (ease == "outin")
+					{
+						hold.start.ease = EaseType::EaseOutIn;
+					}
+					else
+					{
+						hold.start.ease = EaseType::Linear;
+					}
+				}
+				else if (type == "end")
 				{
-					const auto& step = obj["midpoints"][i];
-					if (i == 0)
+					Note endNote(NoteType::HoldEnd);
+					endNote.tick = step["beat"].get<double>() * TICKS_PER_BEAT;
+					endNote.lane = step["lane"].get<float>() + 6 - step["size"].get<float>();
+					endNote.layer = step["timeScaleGroup"].get<int>();
+					endNote.width = step["size"].get<float>() * 2;
+					endNote.critical = isCritical || step["critical"].get<bool>();
+					endNote.flick = step.contains("direction")
+					                    ? step["direction"].get<std::string>() == "up"
+					                          ? FlickType::Default
+					                      : step["direction"].get<std::string>() == "left"
+					                          ? FlickType::Left
+					                          : FlickType::Right
+					                    : FlickType::None;
+					endNote.ID = Note::getNextID();
+					endNote.parentID = hold.start.ID;
+
+					if (step["judgeType"].get<std::string>() == "trace")
 					{
-						Note startNote(NoteType::Hold);
-						startNote.tick = step["beat"].get<double>() * TICKS_PER_BEAT;
-						startNote.lane = step["lane"].get<float>() + 6 - step["size"].get<float>();
-						startNote.layer = step["timeScaleGroup"].get<int>();
-						startNote.ID = Note::getNextID();
-						startNote.width = step["size"].get<float>() * 2;
-						score.notes[startNote.ID] = startNote;
-						hold.start.ID = startNote.ID;
-
-						std::string ease = jsonIO::tryGetValue(step, "ease", std::string("linear"));
-						if (ease == "in")
-						{
-							hold.start.ease = EaseType::EaseIn;
-						}
-						else if (ease == "out")
-						{
-							hold.start.ease = EaseType::EaseOut;
-						}
-						else if (ease == "inout")
-						{
-							hold.start.ease = EaseType::EaseInOut;
-						}
-						else if (ease == "outin")
-						{
-							hold.start.ease = EaseType::EaseOutIn;
-						}
-						else
-						{
-							hold.start.ease = EaseType::Linear;
-						}
-						hold.startType = HoldNoteType::Guide;
+						endNote.friction = true;
+						hold.endType = HoldNoteType::Normal;
 					}
-					else if (i == obj["midpoints"].size() - 1)
+					else if (step["judgeType"].get<std::string>() == "none")
 					{
-						Note endNote(NoteType::HoldEnd);
-						endNote.tick = step["beat"].get<double>() * TICKS_PER_BEAT;
-						endNote.lane = step["lane"].get<float>() + 6 - step["size"].get<float>();
-						endNote.layer = step["timeScaleGroup"].get<int>();
-						endNote.ID = Note::getNextID();
-						endNote.parentID = hold.start.ID;
-						endNote.width = step["size"].get<float>() * 2;
-						score.notes[endNote.ID] = endNote;
-						hold.end = endNote.ID;
-						hold.endType = HoldNoteType::Guide;
+						hold.endType = HoldNoteType::Hidden;
 					}
 					else
 					{
-						HoldStep s;
-						Note mid(NoteType::HoldMid);
-						mid.tick = step["beat"].get<double>() * TICKS_PER_BEAT;
-						mid.lane = step["lane"].get<float>() + 6 - step["size"].get<float>();
-						mid.layer = step["timeScaleGroup"].get<int>();
-						mid.ID = Note::getNextID();
-						mid.parentID = hold.start.ID;
-						mid.width = step["size"].get<float>() * 2;
-						score.notes[mid.ID] = mid;
-						s.ID = mid.ID;
-
-						std::string ease = jsonIO::tryGetValue(step, "ease", std::string("linear"));
-						if (ease == "in")
-						{
-							s.ease = EaseType::EaseIn;
-						}
-						else if (ease == "out")
-						{
-							s.ease = EaseType::EaseOut;
-						}
-						else if (ease == "inout")
-						{
-							s.ease = EaseType::EaseInOut;
-						}
-						else if (ease == "outin")
-						{
-							s.ease = EaseType::EaseOutIn;
-						}
-						else
-						{
-							s.ease = EaseType::Linear;
-						}
-						s.type = HoldStepType::Hidden;
-						hold.steps.push_back(s);
+						hold.endType = HoldNoteType::Normal;
 					}
+					score.notes[endNote.ID] = endNote;
+					hold.end = endNote.ID;
 				}
-				score.holdNotes[hold.start.ID] = hold;
-			}
-			else if (obj["type"] == "slide")
-			{
-				HoldNote hold;
-				hold.fadeType = FadeType::None;
-
-				auto connections = obj["connections"].get<std::vector<json>>();
-				std::stable_sort(connections.begin(), connections.end(),
-				                 [](const json& a, const json& b)
-				                 {
-					                 if (a["type"] == "start")
-					                 {
-						                 return true;
-					                 }
-					                 else if (b["type"] == "start")
-					                 {
-						                 return false;
-					                 }
-					                 else if (a["type"] == "end")
-					                 {
-						                 return false;
-					                 }
-					                 else if (b["type"] == "end")
-					                 {
-						                 return true;
-					                 }
-					                 return a["beat"].get<double>() < b["beat"].get<float>();
-				                 });
-
-				bool isCritical;
-				for (const auto& step : connections)
+				else
 				{
-					auto type = step["type"].get<std::string>();
-					if (type == "start")
+					HoldStep s;
+					Note mid(NoteType::HoldMid);
+					mid.tick = step["beat"].get<double>() * TICKS_PER_BEAT;
+					mid.lane = step["lane"].get<float>() + 6 - step["size"].get<float>();
+					mid.width = step["size"].get<float>() * 2;
+					mid.layer = step["timeScaleGroup"].get<int>();
+					mid.critical = isCritical;
+					mid.ID = Note::getNextID();
+					mid.parentID = hold.start.ID;
+					score.notes[mid.ID] = mid;
+					s.ID = mid.ID;
+
+					std::string ease = jsonIO::tryGetValue(step, "ease", std::string("linear"));
+					if (ease == "in")
 					{
-						Note startNote(NoteType::Hold);
-						startNote.tick = step["beat"].get<double>() * TICKS_PER_BEAT;
-						startNote.lane = step["lane"].get<float>() + 6 - step["size"].get<float>();
-						startNote.layer = step["timeScaleGroup"].get<int>();
-						startNote.critical = step["critical"].get<bool>();
-						isCritical = startNote.critical;
-						startNote.width = step["size"].get<float>() * 2;
-						if (step["judgeType"].get<std::string>() == "trace")
-						{
-							startNote.friction = true;
-							hold.startType = HoldNoteType::Normal;
-						}
-						else if (step["judgeType"].get<std::string>() == "none")
-						{
-							hold.startType = HoldNoteType::Hidden;
-						}
-						else
-						{
-							hold.startType = HoldNoteType::Normal;
-						}
-						startNote.ID = Note::getNextID();
-						score.notes[startNote.ID] = startNote;
-						hold.start.ID = startNote.ID;
-
-						std::string ease = jsonIO::tryGetValue(step, "ease", std::string("linear"));
-						if (ease == "in")
-						{
-							hold.start.ease = EaseType::EaseIn;
-						}
-						else if (ease == "out")
-						{
-							hold.start.ease = EaseType::EaseOut;
-						}
-						else if (ease == "inout")
-						{
-							hold.start.ease = EaseType::EaseInOut;
-						}
-						else if (ease == "outin")
-						{
-							hold.start.ease = EaseType::EaseOutIn;
-						}
-						else
-						{
-							hold.start.ease = EaseType::Linear;
-						}
+						s.ease = EaseType::EaseIn;
 					}
-					else if (type == "end")
+					else if (ease == "out")
 					{
-						Note endNote(NoteType::HoldEnd);
-						endNote.tick = step["beat"].get<double>() * TICKS_PER_BEAT;
-						endNote.lane = step["lane"].get<float>() + 6 - step["size"].get<float>();
-						endNote.layer = step["timeScaleGroup"].get<int>();
-						endNote.width = step["size"].get<float>() * 2;
-						endNote.critical = isCritical || step["critical"].get<bool>();
-						endNote.flick = step.contains("direction")
-						                    ? step["direction"].get<std::string>() == "up"
-						                          ? FlickType::Default
-						                      : step["direction"].get<std::string>() == "left"
-						                          ? FlickType::Left
-						                          : FlickType::Right
-						                    : FlickType::None;
-						endNote.ID = Note::getNextID();
-						endNote.parentID = hold.start.ID;
-
-						if (step["judgeType"].get<std::string>() == "trace")
-						{
-							endNote.friction = true;
-							hold.endType = HoldNoteType::Normal;
-						}
-						else if (step["judgeType"].get<std::string>() == "none")
-						{
-							hold.endType = HoldNoteType::Hidden;
-						}
-						else
-						{
-							hold.endType = HoldNoteType::Normal;
-						}
-						score.notes[endNote.ID] = endNote;
-						hold.end = endNote.ID;
+						s.ease = EaseType::EaseOut;
+					}
+					else if (ease == "inout")
+					{
+						s.ease = EaseType::EaseInOut;
+					}
+					else if (ease == "outin")
+					{
+						s.ease = EaseType::EaseOutIn;
 					}
 					else
 					{
-						HoldStep s;
-						Note mid(NoteType::HoldMid);
-						mid.tick = step["beat"].get<double>() * TICKS_PER_BEAT;
-						mid.lane = step["lane"].get<float>() + 6 - step["size"].get<float>();
-						mid.width = step["size"].get<float>() * 2;
-						mid.layer = step["timeScaleGroup"].get<int>();
-						mid.critical = isCritical;
-						mid.ID = Note::getNextID();
-						mid.parentID = hold.start.ID;
-						score.notes[mid.ID] = mid;
-						s.ID = mid.ID;
-
-						std::string ease = jsonIO::tryGetValue(step, "ease", std::string("linear"));
-						if (ease == "in")
-						{
-							s.ease = EaseType::EaseIn;
-						}
-						else if (ease == "out")
-						{
-							s.ease = EaseType::EaseOut;
-						}
-						else if (ease == "inout")
-						{
-							s.ease = EaseType::EaseInOut;
-						}
-						else if (ease == "outin")
-						{
-							s.ease = EaseType::EaseOutIn;
-						}
-						else
-						{
-							s.ease = EaseType::Linear;
-						}
+						s.ease = EaseType::Linear;
+					}
 
-						if (type == "tick")
+					if (type == "tick")
+					{
+						if (step.contains("critical"))
 						{
-							if (step.contains("critical"))
-							{
-								s.type = HoldStepType::Normal;
-							}
-							else
-							{
-								s.type = HoldStepType::Hidden;
-							}
+							s.type = HoldStepType::Normal;
 						}
-						else if (type == "attach")
+						else
 						{
-							s.type = HoldStepType::Skip;
+							s.type = HoldStepType::Hidden;
 						}
-						hold.steps.push_back(s);
 					}
+					else if (type == "attach")
+					{
+						s.type = HoldStepType::Skip;
+					}
+					hold.steps.push_back(s);
 				}
-
-				score.holdNotes[hold.start.ID] = hold;
 			}
+
+			score.holdNotes[hold.start.ID] = hold;
 		}
+	}
 
+	static void fillUscDefaults(Score& score)
+	{
 		if (score.layers.size() == 0)
 		{
 			score.layers.push_back(Layer{ "#0" });
@@ -1192,7 +1477,53 @@ namespace MikuMikuWorld
 		{
 			score.tempoChanges.push_back(Tempo{ 0, 120 });
 		}
+	}
+
+	json ScoreConverter::readUscObjects(std::istream& stream,
+	                                    const std::function<void(const json&)>& onObject)
+	{
+		UscSaxReader reader(onObject);
+		json::sax_parse(stream, &reader);
+		return std::move(reader.document);
+	}
+
+	Score ScoreConverter::uscToScore(std::istream& stream)
+	{
+		Score score;
+		score.layers.clear();
+		score.hiSpeedChanges.clear();
+		score.tempoChanges.clear();
+
+		// Writers put "version" after "usc", so the objects are usually converted before the
+		// version is known. A conversion error is only reported once the version is supported.
+		std::exception_ptr conversionError;
+		auto convert = [&score, &conversionError](const json& obj)
+		{
+			if (conversionError)
+				return;
+
+			try
+			{
+				uscObjectToScore(obj, score);
+			}
+			catch (...)
+			{
+				conversionError = std::current_exception();
+			}
+		};
+
+		json document = readUscObjects(stream, convert);
+
+		auto version = document.find("version");
+		if (version == document.end() || *version != 2)
+			throw std::runtime_error("Invalid version");
+
+		if (conversionError)
+			std::rethrow_exception(conversionError);
+
+		score.metadata.musicOffset = document.at("usc").at("offset").get<float>() * -1000.0f;
 
+		fillUscDefaults(score);
 		return score;
 	}
 }
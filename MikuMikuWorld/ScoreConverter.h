@@ -1,4 +1,7 @@
 #pragma once
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
 #include <string>
 #include "JsonIO.h"
 
@@ -13,13 +16,23 @@ namespace MikuMikuWorld
 	{
 	  private:
 		static std::pair<int, int> barLengthToFraction(float length, float fractionDenom);
-		static std::string noteKey(const SUSNote& note);
+		static uint64_t noteKey(const SUSNote& note);
 		static std::string noteKey(const Note& note);
 
 	  public:
 		static Score susToScore(const SUS& sus);
 		static SUS scoreToSus(const Score& score);
-		static nlohmann::json scoreToUsc(const Score& score);
-		static Score uscToScore(const nlohmann::json& usc);
+		static void scoreToUsc(const Score& score, std::ostream& stream, int indent = -1);
+
+		/// Calls onObject for every entry of usc.objects in file order, materializing one entry
+		/// at a time. Returns the rest of the document with usc.objects left empty.
+		/// Throws as soon as a top level version other than 2 is read.
+		static nlohmann::json
+		readUscObjects(std::istream& stream,
+		               const std::function<void(const nlohmann::json&)>& onObject);
+
+		/// Reads the file in a single pass. Throws if the version is not supported, even when
+		/// the objects before it cannot be converted.
+		static Score uscToScore(std::istream& stream);
 	};
 }
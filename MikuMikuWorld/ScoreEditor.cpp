@@ -7,10 +7,11 @@
 #include "ApplicationConfiguration.h"
 #include "Constants.h"
 #include "File.h"
-#include "SUS.h"
-#include "ScoreConverter.h"
-#include "SusExporter.h"
-#include "SusParser.h"
+#include "GlyphCache.h"
+#include "JobSystem.h"
+#include "JsonIO.h"
+#include "Profiler.h"
+#include "ScoreFile.h"
 #include "UI.h"
 #include "Utilities.h"
 #include <Windows.h>
@@ -51,23 +52,58 @@ namespace MikuMikuWorld
 		autoSavePath = Application::getAppDir() + "auto_save";
 		autoSaveTimer.reset();
 
-		std::thread fetchUpdateThread(
+		std::wstring wAutoSaveDir = IO::mbToWideStr(autoSavePath);
+		if (!std::filesystem::exists(wAutoSaveDir))
+			std::filesystem::create_directory(wAutoSaveDir);
+
+		// Offer the edits of a session that did not exit normally. Every instance keeps its own
+		// untitled journal, so look for all of them.
+		bool recovered = false;
+		for (const auto& file : std::filesystem::directory_iterator(wAutoSaveDir))
+		{
+			const std::wstring name = file.path().filename().wstring();
+			if (recovered || name.rfind(L"mmw_untitled", 0) != 0 ||
+			    file.path().extension() != L".journal")
+				continue;
+
+			recovered = recoverEdits(IO::wideStringToMb(file.path().wstring()), "");
+		}
+
+		for (size_t i = 0; i < config.recentFiles.size() && !recovered; ++i)
+			recovered = recoverEdits(getJournalFilename(config.recentFiles[i]),
+			                         config.recentFiles[i]);
+
+		if (!recovered)
+			context.journal.checkpoint(getJournalFilename(""), "", context.score);
+
+		JobSystem::schedule(
 		    [this]
 		    {
+			    std::string latestVersion;
 			    try
 			    {
-				    ScoreEditor::fetchUpdate();
+				    latestVersion = ScoreEditor::fetchUpdate();
 			    }
 			    catch (const std::exception& e)
 			    {
 				    std::cout << "Failed to fetch latest update: " << e.what() << std::endl;
 			    }
-		    });
 
-		fetchUpdateThread.detach();
+			    if (latestVersion.empty())
+				    return;
+
+			    // The dialog is drawn by the main thread
+			    JobSystem::runOnMainThread(
+			        [this, latestVersion]
+			        {
+				        updateAvailableDialog.latestVersion = latestVersion;
+				        updateAvailableDialog.open = true;
+			        });
+		    },
+		    JobPriority::Low);
 	}
 
-	void ScoreEditor::fetchUpdate()
+	std::string ScoreEditor::fetchUpdate()
 	{
 
 		std::wstring updateFlagPath =
@@ -96,12 +132,16 @@ namespace MikuMikuWorld
 
 			httplib::Client client("https://api.github.com");
 
+			// Exiting waits for the request since it runs on the shared job pool
+			client.set_connection_timeout(5);
+			client.set_read_timeout(5);
+
 			std::cout << "Fetching new update" << std::endl;
 			auto res = client.Get("/repos/sevenc-nanashi/MikuMikuWorld4cc/releases/latest");
 			if (!res)
 			{
 				std::cout << "Failed to fetch latest update: client.Get failed" << std::endl;
-				return;
+				return {};
 			}
 			std::cout << "Status: " << res->status << std::endl;
 			if (res->status == 200)
@@ -136,13 +176,12 @@ namespace MikuMikuWorld
 			if (latestVersionPart > currentVersionPart)
 			{
 				std::cout << "Update available" << std::endl;
-				updateAvailableDialog.latestVersion = latestVersionString;
-				updateAvailableDialog.open = true;
-				return;
+				return latestVersionString;
 			}
 		}
 
 		std::cout << "No update" << std::endl;
+		return {};
 	}
 
 	void ScoreEditor::writeSettings()
@@ -159,10 +198,14 @@ namespace MikuMikuWorld
 	{
 		context.audio.uninitializeAudioEngine();
 		timeline.background.dispose();
+
+		// The user already chose to save or discard the changes on exit
+		context.journal.close(true);
 	}
 
 	void ScoreEditor::update()
 	{
+		PROFILE_SCOPE("ScoreEditor::update");
 		drawMenubar();
 		drawToolbar();
 
@@ -251,6 +294,9 @@ namespace MikuMikuWorld
 		if (config.backgroundBrightness != timeline.background.getBrightness())
 			timeline.background.setBrightness(config.backgroundBrightness);
 
+		if (config.backgroundBlur != timeline.background.getBlur())
+			timeline.background.setBlur(config.backgroundBlur);
+
 		if (settingsWindow.isBackgroundChangePending)
 		{
 			static const std::string defaultBackgroundPath =
@@ -275,7 +321,7 @@ namespace MikuMikuWorld
 
 		if (config.autoSaveEnabled && autoSaveTimer.elapsedMinutes() >= config.autoSaveInterval)
 		{
-			autoSave();
+			autoSaveInBackground();
 			autoSaveTimer.reset();
 		}
 
@@ -300,6 +346,10 @@ namespace MikuMikuWorld
 		{
 			debugWindow.update(context, timeline);
 		}
+		else
+		{
+			Profiler::setEnabled(false);
+		}
 
 		if (ImGui::Begin(IMGUI_TITLE(ICON_FA_ALIGN_LEFT, "chart_properties"), NULL,
 		                 ImGuiWindowFlags_Static))
@@ -308,6 +358,14 @@ namespace MikuMikuWorld
 		}
 		ImGui::End();
 
+		// Metadata edits do not go through the history, journal them once no field is active
+		if (!ImGui::IsAnyItemActive())
+		{
+			ScoreMetadata metadata = context.workingData.toScoreMetadata();
+			metadata.laneExtension = context.score.metadata.laneExtension;
+			context.journal.recordMetadata(metadata);
+		}
+
 		if (ImGui::Begin(IMGUI_TITLE(ICON_FA_WRENCH, "note_properties"), NULL,
 		                 ImGuiWindowFlags_Static))
 		{
@@ -378,6 +436,7 @@ namespace MikuMikuWorld
 		context.upToDate = true;
 
 		UI::setWindowTitle(windowUntitled);
+		context.journal.checkpoint(getJournalFilename(""), "", context.score);
 	}
 
 	void ScoreEditor::loadScore(std::string filename)
@@ -385,6 +444,8 @@ namespace MikuMikuWorld
 		if (!IO::File::exists(filename))
 			return;
 
+		PROFILE_SCOPE("ScoreEditor::loadScore");
+
 		std::string extension = IO::File::getFileExtension(filename);
 		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
 
@@ -392,44 +453,15 @@ namespace MikuMikuWorld
 		try
 		{
 			std::string workingFilename;
-			Score newScore;
-
-			if (extension == SUS_EXTENSION)
-			{
-				SusParser susParser;
-				newScore = ScoreConverter::susToScore(susParser.parse(filename));
-			}
-			else if (extension == USC_EXTENSION)
-			{
-				std::wstring wFilename = IO::mbToWideStr(filename);
-				std::ifstream uscfile(wFilename);
-				json usc;
-				uscfile >> usc;
-				uscfile.close();
-
-				newScore = ScoreConverter::uscToScore(usc);
-			}
-			else if (extension == MMWS_EXTENSION || extension == CC_MMWS_EXTENSION)
-			{
-				newScore = deserializeScore(filename);
+			Score newScore = readScoreFile(filename);
+			if (extension == MMWS_EXTENSION || extension == CC_MMWS_EXTENSION)
 				workingFilename = filename;
-			}
-
-			context.clearSelection();
-			context.history.clear();
-			context.score = std::move(newScore);
-			context.workingData = EditorScoreData(context.score.metadata, workingFilename);
 
-			loadMusic(context.workingData.musicFilename);
-			context.audio.setMusicOffset(0, context.workingData.musicOffset);
+			setScore(std::move(newScore), workingFilename);
 
-			context.scoreStats.calculateStats(context.score);
-			timeline.calculateMaxOffsetFromScore(context.score);
-
-			UI::setWindowTitle((context.workingData.filename.size()
-			                        ? IO::File::getFilename(context.workingData.filename)
-			                        : windowUntitled));
-			context.upToDate = true;
+			std::string journalFilename = getJournalFilename(workingFilename);
+			if (workingFilename.empty() || !recoverEdits(journalFilename, workingFilename))
+				context.journal.checkpoint(journalFilename, filename, context.score);
 		}
 		catch (std::exception& error)
 		{
@@ -444,12 +476,133 @@ namespace MikuMikuWorld
 		updateRecentFilesList(filename);
 	}
 
+	void ScoreEditor::setScore(Score score, const std::string& workingFilename)
+	{
+		// An auto save still being written belongs to the previous score
+		autoSaveToken.cancel();
+		context.clearSelection();
+		context.history.clear();
+		context.score = std::move(score);
+		context.workingData = EditorScoreData(context.score.metadata, workingFilename);
+
+		// The timeline and title bar can draw these before any window has requested them
+		GlyphCache::request(context.workingData.title);
+		GlyphCache::request(context.workingData.artist);
+		GlyphCache::request(context.workingData.designer);
+		context.requestNameGlyphs();
+
+		loadMusic(context.workingData.musicFilename);
+		context.audio.setMusicOffset(0, context.workingData.musicOffset);
+
+		context.scoreStats.calculateStats(context.score);
+		timeline.calculateMaxOffsetFromScore(context.score);
+
+		UI::setWindowTitle((context.workingData.filename.size()
+		                        ? IO::File::getFilename(context.workingData.filename)
+		                        : windowUntitled));
+		context.upToDate = true;
+	}
+
+	std::string ScoreEditor::getJournalFilename(const std::string& workingFilename) const
+	{
+		// Untitled scores have no file to keep the journal next to. The process ID keeps other
+		// instances from truncating this one's journal.
+		return EditJournal::getJournalFilename(
+		    workingFilename.size()
+		        ? workingFilename
+		        : autoSavePath + "\\mmw_untitled_" + std::to_string(GetCurrentProcessId()));
+	}
+
+	bool ScoreEditor::recoverEdits(const std::string& journalFilename,
+	                               const std::string& workingFilename)
+	{
+		// This session's own journal, or one another running instance is writing to
+		if (journalFilename == context.journal.getFilename() ||
+		    EditJournal::isInUse(journalFilename))
+			return false;
+
+		JournalContents journal{};
+		if (!EditJournal::read(journalFilename, journal) || journal.records.empty())
+			return false;
+
+		std::string name =
+		    workingFilename.size() ? IO::File::getFilename(workingFilename) : windowUntitled;
+		IO::MessageBoxResult result = IO::messageBox(
+		    APP_NAME, IO::formatString(getString("recover_edits"), name.c_str()),
+		    IO::MessageBoxButtons::YesNo, IO::MessageBoxIcon::Question);
+
+		if (result != IO::MessageBoxResult::Yes)
+		{
+			std::error_code error;
+			std::filesystem::remove(IO::mbToWideStr(journalFilename), error);
+			return false;
+		}
+
+		try
+		{
+			Score score =
+			    journal.baseFilename.size() ? readScoreFile(journal.baseFilename) : Score{};
+			EditJournal::replay(journal, score);
+			setScore(std::move(score), workingFilename);
+		}
+		catch (const std::exception& error)
+		{
+			std::string errorMessage =
+			    IO::formatString("%s\n%s: %s", getString("error_recover_edits"),
+			                     getString("error"), error.what());
+
+			IO::messageBox(APP_NAME, errorMessage, IO::MessageBoxButtons::Ok,
+			               IO::MessageBoxIcon::Error);
+			return false;
+		}
+
+		UI::setWindowTitle(name + "*");
+		context.upToDate = false;
+
+		// The recovered edits are not in any file yet, so checkpoint them right away. The journal
+		// of another session's untitled score is not reused by the checkpoint.
+		if (autoSave() && journalFilename != context.journal.getFilename())
+		{
+			std::error_code error;
+			std::filesystem::remove(IO::mbToWideStr(journalFilename), error);
+		}
+
+		return true;
+	}
+
 	void ScoreEditor::loadMusic(std::string filename)
 	{
-		Result result = context.audio.loadMusic(filename);
-		if (result.isOk() || filename.empty())
+		// Only the latest request replaces the music
+		musicLoadToken.cancel();
+		musicLoadToken = CancellationToken{};
+		JobSystem::schedule(
+		    [this, token = musicLoadToken, filename]
+		    {
+			    PROFILE_SCOPE("ScoreEditor::loadMusic");
+			    auto audio = std::make_shared<Audio::DecodedAudio>();
+			    Result result = filename.empty() ? Result::Ok()
+			                                     : Audio::decodeAudioFile(filename, *audio);
+			    if (token.isCancelled())
+				    return;
+
+			    JobSystem::runOnMainThread(
+			        [this, token, filename, audio, result]
+			        {
+				        if (!token.isCancelled())
+					        applyMusic(filename, *audio, result);
+			        });
+		    },
+		    JobPriority::Normal, musicLoadToken);
+	}
+
+	void ScoreEditor::applyMusic(const std::string& filename, Audio::DecodedAudio& audio,
+	                             const Result& result)
+	{
+		context.audio.loadMusic(audio);
+		if (result.isOk())
 		{
 			context.workingData.musicFilename = filename;
+			GlyphCache::request(filename);
 		}
 		else
 		{
@@ -464,6 +617,8 @@ namespace MikuMikuWorld
 		context.waveformL.generateMipChainsFromSampleBuffer(context.audio.musicBuffer, 0);
 		context.waveformR.generateMipChainsFromSampleBuffer(context.audio.musicBuffer, 1);
 		timeline.setPlaying(context, false);
+		context.audio.setMusicOffset(context.getTimeAtCurrentTick(),
+		                             context.workingData.musicOffset);
 	}
 
 	void ScoreEditor::open()
@@ -489,12 +644,15 @@ namespace MikuMikuWorld
 
 	bool ScoreEditor::save(std::string filename)
 	{
+		PROFILE_SCOPE("ScoreEditor::save");
+		autoSaveToken.cancel();
 		try
 		{
 			int laneExtension = context.score.metadata.laneExtension;
 			context.score.metadata = context.workingData.toScoreMetadata();
 			context.score.metadata.laneExtension = laneExtension;
 			serializeScore(context.score, filename);
+			context.journal.checkpoint(getJournalFilename(filename), filename, context.score);
 
 			UI::setWindowTitle(IO::File::getFilename(filename));
 			context.upToDate = true;
@@ -547,14 +705,13 @@ namespace MikuMikuWorld
 		{
 			try
 			{
+				PROFILE_SCOPE("ScoreEditor::exportSus");
 				context.score.metadata = context.workingData.toScoreMetadata();
-				SUS sus = ScoreConverter::scoreToSus(context.score);
 
-				const std::string exportComment =
-				    IO::concat("This file was generated by " APP_NAME,
-				               Application::getAppVersion().c_str(), " ");
-				SusExporter exporter;
-				exporter.dump(sus, fileDialog.outputFilename, exportComment);
+				ScoreWriteOptions options{};
+				options.susComment = IO::concat("This file was generated by " APP_NAME,
+				                                Application::getAppVersion().c_str(), " ");
+				writeScoreFile(context.score, fileDialog.outputFilename, options);
 			}
 			catch (std::exception& err)
 			{
@@ -579,18 +736,14 @@ namespace MikuMikuWorld
 		{
 			try
 			{
+				PROFILE_SCOPE("ScoreEditor::exportUsc");
 				int oldLaneExtension = context.score.metadata.laneExtension;
 				context.score.metadata = context.workingData.toScoreMetadata();
 				context.score.metadata.laneExtension = oldLaneExtension;
 
-				json usc = ScoreConverter::scoreToUsc(context.score);
-
-				std::wstring wFilename = IO::mbToWideStr(fileDialog.outputFilename);
-				IO::File uscfile(wFilename, L"w");
-
-				uscfile.write(usc.dump(config.minifyUsc ? -1 : 4));
-				uscfile.flush();
-				uscfile.close();
+				ScoreWriteOptions options{};
+				options.uscIndent = config.minifyUsc ? -1 : 4;
+				writeScoreFile(context.score, fileDialog.outputFilename, options);
 			}
 			catch (std::exception& err)
 			{
@@ -624,6 +777,7 @@ namespace MikuMikuWorld
 				for (size_t index = 0; index < config.recentFiles.size(); index++)
 				{
 					const std::string& entry = config.recentFiles[index];
+					GlyphCache::request(entry);
 					if (ImGui::MenuItem(entry.c_str()))
 					{
 						if (IO::File::exists(entry))
@@ -931,19 +1085,94 @@ namespace MikuMikuWorld
 		ShellExecuteW(0, 0, L"https://github.com/crash5band/MikuMikuWorld/wiki", 0, 0, SW_SHOW);
 	}
 
-	void ScoreEditor::autoSave()
+	/// Writes an auto save, throws if the file was not created
+	static void writeAutoSave(const std::string& directory, const std::string& filename,
+	                          const Score& score)
 	{
-		std::wstring wAutoSaveDir = IO::mbToWideStr(autoSavePath);
-
 		// create auto save directory if none exists
+		std::wstring wAutoSaveDir = IO::mbToWideStr(directory);
 		if (!std::filesystem::exists(wAutoSaveDir))
 			std::filesystem::create_directory(wAutoSaveDir);
 
+		serializeScore(score, filename);
+		if (!IO::File::exists(filename))
+			throw std::runtime_error("Failed to create file.");
+	}
+
+	std::string ScoreEditor::beginAutoSave()
+	{
+		// A newer auto save replaces one that is still being written
+		autoSaveToken.cancel();
+
 		int laneExtension = context.score.metadata.laneExtension;
 		context.score.metadata = context.workingData.toScoreMetadata();
 		context.score.metadata.laneExtension = laneExtension;
-		serializeScore(context.score, autoSavePath + "\\mmw_auto_save_" +
-		                                  Utilities::getCurrentDateTime() + CC_MMWS_EXTENSION);
+		return autoSavePath + "\\mmw_auto_save_" + Utilities::getCurrentDateTime() +
+		       CC_MMWS_EXTENSION;
+	}
+
+	bool ScoreEditor::autoSave()
+	{
+		PROFILE_SCOPE("ScoreEditor::autoSave");
+		std::string autoSaveFilename = beginAutoSave();
+		try
+		{
+			writeAutoSave(autoSavePath, autoSaveFilename, context.score);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "Failed to auto save: " << e.what() << std::endl;
+			return false;
+		}
+
+		// The auto save becomes the base the journal is replayed over
+		context.journal.checkpoint(getJournalFilename(context.workingData.filename),
+		                           autoSaveFilename, context.score);
+		trimAutoSaves();
+		return true;
+	}
+
+	void ScoreEditor::autoSaveInBackground()
+	{
+		std::string autoSaveFilename = beginAutoSave();
+		autoSaveToken = CancellationToken{};
+
+		auto saved = std::make_shared<const Score>(context.score);
+		JobSystem::schedule(
+		    [this, token = autoSaveToken, directory = autoSavePath, autoSaveFilename, saved]
+		    {
+			    PROFILE_SCOPE("ScoreEditor::autoSave");
+			    try
+			    {
+				    writeAutoSave(directory, autoSaveFilename, *saved);
+			    }
+			    catch (const std::exception& e)
+			    {
+				    // The journal stays on the previous save
+				    std::cout << "Failed to auto save: " << e.what() << std::endl;
+				    return;
+			    }
+
+			    JobSystem::runOnMainThread(
+			        [this, token, autoSaveFilename, saved]
+			        {
+				        if (token.isCancelled())
+					        return;
+
+				        // Edits made while the file was written are replayed on top of it
+				        context.journal.checkpoint(
+				            getJournalFilename(context.workingData.filename), autoSaveFilename,
+				            *saved);
+				        context.journal.recordChange(*saved, context.score);
+				        trimAutoSaves();
+			        });
+		    },
+		    JobPriority::Low, autoSaveToken);
+	}
+
+	void ScoreEditor::trimAutoSaves()
+	{
+		std::wstring wAutoSaveDir = IO::mbToWideStr(autoSavePath);
 
 		// get mmws files
 		int mmwsCount = 0;
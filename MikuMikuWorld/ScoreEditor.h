@@ -1,3 +1,4 @@
+#include "JobSystem.h"
 #include "ScoreEditorWindows.h"
 #include <future>
 
@@ -26,12 +27,24 @@ namespace MikuMikuWorld
 
 		Stopwatch autoSaveTimer;
 		std::string autoSavePath;
+		CancellationToken autoSaveToken;
+		CancellationToken musicLoadToken;
 		bool showImGuiDemoWindow;
 
 		bool save(std::string filename);
 		size_t updateRecentFilesList(const std::string& entry);
 
-		void fetchUpdate();
+		void setScore(Score score, const std::string& workingFilename);
+		std::string getJournalFilename(const std::string& workingFilename) const;
+		bool recoverEdits(const std::string& journalFilename, const std::string& workingFilename);
+
+		void applyMusic(const std::string& filename, Audio::DecodedAudio& audio,
+		                const Result& result);
+		std::string beginAutoSave();
+		void trimAutoSaves();
+
+		/// Returns the latest released version if it is newer than this one
+		static std::string fetchUpdate();
 
 	  public:
 		ScoreEditor();
@@ -41,12 +54,18 @@ namespace MikuMikuWorld
 		void create();
 		void open();
 		void loadScore(std::string filename);
+		/// Decodes the music on a worker, the current music plays on until it is replaced
 		void loadMusic(std::string filename);
 		void exportSus();
 		void exportUsc();
 		bool saveAs();
 		bool trySave(std::string);
-		void autoSave();
+		/// Returns false if the file could not be written, the journal then stays on the last save
+		bool autoSave();
+
+		/// Writes the auto save on a worker. The journal moves over to the new file once it is
+		/// complete, so a crash while writing still recovers from the previous one.
+		void autoSaveInBackground();
 		int deleteOldAutoSave(int count);
 
 		void drawMenubar();
@@ -60,5 +79,6 @@ namespace MikuMikuWorld
 		void uninitialize();
 		inline std::string_view getWorkingFilename() const { return context.workingData.filename; }
 		constexpr inline bool isUpToDate() const { return context.upToDate; }
+		inline bool isAnimating() const { return timeline.isAnimating(); }
 	};
 }
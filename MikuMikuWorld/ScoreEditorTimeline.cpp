@@ -3,7 +3,9 @@
 #include "ApplicationConfiguration.h"
 #include "Colors.h"
 #include "Constants.h"
+#include "Profiler.h"
 #include "ResourceManager.h"
+#include "Rendering/FramebufferTileBackend.h"
 #include "Tempo.h"
 #include "Score.h"
 #include "UI.h"
@@ -66,6 +68,9 @@ namespace MikuMikuWorld
 
 	bool ScoreEditorTimeline::isNoteVisible(const Note& note, int offsetTicks) const
 	{
+		if (!cullOffscreen)
+			return true;
+
 		const float y = getNoteYPosFromTick(note.tick + offsetTicks);
 		return y >= 0 && y <= size.y + position.y + 100;
 	}
@@ -217,6 +222,11 @@ namespace MikuMikuWorld
 
 			visualOffset += std::min(remainingScroll, delta);
 			remainingScroll = std::max(0.0f, remainingScroll - abs(delta));
+
+			// The scroll eases in forever, so settle once it is within a pixel to let the editor
+			// go idle
+			if (remainingScroll < 1.0f)
+				visualOffset = offset;
 		}
 		else
 		{
@@ -388,8 +398,227 @@ namespace MikuMikuWorld
 		}
 	}
 
+	template <typename T> static void hashValue(uint64_t& hash, const T& value)
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+		for (size_t i = 0; i < sizeof(T); ++i)
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+
+	void ScoreEditorTimeline::updateGridTiles(ScoreContext& context)
+	{
+		const float laneOpacity = config.laneOpacity;
+		const Audio::WaveformMipChain& waveform = context.waveformL;
+		uint64_t key = 14695981039346656037ull;
+		hashValue(key, zoom);
+		hashValue(key, division);
+		hashValue(key, laneWidth);
+		hashValue(key, laneOffset);
+		hashValue(key, laneOpacity);
+		hashValue(key, context.score.metadata.laneExtension);
+		// Measure numbers are rasterized with the current font
+		hashValue(key, ImGui::GetMainViewport()->DpiScale);
+		hashValue(key, ImGui::GetFontSize());
+		hashValue(key, config.drawWaveform);
+		if (config.drawWaveform)
+		{
+			hashValue(key, waveform.durationInSeconds);
+			hashValue(key, waveform.generation);
+			hashValue(key, context.workingData.musicOffset);
+			for (const Tempo& tempo : context.score.tempoChanges)
+			{
+				hashValue(key, tempo.tick);
+				hashValue(key, tempo.bpm);
+			}
+		}
+
+		for (const auto& [measure, ts] : context.score.timeSignatures)
+		{
+			hashValue(key, ts.measure);
+			hashValue(key, ts.numerator);
+			hashValue(key, ts.denominator);
+		}
+
+		gridTiles->validate(key, static_cast<int>(ceilf(size.x)));
+
+		// Tile n covers the positions from n * tileHeight up to the next tile
+		const int tileHeight = gridTiles->getTileHeight();
+		const int firstIndex = static_cast<int>(floorf((visualOffset - size.y) / tileHeight));
+		const int lastIndex = static_cast<int>(floorf(visualOffset / tileHeight));
+		gridTiles->update(firstIndex, lastIndex,
+		                  [this, &context, tileHeight](ImDrawList* drawList, int index)
+		                  {
+			                  // Overdraw the neighboring tiles' edges to catch lines and measure
+			                  // numbers that straddle the tile boundaries
+			                  constexpr float margin = 32.0f;
+			                  const float tileTop = static_cast<float>((index + 1) * tileHeight);
+			                  drawGrid(context, drawList, { 0.0f, tileTop },
+			                           index * tileHeight - margin, tileTop + margin);
+		                  });
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		drawList->AddCallback(FramebufferTileBackend::setPremultipliedBlend, nullptr);
+		for (int index = firstIndex; index <= lastIndex; ++index)
+		{
+			const ImVec2 tilePos{ position.x,
+				                  floorf(position.y + visualOffset - (index + 1) * tileHeight) };
+			const ImVec2 tileSize{ static_cast<float>(gridTiles->getTileWidth()),
+				                   static_cast<float>(tileHeight) };
+
+			// Framebuffer textures are stored upside down
+			drawList->AddImage(gridTiles->getTexture(index), tilePos, tilePos + tileSize,
+			                   { 0.0f, 1.0f }, { 1.0f, 0.0f });
+		}
+		drawList->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+	}
+
+	void ScoreEditorTimeline::drawGrid(ScoreContext& context, ImDrawList* drawList,
+	                                   const ImVec2& origin, float minPosition, float maxPosition)
+	{
+		// Everything is drawn relative to origin instead of the timeline's screen position
+		const float dx = origin.x - position.x;
+		const float x1 = getTimelineStartX() + dx;
+		const float x2 = getTimelineEndX() + dx;
+		const float exX1 = getTimelineStartX(context.score) + dx;
+		const float exX2 = getTimelineEndX(context.score) + dx;
+		const float top = origin.y - maxPosition;
+		const float bottom = origin.y - minPosition;
+
+		// Draw solid background color
+		drawList->AddRectFilled(
+		    { exX1, top }, { x1, bottom },
+		    Color::abgrToInt(std::clamp((int)(config.laneOpacity * 255), 0, 255), 0x1c, 0x1a,
+		                     0x0f));
+		drawList->AddRectFilled(
+		    { x1, top }, { x2, bottom },
+		    Color::abgrToInt(std::clamp((int)(config.laneOpacity * 255), 0, 255), 0x1c, 0x1a,
+		                     0x1f));
+		drawList->AddRectFilled(
+		    { x2, top }, { exX2, bottom },
+		    Color::abgrToInt(std::clamp((int)(config.laneOpacity * 255), 0, 255), 0x1c, 0x1a,
+		                     0x0f));
+
+		if (config.drawWaveform)
+			drawWaveform(context, drawList, origin, minPosition, maxPosition);
+
+		// Draw lanes
+		for (int l = 0; l <= NUM_LANES; ++l)
+		{
+			const int x = origin.x + laneToPosition(l);
+			const bool boldLane = !(l & 1);
+			drawList->AddLine(ImVec2(x, top), ImVec2(x, bottom),
+			                  boldLane ? divColor1 : divColor2,
+			                  boldLane ? primaryLineThickness : secondaryLineThickness);
+		}
+
+		// Draw measures
+		int firstTick = std::max(0, positionToTick(minPosition));
+		int lastTick = positionToTick(maxPosition);
+		int measure = accumulateMeasures(firstTick, TICKS_PER_BEAT, context.score.timeSignatures);
+		firstTick = measureToTicks(measure, TICKS_PER_BEAT, context.score.timeSignatures);
+
+		int tsIndex = findTimeSignature(measure, context.score.timeSignatures);
+		int ticksPerMeasure =
+		    beatsPerMeasure(context.score.timeSignatures[tsIndex]) * TICKS_PER_BEAT;
+		int beatTicks = ticksPerMeasure / context.score.timeSignatures[tsIndex].numerator;
+		int subdivision = TICKS_PER_BEAT / (division / 4);
+
+		// Snap to the sub-division before the current measure to prevent the lines from jumping
+		// around
+		for (int tick = firstTick - (firstTick % subdivision); tick <= lastTick;
+		     tick += subdivision)
+		{
+			const int y = origin.y - tickToPosition(tick);
+			int currentMeasure =
+			    accumulateMeasures(tick, TICKS_PER_BEAT, context.score.timeSignatures);
+
+			// Time signature changes on current measure
+			if (context.score.timeSignatures.find(currentMeasure) !=
+			        context.score.timeSignatures.end() &&
+			    currentMeasure != tsIndex)
+			{
+				tsIndex = currentMeasure;
+				ticksPerMeasure =
+				    beatsPerMeasure(context.score.timeSignatures[tsIndex]) * TICKS_PER_BEAT;
+				beatTicks = ticksPerMeasure / context.score.timeSignatures[tsIndex].numerator;
+
+				// snap to sub-division again on time signature change
+				tick = measureToTicks(currentMeasure, TICKS_PER_BEAT, context.score.timeSignatures);
+				tick -= tick % subdivision;
+			}
+
+			// determine whether the tick is a beat relative to its measure's tick
+			int measureTicks =
+			    measureToTicks(currentMeasure, TICKS_PER_BEAT, context.score.timeSignatures);
+
+			ImU32 color;
+			ImU32 exColor;
+			float thickness;
+			if (!((tick - measureTicks) % beatTicks))
+			{
+				color = measureColor;
+				exColor = exMeasureColor;
+				thickness = primaryLineThickness;
+			}
+			else if (division >= 192)
+			{
+				continue;
+			}
+			else
+			{
+				color = divColor2;
+				exColor = exDivColor2;
+				thickness = secondaryLineThickness;
+			}
+
+			drawList->AddLine(ImVec2(exX1, y), ImVec2(x1, y), exColor, thickness);
+			drawList->AddLine(ImVec2(x1, y), ImVec2(x2, y), color, thickness);
+			drawList->AddLine(ImVec2(x2, y), ImVec2(exX2, y), exColor, thickness);
+		}
+
+		tsIndex = findTimeSignature(measure, context.score.timeSignatures);
+		ticksPerMeasure = beatsPerMeasure(context.score.timeSignatures[tsIndex]) * TICKS_PER_BEAT;
+
+		// Overdraw one measure to make sure the measure string is always visible
+		for (int tick = firstTick; tick < lastTick + ticksPerMeasure; tick += ticksPerMeasure)
+		{
+			if (context.score.timeSignatures.find(measure) != context.score.timeSignatures.end())
+			{
+				tsIndex = measure;
+				ticksPerMeasure =
+				    beatsPerMeasure(context.score.timeSignatures[tsIndex]) * TICKS_PER_BEAT;
+			}
+
+			std::string measureStr = std::to_string(measure);
+			const float txtPos =
+			    exX1 - MEASURE_WIDTH - (ImGui::CalcTextSize(measureStr.c_str()).x * 0.5f);
+			const int y = origin.y - tickToPosition(tick);
+
+			drawList->AddLine(ImVec2(exX1 - MEASURE_WIDTH, y), ImVec2(exX2 + MEASURE_WIDTH, y),
+			                  measureColor, primaryLineThickness);
+			drawShadedText(drawList, ImVec2(txtPos, y), 26, measureTxtColor, measureStr.c_str());
+
+			++measure;
+		}
+
+		// draw lanes
+		for (int l = -context.score.metadata.laneExtension;
+		     l <= NUM_LANES + context.score.metadata.laneExtension; ++l)
+		{
+			const int x = origin.x + laneToPosition(l);
+			const bool boldLane = !(l & 1);
+			const bool outOfBounds = l < 0 || l > NUM_LANES;
+			drawList->AddLine(ImVec2(x, top), ImVec2(x, bottom),
+			                  outOfBounds ? boldLane ? exDivColor1 : exDivColor2
+			                  : boldLane  ? divColor1
+			                              : divColor2,
+			                  boldLane ? primaryLineThickness : secondaryLineThickness);
+		}
+	}
+
 	void ScoreEditorTimeline::update(ScoreContext& context, EditArgs& edit, Renderer* renderer)
 	{
+		PROFILE_SCOPE("ScoreEditorTimeline::update");
 		prevSize = size;
 		prevPos = position;
 
@@ -407,6 +636,7 @@ namespace MikuMikuWorld
 		drawList->PushClipRect(boundaries.Min, boundaries.Max, true);
 		drawList->AddRectFilled(boundaries.Min, boundaries.Max, 0xff202020);
 
+		background.update({ size.x, size.y });
 		if (background.isDirty())
 		{
 			background.resize({ size.x, size.y });
@@ -532,141 +762,10 @@ namespace MikuMikuWorld
 			dragging = false;
 		}
 
-		const float x1 = getTimelineStartX();
-		const float x2 = getTimelineEndX();
 		const float exX1 = getTimelineStartX(context.score);
 		const float exX2 = getTimelineEndX(context.score);
 
-		// Draw solid background color
-		drawList->AddRectFilled(
-		    { exX1, position.y }, { x1, position.y + size.y },
-		    Color::abgrToInt(std::clamp((int)(config.laneOpacity * 255), 0, 255), 0x1c, 0x1a,
-		                     0x0f));
-		drawList->AddRectFilled(
-		    { x1, position.y }, { x2, position.y + size.y },
-		    Color::abgrToInt(std::clamp((int)(config.laneOpacity * 255), 0, 255), 0x1c, 0x1a,
-		                     0x1f));
-		drawList->AddRectFilled(
-		    { x2, position.y }, { exX2, position.y + size.y },
-		    Color::abgrToInt(std::clamp((int)(config.laneOpacity * 255), 0, 255), 0x1c, 0x1a,
-		                     0x0f));
-
-		if (config.drawWaveform)
-			drawWaveform(context);
-
-		// Draw lanes
-		for (int l = 0; l <= NUM_LANES; ++l)
-		{
-			const int x = position.x + laneToPosition(l);
-			const bool boldLane = !(l & 1);
-			drawList->AddLine(ImVec2(x, position.y), ImVec2(x, position.y + size.y),
-			                  boldLane ? divColor1 : divColor2,
-			                  boldLane ? primaryLineThickness : secondaryLineThickness);
-		}
-
-		// Draw measures
-		int firstTick = std::max(0, positionToTick(visualOffset - size.y));
-		int lastTick = positionToTick(visualOffset);
-		int measure = accumulateMeasures(firstTick, TICKS_PER_BEAT, context.score.timeSignatures);
-		firstTick = measureToTicks(measure, TICKS_PER_BEAT, context.score.timeSignatures);
-
-		int tsIndex = findTimeSignature(measure, context.score.timeSignatures);
-		int ticksPerMeasure =
-		    beatsPerMeasure(context.score.timeSignatures[tsIndex]) * TICKS_PER_BEAT;
-		int beatTicks = ticksPerMeasure / context.score.timeSignatures[tsIndex].numerator;
-		int subdivision = TICKS_PER_BEAT / (division / 4);
-
-		// Snap to the sub-division before the current measure to prevent the lines from jumping
-		// around
-		for (int tick = firstTick - (firstTick % subdivision); tick <= lastTick;
-		     tick += subdivision)
-		{
-			const int y = position.y - tickToPosition(tick) + visualOffset;
-			int currentMeasure =
-			    accumulateMeasures(tick, TICKS_PER_BEAT, context.score.timeSignatures);
-
-			// Time signature changes on current measure
-			if (context.score.timeSignatures.find(currentMeasure) !=
-			        context.score.timeSignatures.end() &&
-			    currentMeasure != tsIndex)
-			{
-				tsIndex = currentMeasure;
-				ticksPerMeasure =
-				    beatsPerMeasure(context.score.timeSignatures[tsIndex]) * TICKS_PER_BEAT;
-				beatTicks = ticksPerMeasure / context.score.timeSignatures[tsIndex].numerator;
-
-				// snap to sub-division again on time signature change
-				tick = measureToTicks(currentMeasure, TICKS_PER_BEAT, context.score.timeSignatures);
-				tick -= tick % subdivision;
-			}
-
-			// determine whether the tick is a beat relative to its measure's tick
-			int measureTicks =
-			    measureToTicks(currentMeasure, TICKS_PER_BEAT, context.score.timeSignatures);
-
-			ImU32 color;
-			ImU32 exColor;
-			float thickness;
-			if (!((tick - measureTicks) % beatTicks))
-			{
-				color = measureColor;
-				exColor = exMeasureColor;
-				thickness = primaryLineThickness;
-			}
-			else if (division >= 192)
-			{
-				continue;
-			}
-			else
-			{
-				color = divColor2;
-				exColor = exDivColor2;
-				thickness = secondaryLineThickness;
-			}
-
-			drawList->AddLine(ImVec2(exX1, y), ImVec2(x1, y), exColor, thickness);
-			drawList->AddLine(ImVec2(x1, y), ImVec2(x2, y), color, thickness);
-			drawList->AddLine(ImVec2(x2, y), ImVec2(exX2, y), exColor, thickness);
-		}
-
-		tsIndex = findTimeSignature(measure, context.score.timeSignatures);
-		ticksPerMeasure = beatsPerMeasure(context.score.timeSignatures[tsIndex]) * TICKS_PER_BEAT;
-
-		// Overdraw one measure to make sure the measure string is always visible
-		for (int tick = firstTick; tick < lastTick + ticksPerMeasure; tick += ticksPerMeasure)
-		{
-			if (context.score.timeSignatures.find(measure) != context.score.timeSignatures.end())
-			{
-				tsIndex = measure;
-				ticksPerMeasure =
-				    beatsPerMeasure(context.score.timeSignatures[tsIndex]) * TICKS_PER_BEAT;
-			}
-
-			std::string measureStr = std::to_string(measure);
-			const float txtPos =
-			    exX1 - MEASURE_WIDTH - (ImGui::CalcTextSize(measureStr.c_str()).x * 0.5f);
-			const int y = position.y - tickToPosition(tick) + visualOffset;
-
-			drawList->AddLine(ImVec2(exX1 - MEASURE_WIDTH, y), ImVec2(exX2 + MEASURE_WIDTH, y),
-			                  measureColor, primaryLineThickness);
-			drawShadedText(drawList, ImVec2(txtPos, y), 26, measureTxtColor, measureStr.c_str());
-
-			++measure;
-		}
-
-		// draw lanes
-		for (int l = -context.score.metadata.laneExtension;
-		     l <= NUM_LANES + context.score.metadata.laneExtension; ++l)
-		{
-			const int x = position.x + laneToPosition(l);
-			const bool boldLane = !(l & 1);
-			const bool outOfBounds = l < 0 || l > NUM_LANES;
-			drawList->AddLine(ImVec2(x, position.y), ImVec2(x, position.y + size.y),
-			                  outOfBounds ? boldLane ? exDivColor1 : exDivColor2
-			                  : boldLane  ? divColor1
-			                              : divColor2,
-			                  boldLane ? primaryLineThickness : secondaryLineThickness);
-		}
+		updateGridTiles(context);
 
 		hoverTick = snapTickFromPos(-mousePos.y);
 		hoverLane = positionToLane(mousePos.x);
@@ -962,12 +1061,80 @@ namespace MikuMikuWorld
 		}
 	}
 
+	void ScoreEditorTimeline::pickNotes(ScoreContext& context)
+	{
+		// Notes are picked in the same order they are drawn in so that overlapping notes resolve
+		// the same way they always have
+		minNoteYDistance = INT_MAX;
+		pickedControl = {};
+		for (const auto& [id, note] : context.score.notes)
+		{
+			const bool layerHidden = context.score.layers.at(note.layer).hidden;
+			if (!isNoteVisible(note) || (layerHidden && !context.showAllLayers))
+				continue;
+
+			if (note.getType() == NoteType::Tap || note.getType() == NoteType::Damage)
+				pickNote(context, note);
+		}
+
+		for (const auto& [id, hold] : context.score.holdNotes)
+		{
+			const Note& start = context.score.notes.at(hold.start.ID);
+			const Note& end = context.score.notes.at(hold.end);
+
+			const bool startLayerHidden = context.score.layers.at(start.layer).hidden;
+			const bool endLayerHidden = context.score.layers.at(end.layer).hidden;
+			if ((startLayerHidden || endLayerHidden) && !context.showAllLayers)
+				continue;
+
+			if (isNoteVisible(start))
+				pickNote(context, start);
+			if (isNoteVisible(end))
+				pickNote(context, end);
+
+			for (const auto& step : hold.steps)
+			{
+				const Note& mid = context.score.notes.at(step.ID);
+				if (isNoteVisible(mid))
+					pickNote(context, mid);
+			}
+		}
+	}
+
 	void ScoreEditorTimeline::updateNotes(ScoreContext& context, EditArgs& edit, Renderer* renderer)
 	{
+		PROFILE_SCOPE("ScoreEditorTimeline::updateNotes");
+
 		// directxmath dies
 		if (size.y < 10 || size.x < 10)
 			return;
 
+		pickNotes(context);
+		updateNoteControl(context);
+
+		// Nothing drawn into the framebuffer changes without input or animation, so idle frames
+		// show the notes rendered by the last frame that did
+		if (!Application::windowState.idleFrame)
+			renderNotes(context, edit, renderer);
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		drawList->AddImage((void*)framebuffer->getTexture(), position, position + size);
+
+		// draw hold step outlines
+		for (const auto& data : drawSteps)
+		{
+			const bool layerHidden = context.score.layers.at(data.layer).hidden;
+			if (layerHidden && !context.showAllLayers)
+				continue;
+
+			drawOutline(data, context.showAllLayers ? -1 : context.selectedLayer);
+		}
+	}
+
+	void ScoreEditorTimeline::renderNotes(ScoreContext& context, EditArgs& edit, Renderer* renderer)
+	{
+		drawSteps.clear();
+
 		Shader* shader = ResourceManager::shaders[0];
 		shader->use();
 		shader->setMatrix4("projection", camera.getOffCenterOrthographicProjection(
@@ -978,7 +1145,6 @@ namespace MikuMikuWorld
 		framebuffer->clear();
 		renderer->beginBatch();
 
-		minNoteYDistance = INT_MAX;
 		for (auto& [id, note] : context.score.notes)
 		{
 			const bool layerHidden = context.score.layers.at(note.layer).hidden;
@@ -987,7 +1153,6 @@ namespace MikuMikuWorld
 
 			if (note.getType() == NoteType::Tap)
 			{
-				updateNote(context, edit, note);
 				drawNote(note, renderer,
 				         (context.showAllLayers || note.layer == context.selectedLayer)
 				             ? noteTint
@@ -996,7 +1161,6 @@ namespace MikuMikuWorld
 			}
 			if (note.getType() == NoteType::Damage)
 			{
-				updateNote(context, edit, note);
 				drawCcNote(note, renderer,
 				           (context.showAllLayers || note.layer == context.selectedLayer)
 				               ? noteTint
@@ -1015,24 +1179,9 @@ namespace MikuMikuWorld
 			if ((startLayerHidden || endLayerHidden) && !context.showAllLayers)
 				continue;
 
-			if (isNoteVisible(start))
-				updateNote(context, edit, start);
-			if (isNoteVisible(end))
-				updateNote(context, edit, end);
-
-			for (const auto& step : hold.steps)
-			{
-				Note& mid = context.score.notes.at(step.ID);
-				if (isNoteVisible(mid))
-					updateNote(context, edit, mid);
-				if (skipUpdateAfterSortingSteps)
-					break;
-			}
-
 			drawHoldNote(context.score.notes, hold, renderer, noteTint,
 			             context.showAllLayers ? -1 : context.selectedLayer);
 		}
-		skipUpdateAfterSortingSteps = false;
 
 		renderer->endBatch();
 		renderer->beginBatch();
@@ -1067,53 +1216,110 @@ namespace MikuMikuWorld
 			insertingHold = false;
 		}
 
-		renderer->endBatch();
+		renderer->endBatch();
+
+		glDisable(GL_FRAMEBUFFER_SRGB);
+		glDisable(GL_DEPTH_TEST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	void ScoreEditorTimeline::previewPaste(ScoreContext& context, Renderer* renderer)
+	{
+		context.pasteData.offsetLane =
+		    std::clamp(hoverLane - context.pasteData.midLane, context.pasteData.minLaneOffset,
+		               context.pasteData.maxLaneOffset);
+
+		updatePastePreview(context, renderer);
 
-		glDisable(GL_FRAMEBUFFER_SRGB);
-		glDisable(GL_DEPTH_TEST);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		const int offsetTicks = hoverTick;
+		const int offsetLane = context.pasteData.offsetLane;
+		const Vector2 translation{ laneToPosition(offsetLane) - pastePreview.origin.x,
+			                       getNoteYPosFromTick(offsetTicks) - pastePreview.origin.y };
 
-		ImDrawList* drawList = ImGui::GetWindowDrawList();
-		drawList->AddImage((void*)framebuffer->getTexture(), position, position + size);
+		// Same visible range as isNoteVisible, in the payload's ticks
+		const float tickHeight = unitHeight * zoom;
+		const float baseY = getNoteYPosFromTick(offsetTicks);
+		const float minTick = -baseY / tickHeight;
+		const float maxTick = (size.y + position.y + 100 - baseY) / tickHeight;
 
-		// draw hold step outlines
-		for (const auto& data : drawSteps)
+		for (const auto& item : pastePreview.items)
 		{
-			const bool layerHidden = context.score.layers.at(data.layer).hidden;
-			if (layerHidden && !context.showAllLayers)
+			if (item.startTick > maxTick)
+				break;
+
+			if (item.endTick < minTick)
 				continue;
 
-			drawOutline(data, context.showAllLayers ? -1 : context.selectedLayer);
+			renderer->drawQuads(pastePreview.quads.data() + item.firstQuad, item.quadCount,
+			                    translation);
+			for (size_t i = 0; i < item.stepCount; ++i)
+			{
+				StepDrawData step = pastePreview.steps[item.firstStep + i];
+				step.tick += offsetTicks;
+				step.lane += offsetLane;
+				drawSteps.push_back(step);
+			}
 		}
 
-		drawSteps.clear();
+		for (const auto& [_, hsc] : context.pasteData.hiSpeedChanges)
+			hiSpeedControl(context, hsc.tick + hoverTick, hsc.speed, -1);
 	}
 
-	void ScoreEditorTimeline::previewPaste(ScoreContext& context, Renderer* renderer)
+	void ScoreEditorTimeline::updatePastePreview(ScoreContext& context, Renderer* renderer)
 	{
-		context.pasteData.offsetLane =
-		    std::clamp(hoverLane - context.pasteData.midLane, context.pasteData.minLaneOffset,
-		               context.pasteData.maxLaneOffset);
+		const PasteData& paste = context.pasteData;
+		uint64_t key = 14695981039346656037ull;
+		hashValue(key, paste.revision);
+		hashValue(key, zoom);
+		hashValue(key, laneWidth);
+		hashValue(key, notesHeight);
+		hashValue(key, noteTextures);
+		hashValue(key, drawHoldStepOutlines);
+		hashValue(key, context.showAllLayers);
+		hashValue(key, context.selectedLayer);
+		if (key == pastePreview.key)
+			return;
 
-		for (const auto notes : { context.pasteData.notes, context.pasteData.damages })
-			for (const auto& [_, note] : notes)
-				if (isNoteVisible(note, hoverTick))
-				{
-					if (note.getType() == NoteType::Tap)
-						drawNote(note, renderer, hoverTint, hoverTick, context.pasteData.offsetLane,
-						         context.showAllLayers || note.layer == context.selectedLayer);
-					else if (note.getType() == NoteType::Damage)
-						drawCcNote(note, renderer, hoverTint, hoverTick,
-						           context.pasteData.offsetLane,
-						           context.showAllLayers || note.layer == context.selectedLayer);
-				}
+		pastePreview.key = key;
+		pastePreview.items.clear();
+		pastePreview.quads.clear();
+		pastePreview.steps.clear();
+		pastePreview.origin = { laneToPosition(0), getNoteYPosFromTick(0) };
+
+		// Capture the whole payload at offset zero, including the parts currently off screen
+		const size_t firstStep = drawSteps.size();
+		cullOffscreen = false;
+		renderer->beginCapture(pastePreview.quads);
+		for (const PasteItem& item : paste.items)
+		{
+			PastePreview::Item preview{ item.startTick, item.endTick, pastePreview.quads.size(), 0,
+				                        drawSteps.size() - firstStep, 0 };
+			if (item.type == NoteType::Tap)
+			{
+				const Note& note = paste.notes.at(item.id);
+				drawNote(note, renderer, hoverTint, 0, 0,
+				         context.showAllLayers || note.layer == context.selectedLayer);
+			}
+			else if (item.type == NoteType::Damage)
+			{
+				const Note& note = paste.damages.at(item.id);
+				drawCcNote(note, renderer, hoverTint, 0, 0,
+				           context.showAllLayers || note.layer == context.selectedLayer);
+			}
+			else
+			{
+				drawHoldNote(paste.notes, paste.holds.at(item.id), renderer, hoverTint, -1);
+			}
 
-		for (const auto& [_, hold] : context.pasteData.holds)
-			drawHoldNote(context.pasteData.notes, hold, renderer, hoverTint, -1, hoverTick,
-			             context.pasteData.offsetLane);
+			preview.quadCount = pastePreview.quads.size() - preview.firstQuad;
+			preview.stepCount = drawSteps.size() - firstStep - preview.firstStep;
+			pastePreview.items.push_back(preview);
+		}
+		renderer->endCapture();
+		cullOffscreen = true;
 
-		for (const auto& [_, hsc] : context.pasteData.hiSpeedChanges)
-			hiSpeedControl(context, hsc.tick + hoverTick, hsc.speed, -1);
+		pastePreview.steps.assign(drawSteps.begin() + firstStep, drawSteps.end());
+		drawSteps.resize(firstStep);
 	}
 
 	void ScoreEditorTimeline::updateInputNotes(const Score& score, EditArgs& edit)
@@ -1178,11 +1384,12 @@ namespace MikuMikuWorld
 				if (tempo.tick == hoverTick)
 					return;
 
-			Score prev = context.score;
+			context.beginTransaction();
+			context.touchTempoChanges();
 			context.score.tempoChanges.push_back({ hoverTick, edit.bpm });
 			std::sort(context.score.tempoChanges.begin(), context.score.tempoChanges.end(),
 			          [](const auto& a, const auto& b) { return a.tick < b.tick; });
-			context.pushHistory("Insert BPM change", prev, context.score);
+			context.commitTransaction("Insert BPM change");
 		}
 		else if (currentMode == TimelineMode::InsertTimeSign)
 		{
@@ -1191,10 +1398,11 @@ namespace MikuMikuWorld
 			if (context.score.timeSignatures.find(measure) != context.score.timeSignatures.end())
 				return;
 
-			Score prev = context.score;
+			context.beginTransaction();
+			context.touchTimeSignatures();
 			context.score.timeSignatures[measure] = { measure, edit.timeSignatureNumerator,
 				                                      edit.timeSignatureDenominator };
-			context.pushHistory("Insert time signature", prev, context.score);
+			context.commitTransaction("Insert time signature");
 		}
 		else if (currentMode == TimelineMode::InsertHiSpeed)
 		{
@@ -1202,11 +1410,12 @@ namespace MikuMikuWorld
 				if (hs.tick == hoverTick && hs.layer == context.selectedLayer)
 					return;
 
-			Score prev = context.score;
 			id_t id = getNextHiSpeedID();
+			context.beginTransaction();
+			context.touchHiSpeed(id);
 			context.score.hiSpeedChanges[id] = { id, hoverTick, edit.hiSpeed,
 				                                 context.selectedLayer };
-			context.pushHistory("Insert hi-speed changes", prev, context.score);
+			context.commitTransaction("Insert hi-speed changes");
 		}
 	}
 
@@ -1452,30 +1661,63 @@ namespace MikuMikuWorld
 		return -1;
 	}
 
-	bool ScoreEditorTimeline::noteControl(ScoreContext& context, const Note& note,
-	                                      const ImVec2& pos, const ImVec2& sz, const char* id,
-	                                      ImGuiMouseCursor cursor)
+	void ScoreEditorTimeline::getNoteControlRect(const Note& note, NoteControl control,
+	                                             ImVec2& pos, ImVec2& sz) const
+	{
+		pos = { laneToPosition(note.lane) + position.x - 2.0f,
+			    position.y - tickToPosition(note.tick) + visualOffset - (notesHeight * 0.5f) };
+		sz = { noteControlWidth, notesHeight };
+
+		// account for <1 width by always having this be positive
+		float moveWidth = std::max((laneWidth * note.width) + 4.0f - (noteControlWidth * 2.0f),
+		                           (noteControlWidth * 2.0f));
+		if (control == NoteControl::Move)
+		{
+			pos.x += noteControlWidth;
+			sz.x = moveWidth;
+		}
+		else if (control == NoteControl::Right)
+		{
+			pos.x += noteControlWidth + moveWidth;
+		}
+	}
+
+	void ScoreEditorTimeline::updateNoteControl(ScoreContext& context)
 	{
 		float minLane = MIN_LANE - context.score.metadata.laneExtension;
 		float maxLane = MAX_LANE + context.score.metadata.laneExtension;
-		// Do not process notes if the cursor is outside of the timeline
-		// This fixes ui buttons conflicting with note "buttons"
-		if (!mouseInTimeline && !isHoldingNote)
-			return false;
 
-		// Do not allow editing notes during playback
-		if (playing)
-			return false;
+		// The held control stays alive even when the mouse leaves its note
+		NotePick control = isHoldingNote ? activeControl : pickedControl;
+		auto noteIt = context.score.notes.find(control.noteID);
+		if (noteIt == context.score.notes.end())
+		{
+			// The held note was removed while dragging it
+			if (isHoldingNote)
+			{
+				context.discardTransaction();
+				isHoldingNote = isMovingNote = false;
+				holdingNote = 0;
+			}
+			return;
+		}
 
+		const Note& note = noteIt->second;
+		const ImGuiMouseCursor cursor =
+		    control.control == NoteControl::Move ? ImGuiMouseCursor_Hand : ImGuiMouseCursor_ResizeEW;
+
+		ImVec2 pos, sz;
+		getNoteControlRect(note, control.control, pos, sz);
 		ImGui::SetCursorScreenPos(pos);
-		ImGui::InvisibleButton(id, sz);
+		ImGui::InvisibleButton("##note_control", sz);
 		if (mouseInTimeline && ImGui::IsItemHovered() && !dragging)
 			ImGui::SetMouseCursor(cursor);
 
 		// Note clicked
 		if (ImGui::IsItemActivated())
 		{
-			prevUpdateScore = context.score;
+			activeControl = control;
+			context.beginTransaction();
 			ctrlMousePos = mousePos;
 			holdLane = hoverLane;
 			holdTick = hoverTick;
@@ -1486,7 +1728,12 @@ namespace MikuMikuWorld
 		{
 			ImGui::SetMouseCursor(cursor);
 			isHoldingNote = true;
-			return true;
+
+			// Do not allow editing notes during playback
+			if (!playing)
+				dragNoteControl(context, note, control.control);
+
+			return;
 		}
 
 		// Note released
@@ -1500,12 +1747,20 @@ namespace MikuMikuWorld
 			isHoldingNote = false;
 			holdingNote = 0;
 
-			if (!noChange)
+			if (noChange)
+			{
+				context.discardTransaction();
+			}
+			else
 			{
 				std::unordered_set<int> sortHolds = context.getHoldsFromSelection();
 				for (int id : sortHolds)
 				{
+					// Fixing the order can swap positions with notes outside the selection,
+					// touching the hold records all of its notes
+					context.touchHold(id);
 					HoldNote& hold = context.score.holdNotes.at(id);
+
 					Note& start = context.score.notes.at(id);
 					Note& end = context.score.notes.at(hold.end);
 
@@ -1544,69 +1799,60 @@ namespace MikuMikuWorld
 					}
 
 					sortHoldSteps(context.score, hold);
-					skipUpdateAfterSortingSteps = true;
 				}
 
-				context.pushHistory("Update notes", prevUpdateScore, context.score);
+				context.commitTransaction("Update notes");
 			}
-		}
-
-		return false;
-	}
-
-	void ScoreEditorTimeline::updateNote(ScoreContext& context, EditArgs& edit, Note& note)
-	{
-		if (!(context.showAllLayers || context.selectedLayer == note.layer))
-			return;
-		const float minLane = MIN_LANE - context.score.metadata.laneExtension;
-		const float maxLane = MAX_LANE + context.score.metadata.laneExtension;
-		const float maxNoteWidth = MAX_NOTE_WIDTH + context.score.metadata.laneExtension * 2;
 
-		const float btnPosY =
-		    position.y - tickToPosition(note.tick) + visualOffset - (notesHeight * 0.5f);
-		float btnPosX = laneToPosition(note.lane) + position.x - 2.0f;
+			// Per note options here
+			if (control.control == NoteControl::Move && !isMovingNote &&
+			    !context.selectedNotes.empty())
+			{
+				switch (currentMode)
+				{
+				case TimelineMode::InsertFlick:
+					context.setFlick(FlickType::FlickTypeCount);
+					break;
 
-		ImVec2 pos{ btnPosX, btnPosY };
-		ImVec2 noteSz{ laneToPosition(note.lane + note.width) + position.x + 2.0f - btnPosX,
-			           notesHeight };
-		ImVec2 sz{ noteControlWidth, notesHeight };
+				case TimelineMode::MakeCritical:
+					context.toggleCriticals();
+					break;
 
-		const ImGuiIO& io = ImGui::GetIO();
-		if (ImGui::IsMouseHoveringRect(pos, pos + noteSz, false) && mouseInTimeline)
-		{
-			isHoveringNote = true;
+				case TimelineMode::InsertLong:
+					context.setEase(EaseType::EaseTypeCount);
+					break;
 
-			float noteYDistance =
-			    std::abs((btnPosY + notesHeight / 2 - visualOffset - position.y) - mousePos.y);
-			if (noteYDistance < minNoteYDistance || io.KeyCtrl)
-			{
-				minNoteYDistance = noteYDistance;
-				hoveringNote = note.ID;
-				if (ImGui::IsMouseClicked(0) && !UI::isAnyPopupOpen())
-				{
-					if (!io.KeyCtrl && !io.KeyAlt && !context.isNoteSelected(note))
-					{
-						context.selectedNotes.clear();
-						context.selectedHiSpeedChanges.clear();
-					}
+				case TimelineMode::InsertLongMid:
+					context.setStep(HoldStepType::HoldStepTypeCount);
+					break;
 
-					context.selectedNotes.insert(note.ID);
+				case TimelineMode::InsertGuide:
+					context.setGuideColor(GuideColor::GuideColorCount);
+					break;
 
-					if (io.KeyAlt && context.isNoteSelected(note))
-						context.selectedNotes.erase(note.ID);
+				case TimelineMode::MakeFriction:
+					context.toggleFriction();
+					break;
 
-					if (context.isNoteSelected(note))
-					{
-						holdingNote = note.ID;
-						noteTransformOrigin = NoteTransform::fromNote(note);
-					}
+				default:
+					break;
 				}
 			}
+
+			isMovingNote = false;
 		}
+	}
+
+	void ScoreEditorTimeline::dragNoteControl(ScoreContext& context, const Note& note,
+	                                          NoteControl control)
+	{
+		const float minLane = MIN_LANE - context.score.metadata.laneExtension;
+		const float maxLane = MAX_LANE + context.score.metadata.laneExtension;
+		const float maxNoteWidth = MAX_NOTE_WIDTH + context.score.metadata.laneExtension * 2;
 
-		// Left resize
-		ImGui::PushID(note.ID);
-		if (noteControl(context, note, pos, sz, "L", ImGuiMouseCursor_ResizeEW))
+		switch (control)
+		{
+		case NoteControl::Left:
 		{
 			int curLane = positionToLane(mousePos.x);
 			int grabLane = std::clamp(positionToLane(ctrlMousePos.x), minLane, maxLane);
@@ -1630,6 +1876,7 @@ namespace MikuMikuWorld
 					ctrlMousePos.x = mousePos.x;
 					for (id_t id : context.selectedNotes)
 					{
+						context.touchNote(id);
 						Note& n = context.score.notes.at(id);
 						n.width = std::clamp(n.width - diff, (float)MIN_NOTE_WIDTH, maxNoteWidth);
 						n.lane = std::clamp(n.lane + diff, minLane, maxLane - n.width + 1);
@@ -1638,13 +1885,9 @@ namespace MikuMikuWorld
 			}
 		}
 
-		pos.x += noteControlWidth;
-		// account for <1 width by always having this be positive
-		sz.x = std::max((laneWidth * note.width) + 4.0f - (noteControlWidth * 2.0f),
-		                (noteControlWidth * 2.0f));
+			break;
 
-		// Move
-		if (noteControl(context, note, pos, sz, "M", ImGuiMouseCursor_Hand))
+		case NoteControl::Move:
 		{
 			float curLane = truncf(positionToLane(mousePos.x));
 			float grabLane = truncf(std::clamp(positionToLane(ctrlMousePos.x), minLane, maxLane));
@@ -1668,6 +1911,7 @@ namespace MikuMikuWorld
 				{
 					for (id_t id : context.selectedNotes)
 					{
+						context.touchNote(id);
 						Note& n = context.score.notes.at(id);
 						n.lane = std::clamp(n.lane + laneDiff, minLane, maxLane - n.width + 1);
 					}
@@ -1693,6 +1937,7 @@ namespace MikuMikuWorld
 					{
 						for (id_t id : context.selectedNotes)
 						{
+							context.touchNote(id);
 							Note& n = context.score.notes.at(id);
 							n.tick = std::max(n.tick + tickDiff, 0);
 						}
@@ -1707,6 +1952,7 @@ namespace MikuMikuWorld
 
 						for (id_t id : context.selectedNotes)
 						{
+							context.touchNote(id);
 							Note& n = context.score.notes.at(id);
 							n.tick = std::max(n.tick + actualDiff, 0);
 						}
@@ -1726,6 +1972,7 @@ namespace MikuMikuWorld
 
 						for (int id : sortedSelectedNotes)
 						{
+							context.touchNote(id);
 							Note& n = context.score.notes.at(id);
 							auto shiftedTick = n.tick + tickDiff;
 							n.tick = std::max(roundTickDown(shiftedTick, division), 0);
@@ -1740,50 +1987,9 @@ namespace MikuMikuWorld
 			}
 		}
 
-		// Per note options here
-		if (ImGui::IsItemDeactivated())
-		{
-			if (!isMovingNote && !context.selectedNotes.empty())
-			{
-				switch (currentMode)
-				{
-				case TimelineMode::InsertFlick:
-					context.setFlick(FlickType::FlickTypeCount);
-					break;
-
-				case TimelineMode::MakeCritical:
-					context.toggleCriticals();
-					break;
-
-				case TimelineMode::InsertLong:
-					context.setEase(EaseType::EaseTypeCount);
-					break;
-
-				case TimelineMode::InsertLongMid:
-					context.setStep(HoldStepType::HoldStepTypeCount);
-					break;
-
-				case TimelineMode::InsertGuide:
-					context.setGuideColor(GuideColor::GuideColorCount);
-					break;
-
-				case TimelineMode::MakeFriction:
-					context.toggleFriction();
-					break;
-
-				default:
-					break;
-				}
-			}
-
-			isMovingNote = false;
-		}
-
-		pos.x += sz.x;
-		sz.x = noteControlWidth;
+			break;
 
-		// Right resize
-		if (noteControl(context, note, pos, sz, "R", ImGuiMouseCursor_ResizeEW))
+		case NoteControl::Right:
 		{
 			int grabLane = std::clamp(positionToLane(ctrlMousePos.x), minLane, maxLane);
 			int curLane = positionToLane(mousePos.x);
@@ -1805,6 +2011,7 @@ namespace MikuMikuWorld
 					ctrlMousePos.x = mousePos.x;
 					for (id_t id : context.selectedNotes)
 					{
+						context.touchNote(id);
 						Note& n = context.score.notes.at(id);
 						n.width = std::clamp(n.width + diff, (float)MIN_NOTE_WIDTH,
 						                     maxNoteWidth - n.lane);
@@ -1813,7 +2020,72 @@ namespace MikuMikuWorld
 			}
 		}
 
-		ImGui::PopID();
+			break;
+		}
+	}
+
+	void ScoreEditorTimeline::pickNote(ScoreContext& context, const Note& note)
+	{
+		if (!(context.showAllLayers || context.selectedLayer == note.layer))
+			return;
+
+		const float btnPosY =
+		    position.y - tickToPosition(note.tick) + visualOffset - (notesHeight * 0.5f);
+		float btnPosX = laneToPosition(note.lane) + position.x - 2.0f;
+
+		ImVec2 pos{ btnPosX, btnPosY };
+		ImVec2 noteSz{ laneToPosition(note.lane + note.width) + position.x + 2.0f - btnPosX,
+			           notesHeight };
+
+		const ImGuiIO& io = ImGui::GetIO();
+		if (ImGui::IsMouseHoveringRect(pos, pos + noteSz, false) && mouseInTimeline)
+		{
+			isHoveringNote = true;
+
+			float noteYDistance =
+			    std::abs((btnPosY + notesHeight / 2 - visualOffset - position.y) - mousePos.y);
+			if (noteYDistance < minNoteYDistance || io.KeyCtrl)
+			{
+				minNoteYDistance = noteYDistance;
+				hoveringNote = note.ID;
+				if (ImGui::IsMouseClicked(0) && !UI::isAnyPopupOpen())
+				{
+					if (!io.KeyCtrl && !io.KeyAlt && !context.isNoteSelected(note))
+					{
+						context.selectedNotes.clear();
+						context.selectedHiSpeedChanges.clear();
+					}
+
+					context.selectedNotes.insert(note.ID);
+
+					if (io.KeyAlt && context.isNoteSelected(note))
+						context.selectedNotes.erase(note.ID);
+
+					if (context.isNoteSelected(note))
+					{
+						holdingNote = note.ID;
+						noteTransformOrigin = NoteTransform::fromNote(note);
+					}
+				}
+			}
+		}
+
+		// Do not process notes if the cursor is outside of the timeline
+		// This fixes ui buttons conflicting with note controls
+		if (pickedControl.noteID != -1 || !mouseInTimeline || playing)
+			return;
+
+		// The first control under the mouse wins, like overlapping ImGui items did
+		for (NoteControl control : { NoteControl::Left, NoteControl::Move, NoteControl::Right })
+		{
+			ImVec2 controlPos, controlSz;
+			getNoteControlRect(note, control, controlPos, controlSz);
+			if (ImGui::IsMouseHoveringRect(controlPos, controlPos + controlSz))
+			{
+				pickedControl = { note.ID, control };
+				return;
+			}
+		}
 	}
 
 	void ScoreEditorTimeline::drawHoldCurve(const Note& n1, const Note& n2, EaseType ease,
@@ -1871,12 +2143,15 @@ namespace MikuMikuWorld
 			            ? (int)ZIndex::zCount
 			            : 0;
 
-			if (y2 <= 0)
-				continue;
+			if (cullOffscreen)
+			{
+				if (y2 <= 0)
+					continue;
 
-			// rest of hold no longer visible
-			if (y1 > size.y + size.y + position.y + 100)
-				break;
+				// rest of hold no longer visible
+				if (y1 > size.y + size.y + position.y + 100)
+					break;
+			}
 
 			Color localTint =
 			    selectedLayer == -1
@@ -1925,7 +2200,7 @@ namespace MikuMikuWorld
 		}
 	}
 
-	void ScoreEditorTimeline::drawHoldNote(const std::unordered_map<id_t, Note>& notes,
+	void ScoreEditorTimeline::drawHoldNote(const SlotMap<id_t, Note>& notes,
 	                                       const HoldNote& note, Renderer* renderer,
 	                                       const Color& tint_, const int selectedLayer,
 	                                       const int offsetTicks, const int offsetLane)
@@ -2512,10 +2787,11 @@ namespace MikuMikuWorld
 				UI::addFloatProperty(getString("bpm"), eventEdit.editBpm, "%g");
 				if (ImGui::IsItemDeactivatedAfterEdit())
 				{
-					Score prev = context.score;
+					context.beginTransaction();
+					context.touchTempoChanges();
 					tempo.bpm = std::clamp(eventEdit.editBpm, MIN_BPM, MAX_BPM);
 
-					context.pushHistory("Change tempo", prev, context.score);
+					context.commitTransaction("Change tempo");
 				}
 				UI::endPropertyColumns();
 
@@ -2526,10 +2802,11 @@ namespace MikuMikuWorld
 					if (ImGui::Button(getString("remove"), ImVec2(-1, UI::btnSmall.y + 2)))
 					{
 						ImGui::CloseCurrentPopup();
-						Score prev = context.score;
+						context.beginTransaction();
+						context.touchTempoChanges();
 						context.score.tempoChanges.erase(context.score.tempoChanges.begin() +
 						                                 eventEdit.editId);
-						context.pushHistory("Remove tempo change", prev, context.score);
+						context.commitTransaction("Remove tempo change");
 					}
 				}
 			}
@@ -2547,14 +2824,15 @@ namespace MikuMikuWorld
 				if (UI::timeSignatureSelect(eventEdit.editTimeSignatureNumerator,
 				                            eventEdit.editTimeSignatureDenominator))
 				{
-					Score prev = context.score;
+					context.beginTransaction();
+					context.touchTimeSignatures();
 					TimeSignature& ts = context.score.timeSignatures[eventEdit.editId];
 					ts.numerator = std::clamp(abs(eventEdit.editTimeSignatureNumerator),
 					                          MIN_TIME_SIGNATURE, MAX_TIME_SIGNATURE_NUMERATOR);
 					ts.denominator = std::clamp(abs(eventEdit.editTimeSignatureDenominator),
 					                            MIN_TIME_SIGNATURE, MAX_TIME_SIGNATURE_DENOMINATOR);
 
-					context.pushHistory("Change time signature", prev, context.score);
+					context.commitTransaction("Change time signature");
 				}
 				UI::endPropertyColumns();
 
@@ -2565,9 +2843,10 @@ namespace MikuMikuWorld
 					if (ImGui::Button(getString("remove"), ImVec2(-1, UI::btnSmall.y + 2)))
 					{
 						ImGui::CloseCurrentPopup();
-						Score prev = context.score;
+						context.beginTransaction();
+						context.touchTimeSignatures();
 						context.score.timeSignatures.erase(eventEdit.editId);
-						context.pushHistory("Remove time signature", prev, context.score);
+						context.commitTransaction("Remove time signature");
 					}
 				}
 			}
@@ -2586,10 +2865,11 @@ namespace MikuMikuWorld
 				HiSpeedChange& hiSpeed = context.score.hiSpeedChanges[eventEdit.editId];
 				if (ImGui::IsItemDeactivatedAfterEdit())
 				{
-					Score prev = context.score;
+					context.beginTransaction();
+					context.touchHiSpeed(eventEdit.editId);
 					hiSpeed.speed = eventEdit.editHiSpeed;
 
-					context.pushHistory("Change hi-speed", prev, context.score);
+					context.commitTransaction("Change hi-speed");
 				}
 				UI::endPropertyColumns();
 
@@ -2597,9 +2877,10 @@ namespace MikuMikuWorld
 				if (ImGui::Button(getString("remove"), ImVec2(-1, UI::btnSmall.y + 2)))
 				{
 					ImGui::CloseCurrentPopup();
-					Score prev = context.score;
+					context.beginTransaction();
+					context.touchHiSpeed(eventEdit.editId);
 					context.score.hiSpeedChanges.erase(eventEdit.editId);
-					context.pushHistory("Remove hi-speed change", prev, context.score);
+					context.commitTransaction("Remove hi-speed change");
 				}
 			}
 			else if (eventEdit.type == EventType::Waypoint)
@@ -2687,20 +2968,18 @@ namespace MikuMikuWorld
 
 	void ScoreEditorTimeline::insertNote(ScoreContext& context, EditArgs& edit)
 	{
-		Score prev = context.score;
-
 		Note newNote = inputNotes.tap;
 		newNote.ID = Note::getNextID();
 		newNote.layer = context.selectedLayer;
 
+		context.beginTransaction();
+		context.touchNote(newNote.ID);
 		context.score.notes[newNote.ID] = newNote;
-		context.pushHistory("Insert note", prev, context.score);
+		context.commitTransaction("Insert note");
 	}
 
 	void ScoreEditorTimeline::insertHold(ScoreContext& context, EditArgs& edit)
 	{
-		Score prev = context.score;
-
 		Note holdStart = inputNotes.holdStart;
 		holdStart.ID = Note::getNextID();
 		holdStart.layer = context.selectedLayer;
@@ -2752,6 +3031,10 @@ namespace MikuMikuWorld
 			holdEndType = HoldNoteType::Normal;
 		}
 
+		context.beginTransaction();
+		context.touchHold(holdStart.ID);
+		context.touchNote(holdStart.ID);
+		context.touchNote(holdEnd.ID);
 		context.score.notes[holdStart.ID] = holdStart;
 		context.score.notes[holdEnd.ID] = holdEnd;
 		context.score.holdNotes[holdStart.ID] = { {
@@ -2765,7 +3048,7 @@ namespace MikuMikuWorld
 			                                      holdEndType,
 			                                      edit.fadeType,
 			                                      edit.colorType };
-		context.pushHistory("Insert hold", prev, context.score);
+		context.commitTransaction("Insert hold");
 	}
 
 	void ScoreEditorTimeline::insertHoldStep(ScoreContext& context, EditArgs& edit, int holdId)
@@ -2778,8 +3061,6 @@ namespace MikuMikuWorld
 		if (context.score.notes.find(holdId) == context.score.notes.end())
 			return;
 
-		Score prev = context.score;
-
 		HoldNote& hold = context.score.holdNotes[holdId];
 		Note holdStart = context.score.notes[holdId];
 
@@ -2789,6 +3070,9 @@ namespace MikuMikuWorld
 		holdStep.parentID = holdStart.ID;
 		holdStep.layer = context.selectedLayer;
 
+		context.beginTransaction();
+		context.touchHold(holdId);
+		context.touchNote(holdStep.ID);
 		context.score.notes[holdStep.ID] = holdStep;
 
 		hold.steps.push_back(
@@ -2796,19 +3080,19 @@ namespace MikuMikuWorld
 
 		// sort steps in-case the step is inserted before/after existing steps
 		sortHoldSteps(context.score, hold);
-		context.pushHistory("Insert hold step", prev, context.score);
+		context.commitTransaction("Insert hold step");
 	}
 
 	void ScoreEditorTimeline::insertDamage(ScoreContext& context, EditArgs& edit)
 	{
-		Score prev = context.score;
-
 		Note newNote = inputNotes.damage;
 		newNote.ID = Note::getNextID();
 		newNote.layer = context.selectedLayer;
 
+		context.beginTransaction();
+		context.touchNote(newNote.ID);
 		context.score.notes[newNote.ID] = newNote;
-		context.pushHistory("Insert damage", prev, context.score);
+		context.commitTransaction("Insert damage");
 	}
 
 	void ScoreEditorTimeline::debug(ScoreContext& context)
@@ -2825,6 +3109,10 @@ namespace MikuMikuWorld
 		            maxOffset);
 		ImGui::Separator();
 
+		ImGui::Text("Grid tiles: %zu\nGrid tiles rendered: %zu", gridTiles->getTileCount(),
+		            gridTiles->getRenderCount());
+		ImGui::Separator();
+
 		if (mouseInTimeline)
 		{
 			ImGui::Text("Hover lane: %d\nHover tick: %d", hoverLane, hoverTick);
@@ -2864,6 +3152,8 @@ namespace MikuMikuWorld
 	ScoreEditorTimeline::ScoreEditorTimeline()
 	{
 		framebuffer = std::make_unique<Framebuffer>(1920, 1080);
+		gridTiles = std::make_unique<TileCache>(std::make_unique<FramebufferTileBackend>(),
+		                                        gridTileHeight);
 		playbackSpeed = 1.0f;
 
 		background.load(config.backgroundImage.empty()
@@ -2880,6 +3170,8 @@ namespace MikuMikuWorld
 		context.audio.setPlaybackSpeed(playbackSpeed, time);
 	}
 
+	bool ScoreEditorTimeline::isAnimating() const { return playing || visualOffset != offset; }
+
 	void ScoreEditorTimeline::setPlaying(ScoreContext& context, bool state)
 	{
 		if (playing == state)
@@ -2922,6 +3214,8 @@ namespace MikuMikuWorld
 
 	void ScoreEditorTimeline::updateNoteSE(ScoreContext& context)
 	{
+		PROFILE_SCOPE("ScoreEditorTimeline::updateNoteSE");
+
 		if (!playing)
 			return;
 
@@ -2995,12 +3289,15 @@ namespace MikuMikuWorld
 		}
 	}
 
-	void ScoreEditorTimeline::drawWaveform(ScoreContext& context)
+	void ScoreEditorTimeline::drawWaveform(ScoreContext& context, ImDrawList* drawList,
+	                                       const ImVec2& origin, float minPosition,
+	                                       float maxPosition)
 	{
-		ImDrawList* drawList = ImGui::GetWindowDrawList();
 		if (!drawList)
 			return;
 
+		PROFILE_SCOPE("ScoreEditorTimeline::drawWaveform");
+
 		constexpr ImU32 waveformColorL = 0x80646464;
 		constexpr ImU32 waveformColorR = 0x80585858;
 
@@ -3009,7 +3306,8 @@ namespace MikuMikuWorld
 		const double durationSeconds = context.waveformL.durationInSeconds;
 		const double musicOffsetInSeconds = context.workingData.musicOffset / 1000.0f;
 
-		const float timelineMidPosition = midpoint(getTimelineStartX(), getTimelineEndX());
+		const float timelineMidPosition =
+		    midpoint(getTimelineStartX(), getTimelineEndX()) + origin.x - position.x;
 
 		for (size_t index = 0; index < 2; index++)
 		{
@@ -3022,7 +3320,7 @@ namespace MikuMikuWorld
 			const ImU32 waveformColor = rightChannel ? waveformColorR : waveformColorL;
 			const Audio::WaveformMip& mip = waveform.findClosestMip(secondsPerPixel);
 
-			for (int y = visualOffset - size.y; y < visualOffset; y += 1)
+			for (int y = minPosition; y < maxPosition; y += 1)
 			{
 				int tick = positionToTick(y);
 
@@ -3036,11 +3334,10 @@ namespace MikuMikuWorld
 				float amplitude =
 				    std::max(waveform.getAmplitudeAt(mip, secondsAtPixel, secondsPerPixel), 0.0f);
 				float barValue = outOfBounds ? 0.0f : (amplitude * std::min(laneWidth * 6, 180.0f));
-				float rectYPosition = floorf(position.y + visualOffset - y);
+				float rectYPosition = floorf(origin.y - y);
 				// WARNING: A thickness of 0.5 or less does not draw with integrated graphics
 				// (optimization? limitation?)
 
-				float timelineMidPosition = midpoint(getTimelineStartX(), getTimelineEndX());
 				ImVec2 rect1(timelineMidPosition, rectYPosition);
 				ImVec2 rect2(timelineMidPosition +
 				                 (std::max(0.75f, barValue) * (rightChannel ? 1 : -1)),
@@ -5,6 +5,7 @@
 #include "Rendering/Camera.h"
 #include "Rendering/Framebuffer.h"
 #include "Rendering/Renderer.h"
+#include "Rendering/TileCache.h"
 #include "ScoreContext.h"
 #include "TimelineMode.h"
 
@@ -38,6 +39,20 @@ namespace MikuMikuWorld
 		0xFF9DD673, 0xFFD67B73, 0xFF73CED6, 0xFFCD73D6, 0xFFD6AC73, 0xFF000000
 	};
 
+	enum class NoteControl : uint8_t
+	{
+		Left,
+		Move,
+		Right
+	};
+
+	/// The note control under the mouse, found without submitting an ImGui item per note
+	struct NotePick
+	{
+		id_t noteID{ -1 };
+		NoteControl control{};
+	};
+
 	class StepDrawData
 	{
 	  public:
@@ -91,6 +106,7 @@ namespace MikuMikuWorld
 		static constexpr float minZoom = 0.25f;
 		static constexpr float maxZoom = 1920.0f;
 		static constexpr double waveformSecondsPerPixel = 0.005;
+		static constexpr int gridTileHeight = 512;
 		static constexpr float noteControlWidth = 12;
 
 		static constexpr float minPlaybackSpeed = 0.25f;
@@ -101,6 +117,8 @@ namespace MikuMikuWorld
 		int hoverTick{};
 		id_t hoveringNote{};
 		id_t holdingNote{};
+		NotePick pickedControl{};
+		NotePick activeControl{};
 		int holdLane{};
 		int holdTick{};
 		int lastSelectedTick{};
@@ -111,7 +129,6 @@ namespace MikuMikuWorld
 		bool isHoveringNote{ false };
 		bool isHoldingNote{ false };
 		bool isMovingNote{ false };
-		bool skipUpdateAfterSortingSteps{ false };
 		bool dragging{ false };
 		bool insertingHold{ false };
 
@@ -125,6 +142,7 @@ namespace MikuMikuWorld
 
 		Camera camera;
 		std::unique_ptr<Framebuffer> framebuffer;
+		std::unique_ptr<TileCache> gridTiles;
 		ImVec2 size;
 		ImVec2 position;
 		ImVec2 prevPos;
@@ -135,8 +153,6 @@ namespace MikuMikuWorld
 		ImVec2 dragStart;
 		ImVec2 mousePos;
 
-		Score prevUpdateScore;
-
 		struct InputNotes
 		{
 			Note tap;
@@ -166,6 +182,30 @@ namespace MikuMikuWorld
 		} noteTransformOrigin;
 
 		std::vector<StepDrawData> drawSteps;
+
+		/// Geometry of the paste payload drawn at offset zero, reused every frame of the preview
+		/// by translating it to the paste position
+		struct PastePreview
+		{
+			struct Item
+			{
+				int startTick{};
+				int endTick{};
+				size_t firstQuad{};
+				size_t quadCount{};
+				size_t firstStep{};
+				size_t stepCount{};
+			};
+
+			std::vector<Item> items;
+			std::vector<Quad> quads;
+			std::vector<StepDrawData> steps;
+			Vector2 origin{};
+			uint64_t key{};
+		} pastePreview;
+
+		/// Off while capturing geometry that must not depend on the visible range
+		bool cullOffscreen{ true };
 		std::unordered_set<std::string> playingNoteSounds;
 		static constexpr float audioOffsetCorrection = 0.02f;
 		static constexpr float audioLookAhead = 0.05f;
@@ -173,7 +213,11 @@ namespace MikuMikuWorld
 		void updateScrollbar();
 		void updateScrollingPosition();
 
-		void drawWaveform(ScoreContext& context);
+		void drawWaveform(ScoreContext& context, ImDrawList* drawList, const ImVec2& origin,
+		                  float minPosition, float maxPosition);
+		void drawGrid(ScoreContext& context, ImDrawList* drawList, const ImVec2& origin,
+		              float minPosition, float maxPosition);
+		void updateGridTiles(ScoreContext& context);
 
 		void drawHoldCurve(const Note& n1, const Note& n2, EaseType ease, bool isGuide,
 		                   Renderer* renderer, const Color& tint, const int offsetTick = 0,
@@ -181,7 +225,7 @@ namespace MikuMikuWorld
 		                   const float endAlpha = 1,
 		                   const GuideColor guideColor = GuideColor::Green,
 		                   const int selectedLayer = -1);
-		void drawHoldNote(const std::unordered_map<id_t, Note>& notes, const HoldNote& note,
+		void drawHoldNote(const SlotMap<id_t, Note>& notes, const HoldNote& note,
 		                  Renderer* renderer, const Color& tint, const int selectedLayer = -1,
 		                  const int offsetTicks = 0, const int offsetLane = 0);
 		void drawHoldMid(Note& note, HoldStepType type, Renderer* renderer, const Color& tint,
@@ -196,8 +240,12 @@ namespace MikuMikuWorld
 		void drawCcNote(const Note& note, Renderer* renderer, const Color& tint,
 		                const int offsetTick = 0, const int offsetLane = 0,
 		                const bool selectedLayer = true);
-		bool noteControl(ScoreContext& context, const Note& note, const ImVec2& pos,
-		                 const ImVec2& sz, const char* id, ImGuiMouseCursor cursor);
+		void getNoteControlRect(const Note& note, NoteControl control, ImVec2& pos,
+		                        ImVec2& sz) const;
+		void pickNote(ScoreContext& context, const Note& note);
+		void pickNotes(ScoreContext& context);
+		void updateNoteControl(ScoreContext& context);
+		void dragNoteControl(ScoreContext& context, const Note& note, NoteControl control);
 		bool bpmControl(const Score& score, const Tempo& tempo);
 		bool bpmControl(const Score& score, float bpm, int tick, bool enabled);
 		bool timeSignatureControl(const Score& score, int numerator, int denominator, int tick,
@@ -215,6 +263,7 @@ namespace MikuMikuWorld
 		void drawInputNote(Renderer* renderer);
 		void previewInput(const ScoreContext& context, EditArgs& edit, Renderer* renderer);
 		void previewPaste(ScoreContext& context, Renderer* renderer);
+		void updatePastePreview(ScoreContext& context, Renderer* renderer);
 		void executeInput(ScoreContext& context, EditArgs& edit);
 		void eventEditor(ScoreContext& context);
 
@@ -283,13 +332,14 @@ namespace MikuMikuWorld
 		int findClosestHold(ScoreContext& context, int lane, int tick);
 		bool isMouseInHoldPath(const Note& n1, const Note& n2, EaseType ease, float x, float y);
 		constexpr inline bool isPlaying() const { return playing; }
+		bool isAnimating() const;
 		void setPlaying(ScoreContext& context, bool state);
 		void stop(ScoreContext& context);
 		void calculateMaxOffsetFromScore(const Score& score);
 
 		void update(ScoreContext& context, EditArgs& edit, Renderer* renderer);
 		void updateNotes(ScoreContext& context, EditArgs& edit, Renderer* renderer);
-		void updateNote(ScoreContext& context, EditArgs& edit, Note& note);
+		void renderNotes(ScoreContext& context, EditArgs& edit, Renderer* renderer);
 		void updateInputNotes(const Score& score, EditArgs& edit);
 		void debug(ScoreContext& context);
 
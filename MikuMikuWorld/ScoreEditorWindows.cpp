@@ -3,10 +3,15 @@
 #include "ApplicationConfiguration.h"
 #include "Constants.h"
 #include "File.h"
+#include "GlyphCache.h"
+#include "MemoryTracker.h"
 #include "NoteTypes.h"
+#include "Profiler.h"
 #include "ScoreContext.h"
 #include "UI.h"
 #include "Utilities.h"
+#include <algorithm>
+#include <string_view>
 
 namespace MikuMikuWorld
 {
@@ -636,6 +641,8 @@ namespace MikuMikuWorld
 							continue;
 
 						ImGui::PushID(id);
+						GlyphCache::request(preset.getName());
+						GlyphCache::request(preset.description);
 
 						if (ImGui::Button(
 						        preset.getName().c_str(),
@@ -708,11 +715,13 @@ namespace MikuMikuWorld
 			ImGui::Text("%s", getString("name"));
 			ImGui::SetNextItemWidth(-1);
 			ImGui::InputText("##preset_name", &presetName);
+			GlyphCache::request(presetName);
 
 			ImGui::Text("%s", getString("description"));
 			ImGui::InputTextMultiline(
 			    "##preset_desc", &presetDesc,
 			    { -1, ImGui::GetContentRegionAvail().y - UI::btnSmall.y - 10.0f - padding.y });
+			GlyphCache::request(presetDesc);
 
 			ImVec2 btnSz{ (ImGui::GetContentRegionAvail().x - spacing.x - (padding.x * 0.5f)) /
 				              2.0f,
@@ -753,6 +762,7 @@ namespace MikuMikuWorld
 		std::string dialogText = IO::formatString(
 		    "%s \"%s\" %s. %s", getString("file_not_found_msg1"), removeFilename.c_str(),
 		    getString("file_not_found_msg2"), getString("remove_recent_file_not_found"));
+		GlyphCache::request(dialogText);
 
 		float maxDialogSizeX{ ImGui::GetMainViewport()->WorkSize.x * 0.80f };
 		ImVec2 padding = ImGui::GetStyle().WindowPadding;
@@ -946,10 +956,39 @@ namespace MikuMikuWorld
 
 	void DebugWindow::update(ScoreContext& context, ScoreEditorTimeline& timeline)
 	{
+		Profiler::setEnabled(profilerEnabled);
+
+		// The score and paste data have no allocation hook and are measured while debugging
+		MemoryTracker::set(MemoryCategory::Score, getMemoryUsage(context.score));
+		MemoryTracker::set(MemoryCategory::PasteData,
+		                   getMemoryUsage(context.pasteData) +
+		                       getMemoryUsage(context.clipboardCache.payload));
+
 		if (ImGui::Begin(IMGUI_TITLE(ICON_FA_BUG, "debug")))
 		{
 			constexpr ImGuiTreeNodeFlags headerFlags = ImGuiTreeNodeFlags_DefaultOpen;
 			constexpr ImGuiTreeNodeFlags treeNodeFlags = headerFlags | ImGuiTreeNodeFlags_Framed;
+			if (ImGui::TreeNodeEx("Profiler", treeNodeFlags))
+			{
+				updateProfiler();
+				ImGui::TreePop();
+			}
+
+			if (ImGui::TreeNodeEx("Memory", treeNodeFlags))
+			{
+				updateMemory(context);
+				ImGui::TreePop();
+			}
+
+			if (ImGui::TreeNodeEx("Startup", treeNodeFlags & ~ImGuiTreeNodeFlags_DefaultOpen))
+			{
+				if (ImGui::Button("Copy"))
+					ImGui::SetClipboardText(Application::startupTimings.c_str());
+
+				ImGui::TextUnformatted(Application::startupTimings.c_str());
+				ImGui::TreePop();
+			}
+
 			if (ImGui::TreeNodeEx("Audio", treeNodeFlags))
 			{
 				if (ImGui::CollapsingHeader("Engine", headerFlags))
@@ -1092,6 +1131,258 @@ namespace MikuMikuWorld
 		ImGui::End();
 	}
 
+	void DebugWindow::updateProfiler()
+	{
+		ImGui::Checkbox("Record", &profilerEnabled);
+
+		std::vector<ProfileFrame> frames = Profiler::getFrames();
+		if (frames.empty())
+		{
+			ImGui::TextDisabled("No frames recorded");
+			return;
+		}
+
+		auto frameMs = [](const ProfileFrame& frame)
+		{ return static_cast<float>(Profiler::toMilliseconds(frame.end - frame.begin)); };
+
+		// Follow the latest frame unless a frame that is still in the history was picked
+		size_t selected = frames.size() - 1;
+		for (size_t i = 0; i < frames.size(); ++i)
+		{
+			if (frames[i].begin == pinnedFrame)
+				selected = i;
+		}
+
+		ImGui::SameLine();
+		if (ImGui::Button("Latest"))
+		{
+			pinnedFrame = 0;
+			selected = frames.size() - 1;
+		}
+
+		ImGui::SameLine();
+		if (ImGui::Button("Slowest"))
+		{
+			selected = std::max_element(frames.begin(), frames.end(),
+			                            [&](const ProfileFrame& a, const ProfileFrame& b)
+			                            { return frameMs(a) < frameMs(b); }) -
+			           frames.begin();
+			pinnedFrame = frames[selected].begin;
+		}
+
+		// Frame time history. Clicking a bar pins that frame
+		constexpr size_t historyLength = 240;
+		constexpr float targetFrameMs = 1000.0f / 60.0f;
+		constexpr ImU32 slowFrameColor = IM_COL32(230, 90, 80, 255);
+		const size_t first = frames.size() > historyLength ? frames.size() - historyLength : 0;
+
+		float maxMs = targetFrameMs * 2;
+		for (size_t i = first; i < frames.size(); ++i)
+			maxMs = std::max(maxMs, frameMs(frames[i]));
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		const ImVec2 graphPos = ImGui::GetCursorScreenPos();
+		const ImVec2 graphSize{ ImGui::GetContentRegionAvail().x, 60 };
+		const float barWidth = graphSize.x / historyLength;
+		ImGui::InvisibleButton("##frame_history", graphSize);
+		const bool graphHovered = ImGui::IsItemHovered();
+
+		drawList->AddRectFilled(graphPos, graphPos + graphSize,
+		                        ImGui::GetColorU32(ImGuiCol_FrameBg));
+		for (size_t i = first; i < frames.size(); ++i)
+		{
+			const float ms = frameMs(frames[i]);
+			const float x = graphPos.x + (i - first) * barWidth;
+			const ImVec2 barMin{ x, graphPos.y + graphSize.y * (1 - std::min(ms / maxMs, 1.0f)) };
+			const ImVec2 barMax{ x + std::max(barWidth - 1, 1.0f), graphPos.y + graphSize.y };
+
+			ImU32 color = ms > targetFrameMs * 2 ? slowFrameColor
+			                                     : ImGui::GetColorU32(ImGuiCol_PlotHistogram);
+			if (i == selected)
+				color = ImGui::GetColorU32(ImGuiCol_PlotHistogramHovered);
+
+			drawList->AddRectFilled(barMin, barMax, color);
+			if (graphHovered && ImGui::IsMouseHoveringRect({ x, graphPos.y }, barMax))
+			{
+				ImGui::SetTooltip("%.2fms", ms);
+				if (ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+				{
+					pinnedFrame = frames[i].begin;
+					selected = i;
+				}
+			}
+		}
+
+		const float targetY = graphPos.y + graphSize.y * (1 - targetFrameMs / maxMs);
+		drawList->AddLine({ graphPos.x, targetY }, { graphPos.x + graphSize.x, targetY },
+		                  ImGui::GetColorU32(ImGuiCol_TextDisabled));
+
+		const ProfileFrame& frame = frames[selected];
+		const uint64_t frameLength = std::max<uint64_t>(frame.end - frame.begin, 1);
+		ImGui::Text("%s frame: %.2fms", pinnedFrame ? "Pinned" : "Latest", frameMs(frame));
+
+		std::vector<ProfileEvent> events = Profiler::getFrameEvents(frame.begin, frame.end);
+		events.erase(std::remove_if(events.begin(), events.end(),
+		                            [&](const ProfileEvent& event)
+		                            { return event.begin < frame.begin || event.end > frame.end; }),
+		             events.end());
+
+		// Zones of the frame laid out over time with nested zones below their parent
+		constexpr float rowHeight = 18;
+		uint32_t maxDepth = 0;
+		for (const ProfileEvent& event : events)
+			maxDepth = std::max(maxDepth, event.depth);
+
+		const ImVec2 timelinePos = ImGui::GetCursorScreenPos();
+		const ImVec2 timelineSize{ ImGui::GetContentRegionAvail().x, (maxDepth + 1) * rowHeight };
+		ImGui::InvisibleButton("##frame_timeline", timelineSize);
+		const bool timelineHovered = ImGui::IsItemHovered();
+
+		drawList->AddRectFilled(timelinePos, timelinePos + timelineSize,
+		                        ImGui::GetColorU32(ImGuiCol_FrameBg));
+		for (const ProfileEvent& event : events)
+		{
+			const float x1 = timelinePos.x + timelineSize.x * (event.begin - frame.begin) /
+			                                     static_cast<float>(frameLength);
+			const float x2 = timelinePos.x + timelineSize.x * (event.end - frame.begin) /
+			                                     static_cast<float>(frameLength);
+			const ImVec2 zoneMin{ x1, timelinePos.y + event.depth * rowHeight };
+			const ImVec2 zoneMax{ std::max(x2, x1 + 1), zoneMin.y + rowHeight - 1 };
+
+			// Same zone, same color across frames
+			const float hue = (std::hash<std::string_view>{}(event.name) % 360) / 360.0f;
+			drawList->AddRectFilled(zoneMin, zoneMax, ImColor::HSV(hue, 0.45f, 0.65f));
+			drawList->PushClipRect(zoneMin, zoneMax, true);
+			drawList->AddText(zoneMin + ImVec2{ 3, 2 }, IM_COL32_WHITE, event.name);
+			drawList->PopClipRect();
+
+			if (timelineHovered && ImGui::IsMouseHoveringRect(zoneMin, zoneMax))
+				ImGui::SetTooltip("%s\n%.3fms", event.name,
+				                  Profiler::toMilliseconds(event.end - event.begin));
+		}
+
+		constexpr ImGuiTableFlags tableFlags = ImGuiTableFlags_BordersOuter |
+		                                       ImGuiTableFlags_BordersInnerV |
+		                                       ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg;
+		if (ImGui::BeginTable("##profiler_zones", 3, tableFlags, { -1, 200 }))
+		{
+			ImGui::TableSetupScrollFreeze(0, 1);
+			ImGui::TableSetupColumn("Zone");
+			ImGui::TableSetupColumn("Time (ms)", ImGuiTableColumnFlags_WidthFixed);
+			ImGui::TableSetupColumn("Frame %", ImGuiTableColumnFlags_WidthFixed);
+			ImGui::TableHeadersRow();
+
+			for (const ProfileEvent& event : events)
+			{
+				const uint64_t length = event.end - event.begin;
+				ImGui::TableNextRow();
+				ImGui::TableSetColumnIndex(0);
+				ImGui::Text("%*s%s", event.depth * 2, "", event.name);
+				ImGui::TableSetColumnIndex(1);
+				ImGui::Text("%.3f", Profiler::toMilliseconds(length));
+				ImGui::TableSetColumnIndex(2);
+				ImGui::Text("%.1f", length * 100.0 / frameLength);
+			}
+
+			ImGui::EndTable();
+		}
+
+		ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.5f);
+		ImGui::SliderFloat("##trace_seconds", &traceSeconds, 1, 60, "Last %.0f seconds");
+		ImGui::SameLine();
+		if (ImGui::Button("Save Chrome Trace", { -1, 0 }))
+			saveTrace();
+	}
+
+	static std::string formatBytes(size_t bytes)
+	{
+		if (bytes >= 1 << 20)
+			return IO::formatString("%.2f MB", bytes / static_cast<double>(1 << 20));
+
+		if (bytes >= 1 << 10)
+			return IO::formatString("%.1f KB", bytes / static_cast<double>(1 << 10));
+
+		return IO::formatString("%zu B", bytes);
+	}
+
+	void DebugWindow::updateMemory(ScoreContext& context)
+	{
+		constexpr ImGuiTableFlags tableFlags = ImGuiTableFlags_BordersOuter |
+		                                       ImGuiTableFlags_BordersInnerV |
+		                                       ImGuiTableFlags_RowBg;
+		if (ImGui::BeginTable("##memory_usage", 3, tableFlags))
+		{
+			ImGui::TableSetupColumn("Owner");
+			ImGui::TableSetupColumn("Live", ImGuiTableColumnFlags_WidthFixed);
+			ImGui::TableSetupColumn("Peak", ImGuiTableColumnFlags_WidthFixed);
+			ImGui::TableHeadersRow();
+
+			size_t totalBytes = 0;
+			for (size_t i = 0; i < arrayLength(memoryCategoryNames); ++i)
+			{
+				const MemoryUsage usage = MemoryTracker::getUsage(static_cast<MemoryCategory>(i));
+				totalBytes += usage.bytes;
+
+				ImGui::TableNextRow();
+				ImGui::TableSetColumnIndex(0);
+				ImGui::TextUnformatted(memoryCategoryNames[i]);
+				ImGui::TableSetColumnIndex(1);
+				ImGui::TextUnformatted(formatBytes(usage.bytes).c_str());
+				ImGui::TableSetColumnIndex(2);
+				ImGui::TextUnformatted(formatBytes(usage.peakBytes).c_str());
+			}
+
+			ImGui::TableNextRow();
+			ImGui::TableSetColumnIndex(0);
+			ImGui::TextUnformatted("Total");
+			ImGui::TableSetColumnIndex(1);
+			ImGui::TextUnformatted(formatBytes(totalBytes).c_str());
+			ImGui::EndTable();
+		}
+
+		const int historyEntries = context.history.undoCount() + context.history.redoCount();
+		const size_t historyBytes = context.history.getMemoryUsage();
+		UI::beginPropertyColumns();
+		UI::addReadOnlyProperty("Undo Entries", historyEntries);
+		UI::addReadOnlyProperty("Bytes per Entry",
+		                        formatBytes(historyEntries ? historyBytes / historyEntries : 0));
+		UI::addReadOnlyProperty("Resident Glyphs",
+		                        static_cast<int>(GlyphCache::getResidentCount()));
+		UI::endPropertyColumns();
+
+		if (ImGui::Button("Reset Peaks", { -1, UI::btnSmall.y }))
+			MemoryTracker::resetPeaks();
+	}
+
+	void DebugWindow::saveTrace()
+	{
+		// Taken before the dialog so the trace ends where the button was pressed
+		const uint64_t end = Profiler::now();
+		const uint64_t begin = end - std::min(end, static_cast<uint64_t>(traceSeconds * 1e9));
+
+		IO::FileDialog fileDialog{};
+		fileDialog.title = "Save Chrome Trace";
+		fileDialog.filters = { { "Chrome Trace", "*.json" } };
+		fileDialog.defaultExtension = "json";
+		fileDialog.parentWindowHandle = Application::windowState.windowHandle;
+		fileDialog.inputFilename = "mmw_trace";
+
+		if (fileDialog.saveFile() != IO::FileDialogResult::OK)
+			return;
+
+		try
+		{
+			Profiler::writeChromeTrace(fileDialog.outputFilename, begin, end);
+		}
+		catch (const std::exception& err)
+		{
+			IO::messageBox(APP_NAME,
+			               IO::formatString("An error occurred while saving the trace\n%s",
+			                                err.what()),
+			               IO::MessageBoxButtons::Ok, IO::MessageBoxIcon::Error);
+		}
+	}
+
 	void SettingsWindow::updateKeyConfig(MultiInputBinding* bindings[], int count)
 	{
 		ImVec2 size = ImVec2(-1, ImGui::GetContentRegionAvail().y * 0.7);
@@ -1295,20 +1586,22 @@ namespace MikuMikuWorld
 						UI::beginPropertyColumns();
 						UI::propertyLabel(getString("language"));
 
+						const auto& languageFiles = Localization::getLanguageFiles();
 						std::string curr = getString("auto");
-						auto langIt = Localization::languages.find(config.language);
-						if (langIt != Localization::languages.end())
-							curr = langIt->second->getString("language_name");
+						if (languageFiles.find(config.language) != languageFiles.end())
+							curr = Localization::getLanguageName(config.language);
+						GlyphCache::request(curr);
 
 						if (ImGui::BeginCombo("##language", curr.c_str()))
 						{
 							if (ImGui::Selectable(getString("auto"), config.language == "auto"))
 								config.language = "auto";
 
-							for (const auto& [code, language] : Localization::languages)
+							for (const auto& [code, _] : languageFiles)
 							{
-								const bool selected = curr == code;
-								std::string str = language->getString("language_name");
+								const bool selected = config.language == code;
+								const std::string& str = Localization::getLanguageName(code);
+								GlyphCache::request(str);
 
 								if (ImGui::Selectable(str.c_str(), selected))
 									config.language = code;
@@ -1514,6 +1807,8 @@ namespace MikuMikuWorld
 
 						UI::addPercentSliderProperty(getString("background_brightnes"),
 						                             config.backgroundBrightness);
+						UI::addPercentSliderProperty(getString("background_blur"),
+						                             config.backgroundBlur);
 						ImGui::Separator();
 
 						UI::addPercentSliderProperty(getString("lanes_opacity"),
@@ -1590,6 +1885,7 @@ namespace MikuMikuWorld
 				{
 					++index;
 					ImGui::PushID(index);
+					GlyphCache::request(layer.name);
 
 					int isSelected = index == context.selectedLayer;
 
@@ -1786,6 +2082,7 @@ namespace MikuMikuWorld
 			ImGui::Text("%s", getString("name"));
 			ImGui::SetNextItemWidth(-1);
 			ImGui::InputText("##layer_name", &layerName);
+			GlyphCache::request(layerName);
 
 			ImVec2 btnSz{ (ImGui::GetContentRegionAvail().x - spacing.x - (padding.x * 0.5f)) /
 				              2.0f,
@@ -1830,6 +2127,7 @@ namespace MikuMikuWorld
 				{
 					++index;
 					ImGui::PushID(index);
+					GlyphCache::request(waypoint.name);
 
 					if (ImGui::Button(
 					        waypoint.name.c_str(),
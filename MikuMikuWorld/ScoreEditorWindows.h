@@ -52,6 +52,15 @@ namespace MikuMikuWorld
 
 	class DebugWindow
 	{
+	  private:
+		bool profilerEnabled{ true };
+		uint64_t pinnedFrame{};
+		float traceSeconds{ 10.0f };
+
+		void updateProfiler();
+		void saveTrace();
+		void updateMemory(ScoreContext& context);
+
 	  public:
 		void update(ScoreContext& context, ScoreEditorTimeline& timeline);
 	};
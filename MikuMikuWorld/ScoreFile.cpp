@@ -0,0 +1,85 @@
+#include "ScoreFile.h"
+#include "File.h"
+#include "IO.h"
+#include "SUS.h"
+#include "ScoreConverter.h"
+#include "SusExporter.h"
+#include "SusParser.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace MikuMikuWorld
+{
+	ScoreFileFormat getScoreFileFormat(const std::string& filename)
+	{
+		std::string extension = IO::File::getFileExtension(filename);
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+		if (extension == MMWS_EXTENSION || extension == CC_MMWS_EXTENSION)
+			return ScoreFileFormat::Mmws;
+		else if (extension == SUS_EXTENSION)
+			return ScoreFileFormat::Sus;
+		else if (extension == USC_EXTENSION)
+			return ScoreFileFormat::Usc;
+
+		return ScoreFileFormat::Unknown;
+	}
+
+	Score readScoreFile(const std::string& filename)
+	{
+		switch (getScoreFileFormat(filename))
+		{
+		case ScoreFileFormat::Sus:
+		{
+			if (!IO::File::exists(filename))
+				throw std::runtime_error("Failed to open file.");
+
+			SusParser susParser;
+			return ScoreConverter::susToScore(susParser.parse(filename));
+		}
+		case ScoreFileFormat::Usc:
+		{
+			std::ifstream uscfile(std::filesystem::path(IO::mbToWideStr(filename)));
+			if (!uscfile.is_open())
+				throw std::runtime_error("Failed to open file.");
+
+			return ScoreConverter::uscToScore(uscfile);
+		}
+		case ScoreFileFormat::Mmws:
+			return deserializeScore(filename);
+		default:
+			throw std::runtime_error("Unsupported file format.");
+		}
+	}
+
+	void writeScoreFile(const Score& score, const std::string& filename,
+	                    const ScoreWriteOptions& options)
+	{
+		switch (getScoreFileFormat(filename))
+		{
+		case ScoreFileFormat::Sus:
+		{
+			SUS sus = ScoreConverter::scoreToSus(score);
+			SusExporter exporter;
+			exporter.dump(sus, filename, options.susComment);
+			break;
+		}
+		case ScoreFileFormat::Usc:
+		{
+			std::ofstream uscfile(std::filesystem::path(IO::mbToWideStr(filename)));
+			if (!uscfile.is_open())
+				throw std::runtime_error("Failed to create file.");
+
+			ScoreConverter::scoreToUsc(score, uscfile, options.uscIndent);
+			uscfile.flush();
+			break;
+		}
+		case ScoreFileFormat::Mmws:
+			serializeScore(score, filename);
+			break;
+		default:
+			throw std::runtime_error("Unsupported file format.");
+		}
+	}
+}
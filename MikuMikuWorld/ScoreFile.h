@@ -0,0 +1,34 @@
+#pragma once
+#include "Score.h"
+#include <cstdint>
+#include <string>
+
+namespace MikuMikuWorld
+{
+	enum class ScoreFileFormat : uint8_t
+	{
+		Unknown,
+		Mmws,
+		Sus,
+		Usc
+	};
+
+	struct ScoreWriteOptions
+	{
+		/// Comment written at the top of SUS files
+		std::string susComment;
+
+		/// Indentation of USC files, -1 writes them minified
+		int uscIndent{ -1 };
+	};
+
+	/// Format of a score file by its extension
+	ScoreFileFormat getScoreFileFormat(const std::string& filename);
+
+	/// Reads a score file in any supported format. Throws if the file cannot be read.
+	Score readScoreFile(const std::string& filename);
+
+	/// Writes a score in the format given by the extension of filename
+	void writeScoreFile(const Score& score, const std::string& filename,
+	                    const ScoreWriteOptions& options = {});
+}
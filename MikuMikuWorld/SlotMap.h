@@ -0,0 +1,474 @@
+#pragma once
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	/// Refers to a slot of a SlotMap. Becomes stale once the element is erased even if the slot
+	/// is reused afterwards.
+	struct SlotHandle
+	{
+		uint32_t index{ UINT32_MAX };
+		uint32_t generation{};
+
+		constexpr bool isValid() const { return index != UINT32_MAX; }
+		constexpr bool operator==(const SlotHandle& other) const
+		{
+			return index == other.index && generation == other.generation;
+		}
+		constexpr bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+	};
+
+	/// Generational slot map keyed by an integer ID with the interface of std::unordered_map.
+	/// Elements live in fixed size pages so references stay valid until the element is erased,
+	/// iteration walks the pages linearly and copying does not allocate per element.
+	template <typename Key, typename T> class SlotMap
+	{
+	  public:
+		using key_type = Key;
+		using mapped_type = T;
+		using value_type = std::pair<const Key, T>;
+		using size_type = size_t;
+
+	  private:
+		static constexpr uint32_t pageShift = 8;
+		static constexpr uint32_t pageSize = 1 << pageShift;
+		static constexpr uint32_t pageMask = pageSize - 1;
+		static constexpr uint32_t emptyBucket = UINT32_MAX;
+
+		struct Slot
+		{
+			alignas(value_type) unsigned char storage[sizeof(value_type)];
+			uint32_t generation;
+			bool alive;
+
+			value_type& value() { return *std::launder(reinterpret_cast<value_type*>(storage)); }
+			const value_type& value() const
+			{
+				return *std::launder(reinterpret_cast<const value_type*>(storage));
+			}
+		};
+
+		/// The key is kept next to the slot index so probing never touches the pages
+		struct Bucket
+		{
+			Key key;
+			uint32_t index;
+		};
+
+		std::vector<std::unique_ptr<Slot[]>> pages;
+		std::vector<uint32_t> freeSlots;
+		std::vector<Bucket> buckets;
+		uint32_t slotCount{};
+		size_t liveCount{};
+
+		Slot& slot(uint32_t index) { return pages[index >> pageShift][index & pageMask]; }
+		const Slot& slot(uint32_t index) const
+		{
+			return pages[index >> pageShift][index & pageMask];
+		}
+
+		static size_t hash(Key key)
+		{
+			uint32_t h = static_cast<uint32_t>(key);
+			h ^= h >> 16;
+			h *= 0x7feb352d;
+			h ^= h >> 15;
+			h *= 0x846ca68b;
+			h ^= h >> 16;
+			return h;
+		}
+
+		/// Returns the bucket holding key, or the empty bucket where it would be inserted
+		size_t findBucket(Key key) const
+		{
+			size_t mask = buckets.size() - 1;
+			size_t i = hash(key) & mask;
+			while (buckets[i].index != emptyBucket && buckets[i].key != key)
+				i = (i + 1) & mask;
+
+			return i;
+		}
+
+		uint32_t findSlot(Key key) const
+		{
+			return buckets.empty() ? emptyBucket : buckets[findBucket(key)].index;
+		}
+
+		void rehash(size_t bucketCount)
+		{
+			buckets.assign(bucketCount, Bucket{ Key{}, emptyBucket });
+			size_t mask = bucketCount - 1;
+			for (uint32_t index = 0; index < slotCount; ++index)
+			{
+				if (!slot(index).alive)
+					continue;
+
+				const Key key = slot(index).value().first;
+				size_t i = hash(key) & mask;
+				while (buckets[i].index != emptyBucket)
+					i = (i + 1) & mask;
+
+				buckets[i] = { key, index };
+			}
+		}
+
+		void growBuckets(size_t elementCount)
+		{
+			size_t bucketCount = buckets.empty() ? 16 : buckets.size();
+			while (bucketCount < elementCount * 2)
+				bucketCount *= 2;
+
+			if (bucketCount != buckets.size())
+				rehash(bucketCount);
+		}
+
+		uint32_t allocateSlot()
+		{
+			if (!freeSlots.empty())
+			{
+				uint32_t index = freeSlots.back();
+				freeSlots.pop_back();
+				return index;
+			}
+
+			if ((slotCount >> pageShift) == pages.size())
+				addPage();
+
+			return slotCount++;
+		}
+
+		void addPage()
+		{
+			std::unique_ptr<Slot[]> page(new Slot[pageSize]);
+			for (uint32_t i = 0; i < pageSize; ++i)
+			{
+				page[i].generation = 0;
+				page[i].alive = false;
+			}
+
+			pages.push_back(std::move(page));
+		}
+
+		/// Backward shift deletion keeps probe sequences intact without tombstones
+		void unlinkBucket(size_t hole)
+		{
+			size_t mask = buckets.size() - 1;
+			size_t i = (hole + 1) & mask;
+			while (buckets[i].index != emptyBucket)
+			{
+				size_t home = hash(buckets[i].key) & mask;
+				if (((i - home) & mask) >= ((i - hole) & mask))
+				{
+					buckets[hole] = buckets[i];
+					hole = i;
+				}
+				i = (i + 1) & mask;
+			}
+			buckets[hole].index = emptyBucket;
+		}
+
+		void destroyAll()
+		{
+			for (uint32_t index = 0; index < slotCount; ++index)
+			{
+				if (slot(index).alive)
+					slot(index).value().~value_type();
+			}
+		}
+
+		template <typename... Args> std::pair<uint32_t, bool> tryEmplace(Key key, Args&&... args)
+		{
+			growBuckets(liveCount + 1);
+			size_t bucket = findBucket(key);
+			if (buckets[bucket].index != emptyBucket)
+				return { buckets[bucket].index, false };
+
+			uint32_t index = allocateSlot();
+			Slot& s = slot(index);
+			new (s.storage) value_type(std::piecewise_construct, std::forward_as_tuple(key),
+			                           std::forward_as_tuple(std::forward<Args>(args)...));
+			s.alive = true;
+			buckets[bucket] = { key, index };
+			++liveCount;
+			return { index, true };
+		}
+
+		template <bool Const> class Iterator
+		{
+		  private:
+			using Map = std::conditional_t<Const, const SlotMap, SlotMap>;
+			Map* map{};
+			uint32_t index{};
+
+			void skipDead()
+			{
+				while (index < map->slotCount && !map->slot(index).alive)
+					++index;
+			}
+
+			friend class SlotMap;
+			friend class Iterator<!Const>;
+
+		  public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = typename SlotMap::value_type;
+			using difference_type = std::ptrdiff_t;
+			using reference = std::conditional_t<Const, const value_type&, value_type&>;
+			using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+
+			Iterator() = default;
+			Iterator(Map* map, uint32_t index) : map{ map }, index{ index } { skipDead(); }
+			template <bool C = Const, typename = std::enable_if_t<C>>
+			Iterator(const Iterator<false>& other) : map{ other.map }, index{ other.index }
+			{
+			}
+
+			reference operator*() const { return map->slot(index).value(); }
+			pointer operator->() const { return &map->slot(index).value(); }
+
+			Iterator& operator++()
+			{
+				++index;
+				skipDead();
+				return *this;
+			}
+
+			Iterator operator++(int)
+			{
+				Iterator it = *this;
+				++(*this);
+				return it;
+			}
+
+			bool operator==(const Iterator& other) const { return index == other.index; }
+			bool operator!=(const Iterator& other) const { return index != other.index; }
+
+			SlotHandle handle() const { return { index, map->slot(index).generation }; }
+		};
+
+	  public:
+		using iterator = Iterator<false>;
+		using const_iterator = Iterator<true>;
+
+		SlotMap() = default;
+		SlotMap(SlotMap&& other) noexcept
+		    : pages{ std::move(other.pages) }, freeSlots{ std::move(other.freeSlots) },
+		      buckets{ std::move(other.buckets) }, slotCount{ other.slotCount },
+		      liveCount{ other.liveCount }
+		{
+			other.slotCount = 0;
+			other.liveCount = 0;
+		}
+
+		// Delegating makes the destructor run if copying an element throws
+		SlotMap(const SlotMap& other) : SlotMap() { *this = other; }
+
+		~SlotMap() { destroyAll(); }
+
+		SlotMap& operator=(SlotMap&& other) noexcept
+		{
+			if (this != &other)
+			{
+				destroyAll();
+				pages = std::move(other.pages);
+				freeSlots = std::move(other.freeSlots);
+				buckets = std::move(other.buckets);
+				slotCount = other.slotCount;
+				liveCount = other.liveCount;
+				other.slotCount = 0;
+				other.liveCount = 0;
+			}
+			return *this;
+		}
+
+		SlotMap& operator=(const SlotMap& other)
+		{
+			if (this == &other)
+				return *this;
+
+			clear();
+			uint32_t pageCount = (other.slotCount + pageMask) >> pageShift;
+			while (pages.size() < pageCount)
+				addPage();
+
+			for (uint32_t index = 0; index < pageCount * pageSize; ++index)
+				slot(index).generation = index < other.slotCount ? other.slot(index).generation : 0;
+
+			// A slot is only marked alive once its element is constructed, so if a copy throws
+			// clear destroys exactly the elements copied so far and leaves the map empty
+			slotCount = other.slotCount;
+			try
+			{
+				for (uint32_t index = 0; index < other.slotCount; ++index)
+				{
+					if (!other.slot(index).alive)
+						continue;
+
+					new (slot(index).storage) value_type(other.slot(index).value());
+					slot(index).alive = true;
+				}
+
+				freeSlots = other.freeSlots;
+				buckets = other.buckets;
+			}
+			catch (...)
+			{
+				clear();
+				throw;
+			}
+
+			liveCount = other.liveCount;
+			return *this;
+		}
+
+		iterator begin() { return { this, 0 }; }
+		iterator end() { return { this, slotCount }; }
+		const_iterator begin() const { return { this, 0 }; }
+		const_iterator end() const { return { this, slotCount }; }
+		const_iterator cbegin() const { return begin(); }
+		const_iterator cend() const { return end(); }
+
+		size_t size() const { return liveCount; }
+		bool empty() const { return liveCount == 0; }
+
+		/// Bytes held by the pages and lookup tables, not counting memory owned by the elements
+		size_t getMemoryUsage() const
+		{
+			return pages.size() * pageSize * sizeof(Slot) +
+			       pages.capacity() * sizeof(std::unique_ptr<Slot[]>) +
+			       freeSlots.capacity() * sizeof(uint32_t) + buckets.capacity() * sizeof(Bucket);
+		}
+
+		void reserve(size_t elementCount)
+		{
+			growBuckets(elementCount);
+			pages.reserve((elementCount + pageMask) >> pageShift);
+		}
+
+		void clear()
+		{
+			destroyAll();
+			for (auto& page : pages)
+			{
+				for (uint32_t i = 0; i < pageSize; ++i)
+				{
+					page[i].generation += page[i].alive;
+					page[i].alive = false;
+				}
+			}
+
+			freeSlots.clear();
+			buckets.clear();
+			slotCount = 0;
+			liveCount = 0;
+		}
+
+		iterator find(Key key) { return { this, findOrEnd(key) }; }
+		const_iterator find(Key key) const { return { this, findOrEnd(key) }; }
+		size_t count(Key key) const { return findSlot(key) != emptyBucket; }
+		bool contains(Key key) const { return findSlot(key) != emptyBucket; }
+
+		T& at(Key key)
+		{
+			uint32_t index = findSlot(key);
+			if (index == emptyBucket)
+				throw std::out_of_range("invalid SlotMap<K, T> key");
+
+			return slot(index).value().second;
+		}
+
+		const T& at(Key key) const
+		{
+			uint32_t index = findSlot(key);
+			if (index == emptyBucket)
+				throw std::out_of_range("invalid SlotMap<K, T> key");
+
+			return slot(index).value().second;
+		}
+
+		T& operator[](Key key) { return slot(tryEmplace(key).first).value().second; }
+
+		template <typename... Args> std::pair<iterator, bool> emplace(Key key, Args&&... args)
+		{
+			auto [index, inserted] = tryEmplace(key, std::forward<Args>(args)...);
+			return { iterator(this, index), inserted };
+		}
+
+		std::pair<iterator, bool> insert(const value_type& value)
+		{
+			return emplace(value.first, value.second);
+		}
+
+		size_t erase(Key key)
+		{
+			if (buckets.empty())
+				return 0;
+
+			size_t bucket = findBucket(key);
+			uint32_t index = buckets[bucket].index;
+			if (index == emptyBucket)
+				return 0;
+
+			unlinkBucket(bucket);
+			Slot& s = slot(index);
+			s.value().~value_type();
+			s.alive = false;
+			++s.generation;
+			freeSlots.push_back(index);
+			--liveCount;
+			return 1;
+		}
+
+		iterator erase(const_iterator position)
+		{
+			uint32_t index = position.index;
+			erase(slot(index).value().first);
+			return { this, index + 1 };
+		}
+
+		/// Handle of the slot holding key, or an invalid handle if there is none
+		SlotHandle handle(Key key) const
+		{
+			uint32_t index = findSlot(key);
+			return index == emptyBucket ? SlotHandle{}
+			                            : SlotHandle{ index, slot(index).generation };
+		}
+
+		T* get(SlotHandle handle)
+		{
+			return isAlive(handle) ? &slot(handle.index).value().second : nullptr;
+		}
+
+		const T* get(SlotHandle handle) const
+		{
+			return isAlive(handle) ? &slot(handle.index).value().second : nullptr;
+		}
+
+		bool isAlive(SlotHandle handle) const
+		{
+			return handle.index < slotCount && slot(handle.index).alive &&
+			       slot(handle.index).generation == handle.generation;
+		}
+
+		/// Whether slot index holds the element with key. Lets tables indexed by slot tell
+		/// whether an entry still refers to the same element.
+		bool slotHolds(uint32_t index, Key key) const
+		{
+			return index < slotCount && slot(index).alive && slot(index).value().first == key;
+		}
+
+	  private:
+		uint32_t findOrEnd(Key key) const
+		{
+			uint32_t index = findSlot(key);
+			return index == emptyBucket ? slotCount : index;
+		}
+	};
+}
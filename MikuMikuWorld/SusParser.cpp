@@ -1,6 +1,8 @@
 #include "SusParser.h"
 #include "File.h"
 #include "IO.h"
+#include "JobSystem.h"
+#include <algorithm>
 
 using namespace IO;
 
@@ -31,20 +33,33 @@ namespace MikuMikuWorld
 		return line.find_first_of(':') == std::string::npos;
 	}
 
-	int SusParser::toTicks(int measure, int i, int total)
+	void SusParser::buildBarIndex()
 	{
-		int bIndex = 0;
-		int accBarTicks = 0;
-		for (int i = 0; i < bars.size(); ++i)
+		accBarTicks.resize(bars.size());
+
+		int acc = 0;
+		for (size_t b = 0; b < bars.size(); ++b)
 		{
-			if (bars[i].measure > measure)
-				break;
+			acc += bars[b].ticks;
+			accBarTicks[b] = acc;
+		}
+	}
 
-			bIndex = i;
-			accBarTicks += bars[i].ticks;
+	int SusParser::toTicks(int measure, int i, int total) const
+	{
+		// Find the last bar starting at or before the measure
+		auto it = std::upper_bound(bars.begin(), bars.end(), measure,
+		                           [](int m, const Bar& bar) { return m < bar.measure; });
+
+		int bIndex = 0;
+		int barTicks = 0;
+		if (it != bars.begin())
+		{
+			bIndex = std::distance(bars.begin(), it) - 1;
+			barTicks = accBarTicks[bIndex];
 		}
 
-		return accBarTicks + ((measure - bars[bIndex].measure) * bars[bIndex].ticksPerMeasure) +
+		return barTicks + ((measure - bars[bIndex].measure) * bars[bIndex].ticksPerMeasure) +
 		       ((i * bars[bIndex].ticksPerMeasure) / total);
 	}
 
@@ -79,7 +94,7 @@ namespace MikuMikuWorld
 	}
 
 	std::vector<SUSNote> SusParser::toNotes(const std::string& header, const std::string& data,
-	                                        int measureBase)
+	                                        int measureBase, const std::string& hiSpeedGroup) const
 	{
 		std::vector<SUSNote> notes;
 		int measure = measureBase + std::stoul(header.substr(0, 3).c_str(), nullptr, 10);
@@ -93,12 +108,80 @@ namespace MikuMikuWorld
 			                         (int)std::stoul(header.substr(4, 1), nullptr, 36) + laneOffset,
 			                         (int)std::stoul(data.substr(i + 1, 1), nullptr, 36),
 			                         (int)std::stoul(data.substr(i, 1), nullptr, 36),
-			                         currentHiSpeedGroup });
+			                         hiSpeedGroup });
 		}
 
 		return notes;
 	}
 
+	SusNoteLine SusParser::decodeNoteLine(const SusLineData& line,
+	                                      const std::string& hiSpeedGroup) const
+	{
+		SusNoteLine result;
+		auto l = split(line.line, ":");
+		if (l.size() < 2) // no ':' found
+			return result;
+
+		std::string header = trim(l[0]).substr(1);
+		std::string data = l.size() > 1 ? trim(l[1]) : "";
+
+		if (header.size() == 5 && header[3] == '1')
+			result.type = SusNoteLineType::Tap;
+		else if (header.size() == 6 && header[3] == '3')
+			result.type = SusNoteLineType::Slide;
+		else if (header.size() == 5 && header[3] == '5')
+			result.type = SusNoteLineType::Directional;
+		else if (header.size() == 6 && header[3] == '9')
+			result.type = SusNoteLineType::Guide;
+		else
+			return result;
+
+		if (result.type == SusNoteLineType::Slide || result.type == SusNoteLineType::Guide)
+			result.channel = std::stoul(header.substr(5, 1), nullptr, 36);
+
+		result.notes = toNotes(header, data, line.measureOffset, hiSpeedGroup);
+		return result;
+	}
+
+	std::vector<SusNoteLine>
+	SusParser::decodeNoteLines(const std::vector<SusLineData>& lines,
+	                           const std::vector<std::string>& hiSpeedGroups) const
+	{
+		std::vector<SusNoteLine> decoded(lines.size());
+
+		std::vector<size_t> chunkStarts;
+		for (size_t start = 0; start < lines.size(); start += noteLinesPerChunk)
+			chunkStarts.push_back(start);
+
+		// Keep the error of each chunk and rethrow the one of the earliest line once all chunks
+		// are done, so a broken file reports the same error however the chunks were scheduled
+		std::vector<std::exception_ptr> chunkErrors(chunkStarts.size());
+		auto decodeChunk = [&](size_t start)
+		{
+			size_t end = std::min(start + noteLinesPerChunk, lines.size());
+			try
+			{
+				for (size_t i = start; i < end; ++i)
+					decoded[i] = decodeNoteLine(lines[i], hiSpeedGroups[i]);
+			}
+			catch (...)
+			{
+				chunkErrors[start / noteLinesPerChunk] = std::current_exception();
+			}
+		};
+
+		if (parallelDecode)
+			JobSystem::forEach(chunkStarts.begin(), chunkStarts.end(), decodeChunk);
+		else
+			std::for_each(chunkStarts.begin(), chunkStarts.end(), decodeChunk);
+
+		for (const auto& error : chunkErrors)
+			if (error)
+				std::rethrow_exception(error);
+
+		return decoded;
+	}
+
 	void SusParser::processCommand(std::string& line)
 	{
 		int keyPos = line.find_first_of(' ');
@@ -140,6 +223,35 @@ namespace MikuMikuWorld
 		}
 	}
 
+	SUSMetadata SusParser::parseMetadata(const std::string& filename)
+	{
+		title.clear();
+		artist.clear();
+		designer.clear();
+		waveOffset = 0;
+
+		File susFile(mbToWideStr(filename), L"r");
+		while (!susFile.isEndofFile())
+		{
+			std::string line = trim(susFile.readLine());
+			if (!startsWith(line, "#"))
+				continue;
+
+			if (!isCommand(line))
+				break;
+
+			processCommand(line);
+		}
+		susFile.close();
+
+		SUSMetadata metadata;
+		metadata.data["title"] = title;
+		metadata.data["artist"] = artist;
+		metadata.data["designer"] = designer;
+		metadata.waveOffset = waveOffset;
+		return metadata;
+	}
+
 	SUS SusParser::parse(const std::string& filename)
 	{
 		std::wstring wFilename = mbToWideStr(filename);
@@ -243,6 +355,7 @@ namespace MikuMikuWorld
 		}
 		std::sort(bars.begin(), bars.end(),
 		          [](const Bar& b1, const Bar& b2) { return b1.measure < b2.measure; });
+		buildBarIndex();
 
 		// Process BPM changes
 		std::vector<BPM> bpms;
@@ -324,49 +437,47 @@ namespace MikuMikuWorld
 		}
 
 		// Process notes
+		// Resolve the hi-speed group of every line first, the lines themselves are then
+		// independent of each other and can be decoded in parallel
+		std::vector<std::string> lineHiSpeedGroups(noteLines.size());
+		for (size_t i = 0; i < noteLines.size(); i++)
+		{
+			// The changes are keyed by the index of the note line that follows them
+			const int line = static_cast<int>(i);
+			if (measureOffsets.find(line) != measureOffsets.end())
+				measureOffset = measureOffsets[line];
+			if (hiSpeedGroupChanges.find(line) != hiSpeedGroupChanges.end())
+				currentHiSpeedGroup = hiSpeedGroupChanges[line];
+			lineHiSpeedGroups[i] = currentHiSpeedGroup;
+		}
+
+		std::vector<SusNoteLine> decodedLines = decodeNoteLines(noteLines, lineHiSpeedGroups);
+
+		// Merge in line order so the note streams match a serial parse
 		std::vector<SUSNote> taps;
 		std::vector<SUSNote> directionals;
 		std::unordered_map<int, std::vector<SUSNote>> slideStreams;
 		std::unordered_map<int, std::vector<SUSNote>> guideStreams;
-		for (int i = 0; i < noteLines.size(); i++)
+		for (const auto& line : decodedLines)
 		{
-			if (measureOffsets.find(i) != measureOffsets.end())
-				measureOffset = measureOffsets[i];
-			if (hiSpeedGroupChanges.find(i) != hiSpeedGroupChanges.end())
-				currentHiSpeedGroup = hiSpeedGroupChanges[i];
-			auto line = noteLines[i];
-			auto l = split(line.line, ":");
-			if (l.size() < 2) // no ':' found
-				continue;
-
-			std::string header = trim(l[0]).substr(1);
-			std::string data = l.size() > 1 ? trim(l[1]) : "";
-
-			if (header.size() == 5 && header[3] == '1')
-			{
-				std::vector<SUSNote> appendNotes = toNotes(header, data, line.measureOffset);
-				taps.insert(taps.end(), appendNotes.begin(), appendNotes.end());
-			}
-			else if (header.size() == 6 && header[3] == '3')
-			{
-				int channel = std::stoul(header.substr(5, 1), nullptr, 36);
-
-				std::vector<SUSNote> appendNotes = toNotes(header, data, line.measureOffset);
-				slideStreams[channel].insert(slideStreams[channel].end(), appendNotes.begin(),
-				                             appendNotes.end());
-			}
-			else if (header.size() == 5 && header[3] == '5')
+			switch (line.type)
 			{
-				std::vector<SUSNote> appendNotes = toNotes(header, data, line.measureOffset);
-				directionals.insert(directionals.end(), appendNotes.begin(), appendNotes.end());
-			}
-			else if (header.size() == 6 && header[3] == '9')
-			{
-				int channel = std::stoul(header.substr(5, 1), nullptr, 36);
-
-				std::vector<SUSNote> appendNotes = toNotes(header, data, line.measureOffset);
-				guideStreams[channel].insert(guideStreams[channel].end(), appendNotes.begin(),
-				                             appendNotes.end());
+			case SusNoteLineType::Tap:
+				taps.insert(taps.end(), line.notes.begin(), line.notes.end());
+				break;
+			case SusNoteLineType::Slide:
+				slideStreams[line.channel].insert(slideStreams[line.channel].end(),
+				                                  line.notes.begin(), line.notes.end());
+				break;
+			case SusNoteLineType::Directional:
+				directionals.insert(directionals.end(), line.notes.begin(), line.notes.end());
+				break;
+			case SusNoteLineType::Guide:
+				guideStreams[line.channel].insert(guideStreams[line.channel].end(),
+				                                  line.notes.begin(), line.notes.end());
+				break;
+			default:
+				break;
 			}
 		}
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "SUS.h"
+#include <cstdint>
 #include <regex>
 #include <string>
 
@@ -12,6 +13,22 @@ namespace MikuMikuWorld
 		std::string line;
 	};
 
+	enum class SusNoteLineType : uint8_t
+	{
+		None,
+		Tap,
+		Slide,
+		Directional,
+		Guide
+	};
+
+	struct SusNoteLine
+	{
+		SusNoteLineType type{ SusNoteLineType::None };
+		int channel{};
+		std::vector<SUSNote> notes;
+	};
+
 	struct SusLineArgs
 	{
 		std::string header;
@@ -31,19 +48,36 @@ namespace MikuMikuWorld
 		std::string designer;
 		std::unordered_map<std::string, float> bpmDefinitions;
 		std::vector<Bar> bars;
+		// Running sum of Bar::ticks, built once the bars are sorted
+		std::vector<int> accBarTicks;
 
 		std::string currentHiSpeedGroup;
 
+		bool parallelDecode{ true };
+
+		// Number of note lines decoded by a single worker task
+		static constexpr size_t noteLinesPerChunk = 256;
+
 		bool isCommand(const std::string& line);
-		int toTicks(int measure, int i, int total);
+		void buildBarIndex();
+		int toTicks(int measure, int i, int total) const;
 		SUSNoteStream toSlides(const std::vector<SUSNote>& stream);
 		std::vector<SUSNote> toNotes(const std::string& header, const std::string& data,
-		                             int measureBase);
+		                             int measureBase, const std::string& hiSpeedGroup) const;
+		SusNoteLine decodeNoteLine(const SusLineData& line, const std::string& hiSpeedGroup) const;
+		std::vector<SusNoteLine> decodeNoteLines(const std::vector<SusLineData>& lines,
+		                                         const std::vector<std::string>& hiSpeedGroups) const;
 
 	  public:
 		SusParser();
 
+		/// Decodes the note lines on the calling thread, the reference for the parallel path
+		void setParallelDecode(bool parallel) { parallelDecode = parallel; }
+
 		SUS parse(const std::string& filename);
+
+		/// Reads the header commands of a SUS file, stopping at the first note data line
+		SUSMetadata parseMetadata(const std::string& filename);
 		void processCommand(std::string& line);
 	};
 }
@@ -0,0 +1,173 @@
+#include "TaskGraph.h"
+#include "IO.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+
+namespace MikuMikuWorld
+{
+	TaskGraph::TaskID TaskGraph::add(std::string name, TaskThread thread,
+	                                 std::function<void()> function,
+	                                 const std::vector<TaskID>& dependencies)
+	{
+		const TaskID id = tasks.size();
+		Task& task = tasks.emplace_back();
+		task.name = std::move(name);
+		task.thread = thread;
+		task.function = std::move(function);
+		task.dependencyCount = dependencies.size();
+
+		for (TaskID dependency : dependencies)
+			tasks[dependency].dependents.push_back(id);
+
+		return id;
+	}
+
+	void TaskGraph::start(TaskID id)
+	{
+		if (tasks[id].thread == TaskThread::Worker)
+		{
+			JobSystem::schedule([this, id] { execute(id); }, JobPriority::Normal);
+			return;
+		}
+
+		{
+			std::lock_guard lock{ mutex };
+			readyMainTasks.push_back(id);
+		}
+		condition.notify_all();
+	}
+
+	void TaskGraph::execute(TaskID id)
+	{
+		Task& task = tasks[id];
+		task.begin = Profiler::now();
+		bool failed = task.skipped.load(std::memory_order_relaxed);
+		if (!failed)
+		{
+			try
+			{
+				task.function();
+			}
+			catch (...)
+			{
+				failed = true;
+				std::lock_guard lock{ mutex };
+				if (!exception)
+					exception = std::current_exception();
+			}
+		}
+		task.end = Profiler::now();
+
+		// Dependents of a failed task would work on missing results. They still go through
+		// execute so they count as finished and skip their own dependents in turn.
+		for (TaskID dependent : task.dependents)
+		{
+			if (failed)
+				tasks[dependent].skipped.store(true, std::memory_order_relaxed);
+
+			if (tasks[dependent].remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				start(dependent);
+		}
+
+		// Notified under the lock, run may return and destroy the graph as soon as it is released
+		std::lock_guard lock{ mutex };
+		++finishedCount;
+		condition.notify_all();
+	}
+
+	void TaskGraph::run()
+	{
+		runBegin = Profiler::now();
+		finishedCount = 0;
+		exception = nullptr;
+		for (Task& task : tasks)
+		{
+			task.remaining.store(task.dependencyCount, std::memory_order_relaxed);
+			task.skipped.store(false, std::memory_order_relaxed);
+		}
+
+		for (TaskID id = 0; id < tasks.size(); ++id)
+		{
+			if (tasks[id].dependencyCount == 0)
+				start(id);
+		}
+
+		std::unique_lock lock{ mutex };
+		while (finishedCount < tasks.size())
+		{
+			if (!readyMainTasks.empty())
+			{
+				const TaskID id = readyMainTasks.front();
+				readyMainTasks.pop_front();
+
+				lock.unlock();
+				execute(id);
+				lock.lock();
+				continue;
+			}
+
+			// Help the workers while no main thread task is ready. Low priority jobs such as the
+			// update check may block for a long time so they are left to the workers.
+			lock.unlock();
+			const bool ranJob = JobSystem::runPendingJob(JobPriority::Normal);
+			lock.lock();
+
+			if (!ranJob)
+			{
+				condition.wait_for(lock, std::chrono::milliseconds(1),
+				                   [this] {
+					                   return finishedCount == tasks.size() ||
+					                          !readyMainTasks.empty();
+				                   });
+			}
+		}
+
+		runEnd = Profiler::now();
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+
+	std::vector<TaskTiming> TaskGraph::getTimings() const
+	{
+		std::vector<TaskTiming> timings;
+		timings.reserve(tasks.size());
+		for (const Task& task : tasks)
+			timings.push_back({ task.name, task.thread, task.begin - runBegin, task.end - runBegin,
+			                    task.skipped.load(std::memory_order_relaxed) });
+
+		return timings;
+	}
+
+	std::string TaskGraph::formatTimings() const
+	{
+		std::vector<TaskTiming> timings = getTimings();
+		std::stable_sort(timings.begin(), timings.end(),
+		                 [](const TaskTiming& a, const TaskTiming& b)
+		                 { return a.end - a.begin > b.end - b.begin; });
+
+		std::string report =
+		    IO::formatString("%-40s %-6s %10s %10s\n", "Task", "Thread", "Start ms", "Time ms");
+		for (const TaskTiming& timing : timings)
+		{
+			if (timing.skipped)
+			{
+				report += IO::formatString("%-40s %-6s %10s\n", timing.name.c_str(),
+				                           timing.thread == TaskThread::Main ? "Main" : "Worker",
+				                           "skipped");
+				continue;
+			}
+
+			report += IO::formatString("%-40s %-6s %10.2f %10.2f\n", timing.name.c_str(),
+			                           timing.thread == TaskThread::Main ? "Main" : "Worker",
+			                           Profiler::toMilliseconds(timing.begin),
+			                           Profiler::toMilliseconds(timing.end - timing.begin));
+		}
+
+		report += IO::formatString("Total %.2f ms on %zu workers\n",
+		                           Profiler::toMilliseconds(runEnd - runBegin),
+		                           JobSystem::getThreadCount());
+		return report;
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	enum class TaskThread : uint8_t
+	{
+		/// Runs on the job system. Used for file reads and decodes.
+		Worker,
+		/// Runs on the thread that calls TaskGraph::run. Used for GL and main thread only state.
+		Main
+	};
+
+	struct TaskTiming
+	{
+		std::string name;
+		TaskThread thread{};
+
+		/// Profiler ticks since the graph started running
+		uint64_t begin{};
+		uint64_t end{};
+
+		/// Not run because a task it depends on failed
+		bool skipped{};
+	};
+
+	/// A set of tasks that each start once their dependencies have finished. Worker tasks run in
+	/// parallel while the main thread runs its own tasks in the order they become ready.
+	class TaskGraph
+	{
+	  public:
+		using TaskID = size_t;
+
+		TaskID add(std::string name, TaskThread thread, std::function<void()> function,
+		           const std::vector<TaskID>& dependencies = {});
+
+		/// Runs every task and returns once all of them have finished. An exception thrown by a
+		/// task is rethrown here after the remaining tasks have run. Tasks that depend on a failed
+		/// task, directly or not, are skipped.
+		void run();
+
+		/// Timings of the last run in the order the tasks were added
+		std::vector<TaskTiming> getTimings() const;
+
+		/// Writes the timings of the last run as a table, slowest task first
+		std::string formatTimings() const;
+
+	  private:
+		struct Task
+		{
+			std::string name;
+			TaskThread thread{};
+			std::function<void()> function;
+			std::vector<TaskID> dependents;
+			size_t dependencyCount{};
+			std::atomic<size_t> remaining{};
+			std::atomic<bool> skipped{};
+			uint64_t begin{};
+			uint64_t end{};
+		};
+
+		std::deque<Task> tasks;
+		uint64_t runBegin{};
+		uint64_t runEnd{};
+
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<TaskID> readyMainTasks;
+		size_t finishedCount{};
+		std::exception_ptr exception;
+
+		void start(TaskID id);
+		void execute(TaskID id);
+	};
+}
@@ -1,6 +1,7 @@
 #include "UI.h"
 #include "Utilities.h"
 #include "Colors.h"
+#include "GlyphCache.h"
 #include "Tempo.h"
 #include "ResourceManager.h"
 #include "TimelineMode.h"
@@ -119,6 +120,7 @@ namespace MikuMikuWorld
 		propertyLabel(label);
 
 		ImGui::InputText(labelID(label), &val);
+		GlyphCache::request(val);
 		ImGui::NextColumn();
 	}
 
@@ -216,6 +218,7 @@ namespace MikuMikuWorld
 		if (ImGui::InputTextWithHint(labelID(label), "n/a", &val,
 		                             ImGuiInputTextFlags_EnterReturnsTrue))
 			result = 1;
+		GlyphCache::request(val);
 		ImGui::SameLine();
 
 		ImGui::PushID(label);
@@ -274,6 +277,7 @@ namespace MikuMikuWorld
 		propertyLabel(label);
 
 		ImGui::InputTextMultiline(labelID(label), &val, ImVec2(-1, 50));
+		GlyphCache::request(val);
 		ImGui::NextColumn();
 	}
 
@@ -34,7 +34,7 @@ namespace jsonIO
 		return note;
 	}
 
-	static json noteToJson(const mmw::Note& note)
+	json noteToJson(const mmw::Note& note)
 	{
 		json data;
 		data["tick"] = note.tick;
@@ -56,7 +56,7 @@ namespace jsonIO
 	}
 
 	json noteSelectionToJson(const mmw::Score& score,
-	                         const std::unordered_set<mmw::id_t>& selection,
+	                         const mmw::NoteSelection& selection,
 	                         const std::unordered_set<mmw::id_t>& hiSpeedSelection, int baseTick)
 	{
 		json data, notes, holds, damages, hiSpeedChanges;
@@ -53,6 +53,10 @@ int main()
 
 LRESULT CALLBACK wndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
+	// Any message may change what is on screen so keep drawing until the UI settles
+	if (uMsg != WM_TIMER)
+		mmw::Application::windowState.pendingFrames = mmw::Application::idleRedrawFrames;
+
 	switch (uMsg)
 	{
 	case WM_TIMER:
@@ -70,10 +74,13 @@ LRESULT CALLBACK wndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 
 	case WM_ENTERSIZEMOVE:
 		mmw::Application::windowState.windowDragging = true;
+		// Only tick while dragging so the timer does not wake the idle event loop
+		::SetTimer(hwnd, mmw::Application::windowState.windowTimerId, USER_TIMER_MINIMUM, nullptr);
 		break;
 
 	case WM_EXITSIZEMOVE:
 		mmw::Application::windowState.windowDragging = false;
+		::KillTimer(hwnd, mmw::Application::windowState.windowTimerId);
 		break;
 
 	case WM_DROPFILES:
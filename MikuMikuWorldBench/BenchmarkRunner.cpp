@@ -0,0 +1,55 @@
+#include "BenchmarkRunner.h"
+#include "Stopwatch.h"
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <stdexcept>
+
+namespace MikuMikuWorld
+{
+	BenchmarkRunner::BenchmarkRunner(int iterations, std::string filter)
+	    : iterations{ std::max(iterations, 1) }, filter{ std::move(filter) }
+	{
+	}
+
+	void BenchmarkRunner::run(const std::string& name, const Body& body, const Setup& setup)
+	{
+		if (!filter.empty() && name.find(filter) == std::string::npos)
+			return;
+
+		std::vector<double> times;
+		times.reserve(iterations);
+		try
+		{
+			if (setup)
+				setup();
+			body();
+
+			for (int i = 0; i < iterations; ++i)
+			{
+				if (setup)
+					setup();
+
+				Stopwatch stopwatch;
+				body();
+				times.push_back(stopwatch.elapsed() * 1000);
+			}
+		}
+		catch (const std::exception& error)
+		{
+			throw std::runtime_error(name + ": " + error.what());
+		}
+
+		std::sort(times.begin(), times.end());
+		BenchmarkResult result{ name, iterations };
+		result.minMs = times.front();
+		result.maxMs = times.back();
+		result.medianMs = times.size() % 2 ? times[times.size() / 2]
+		                                   : (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2;
+		result.meanMs = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+
+		fprintf(stderr, "%-32s %10.3f %10.3f %10.3f %10.3f\n", name.c_str(), result.minMs,
+		        result.medianMs, result.meanMs, result.maxMs);
+		results.push_back(std::move(result));
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	struct BenchmarkResult
+	{
+		std::string name;
+		int iterations{};
+		double minMs{};
+		double medianMs{};
+		double meanMs{};
+		double maxMs{};
+	};
+
+	/// Times named functions. Each one runs once untimed to warm up caches and then a fixed
+	/// number of timed iterations.
+	class BenchmarkRunner
+	{
+	  private:
+		int iterations;
+		std::string filter;
+		std::vector<BenchmarkResult> results;
+
+	  public:
+		/// setup runs before each iteration and is not timed
+		using Setup = std::function<void()>;
+		using Body = std::function<void()>;
+
+		BenchmarkRunner(int iterations, std::string filter);
+
+		/// Runs the benchmark unless its name does not contain the filter. A benchmark fails by
+		/// throwing, which is rethrown with its name and records no result.
+		void run(const std::string& name, const Body& body, const Setup& setup = {});
+
+		const std::vector<BenchmarkResult>& getResults() const { return results; }
+	};
+}
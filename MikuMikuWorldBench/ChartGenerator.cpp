@@ -0,0 +1,160 @@
+#include "ChartGenerator.h"
+#include <algorithm>
+#include <random>
+
+namespace MikuMikuWorld
+{
+	class ChartRandom
+	{
+	  private:
+		std::mt19937 engine;
+
+	  public:
+		ChartRandom(uint32_t seed) : engine{ seed } {}
+
+		int range(int min, int max) { return std::uniform_int_distribution<int>(min, max)(engine); }
+		bool chance(float probability)
+		{
+			return std::uniform_real_distribution<float>(0, 1)(engine) < probability;
+		}
+
+		/// Places a note of random width in the lanes. Half lanes are used like the editor allows.
+		void placeNote(Note& note)
+		{
+			note.width = range(2, 12) / 2.0f;
+			note.lane = range(0, static_cast<int>((NUM_LANES - note.width) * 2)) / 2.0f;
+		}
+	};
+
+	static Note makeNote(NoteType type, int tick, int layer, ChartRandom& random)
+	{
+		Note note(type);
+		note.ID = Note::getNextID();
+		note.tick = tick;
+		note.layer = layer;
+		random.placeNote(note);
+		return note;
+	}
+
+	static void addHold(Score& score, int startTick, int length, int steps, bool guide, int layer,
+	                    ChartRandom& random)
+	{
+		Note start = makeNote(NoteType::Hold, startTick, layer, random);
+		start.critical = random.chance(0.2f);
+		score.notes[start.ID] = start;
+
+		HoldNote hold;
+		hold.start = { start.ID, HoldStepType::Normal,
+			           static_cast<EaseType>(random.range(0, (int)EaseType::EaseTypeCount - 1)) };
+		if (guide)
+		{
+			hold.startType = hold.endType = HoldNoteType::Guide;
+			hold.guideColor =
+			    static_cast<GuideColor>(random.range(0, (int)GuideColor::GuideColorCount - 1));
+		}
+
+		std::vector<int> stepTicks(steps);
+		for (int& tick : stepTicks)
+			tick = startTick + random.range(1, std::max(1, length - 1));
+		std::sort(stepTicks.begin(), stepTicks.end());
+
+		hold.steps.reserve(steps);
+		for (int tick : stepTicks)
+		{
+			Note mid = makeNote(NoteType::HoldMid, tick, layer, random);
+			mid.parentID = start.ID;
+			mid.critical = start.critical;
+			score.notes[mid.ID] = mid;
+
+			HoldStepType type = guide ? HoldStepType::Hidden
+			                          : static_cast<HoldStepType>(random.range(0, 2));
+			EaseType ease = static_cast<EaseType>(random.range(0, (int)EaseType::EaseTypeCount - 1));
+			hold.steps.push_back({ mid.ID, type, ease });
+		}
+
+		Note end = makeNote(NoteType::HoldEnd, startTick + length, layer, random);
+		end.parentID = start.ID;
+		end.critical = start.critical;
+		if (!guide && random.chance(0.2f))
+			end.flick = static_cast<FlickType>(random.range(1, 3));
+		score.notes[end.ID] = end;
+
+		hold.end = end.ID;
+		score.holdNotes[start.ID] = hold;
+	}
+
+	Score generateChart(const ChartGeneratorOptions& options)
+	{
+		ChartRandom random(options.seed);
+		Score score;
+		score.metadata.title = "Synthetic chart";
+		score.metadata.artist = "Benchmark";
+		score.metadata.author = "ChartGenerator";
+
+		for (int i = 1; i < options.layers; ++i)
+			score.layers.push_back({ "layer " + std::to_string(i) });
+
+		const int layerCount = std::max<int>(score.layers.size(), 1);
+		const int measureTicks = TICKS_PER_BEAT * 4;
+		const int lastTick = std::max(options.measures, 1) * measureTicks;
+
+		// The default signature stays at measure 0, changes go on distinct later measures
+		for (int i = 0; i < options.timeSignatures && options.measures > 1; ++i)
+		{
+			int measure = random.range(1, options.measures - 1);
+			score.timeSignatures[measure] = { measure, random.range(2, 7),
+				                              random.chance(0.5f) ? 4 : 8 };
+		}
+
+		// Whole BPMs keep the number of distinct values within what SUS can define
+		for (int i = 0; i < options.tempoChanges; ++i)
+			score.tempoChanges.push_back(
+			    Tempo(random.range(1, lastTick / TICKS_PER_BEAT) * TICKS_PER_BEAT,
+			          static_cast<float>(random.range(60, 240))));
+
+		std::sort(score.tempoChanges.begin(), score.tempoChanges.end(),
+		          [](const Tempo& a, const Tempo& b) { return a.tick < b.tick; });
+
+		for (int i = 0; i < options.hiSpeedChanges; ++i)
+		{
+			id_t id = getNextHiSpeedID();
+			score.hiSpeedChanges[id] = { id, random.range(0, lastTick),
+				                         random.range(1, 40) / 10.0f,
+				                         random.range(0, layerCount - 1) };
+		}
+
+		score.notes.reserve(options.taps + options.damages +
+		                    (options.holds + options.guides) * (options.stepsPerHold + 2));
+		score.holdNotes.reserve(options.holds + options.guides);
+
+		for (int i = 0; i < options.taps; ++i)
+		{
+			Note note = makeNote(NoteType::Tap, random.range(0, lastTick) / 60 * 60,
+			                     random.range(0, layerCount - 1), random);
+			note.critical = random.chance(0.1f);
+			note.friction = random.chance(0.05f);
+			if (random.chance(0.15f))
+				note.flick = static_cast<FlickType>(random.range(1, 3));
+
+			score.notes[note.ID] = note;
+		}
+
+		for (int i = 0; i < options.damages; ++i)
+		{
+			Note note = makeNote(NoteType::Damage, random.range(0, lastTick) / 60 * 60,
+			                     random.range(0, layerCount - 1), random);
+			score.notes[note.ID] = note;
+		}
+
+		const int maxHoldLength = measureTicks * 2;
+		for (int i = 0; i < options.holds + options.guides; ++i)
+		{
+			int length = random.range(TICKS_PER_BEAT / 4, maxHoldLength) / 60 * 60;
+			int start = random.range(0, std::max(lastTick - length, 0)) / 60 * 60;
+			addHold(score, start, length, options.stepsPerHold, i >= options.holds,
+			        random.range(0, layerCount - 1), random);
+		}
+
+		return score;
+	}
+}
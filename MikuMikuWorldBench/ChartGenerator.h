@@ -0,0 +1,25 @@
+#pragma once
+#include "Score.h"
+#include <cstdint>
+
+namespace MikuMikuWorld
+{
+	/// Size of a synthetic chart. Counts are exact, positions are random but depend only on
+	/// the seed so runs with the same options time the same chart.
+	struct ChartGeneratorOptions
+	{
+		int measures{ 200 };
+		int taps{ 2000 };
+		int damages{ 100 };
+		int holds{ 400 };
+		int stepsPerHold{ 4 };
+		int guides{ 100 };
+		int tempoChanges{ 20 };
+		int timeSignatures{ 10 };
+		int hiSpeedChanges{ 50 };
+		int layers{ 2 };
+		uint32_t seed{ 39 };
+	};
+
+	Score generateChart(const ChartGeneratorOptions& options);
+}
@@ -0,0 +1,1508 @@
+#include "Checks.h"
+#include "ChartGenerator.h"
+#include "EditJournal.h"
+#include "GlyphCache.h"
+#include "HistoryManager.h"
+#include "IO.h"
+#include "JobSystem.h"
+#include "JsonIO.h"
+#include "Language.h"
+#include "NoteClipboard.h"
+#include "Rendering/ImageBlur.h"
+#include "Rendering/TileCache.h"
+#include "SUS.h"
+#include "SlotMap.h"
+#include "ScoreConverter.h"
+#include "ScoreFile.h"
+#include "SusExporter.h"
+#include "SusParser.h"
+#include "TaskGraph.h"
+#include "UscReference.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	CheckRunner::CheckRunner(std::string filter) : filter{ std::move(filter) } {}
+
+	void CheckRunner::run(const std::string& name, const Check& check)
+	{
+		if (!filter.empty() && name.find(filter) == std::string::npos)
+			return;
+
+		try
+		{
+			check();
+			fprintf(stderr, "%-32s passed\n", name.c_str());
+			++passed;
+		}
+		catch (const std::exception& error)
+		{
+			fprintf(stderr, "%-32s FAILED: %s\n", name.c_str(), error.what());
+			++failed;
+		}
+	}
+
+	/// Starts the workers for the checks of a parallel code path and joins them afterwards
+	struct JobSystemScope
+	{
+		JobSystemScope(size_t threadCount) { JobSystem::initialize(threadCount); }
+		~JobSystemScope() { JobSystem::shutdown(); }
+	};
+
+	static std::string describeNote(const SUSNote& note)
+	{
+		return IO::formatString("tick %d lane %d width %d type %d group '%s'", note.tick, note.lane,
+		                        note.width, note.type, note.hiSpeedGroup.c_str());
+	}
+
+	/// Throws with the first note that differs between the expected and actual stream
+	static void expectSameNotes(const std::string& stream, const std::vector<SUSNote>& expected,
+	                            const std::vector<SUSNote>& actual)
+	{
+		for (size_t i = 0; i < std::max(expected.size(), actual.size()); ++i)
+		{
+			const bool same = i < expected.size() && i < actual.size() &&
+			                  expected[i].tick == actual[i].tick &&
+			                  expected[i].lane == actual[i].lane &&
+			                  expected[i].width == actual[i].width &&
+			                  expected[i].type == actual[i].type &&
+			                  expected[i].hiSpeedGroup == actual[i].hiSpeedGroup;
+			if (same)
+				continue;
+
+			throw std::runtime_error(
+			    stream + " note " + std::to_string(i) + ": expected " +
+			    (i < expected.size() ? describeNote(expected[i]) : "nothing") + ", got " +
+			    (i < actual.size() ? describeNote(actual[i]) : "nothing"));
+		}
+	}
+
+	static void expectSameStreams(const std::string& stream, const SUSNoteStream& expected,
+	                              const SUSNoteStream& actual)
+	{
+		if (expected.size() != actual.size())
+			throw std::runtime_error(stream + ": expected " + std::to_string(expected.size()) +
+			                         " streams, got " + std::to_string(actual.size()));
+
+		for (size_t i = 0; i < expected.size(); ++i)
+			expectSameNotes(stream + " " + std::to_string(i), expected[i], actual[i]);
+	}
+
+	/// The parallel SUS note decoding must produce the same note streams, in the same order,
+	/// as decoding every line on one thread
+	static void checkSusParallelParse(const Score& score, const std::filesystem::path& directory)
+	{
+		JobSystemScope jobSystemScope(2);
+		const std::string susFilename = IO::wideStringToMb((directory / "check.sus").wstring());
+		SusExporter().dump(ScoreConverter::scoreToSus(score), susFilename);
+
+		SusParser serialParser;
+		serialParser.setParallelDecode(false);
+		const SUS serial = serialParser.parse(susFilename);
+		const SUS parallel = SusParser().parse(susFilename);
+
+		expectSameNotes("taps", serial.taps, parallel.taps);
+		expectSameNotes("directionals", serial.directionals, parallel.directionals);
+		expectSameStreams("slides", serial.slides, parallel.slides);
+		expectSameStreams("guides", serial.guides, parallel.guides);
+	}
+
+	static void expectSame(bool same, const std::string& what)
+	{
+		if (!same)
+			throw std::runtime_error(what + " differs");
+	}
+
+	static void expectThrows(const std::string& what, const std::function<void()>& action)
+	{
+		try
+		{
+			action();
+		}
+		catch (const std::runtime_error&)
+		{
+			return;
+		}
+
+		throw std::runtime_error(what + " did not throw");
+	}
+
+	/// Note IDs come from a sequence that starts over on every thread, so two imports of the
+	/// same file give every note the same ID if each runs on a new thread
+	static Score importOnNewThread(const std::function<Score()>& import)
+	{
+		Score score;
+		std::exception_ptr error;
+		std::thread thread(
+		    [&]
+		    {
+			    try
+			    {
+				    score = import();
+			    }
+			    catch (...)
+			    {
+				    error = std::current_exception();
+			    }
+		    });
+		thread.join();
+
+		if (error)
+			std::rethrow_exception(error);
+
+		return score;
+	}
+
+	/// Throws with the first difference between two imports of the same file made with
+	/// importOnNewThread
+	static void expectSameScore(const Score& expected, const Score& actual)
+	{
+		expectSame(expected.notes.size() == actual.notes.size(), "note count");
+		for (const auto& [id, note] : expected.notes)
+		{
+			const std::string what = "note " + std::to_string(id);
+			expectSame(actual.notes.contains(id), what);
+			const Note& other = actual.notes.at(id);
+			expectSame(note.getType() == other.getType(), what + " type");
+			expectSame(note.tick == other.tick, what + " tick");
+			expectSame(note.lane == other.lane, what + " lane");
+			expectSame(note.width == other.width, what + " width");
+			expectSame(note.critical == other.critical, what + " critical");
+			expectSame(note.friction == other.friction, what + " friction");
+			expectSame(note.flick == other.flick, what + " flick");
+			expectSame(note.layer == other.layer, what + " layer");
+			expectSame(note.parentID == other.parentID, what + " parent");
+		}
+
+		auto sameStep = [](const HoldStep& a, const HoldStep& b)
+		{ return a.ID == b.ID && a.type == b.type && a.ease == b.ease; };
+
+		expectSame(expected.holdNotes.size() == actual.holdNotes.size(), "hold count");
+		for (const auto& [id, hold] : expected.holdNotes)
+		{
+			const std::string what = "hold " + std::to_string(id);
+			expectSame(actual.holdNotes.contains(id), what);
+			const HoldNote& other = actual.holdNotes.at(id);
+			// Neither import sets the type of the start step
+			expectSame(hold.start.ID == other.start.ID && hold.start.ease == other.start.ease,
+			           what + " start");
+			expectSame(hold.steps.size() == other.steps.size(), what + " step count");
+			for (size_t i = 0; i < hold.steps.size(); ++i)
+				expectSame(sameStep(hold.steps[i], other.steps[i]),
+				           what + " step " + std::to_string(i));
+
+			expectSame(hold.end == other.end, what + " end");
+			expectSame(hold.startType == other.startType && hold.endType == other.endType,
+			           what + " type");
+			expectSame(hold.fadeType == other.fadeType, what + " fade");
+			expectSame(hold.guideColor == other.guideColor, what + " guide color");
+		}
+
+		for (const auto& [id, change] : expected.hiSpeedChanges)
+		{
+			const std::string what = "hi-speed change " + std::to_string(id);
+			auto other = actual.hiSpeedChanges.find(id);
+			expectSame(other != actual.hiSpeedChanges.end() && other->second.ID == id &&
+			               change.tick == other->second.tick &&
+			               change.speed == other->second.speed &&
+			               change.layer == other->second.layer,
+			           what);
+		}
+
+		expectSame(expected.tempoChanges.size() == actual.tempoChanges.size(), "tempo count");
+		for (size_t i = 0; i < expected.tempoChanges.size(); ++i)
+			expectSame(expected.tempoChanges[i].tick == actual.tempoChanges[i].tick &&
+			               expected.tempoChanges[i].bpm == actual.tempoChanges[i].bpm,
+			           "tempo " + std::to_string(i));
+
+		expectSame(expected.timeSignatures.size() == actual.timeSignatures.size(),
+		           "time signature count");
+		for (const auto& [measure, signature] : expected.timeSignatures)
+		{
+			auto other = actual.timeSignatures.find(measure);
+			expectSame(other != actual.timeSignatures.end() &&
+			               signature.measure == other->second.measure &&
+			               signature.numerator == other->second.numerator &&
+			               signature.denominator == other->second.denominator,
+			           "time signature at measure " + std::to_string(measure));
+		}
+
+		expectSame(expected.layers.size() == actual.layers.size(), "layer count");
+		for (size_t i = 0; i < expected.layers.size(); ++i)
+			expectSame(expected.layers[i].name == actual.layers[i].name &&
+			               expected.layers[i].hidden == actual.layers[i].hidden,
+			           "layer " + std::to_string(i));
+
+		expectSame(expected.metadata.musicOffset == actual.metadata.musicOffset, "music offset");
+	}
+
+	/// Streaming a USC file must see the same objects and the same document as parsing it whole,
+	/// and import the same score as the json based conversion it replaced. The streamed export
+	/// must match json::dump byte for byte.
+	static void checkUscStreamImport(const Score& score)
+	{
+		for (int indent : { -1, 4 })
+		{
+			std::ostringstream output;
+			ScoreConverter::scoreToUsc(score, output, indent);
+			const std::string usc = output.str();
+
+			const nlohmann::json expected = nlohmann::json::parse(usc);
+			if (expected.dump(indent) != usc)
+				throw std::runtime_error("export with indent " + std::to_string(indent) +
+				                         " differs from json::dump");
+
+			nlohmann::json objects = nlohmann::json::array();
+			std::istringstream input(usc);
+			nlohmann::json actual = ScoreConverter::readUscObjects(
+			    input, [&objects](const nlohmann::json& object) { objects.push_back(object); });
+
+			const nlohmann::json& expectedObjects = expected.at("usc").at("objects");
+			for (size_t i = 0; i < std::max(expectedObjects.size(), objects.size()); ++i)
+			{
+				if (i < expectedObjects.size() && i < objects.size() &&
+				    expectedObjects[i] == objects[i])
+					continue;
+
+				throw std::runtime_error(
+				    "object " + std::to_string(i) + ": expected " +
+				    (i < expectedObjects.size() ? expectedObjects[i].dump() : "nothing") +
+				    ", got " + (i < objects.size() ? objects[i].dump() : "nothing"));
+			}
+
+			actual["usc"]["objects"] = std::move(objects);
+			if (actual != expected)
+				throw std::runtime_error("document differs outside of usc.objects");
+
+			const Score reference =
+			    importOnNewThread([&] { return uscToScoreReference(expected); });
+			const Score imported = importOnNewThread(
+			    [&]
+			    {
+				    std::istringstream importInput(usc);
+				    return ScoreConverter::uscToScore(importInput);
+			    });
+			expectSameScore(reference, imported);
+		}
+	}
+
+	/// An unsupported version must be reported as such whether it comes before or after the
+	/// objects. The object in the file cannot be converted, so any other error means the failed
+	/// conversion was reported first.
+	static void checkUscRejectsVersion()
+	{
+		const char* files[] = {
+			R"({"usc":{"objects":[{"beat":"x","bpm":1,"type":"bpm"}],"offset":0},"version":3})",
+			R"({"version":3,"usc":{"objects":[{"beat":"x","bpm":1,"type":"bpm"}],"offset":0}})",
+			R"({"usc":{"objects":[{"beat":"x","bpm":1,"type":"bpm"}],"offset":0}})"
+		};
+
+		for (const char* file : files)
+		{
+			std::istringstream input(file);
+			try
+			{
+				ScoreConverter::uscToScore(input);
+			}
+			catch (const std::exception& error)
+			{
+				if (std::string(error.what()) != "Invalid version")
+					throw std::runtime_error(std::string("failed with '") + error.what() +
+					                         "' instead of rejecting the version of " + file);
+				continue;
+			}
+
+			throw std::runtime_error(std::string("accepted ") + file);
+		}
+	}
+
+	static std::string describeNoteValue(const Note& note)
+	{
+		return IO::formatString(
+		    "type %d tick %d lane %g width %g critical %d friction %d flick %d layer %d",
+		    (int)note.getType(), note.tick, note.lane, note.width, note.critical, note.friction,
+		    (int)note.flick, note.layer);
+	}
+
+	static std::string describeHold(const HoldNote& hold, const SlotMap<id_t, Note>& notes)
+	{
+		std::string item = IO::formatString(
+		    "hold %d %d fade %d color %d ease %d start %s end %s", (int)hold.startType,
+		    (int)hold.endType, (int)hold.fadeType, (int)hold.guideColor, (int)hold.start.ease,
+		    describeNoteValue(notes.at(hold.start.ID)).c_str(),
+		    describeNoteValue(notes.at(hold.end)).c_str());
+		for (const HoldStep& step : hold.steps)
+			item += IO::formatString(" step %d %d %s", (int)step.type, (int)step.ease,
+			                         describeNoteValue(notes.at(step.ID)).c_str());
+
+		return item;
+	}
+
+	/// Throws with the first item that differs between two sorted descriptions
+	static void expectSameItems(const std::string& what, const std::vector<std::string>& expected,
+	                            const std::vector<std::string>& actual)
+	{
+		for (size_t i = 0; i < std::max(expected.size(), actual.size()); ++i)
+		{
+			if (i < expected.size() && i < actual.size() && expected[i] == actual[i])
+				continue;
+
+			throw std::runtime_error(what + " item " + std::to_string(i) + ": expected " +
+			                         (i < expected.size() ? expected[i] : "nothing") + ", got " +
+			                         (i < actual.size() ? actual[i] : "nothing"));
+		}
+	}
+
+	/// Every note, hold and hi-speed change of a paste as sorted text. The JSON and binary
+	/// payloads list the notes in different orders, so the pastes get different IDs.
+	static std::vector<std::string> describePaste(const PasteData& paste)
+	{
+		std::vector<std::string> items;
+		for (const auto& [id, note] : paste.notes)
+		{
+			if (note.getType() == NoteType::Tap)
+				items.push_back(describeNoteValue(note));
+		}
+
+		for (const auto& [id, note] : paste.damages)
+			items.push_back(describeNoteValue(note));
+
+		for (const auto& [id, hold] : paste.holds)
+			items.push_back(describeHold(hold, paste.notes));
+
+		for (const auto& [id, hiSpeed] : paste.hiSpeedChanges)
+			items.push_back(IO::formatString("hi-speed tick %d speed %g", hiSpeed.tick,
+			                                 hiSpeed.speed));
+
+		std::sort(items.begin(), items.end());
+		return items;
+	}
+
+	/// Contents of a score as sorted text without IDs, so scores loaded in different sessions
+	/// can be compared
+	static std::vector<std::string> describeScore(const Score& score)
+	{
+		std::vector<std::string> items;
+		items.push_back(IO::formatString("%zu notes", score.notes.size()));
+		for (const auto& [id, note] : score.notes)
+		{
+			if (!note.isHold())
+				items.push_back(describeNoteValue(note));
+		}
+
+		for (const auto& [id, hold] : score.holdNotes)
+			items.push_back(describeHold(hold, score.notes));
+
+		for (const auto& [id, hiSpeed] : score.hiSpeedChanges)
+			items.push_back(IO::formatString("hi-speed tick %d speed %g layer %d", hiSpeed.tick,
+			                                 hiSpeed.speed, hiSpeed.layer));
+
+		for (size_t i = 0; i < score.tempoChanges.size(); ++i)
+			items.push_back(IO::formatString("tempo %zu tick %d bpm %g", i,
+			                                 score.tempoChanges[i].tick,
+			                                 score.tempoChanges[i].bpm));
+
+		for (const auto& [measure, ts] : score.timeSignatures)
+			items.push_back(IO::formatString("time signature %d %d/%d", ts.measure, ts.numerator,
+			                                 ts.denominator));
+
+		for (const auto& [id, skill] : score.skills)
+			items.push_back(IO::formatString("skill %d", skill.tick));
+
+		for (size_t i = 0; i < score.layers.size(); ++i)
+			items.push_back(IO::formatString("layer %zu %s %d", i, score.layers[i].name.c_str(),
+			                                 score.layers[i].hidden));
+
+		for (size_t i = 0; i < score.waypoints.size(); ++i)
+			items.push_back(IO::formatString("waypoint %zu %s %d", i,
+			                                 score.waypoints[i].name.c_str(),
+			                                 score.waypoints[i].tick));
+
+		const ScoreMetadata& metadata = score.metadata;
+		items.push_back(IO::formatString(
+		    "fever %d %d metadata %s|%s|%s|%s|%s|%g|%d", score.fever.startTick,
+		    score.fever.endTick, metadata.title.c_str(), metadata.artist.c_str(),
+		    metadata.author.c_str(), metadata.musicFile.c_str(), metadata.jacketFile.c_str(),
+		    metadata.musicOffset, metadata.laneExtension));
+
+		std::sort(items.begin(), items.end());
+		return items;
+	}
+
+	/// The clipboard text must keep the JSON that older builds paste, and its binary payload
+	/// must paste the same notes. The payload is little-endian on every host.
+	static void checkClipboard(const Score& score)
+	{
+		NoteSelection selection(score);
+		selection.selectAll();
+		std::unordered_set<id_t> hiSpeedSelection;
+		for (const auto& [id, hiSpeed] : score.hiSpeedChanges)
+			hiSpeedSelection.insert(id);
+
+		const int baseTick = TICKS_PER_BEAT;
+		const nlohmann::json data =
+		    jsonIO::noteSelectionToJson(score, selection, hiSpeedSelection, baseTick);
+		const std::string payload =
+		    selectionToClipboardPayload(score, selection, hiSpeedSelection, baseTick);
+		const std::string text = clipboardText(data, payload);
+
+		const unsigned char version[] = { 1, 0, 0, 0 };
+		if (payload.size() < sizeof(version) || memcmp(payload.data(), version, sizeof(version)))
+			throw std::runtime_error("payload does not start with a little-endian version 1");
+
+		nlohmann::json pastedJson =
+		    nlohmann::json::parse(text.substr(strlen(clipboardSignature)));
+		pastedJson.erase("binary");
+		if (pastedJson != data)
+			throw std::runtime_error("clipboard JSON differs from noteSelectionToJson");
+
+		std::string readPayload;
+		if (!readClipboardPayload(text, readPayload) || readPayload != payload)
+			throw std::runtime_error("binary payload not found in the clipboard text");
+
+		const std::string olderText = clipboardSignature + data.dump();
+		if (readClipboardPayload(olderText, readPayload))
+			throw std::runtime_error("found a binary payload in clipboard text without one");
+
+		PasteData fromJson;
+		PasteData fromBinary;
+		jsonToPasteData(data, 0, fromJson);
+		if (!binaryToPasteData(payload, 0, fromBinary))
+			throw std::runtime_error("binary payload was rejected");
+
+		expectSameItems("paste", describePaste(fromJson), describePaste(fromBinary));
+
+		if (binaryToPasteData(payload.substr(0, payload.size() - 1), 0, fromBinary) ||
+		    !fromBinary.notes.empty() || !fromBinary.hiSpeedChanges.empty())
+			throw std::runtime_error("truncated payload was pasted");
+	}
+
+	/// Random inserts, erases and lookups with editor note IDs must keep a SlotMap in step with
+	/// std::unordered_map, including through copies
+	static void checkSlotMap()
+	{
+		SlotMap<id_t, int> map;
+		std::unordered_map<id_t, int> expected;
+		std::vector<id_t> ids;
+		for (int i = 0; i < 4096; ++i)
+			ids.push_back(Note::getNextID());
+
+		std::mt19937 random(31);
+		for (int i = 0; i < 200000; ++i)
+		{
+			const id_t id = ids[random() % ids.size()];
+			switch (random() % 4)
+			{
+			case 0:
+			case 1:
+				map[id] = i;
+				expected[id] = i;
+				break;
+			case 2:
+				if (map.erase(id) != expected.erase(id))
+					throw std::runtime_error("erase of " + std::to_string(id) + " differs");
+				break;
+			default:
+				if (map.contains(id) != (expected.count(id) != 0) ||
+				    (map.contains(id) && map.at(id) != expected.at(id)))
+					throw std::runtime_error("lookup of " + std::to_string(id) + " differs");
+				break;
+			}
+
+			if (i % 50000 == 0)
+				map = SlotMap<id_t, int>(map);
+		}
+
+		if (map.size() != expected.size())
+			throw std::runtime_error("size differs");
+
+		size_t iterated = 0;
+		for (const auto& [id, value] : map)
+		{
+			auto it = expected.find(id);
+			if (it == expected.end() || it->second != value)
+				throw std::runtime_error("iterated entry " + std::to_string(id) + " differs");
+			++iterated;
+		}
+
+		if (iterated != expected.size())
+			throw std::runtime_error("iteration visited " + std::to_string(iterated) +
+			                         " entries instead of " + std::to_string(expected.size()));
+	}
+
+	/// A journal replayed over its base file must rebuild the score it recorded, although the
+	/// base file is loaded with other note IDs than the ones the journal refers to. A torn last
+	/// record must be dropped while the records before it are kept.
+	static void checkJournalReplay(const Score& score, const std::filesystem::path& directory)
+	{
+		const std::string baseFilename = IO::wideStringToMb((directory / "journal.mmws").wstring());
+		const std::string journalFilename = EditJournal::getJournalFilename(baseFilename);
+		serializeScore(score, baseFilename);
+
+		Score working = deserializeScore(baseFilename);
+		std::vector<std::string> beforeLastRecord;
+		{
+			EditJournal journal;
+			journal.checkpoint(journalFilename, baseFilename, working);
+			if (!journal.isOpen())
+				throw std::runtime_error("failed to open " + journalFilename);
+
+			// A snapshot edit that moves, erases and adds notes and changes the rest of the score
+			Score prev = working;
+			for (auto& [id, note] : working.notes)
+			{
+				if (note.getType() == NoteType::Tap)
+					note.tick += TICKS_PER_BEAT;
+			}
+
+			if (!working.holdNotes.empty())
+			{
+				const HoldNote hold = working.holdNotes.begin()->second;
+				working.notes.erase(hold.start.ID);
+				working.notes.erase(hold.end);
+				for (const HoldStep& step : hold.steps)
+					working.notes.erase(step.ID);
+				working.holdNotes.erase(hold.start.ID);
+			}
+
+			Note added(NoteType::Tap, TICKS_PER_BEAT * 2, 3, 2);
+			added.ID = Note::getNextID();
+			working.notes[added.ID] = added;
+			working.tempoChanges.push_back(Tempo(TICKS_PER_BEAT * 8, 200));
+			working.layers.push_back(Layer{ "journal" });
+			working.waypoints.push_back(Waypoint{ "journal", TICKS_PER_BEAT });
+			working.metadata.title = "journal";
+			journal.recordChange(prev, working);
+
+			// A delta edit of the remaining holds, undone and redone
+			EditTransaction transaction;
+			transaction.begin();
+			for (auto& [id, hold] : working.holdNotes)
+			{
+				transaction.touchHold(working, id);
+				working.notes.at(hold.end).lane = 0;
+				for (HoldStep& step : hold.steps)
+					step.ease = EaseType::EaseIn;
+			}
+
+			const ScoreDelta delta = transaction.commit(working);
+			journal.recordChange(delta, false);
+			delta.apply(working, true);
+			journal.recordChange(delta, true);
+			delta.apply(working, false);
+			journal.recordChange(delta, false);
+			beforeLastRecord = describeScore(working);
+
+			prev = working;
+			for (auto& [id, note] : working.notes)
+				note.width = 1;
+			journal.recordChange(prev, working);
+		}
+
+		auto replay = [&]
+		{
+			JournalContents contents;
+			if (!EditJournal::read(journalFilename, contents))
+				throw std::runtime_error("failed to read " + journalFilename);
+
+			if (contents.baseFilename != baseFilename)
+				throw std::runtime_error("journal refers to " + contents.baseFilename);
+
+			Score loaded = deserializeScore(baseFilename);
+			EditJournal::replay(contents, loaded);
+			return describeScore(loaded);
+		};
+
+		expectSameItems("replay", describeScore(working), replay());
+
+		const std::filesystem::path journalPath = IO::mbToWideStr(journalFilename);
+		std::filesystem::resize_file(journalPath, std::filesystem::file_size(journalPath) - 3);
+		expectSameItems("replay with a torn record", beforeLastRecord, replay());
+	}
+
+	static void expectSameSummary(const std::string& chart, const Score& score,
+	                              const ScoreSummary& summary)
+	{
+		ScoreSummary expected;
+		expected.metadata = score.metadata;
+		expected.holdCount = score.holdNotes.size();
+		for (const auto& [id, hold] : score.holdNotes)
+			expected.stepCount += hold.steps.size();
+
+		for (const auto& [id, note] : score.notes)
+		{
+			if (note.getType() == NoteType::Tap)
+				++expected.tapCount;
+			else if (note.getType() == NoteType::Damage)
+				++expected.damageCount;
+
+			expected.lastTick = std::max(expected.lastTick, note.tick);
+		}
+		expected.duration =
+		    accumulateDuration(expected.lastTick, TICKS_PER_BEAT, score.tempoChanges);
+
+		auto expectField = [&](bool same, const char* field)
+		{ expectSame(same, chart + " " + field); };
+
+		const ScoreMetadata& metadata = summary.metadata;
+		expectField(metadata.title == expected.metadata.title, "title");
+		expectField(metadata.artist == expected.metadata.artist, "artist");
+		expectField(metadata.author == expected.metadata.author, "author");
+		expectField(metadata.musicFile == expected.metadata.musicFile, "music file");
+		expectField(metadata.jacketFile == expected.metadata.jacketFile, "jacket file");
+		expectField(metadata.musicOffset == expected.metadata.musicOffset, "music offset");
+		expectField(metadata.laneExtension == expected.metadata.laneExtension, "lane extension");
+		expectField(summary.tapCount == expected.tapCount, "tap count");
+		expectField(summary.holdCount == expected.holdCount, "hold count");
+		expectField(summary.stepCount == expected.stepCount, "step count");
+		expectField(summary.damageCount == expected.damageCount, "damage count");
+		expectField(summary.lastTick == expected.lastTick, "last tick");
+		expectField(summary.duration == expected.duration, "duration");
+	}
+
+	/// The summary of the chart library reads score files with its own parser, which must
+	/// agree with a full load and reject the same truncated files
+	static void checkScoreSummary(const Score& score, const std::filesystem::path& directory)
+	{
+		ChartGeneratorOptions empty;
+		empty.measures = 1;
+		empty.taps = empty.damages = empty.holds = empty.guides = 0;
+		empty.tempoChanges = empty.timeSignatures = empty.hiSpeedChanges = 0;
+
+		ChartGeneratorOptions tapsOnly;
+		tapsOnly.measures = 16;
+		tapsOnly.taps = 300;
+		tapsOnly.holds = tapsOnly.guides = 0;
+		tapsOnly.seed = 3;
+
+		ChartGeneratorOptions holdsOnly;
+		holdsOnly.measures = 32;
+		holdsOnly.taps = holdsOnly.damages = 0;
+		holdsOnly.holds = 120;
+		holdsOnly.stepsPerHold = 7;
+		holdsOnly.seed = 11;
+
+		std::vector<std::pair<std::string, Score>> charts;
+		charts.emplace_back("generated", score);
+		charts.emplace_back("empty", generateChart(empty));
+		charts.emplace_back("taps only", generateChart(tapsOnly));
+		charts.emplace_back("holds only", generateChart(holdsOnly));
+
+		ScoreMetadata& metadata = charts.back().second.metadata;
+		metadata.title = "\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88";
+		metadata.musicFile = "C:/music/\xe6\x9b\xb2.mp3";
+		metadata.jacketFile = "jacket.png";
+		metadata.musicOffset = -125.5f;
+		metadata.laneExtension = 2;
+
+		const std::string filename = IO::wideStringToMb((directory / "summary.mmws").wstring());
+		for (const auto& [chart, generated] : charts)
+		{
+			serializeScore(generated, filename);
+			expectSameSummary(chart, deserializeScore(filename), readScoreSummary(filename));
+		}
+
+		// Cut inside the offset table and halfway through the notes
+		const std::filesystem::path path = IO::mbToWideStr(filename);
+		const uintmax_t fullSize = std::filesystem::file_size(path);
+		for (const uintmax_t size : { fullSize / 2, static_cast<uintmax_t>(20) })
+		{
+			std::filesystem::resize_file(path, size);
+			expectThrows("summary of a file cut to " + std::to_string(size) + " bytes",
+			             [&] { readScoreSummary(filename); });
+		}
+	}
+
+	/// Validating charts relies on loading a missing or truncated score file to throw
+	static void checkScoreFileRejectsBroken(const Score& score,
+	                                        const std::filesystem::path& directory)
+	{
+		const std::filesystem::path missing = directory / "missing.ccmmws";
+		std::filesystem::remove(missing);
+		expectThrows("loading a missing file",
+		             [&] { readScoreFile(IO::wideStringToMb(missing.wstring())); });
+
+		const std::filesystem::path path = directory / "broken.ccmmws";
+		const std::string filename = IO::wideStringToMb(path.wstring());
+		serializeScore(score, filename);
+		expectSame(readScoreFile(filename).notes.size() == score.notes.size(), "note count");
+
+		// Cut halfway through the notes and inside the waypoints at the end
+		const uintmax_t fullSize = std::filesystem::file_size(path);
+		for (const uintmax_t size : { fullSize / 2, fullSize - 3 })
+		{
+			std::filesystem::resize_file(path, size);
+			expectThrows("loading a file cut to " + std::to_string(size) + " bytes",
+			             [&] { readScoreFile(filename); });
+		}
+	}
+
+	/// Touching entities without changing them must not leave an entry in the history
+	static void checkHistoryEmptyTransaction(const Score& score)
+	{
+		Score working = score;
+		HistoryManager history;
+		EditTransaction transaction;
+		transaction.begin();
+		for (const auto& [id, note] : working.notes)
+			transaction.touchNote(working, id);
+		for (const auto& [id, hold] : working.holdNotes)
+			transaction.touchHold(working, id);
+		transaction.touchTempoChanges(working);
+		transaction.touchTimeSignatures(working);
+
+		ScoreDelta delta = transaction.commit(working);
+		if (!delta.isEmpty())
+			throw std::runtime_error("unchanged transaction produced a delta");
+
+		history.pushHistory("nothing", std::move(delta));
+		if (history.hasUndo())
+			throw std::runtime_error("empty delta was pushed onto the history");
+
+		if (working.notes.empty())
+			return;
+
+		transaction.begin();
+		const id_t movedID = working.notes.begin()->first;
+		for (const auto& [id, note] : working.notes)
+			transaction.touchNote(working, id);
+		working.notes.at(movedID).tick += TICKS_PER_BEAT;
+
+		delta = transaction.commit(working);
+		if (delta.notes.size() != 1 || delta.notes[0].id != movedID)
+			throw std::runtime_error("expected only the moved note in the delta, got " +
+			                         std::to_string(delta.notes.size()) + " notes");
+	}
+
+	/// Records what the cache draws instead of rendering it
+	class CountingTileBackend : public TileBackend
+	{
+	  public:
+		std::vector<size_t> renderedSlots;
+		size_t slotCount{};
+
+		void resize(size_t slot, int, int) override
+		{
+			slotCount = std::max(slotCount, slot + 1);
+		}
+
+		void render(size_t slot, ImDrawList*, int, int) override
+		{
+			if (slot >= slotCount)
+				throw std::runtime_error("rendered a slot that was never resized");
+
+			renderedSlots.push_back(slot);
+		}
+
+		ImTextureID getTexture(size_t slot) const override
+		{
+			return reinterpret_cast<ImTextureID>(slot + 1);
+		}
+	};
+
+	static void checkTileCache()
+	{
+		struct ImGuiContextScope
+		{
+			ImGuiContextScope() { ImGui::CreateContext(); }
+			~ImGuiContextScope() { ImGui::DestroyContext(); }
+		} contextScope;
+
+		auto backendPtr = std::make_unique<CountingTileBackend>();
+		CountingTileBackend& backend = *backendPtr;
+		TileCache cache(std::move(backendPtr), 64);
+
+		std::vector<int> drawn;
+		size_t renderCount = 0;
+		auto draw = [&](ImDrawList* drawList, int index)
+		{
+			drawList->AddRectFilled({ 0.0f, 0.0f }, { 16.0f, 16.0f }, IM_COL32_WHITE);
+			drawn.push_back(index);
+		};
+
+		auto expectDrawn = [&](const std::vector<int>& expected, const char* step)
+		{
+			if (drawn != expected)
+				throw std::runtime_error(IO::formatString("%s: drew %zu tiles, expected %zu", step,
+				                                          drawn.size(), expected.size()));
+
+			if (backend.renderedSlots.size() != drawn.size() ||
+			    cache.getRenderCount() - renderCount != drawn.size())
+				throw std::runtime_error(std::string(step) + ": render count mismatch");
+
+			drawn.clear();
+			backend.renderedSlots.clear();
+			renderCount = cache.getRenderCount();
+		};
+
+		cache.validate(1, 100);
+		cache.update(0, 3, draw);
+		expectDrawn({ 0, 1, 2, 3 }, "first frame");
+
+		cache.update(0, 3, draw);
+		expectDrawn({}, "same frame");
+
+		cache.update(1, 4, draw);
+		expectDrawn({ 4 }, "scroll by one tile");
+
+		cache.update(0, 3, draw);
+		expectDrawn({}, "scroll back");
+
+		std::vector<ImTextureID> textures;
+		for (int index = 0; index <= 3; ++index)
+		{
+			ImTextureID texture = cache.getTexture(index);
+			if (texture == nullptr || std::find(textures.begin(), textures.end(), texture) !=
+			                              textures.end())
+				throw std::runtime_error("visible tiles do not have distinct textures");
+
+			textures.push_back(texture);
+		}
+
+		cache.validate(1, 100);
+		cache.update(0, 3, draw);
+		expectDrawn({}, "same key");
+
+		cache.validate(2, 100);
+		cache.update(0, 3, draw);
+		expectDrawn({ 0, 1, 2, 3 }, "key change");
+
+		cache.validate(2, 120);
+		cache.update(0, 3, draw);
+		expectDrawn({ 0, 1, 2, 3 }, "width change");
+	}
+
+	/// Three box blur passes over the rows and then the columns, one pixel and channel at a time
+	static ImageData naiveBoxBlur(const ImageData& image, int radius)
+	{
+		const int width = image.width;
+		const int height = image.height;
+		const float scale = 1.0f / (radius * 2 + 1);
+		ImageData result = image;
+		std::vector<uint8_t> buffer(image.pixels.size());
+		for (int pass = 0; pass < 3; ++pass)
+		{
+			for (int y = 0; y < height; ++y)
+			{
+				for (int x = 0; x < width; ++x)
+				{
+					for (int c = 0; c < 4; ++c)
+					{
+						int sum = 0;
+						for (int i = -radius; i <= radius; ++i)
+						{
+							const int sx = std::clamp(x + i, 0, width - 1);
+							sum += result.pixels[(y * width + sx) * 4 + c];
+						}
+
+						buffer[(y * width + x) * 4 + c] = static_cast<uint8_t>(sum * scale + 0.5f);
+					}
+				}
+			}
+
+			for (int y = 0; y < height; ++y)
+			{
+				for (int x = 0; x < width; ++x)
+				{
+					for (int c = 0; c < 4; ++c)
+					{
+						int sum = 0;
+						for (int i = -radius; i <= radius; ++i)
+						{
+							const int sy = std::clamp(y + i, 0, height - 1);
+							sum += buffer[(sy * width + x) * 4 + c];
+						}
+
+						result.pixels[(y * width + x) * 4 + c] =
+						    static_cast<uint8_t>(sum * scale + 0.5f);
+					}
+				}
+			}
+		}
+
+		return result;
+	}
+
+	static void checkBoxBlur()
+	{
+		JobSystemScope jobSystemScope(2);
+
+		// Odd sizes, images wider and taller than one job, and radii larger than the image
+		struct BlurCase
+		{
+			int width;
+			int height;
+			int radius;
+		};
+		const BlurCase cases[] = { { 1, 1, 1 },   { 3, 5, 1 },    { 5, 3, 20 },
+			                       { 37, 29, 2 }, { 70, 33, 7 },  { 129, 65, 3 },
+			                       { 2, 97, 5 },  { 97, 2, 40 } };
+
+		std::mt19937 random{ 47 };
+		std::uniform_int_distribution<int> channel{ 0, 255 };
+		for (const BlurCase& blurCase : cases)
+		{
+			ImageData image;
+			image.width = blurCase.width;
+			image.height = blurCase.height;
+			image.pixels.resize(static_cast<size_t>(image.width) * image.height * 4);
+			for (uint8_t& value : image.pixels)
+				value = static_cast<uint8_t>(channel(random));
+
+			const ImageData expected = naiveBoxBlur(image, blurCase.radius);
+			blurImage(image, blurCase.radius);
+
+			// The SIMD path rounds halves to even, so allow one step of difference
+			for (size_t i = 0; i < image.pixels.size(); ++i)
+			{
+				if (std::abs(image.pixels[i] - expected.pixels[i]) > 1)
+					throw std::runtime_error(IO::formatString(
+					    "%dx%d radius %d: pixel (%zu, %zu) channel %zu is %d, expected %d",
+					    blurCase.width, blurCase.height, blurCase.radius, i / 4 % image.width,
+					    i / 4 / image.width, i % 4, image.pixels[i], expected.pixels[i]));
+			}
+		}
+
+		// Extending the edges keeps a solid image unchanged, a zero border would darken it
+		ImageData solid;
+		solid.width = 41;
+		solid.height = 17;
+		solid.pixels.resize(static_cast<size_t>(solid.width) * solid.height * 4);
+		for (size_t i = 0; i < solid.pixels.size(); i += 4)
+		{
+			solid.pixels[i + 0] = 200;
+			solid.pixels[i + 1] = 100;
+			solid.pixels[i + 2] = 50;
+			solid.pixels[i + 3] = 255;
+		}
+
+		const std::vector<uint8_t> original = solid.pixels;
+		blurImage(solid, 9);
+		if (solid.pixels != original)
+			throw std::runtime_error("blurring a solid image changed its edges");
+	}
+
+	/// Polls condition without running queued jobs, so only the workers make progress
+	static void waitUntil(const std::function<bool()>& condition, const std::string& what)
+	{
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (!condition())
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+				throw std::runtime_error("timed out waiting for " + what);
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	/// Keeps a worker busy until released, so the jobs queued meanwhile stay in the queues
+	class WorkerGate
+	{
+	  private:
+		std::atomic<bool> started{};
+		std::atomic<bool> released{};
+		JobGroup group;
+
+	  public:
+		WorkerGate()
+		{
+			JobSystem::schedule(
+			    [this]
+			    {
+				    started = true;
+				    const auto deadline =
+				        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+				    while (!released && std::chrono::steady_clock::now() < deadline)
+					    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			    },
+			    JobPriority::High, &group);
+			waitUntil([this] { return started.load(); }, "the gate job to start");
+		}
+
+		~WorkerGate()
+		{
+			release();
+			while (!group.isDone())
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		void release() { released = true; }
+	};
+
+	/// Jobs scheduled by a worker go to its own queue, so while it is busy another worker has to
+	/// steal them
+	static void checkJobStealing()
+	{
+		JobSystemScope jobSystemScope(2);
+
+		constexpr size_t jobCount = 16;
+		std::mutex threadsMutex;
+		std::vector<std::thread::id> threads;
+		std::thread::id owner;
+		JobGroup outer;
+		JobGroup inner;
+		JobSystem::schedule(
+		    [&]
+		    {
+			    owner = std::this_thread::get_id();
+			    for (size_t i = 0; i < jobCount; ++i)
+				    JobSystem::schedule(
+				        [&]
+				        {
+					        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					        std::lock_guard lock{ threadsMutex };
+					        threads.push_back(std::this_thread::get_id());
+				        },
+				        JobPriority::Normal, &inner);
+
+			    // Stay busy without helping, the jobs can only run on the other worker
+			    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+			    while (!inner.isDone() && std::chrono::steady_clock::now() < deadline)
+				    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		    },
+		    JobPriority::Normal, &outer);
+
+		waitUntil([&] { return outer.isDone() && inner.isDone(); }, "the jobs");
+		outer.wait();
+
+		if (threads.size() != jobCount)
+			throw std::runtime_error(
+			    IO::formatString("%zu of %zu jobs ran", threads.size(), jobCount));
+
+		if (std::count(threads.begin(), threads.end(), owner) != 0)
+			throw std::runtime_error("the busy worker ran its own queued jobs");
+	}
+
+	/// Workers take the most urgent job first, and a wait only helps with jobs at least as urgent
+	/// as those of its group
+	static void checkJobPriorities()
+	{
+		JobSystemScope jobSystemScope(1);
+
+		std::mutex orderMutex;
+		std::vector<JobPriority> order;
+		auto record = [&](JobPriority priority)
+		{
+			std::lock_guard lock{ orderMutex };
+			order.push_back(priority);
+		};
+
+		{
+			WorkerGate gate;
+			JobGroup group;
+			const JobPriority priorities[] = { JobPriority::Low, JobPriority::Normal,
+				                               JobPriority::High };
+			for (JobPriority priority : priorities)
+				JobSystem::schedule([&record, priority] { record(priority); }, priority, &group);
+
+			gate.release();
+			waitUntil([&] { return group.isDone(); }, "the prioritized jobs");
+		}
+
+		const std::vector<JobPriority> expected = { JobPriority::High, JobPriority::Normal,
+			                                        JobPriority::Low };
+		if (order != expected)
+			throw std::runtime_error("jobs did not run from the most to the least urgent");
+
+		WorkerGate gate;
+		std::atomic<bool> lowRan{};
+		JobGroup lowGroup;
+		JobSystem::schedule([&] { lowRan = true; }, JobPriority::Low, &lowGroup);
+
+		std::thread::id highThread;
+		JobGroup highGroup;
+		JobSystem::schedule([&] { highThread = std::this_thread::get_id(); }, JobPriority::High,
+		                    &highGroup);
+
+		// The only worker is held by the gate, so the wait has to run the urgent job itself
+		highGroup.wait();
+		if (highThread != std::this_thread::get_id())
+			throw std::runtime_error("the waiting thread did not run the job of its group");
+		if (lowRan)
+			throw std::runtime_error("waiting for urgent jobs ran a less urgent one");
+
+		gate.release();
+		waitUntil([&] { return lowGroup.isDone(); }, "the low priority job");
+	}
+
+	/// A job cancelled before it starts is dropped but still finishes its group, and a running
+	/// job sees the cancellation
+	static void checkJobCancellation()
+	{
+		JobSystemScope jobSystemScope(1);
+
+		std::atomic<bool> droppedRan{};
+		JobGroup group;
+		{
+			WorkerGate gate;
+			CancellationToken token;
+			JobSystem::schedule([&] { droppedRan = true; }, JobPriority::Normal, token, &group);
+			token.cancel();
+		}
+
+		waitUntil([&] { return group.isDone(); }, "the cancelled job to finish its group");
+		if (droppedRan)
+			throw std::runtime_error("a job cancelled before it started ran");
+
+		std::atomic<bool> running{};
+		std::atomic<bool> sawCancel{};
+		CancellationToken token;
+		JobSystem::schedule(
+		    [&, token]
+		    {
+			    running = true;
+			    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+			    while (!token.isCancelled() && std::chrono::steady_clock::now() < deadline)
+				    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			    sawCancel = token.isCancelled();
+		    },
+		    JobPriority::Normal, token, &group);
+
+		waitUntil([&] { return running.load(); }, "the job to start");
+		token.cancel();
+		waitUntil([&] { return group.isDone(); }, "the running job to return");
+		if (!sawCancel)
+			throw std::runtime_error("a running job did not see its cancellation");
+	}
+
+	/// JobGroup::wait rethrows the exception of a failed job once the others are done. A job
+	/// with no group or token only logs its exception.
+	static void checkJobExceptions()
+	{
+		{
+			JobSystemScope jobSystemScope(2);
+
+			constexpr int jobCount = 32;
+			std::atomic<int> finished{};
+			JobGroup group;
+			for (int i = 0; i < jobCount; ++i)
+				JobSystem::schedule(
+				    [&finished, i]
+				    {
+					    if (i == jobCount / 2)
+						    throw std::runtime_error("job failed");
+
+					    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					    ++finished;
+				    },
+				    JobPriority::Normal, &group);
+
+			std::string message;
+			try
+			{
+				group.wait();
+			}
+			catch (const std::runtime_error& error)
+			{
+				message = error.what();
+			}
+
+			if (message != "job failed")
+				throw std::runtime_error("wait did not rethrow the exception of the failed job");
+			if (finished != jobCount - 1)
+				throw std::runtime_error("wait returned before the other jobs finished");
+
+			// The exception is reported once
+			group.wait();
+
+			CancellationToken token;
+			JobSystem::schedule([] { throw std::runtime_error("token job failed"); },
+			                    JobPriority::Normal, token);
+			waitUntil([&] { return token.getException() != nullptr; },
+			          "the token to get the exception");
+		}
+
+		// Without workers the job runs on the calling thread, like in the command line tools
+		bool ran = false;
+		JobSystem::schedule(
+		    [&ran]
+		    {
+			    ran = true;
+			    throw std::runtime_error("expected by the check, nobody waits for this job");
+		    });
+
+		if (!ran)
+			throw std::runtime_error("without workers the job did not run right away");
+
+		// An exception rethrown here would take down the editor's main loop
+		JobSystem::drainMainThread();
+	}
+
+	/// Builds a graph where each task depends on up to three earlier ones and runs it twice. Every
+	/// task has to start after its dependencies ended, and Main tasks run on the calling thread.
+	static void checkTaskGraphOrdering()
+	{
+		JobSystemScope jobSystemScope(2);
+
+		constexpr size_t taskCount = 120;
+		std::mt19937 random(17);
+		std::vector<std::vector<TaskGraph::TaskID>> dependencies(taskCount);
+		std::vector<TaskThread> threads(taskCount);
+		std::vector<std::atomic<size_t>> runs(taskCount);
+		std::vector<size_t> starts(taskCount);
+		std::vector<size_t> ends(taskCount);
+		std::vector<std::thread::id> threadIds(taskCount);
+		std::vector<int> sleeps(taskCount);
+		std::atomic<size_t> clock{};
+
+		TaskGraph graph;
+		for (size_t i = 0; i < taskCount; ++i)
+		{
+			threads[i] = random() % 3 == 0 ? TaskThread::Main : TaskThread::Worker;
+			sleeps[i] = random() % 200;
+			for (size_t n = random() % 4; i > 0 && n > 0; --n)
+			{
+				const TaskGraph::TaskID dependency = random() % i;
+				if (std::find(dependencies[i].begin(), dependencies[i].end(), dependency) ==
+				    dependencies[i].end())
+					dependencies[i].push_back(dependency);
+			}
+
+			graph.add(IO::formatString("task %zu", i), threads[i],
+			          [&, i]
+			          {
+				          starts[i] = clock++;
+				          threadIds[i] = std::this_thread::get_id();
+				          std::this_thread::sleep_for(std::chrono::microseconds(sleeps[i]));
+				          ++runs[i];
+				          ends[i] = clock++;
+			          },
+			          dependencies[i]);
+		}
+
+		for (size_t run = 1; run <= 2; ++run)
+		{
+			graph.run();
+			for (size_t i = 0; i < taskCount; ++i)
+			{
+				if (runs[i] != run)
+					throw std::runtime_error(IO::formatString("task %zu ran %zu times in %zu runs",
+					                                          i, runs[i].load(), run));
+
+				for (TaskGraph::TaskID dependency : dependencies[i])
+				{
+					if (ends[dependency] > starts[i])
+						throw std::runtime_error(IO::formatString(
+						    "task %zu started before its dependency %zu ended", i, dependency));
+				}
+
+				if (threads[i] == TaskThread::Main && threadIds[i] != std::this_thread::get_id())
+					throw std::runtime_error(
+					    IO::formatString("main task %zu ran on another thread", i));
+			}
+		}
+	}
+
+	/// Main tasks that depend on worker tasks and the other way around run on the calling thread,
+	/// with and without workers
+	static void checkTaskGraphMainThread()
+	{
+		auto runChain = [](const std::string& what)
+		{
+			const std::thread::id caller = std::this_thread::get_id();
+			std::vector<std::thread::id> mainThreads;
+			TaskGraph graph;
+			TaskGraph::TaskID previous = 0;
+			for (size_t i = 0; i < 8; ++i)
+			{
+				const TaskThread thread = i % 2 == 0 ? TaskThread::Worker : TaskThread::Main;
+				std::function<void()> function = [] {};
+				if (thread == TaskThread::Main)
+					function = [&] { mainThreads.push_back(std::this_thread::get_id()); };
+
+				std::vector<TaskGraph::TaskID> dependencies;
+				if (i > 0)
+					dependencies.push_back(previous);
+				previous =
+				    graph.add(IO::formatString("link %zu", i), thread, function, dependencies);
+			}
+
+			graph.run();
+			if (mainThreads.size() != 4)
+				throw std::runtime_error(IO::formatString("%zu of 4 main tasks ran %s",
+				                                          mainThreads.size(), what.c_str()));
+			if (std::count(mainThreads.begin(), mainThreads.end(), caller) != 4)
+				throw std::runtime_error("a main task ran on another thread " + what);
+		};
+
+		{
+			JobSystemScope jobSystemScope(2);
+			runChain("with workers");
+		}
+
+		// The command line tools run without workers, worker tasks then run inline
+		runChain("without workers");
+	}
+
+	/// A failed task skips the tasks that depend on it, directly or not, while the others still
+	/// run. run rethrows the exception once everything finished, and the next run starts over.
+	static void checkTaskGraphExceptions()
+	{
+		JobSystemScope jobSystemScope(2);
+
+		std::atomic<bool> fail{ true };
+		std::mutex ranMutex;
+		std::vector<std::string> ran;
+		TaskGraph graph;
+		auto add = [&](const std::string& name, TaskThread thread,
+		               const std::vector<TaskGraph::TaskID>& dependencies)
+		{
+			return graph.add(
+			    name, thread,
+			    [&, name]
+			    {
+				    if (name == "decode" && fail)
+					    throw std::runtime_error("decode failed");
+
+				    std::lock_guard lock{ ranMutex };
+				    ran.push_back(name);
+			    },
+			    dependencies);
+		};
+
+		const TaskGraph::TaskID decode = add("decode", TaskThread::Worker, {});
+		const TaskGraph::TaskID upload = add("upload", TaskThread::Main, { decode });
+		const TaskGraph::TaskID read = add("read", TaskThread::Worker, {});
+		add("atlas", TaskThread::Worker, { upload });
+		add("finish", TaskThread::Main, { upload, read });
+		add("other", TaskThread::Main, { read });
+
+		std::string message;
+		try
+		{
+			graph.run();
+		}
+		catch (const std::runtime_error& error)
+		{
+			message = error.what();
+		}
+
+		if (message != "decode failed")
+			throw std::runtime_error("run did not rethrow the exception of the failed task");
+
+		std::sort(ran.begin(), ran.end());
+		if (ran != std::vector<std::string>{ "other", "read" })
+			throw std::runtime_error("tasks depending on the failed one ran, or others did not");
+
+		for (const TaskTiming& timing : graph.getTimings())
+		{
+			const bool expected = timing.name != "decode" && timing.name != "read" &&
+			                      timing.name != "other";
+			if (timing.skipped != expected)
+				throw std::runtime_error("the timings of " + timing.name +
+				                         (expected ? " are not" : " are") + " marked skipped");
+		}
+
+		fail = false;
+		ran.clear();
+		graph.run();
+		if (ran.size() != 6)
+			throw std::runtime_error(
+			    IO::formatString("%zu of 6 tasks ran after the failure was fixed", ran.size()));
+	}
+
+	static bool rangesContain(const ImVector<ImWchar>& ranges, ImWchar c)
+	{
+		for (int i = 0; i + 1 < ranges.Size && ranges[i]; i += 2)
+		{
+			if (c >= ranges[i] && c <= ranges[i + 1])
+				return true;
+		}
+
+		return false;
+	}
+
+	/// Requested characters become resident once, mark the cache dirty until the ranges are
+	/// rebuilt, and show up in those ranges. Text is decoded as UTF-8 within its view only.
+	static void checkGlyphCache()
+	{
+		ImVector<ImWchar> ranges;
+		GlyphCache::buildRanges(ranges);
+		if (GlyphCache::isDirty())
+			throw std::runtime_error("the cache is dirty right after building its ranges");
+		if (!rangesContain(ranges, 'A') || !rangesContain(ranges, 0x00E9) ||
+		    !rangesContain(ranges, 0xFFFD))
+			throw std::runtime_error("the default ranges are not resident");
+
+		const size_t defaultCount = GlyphCache::getResidentCount();
+		GlyphCache::request("Latin text, caf\xC3\xA9\n\t");
+		if (GlyphCache::isDirty() || GlyphCache::getResidentCount() != defaultCount)
+			throw std::runtime_error("requesting resident characters changed the cache");
+
+		// The view ends inside the second character, which must not be read
+		const std::string text = "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E";
+		GlyphCache::request(std::string_view(text.data(), 4));
+		if (!GlyphCache::isDirty())
+			throw std::runtime_error("requesting a new character did not mark the cache dirty");
+		if (GlyphCache::getResidentCount() != defaultCount + 1)
+			throw std::runtime_error(IO::formatString(
+			    "%zu characters became resident, expected 1",
+			    GlyphCache::getResidentCount() - defaultCount));
+
+		GlyphCache::request(text);
+		GlyphCache::buildRanges(ranges);
+		if (GlyphCache::isDirty())
+			throw std::runtime_error("building the ranges did not clear the dirty flag");
+		for (ImWchar c : { 0x65E5, 0x672C, 0x8A9E })
+		{
+			if (!rangesContain(ranges, c))
+				throw std::runtime_error(IO::formatString("U+%04X is not in the ranges", c));
+		}
+		if (rangesContain(ranges, 0x65E6) || GlyphCache::getResidentCount() != defaultCount + 3)
+			throw std::runtime_error("the ranges hold characters that were not requested");
+
+		// Invalid and truncated sequences and characters beyond the font's range become the
+		// replacement character, which is resident
+		GlyphCache::request("\xFF\xE6\x97 \xF0\x9F\x8E\xB5 \xE6");
+		if (GlyphCache::isDirty())
+			throw std::runtime_error("invalid UTF-8 made characters resident");
+
+		// Languages are requested along with their fallback, across the null separators
+		Language fallback("en", LanguageEntries{ { "a", "\xE9\x9F\xB3" }, { "b", "x" } });
+		Language language("ja", LanguageEntries{ { "b", "\xE6\xA5\xBD" } });
+		language.resolve(&fallback);
+		GlyphCache::request(language);
+		GlyphCache::buildRanges(ranges);
+		if (!rangesContain(ranges, 0x97F3) || !rangesContain(ranges, 0x697D))
+			throw std::runtime_error("the strings of a language or its fallback are missing");
+	}
+
+	void runChecks(CheckRunner& runner, const Score& score, const std::filesystem::path& directory)
+	{
+		runner.run("sus.parallelParse", [&] { checkSusParallelParse(score, directory); });
+		runner.run("usc.streamImport", [&] { checkUscStreamImport(score); });
+		runner.run("usc.rejectsVersion", checkUscRejectsVersion);
+		runner.run("clipboard.binaryPaste", [&] { checkClipboard(score); });
+		runner.run("slotmap.randomOps", checkSlotMap);
+		runner.run("journal.replay", [&] { checkJournalReplay(score, directory); });
+		runner.run("mmws.summary", [&] { checkScoreSummary(score, directory); });
+		runner.run("mmws.rejectsBroken", [&] { checkScoreFileRejectsBroken(score, directory); });
+		runner.run("history.emptyTransaction", [&] { checkHistoryEmptyTransaction(score); });
+		runner.run("tiles.cache", checkTileCache);
+		runner.run("blur.boxBlur", checkBoxBlur);
+		runner.run("jobs.stealing", checkJobStealing);
+		runner.run("jobs.priorities", checkJobPriorities);
+		runner.run("jobs.cancellation", checkJobCancellation);
+		runner.run("jobs.exceptions", checkJobExceptions);
+		runner.run("tasks.ordering", checkTaskGraphOrdering);
+		runner.run("tasks.mainThread", checkTaskGraphMainThread);
+		runner.run("tasks.exceptions", checkTaskGraphExceptions);
+		runner.run("glyphs.cache", checkGlyphCache);
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "Score.h"
+#include <filesystem>
+#include <functional>
+#include <string>
+
+namespace MikuMikuWorld
+{
+	/// Runs named checks and counts the failed ones. A check fails by throwing, the message of
+	/// the exception is printed next to its name.
+	class CheckRunner
+	{
+	  private:
+		std::string filter;
+		int passed{};
+		int failed{};
+
+	  public:
+		using Check = std::function<void()>;
+
+		CheckRunner(std::string filter);
+
+		/// Runs the check unless its name does not contain the filter
+		void run(const std::string& name, const Check& check);
+
+		int getPassed() const { return passed; }
+		int getFailed() const { return failed; }
+	};
+
+	/// Compares the optimized code paths against simpler reference implementations on the
+	/// generated chart. directory is used for the files the checks write.
+	void runChecks(CheckRunner& runner, const Score& score, const std::filesystem::path& directory);
+}
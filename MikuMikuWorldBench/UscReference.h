@@ -0,0 +1,10 @@
+#pragma once
+#include "JsonIO.h"
+#include "Score.h"
+
+namespace MikuMikuWorld
+{
+	/// The USC import as it was before ScoreConverter::uscToScore streamed the file, converting
+	/// a whole json document. Kept as the reference for the streaming import.
+	Score uscToScoreReference(const nlohmann::json& vusc);
+}
@@ -0,0 +1,440 @@
+#include "BenchmarkRunner.h"
+#include "ChartGenerator.h"
+#include "Checks.h"
+#include "HistoryManager.h"
+#include "IO.h"
+#include "JobSystem.h"
+#include "JsonIO.h"
+#include "NoteClipboard.h"
+#include "SUS.h"
+#include "ScoreConverter.h"
+#include "ScoreFile.h"
+#include "ScoreStats.h"
+#include "SlotMap.h"
+#include "SusExporter.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace MikuMikuWorld;
+using nlohmann::json;
+
+// Results are stored here so the compiler cannot drop the timed work
+static volatile size_t sink;
+
+struct CommandLineOptions
+{
+	ChartGeneratorOptions chart{};
+	int iterations{ 10 };
+	std::string filter;
+	std::string outputFilename;
+	bool check{};
+};
+
+static void printUsage(const char* program)
+{
+	printf("Usage: %s [options]\n"
+	       "Times core score operations on a generated chart. The results are written as JSON to\n"
+	       "stdout or --output, and a table is printed to stderr.\n\n"
+	       "Chart options:\n"
+	       "  --measures <n>         Length of the chart (default 200)\n"
+	       "  --taps <n>             Tap notes (default 2000)\n"
+	       "  --damages <n>          Damage notes (default 100)\n"
+	       "  --holds <n>            Hold notes (default 400)\n"
+	       "  --steps <n>            Steps per hold and guide (default 4)\n"
+	       "  --guides <n>           Guides (default 100)\n"
+	       "  --tempos <n>           Tempo changes (default 20)\n"
+	       "  --time-signatures <n>  Time signature changes (default 10)\n"
+	       "  --hispeeds <n>         Hi-speed changes (default 50)\n"
+	       "  --layers <n>           Layers the notes and hi-speeds are spread over (default 2)\n"
+	       "  --seed <n>             Random seed (default 39)\n\n"
+	       "Run options:\n"
+	       "  --iterations <n>       Timed runs of each benchmark (default 10)\n"
+	       "  --filter <text>        Only run benchmarks whose name contains text\n"
+	       "  --output <file>        Write the JSON results to file instead of stdout\n"
+	       "  --check                Compare the optimized code paths against their reference\n"
+	       "                         implementations instead of timing them, exits with 1 if any\n"
+	       "                         check fails\n",
+	       program);
+}
+
+static bool parseCommandLine(int argc, char** argv, CommandLineOptions& options)
+{
+	ChartGeneratorOptions& chart = options.chart;
+	const std::pair<const char*, int*> counts[] = {
+		{ "--measures", &chart.measures },
+		{ "--taps", &chart.taps },
+		{ "--damages", &chart.damages },
+		{ "--holds", &chart.holds },
+		{ "--steps", &chart.stepsPerHold },
+		{ "--guides", &chart.guides },
+		{ "--tempos", &chart.tempoChanges },
+		{ "--time-signatures", &chart.timeSignatures },
+		{ "--hispeeds", &chart.hiSpeedChanges },
+		{ "--layers", &chart.layers },
+		{ "--iterations", &options.iterations },
+	};
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--check")
+		{
+			options.check = true;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+			return false;
+
+		const char* value = argv[++i];
+		auto count = std::find_if(std::begin(counts), std::end(counts),
+		                          [&](const auto& option) { return arg == option.first; });
+		if (count != std::end(counts))
+			*count->second = std::max(atoi(value), 0);
+		else if (arg == "--seed")
+			chart.seed = strtoul(value, nullptr, 10);
+		else if (arg == "--filter")
+			options.filter = value;
+		else if (arg == "--output")
+			options.outputFilename = value;
+		else
+			return false;
+	}
+
+	return true;
+}
+
+static json chartToJson(const ChartGeneratorOptions& chart, const Score& score)
+{
+	return { { "measures", chart.measures },
+		     { "taps", chart.taps },
+		     { "damages", chart.damages },
+		     { "holds", chart.holds },
+		     { "steps_per_hold", chart.stepsPerHold },
+		     { "guides", chart.guides },
+		     { "tempo_changes", chart.tempoChanges },
+		     { "time_signatures", chart.timeSignatures },
+		     { "hispeed_changes", chart.hiSpeedChanges },
+		     { "layers", chart.layers },
+		     { "seed", chart.seed },
+		     { "total_notes", score.notes.size() } };
+}
+
+static void runBenchmarks(BenchmarkRunner& runner, const CommandLineOptions& options,
+                          const Score& score, const std::filesystem::path& directory)
+{
+	const std::string mmwsFilename = IO::wideStringToMb((directory / "chart.ccmmws").wstring());
+	const std::string susFilename = IO::wideStringToMb((directory / "chart.sus").wstring());
+	const int lastTick = options.chart.measures * TICKS_PER_BEAT * 4;
+
+	runner.run("chart.generate", [&] { sink = generateChart(options.chart).notes.size(); });
+
+	// Every read benchmark takes the output of a write benchmark, which is also produced up front
+	// so that a filtered run reads the chart instead of a missing file
+	auto serializeMmws = [&] { serializeScore(score, mmwsFilename); };
+	serializeMmws();
+	runner.run("mmws.serialize", serializeMmws);
+	runner.run("mmws.deserialize", [&] { sink = deserializeScore(mmwsFilename).notes.size(); });
+	runner.run("mmws.summary", [&] { sink = readScoreSummary(mmwsFilename).tapCount; });
+
+	auto exportSus = [&]
+	{
+		SusExporter exporter;
+		exporter.dump(ScoreConverter::scoreToSus(score), susFilename);
+	};
+	exportSus();
+	runner.run("sus.export", exportSus);
+
+	// Through readScoreFile like the editor, the parser alone reads a missing file as empty
+	runner.run("sus.parse", [&] { sink = readScoreFile(susFilename).notes.size(); });
+
+	std::string usc;
+	auto exportUsc = [&]
+	{
+		std::ostringstream stream;
+		ScoreConverter::scoreToUsc(score, stream);
+		usc = stream.str();
+	};
+	exportUsc();
+	runner.run("usc.export", exportUsc);
+	runner.run("usc.import",
+	           [&]
+	           {
+		           std::istringstream stream(usc);
+		           sink = ScoreConverter::uscToScore(stream).notes.size();
+	           });
+
+	runner.run("stats.calculate",
+	           [&]
+	           {
+		           ScoreStats stats;
+		           stats.calculateStats(score);
+		           sink = stats.getTotal();
+	           });
+
+	// Sample the whole chart so every tempo segment is visited
+	constexpr int samples = 10000;
+	runner.run("tempo.accumulateDuration",
+	           [&]
+	           {
+		           float total = 0;
+		           for (int i = 0; i < samples; ++i)
+			           total += accumulateDuration(static_cast<int>((int64_t)lastTick * i / samples),
+			                                       TICKS_PER_BEAT, score.tempoChanges);
+		           sink = static_cast<size_t>(total);
+	           });
+
+	const float duration = accumulateDuration(lastTick, TICKS_PER_BEAT, score.tempoChanges);
+	runner.run("tempo.accumulateTicks",
+	           [&]
+	           {
+		           size_t total = 0;
+		           for (int i = 0; i < samples; ++i)
+			           total += accumulateTicks(duration * i / samples, TICKS_PER_BEAT,
+			                                    score.tempoChanges);
+		           sink = total;
+	           });
+
+	// Both history benchmarks push one edit and undo it on a fresh copy of the chart
+	Score working;
+	HistoryManager history;
+	auto resetHistory = [&]
+	{
+		working = score;
+		history.clear();
+	};
+
+	runner.run(
+	    "history.snapshot",
+	    [&]
+	    {
+		    Score prev = working;
+		    for (auto& [id, note] : working.notes)
+			    note.tick += TICKS_PER_BEAT;
+
+		    history.pushHistory("move", prev, working);
+		    history.undo(working);
+	    },
+	    resetHistory);
+
+	runner.run(
+	    "history.delta",
+	    [&]
+	    {
+		    EditTransaction transaction;
+		    transaction.begin();
+		    for (auto& [id, note] : working.notes)
+		    {
+			    transaction.touchNote(working, id);
+			    note.tick += TICKS_PER_BEAT;
+		    }
+
+		    history.pushHistory("move", transaction.commit(working));
+		    history.undo(working);
+	    },
+	    resetHistory);
+
+	// The copy side is what ScoreContext::copySelection does. The JSON paste is what older
+	// builds and text from other tools take, the binary paste is the one this build takes.
+	NoteSelection selection(score);
+	selection.selectAll();
+	std::unordered_set<MikuMikuWorld::id_t> hiSpeedSelection;
+	for (const auto& [id, hiSpeed] : score.hiSpeedChanges)
+		hiSpeedSelection.insert(id);
+
+	std::string clipboard;
+	auto copySelection = [&]
+	{
+		const std::string payload =
+		    selectionToClipboardPayload(score, selection, hiSpeedSelection, 0);
+		clipboard = clipboardText(
+		    jsonIO::noteSelectionToJson(score, selection, hiSpeedSelection, 0), payload);
+	};
+	copySelection();
+	runner.run("clipboard.copy", copySelection);
+
+	PasteData pasteData;
+	runner.run("clipboard.pasteJson",
+	           [&]
+	           {
+		           jsonToPasteData(json::parse(clipboard.substr(strlen(clipboardSignature))), 0,
+		                           pasteData);
+		           sink = pasteData.notes.size();
+	           });
+
+	runner.run("clipboard.pasteBinary",
+	           [&]
+	           {
+		           std::string payload;
+		           if (!readClipboardPayload(clipboard, payload) ||
+		               !binaryToPasteData(payload, 0, pasteData))
+			           throw std::runtime_error("clipboard text has no valid binary payload");
+
+		           sink = pasteData.notes.size();
+	           });
+}
+
+/// Times iteration, lookup and copying of the note container against std::unordered_map.
+/// The IDs are spread over the whole int range like the hashed ones from Note::getNextID,
+/// and every eighth note is erased so iteration has to skip free slots like in an edited chart.
+/// Lookups are at() calls on the live IDs in random order.
+template <typename Map>
+static void runContainerBenchmarks(BenchmarkRunner& runner, const std::string& prefix)
+{
+	using NoteID = MikuMikuWorld::id_t;
+	for (int count : { 1000, 10000, 100000 })
+	{
+		std::mt19937 random(static_cast<uint32_t>(count));
+		Map notes;
+		std::vector<NoteID> ids;
+		while (ids.size() < static_cast<size_t>(count))
+		{
+			Note note(NoteType::Tap);
+			note.ID = static_cast<NoteID>(random());
+			note.tick = static_cast<int>(ids.size()) * 10;
+			if (notes.count(note.ID))
+				continue;
+
+			notes[note.ID] = note;
+			ids.push_back(note.ID);
+		}
+
+		for (size_t i = 0; i < ids.size(); i += 8)
+			notes.erase(ids[i]);
+
+		std::vector<NoteID> lookups;
+		for (size_t i = 0; i < ids.size(); ++i)
+		{
+			if (i % 8 != 0)
+				lookups.push_back(ids[i]);
+		}
+		std::shuffle(lookups.begin(), lookups.end(), random);
+
+		const std::string suffix = "." + std::to_string(count / 1000) + "k";
+		runner.run(prefix + ".iterate" + suffix,
+		           [&]
+		           {
+			           size_t total = 0;
+			           for (const auto& [id, note] : notes)
+				           total += note.tick;
+			           sink = total;
+		           });
+
+		runner.run(prefix + ".lookup" + suffix,
+		           [&]
+		           {
+			           size_t total = 0;
+			           for (NoteID id : lookups)
+				           total += notes.at(id).tick;
+			           sink = total;
+		           });
+
+		Map copy;
+		runner.run(prefix + ".copy" + suffix,
+		           [&]
+		           {
+			           copy = notes;
+			           sink = copy.size();
+		           });
+	}
+}
+
+int main(int argc, char** argv)
+{
+	CommandLineOptions options{};
+	if (!parseCommandLine(argc, argv, options))
+	{
+		printUsage(argv[0]);
+		return 2;
+	}
+
+	namespace fs = std::filesystem;
+	const fs::path directory =
+	    fs::temp_directory_path() / ("mmw-bench-" + std::to_string(options.chart.seed));
+	fs::create_directories(directory);
+
+	Score score = generateChart(options.chart);
+	if (options.check)
+	{
+		CheckRunner checks(options.filter);
+		runChecks(checks, score, directory);
+
+		std::error_code error;
+		fs::remove_all(directory, error);
+
+		fprintf(stderr, "\n%d passed, %d failed\n", checks.getPassed(), checks.getFailed());
+		return checks.getFailed() ? 1 : 0;
+	}
+
+	fprintf(stderr, "Chart: %zu notes, %zu holds, %zu tempo changes, %zu hi-speed changes\n\n",
+	        score.notes.size(), score.holdNotes.size(), score.tempoChanges.size(),
+	        score.hiSpeedChanges.size());
+	fprintf(stderr, "%-32s %10s %10s %10s %10s\n", "benchmark (ms)", "min", "median", "mean",
+	        "max");
+
+	// The SUS parser and the other parallel paths time what they take in the editor
+	JobSystem::initialize();
+	BenchmarkRunner runner(options.iterations, options.filter);
+	try
+	{
+		runBenchmarks(runner, options, score, directory);
+		// id_t alone is ambiguous with the POSIX type
+		using NoteID = MikuMikuWorld::id_t;
+		runContainerBenchmarks<SlotMap<NoteID, Note>>(runner, "slotmap");
+		runContainerBenchmarks<std::unordered_map<NoteID, Note>>(runner, "unordered_map");
+	}
+	catch (const std::exception& error)
+	{
+		fprintf(stderr, "Benchmark failed: %s\n", error.what());
+		JobSystem::shutdown();
+		fs::remove_all(directory);
+		return 1;
+	}
+
+	JobSystem::shutdown();
+
+	std::error_code error;
+	fs::remove_all(directory, error);
+
+	json results = json::array();
+	for (const BenchmarkResult& result : runner.getResults())
+	{
+		results.push_back({ { "name", result.name },
+		                    { "iterations", result.iterations },
+		                    { "min_ms", result.minMs },
+		                    { "median_ms", result.medianMs },
+		                    { "mean_ms", result.meanMs },
+		                    { "max_ms", result.maxMs } });
+	}
+
+	json report;
+	report["version"] = 1;
+#ifdef NDEBUG
+	report["build"] = "release";
+#else
+	report["build"] = "debug";
+#endif
+	report["chart"] = chartToJson(options.chart, score);
+	report["results"] = results;
+
+	if (options.outputFilename.empty())
+	{
+		printf("%s\n", report.dump(4).c_str());
+	}
+	else
+	{
+		std::ofstream output(fs::path(IO::mbToWideStr(options.outputFilename)));
+		output << report.dump(4) << std::endl;
+	}
+
+	return 0;
+}
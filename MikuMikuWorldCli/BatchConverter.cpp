@@ -0,0 +1,159 @@
+#include "BatchConverter.h"
+#include "IO.h"
+#include "Stopwatch.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace MikuMikuWorld
+{
+	static std::string pathToString(const fs::path& path)
+	{
+		return IO::wideStringToMb(path.wstring());
+	}
+
+	static std::string outputFilename(const fs::path& input, const fs::path& relativeInput,
+	                                  const std::string& outputDirectory,
+	                                  const std::string& extension)
+	{
+		fs::path output = outputDirectory.empty()
+		                      ? input
+		                      : fs::path(IO::mbToWideStr(outputDirectory)) / relativeInput;
+
+		output.replace_extension(IO::mbToWideStr(extension));
+		return pathToString(output);
+	}
+
+	BatchConverter::BatchConverter(int threadCount, ScoreWriteOptions writeOptions)
+	    : writeOptions{ std::move(writeOptions) }, threadCount{ std::max(threadCount, 1) }
+	{
+	}
+
+	std::vector<BatchJob> BatchConverter::collectJobs(const std::vector<std::string>& inputs,
+	                                                  const std::string& outputDirectory,
+	                                                  const std::string& extension)
+	{
+		std::vector<BatchJob> jobs;
+		auto addJob = [&](const fs::path& input, const fs::path& relativeInput)
+		{
+			std::string output;
+			if (!extension.empty())
+				output = outputFilename(input, relativeInput, outputDirectory, extension);
+
+			jobs.push_back({ pathToString(input), std::move(output) });
+		};
+
+		for (const std::string& input : inputs)
+		{
+			fs::path path(IO::mbToWideStr(input));
+			std::error_code error;
+			if (!fs::is_directory(path, error))
+			{
+				// Missing files are still added so they are reported as failures
+				addJob(path, path.filename());
+				continue;
+			}
+
+			std::vector<fs::path> files;
+			for (auto it = fs::recursive_directory_iterator(path, error);
+			     it != fs::recursive_directory_iterator(); it.increment(error))
+			{
+				if (it->is_regular_file(error) &&
+				    getScoreFileFormat(pathToString(it->path())) != ScoreFileFormat::Unknown)
+					files.push_back(it->path());
+			}
+
+			std::sort(files.begin(), files.end());
+			for (const fs::path& file : files)
+				addJob(file, file.lexically_relative(path));
+		}
+
+		return jobs;
+	}
+
+	BatchResult BatchConverter::process(const BatchJob& job) const
+	{
+		BatchResult result{ job.input, job.output, {}, 0, 0.0, false };
+		Stopwatch stopwatch;
+		try
+		{
+			Score score = readScoreFile(job.input);
+			result.noteCount = score.notes.size();
+
+			if (!job.output.empty())
+			{
+				fs::path input(IO::mbToWideStr(job.input));
+				fs::path output(IO::mbToWideStr(job.output));
+				std::error_code error;
+				if (fs::equivalent(input, output, error))
+					throw std::runtime_error("The output would overwrite the input file.");
+
+				if (output.has_parent_path())
+					fs::create_directories(output.parent_path(), error);
+
+				writeScoreFile(score, job.output, writeOptions);
+				if (!fs::exists(output, error))
+					throw std::runtime_error("Failed to create the output file.");
+			}
+
+			result.succeeded = true;
+		}
+		catch (const std::exception& error)
+		{
+			result.error = error.what();
+		}
+
+		result.seconds = stopwatch.elapsed();
+		return result;
+	}
+
+	std::vector<BatchResult> BatchConverter::run(const std::vector<BatchJob>& jobs,
+	                                             const ResultCallback& onResult) const
+	{
+		// Two inputs differing only by extension would be written to the same file at once
+		std::vector<uint8_t> conflicts(jobs.size());
+		std::unordered_set<std::string> outputs;
+		for (size_t i = 0; i < jobs.size(); ++i)
+			conflicts[i] = !jobs[i].output.empty() && !outputs.insert(jobs[i].output).second;
+
+		std::vector<BatchResult> results(jobs.size());
+		std::atomic<size_t> nextJob{ 0 };
+		std::mutex callbackMutex;
+
+		auto work = [&]()
+		{
+			for (size_t index = nextJob++; index < jobs.size(); index = nextJob++)
+			{
+				if (conflicts[index])
+					results[index] = { jobs[index].input, jobs[index].output,
+						               "Another input is written to the same output file.", 0, 0.0,
+						               false };
+				else
+					results[index] = process(jobs[index]);
+				if (onResult)
+				{
+					std::lock_guard<std::mutex> lock(callbackMutex);
+					onResult(results[index]);
+				}
+			}
+		};
+
+		const size_t workerCount = std::min<size_t>(threadCount, jobs.size());
+		std::vector<std::thread> workers;
+		workers.reserve(workerCount);
+		for (size_t i = 1; i < workerCount; ++i)
+			workers.emplace_back(work);
+
+		// The calling thread takes jobs too instead of waiting idle
+		work();
+		for (std::thread& worker : workers)
+			worker.join();
+
+		return results;
+	}
+}
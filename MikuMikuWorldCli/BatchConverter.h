@@ -0,0 +1,52 @@
+#pragma once
+#include "ScoreFile.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	/// A file to read and, when output is set, write in another format
+	struct BatchJob
+	{
+		std::string input;
+		std::string output;
+	};
+
+	struct BatchResult
+	{
+		std::string input;
+		std::string output;
+		std::string error;
+		size_t noteCount{};
+		double seconds{};
+		bool succeeded{};
+	};
+
+	/// Converts or validates score files on a pool of worker threads
+	class BatchConverter
+	{
+	  private:
+		ScoreWriteOptions writeOptions;
+		int threadCount;
+
+		BatchResult process(const BatchJob& job) const;
+
+	  public:
+		using ResultCallback = std::function<void(const BatchResult&)>;
+
+		BatchConverter(int threadCount, ScoreWriteOptions writeOptions = {});
+
+		/// Expands inputs into one job per score file. Directories are searched recursively.
+		/// Jobs only validate when extension is empty, otherwise their output has that extension
+		/// and is placed in outputDirectory, or next to the input if it is empty.
+		static std::vector<BatchJob> collectJobs(const std::vector<std::string>& inputs,
+		                                         const std::string& outputDirectory,
+		                                         const std::string& extension);
+
+		/// Runs every job and returns the results in the order of jobs. onResult is called from
+		/// the worker threads, one at a time, as soon as each job finishes.
+		std::vector<BatchResult> run(const std::vector<BatchJob>& jobs,
+		                             const ResultCallback& onResult = {}) const;
+	};
+}
@@ -0,0 +1,220 @@
+#include "BatchConverter.h"
+#include "ChartLibrary.h"
+#include "IO.h"
+#include "JobSystem.h"
+#include "Stopwatch.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace MikuMikuWorld;
+
+constexpr const char* susExportComment = "This file was generated by MikuMikuWorld for Chart Cyanvas";
+
+struct CommandLineOptions
+{
+	std::vector<std::string> inputs;
+	std::string outputDirectory;
+	std::string extension;
+	std::string indexFile;
+	int threadCount{};
+	bool minifyUsc{ true };
+	bool quiet{};
+	bool help{};
+};
+
+static void printUsage(const char* program)
+{
+	printf("Usage: %s [options] <files or directories...>\n"
+	       "Converts or validates score files. Directories are searched recursively.\n\n"
+	       "Options:\n"
+	       "  -f, --format <format>  Convert to mmws, ccmmws, sus or usc. Without it the files\n"
+	       "                         are only read to check that they load.\n"
+	       "  -o, --output <dir>     Write converted files here instead of next to the inputs\n"
+	       "  -i, --index <file>     List the charts of a directory in this index file. Entries\n"
+	       "                         of files unchanged since the last run are reused.\n"
+	       "  -j, --jobs <count>     Number of worker threads (default: all cores)\n"
+	       "      --indent-usc       Write indented USC files instead of minified ones\n"
+	       "  -q, --quiet            Only print failures and the summary\n"
+	       "  -h, --help             Show this message\n",
+	       program);
+}
+
+static bool parseCommandLine(const std::vector<std::string>& args, CommandLineOptions& options)
+{
+	for (size_t i = 1; i < args.size(); ++i)
+	{
+		const std::string& arg = args[i];
+		const bool hasValue = i + 1 < args.size();
+
+		if ((arg == "-f" || arg == "--format") && hasValue)
+		{
+			std::string format = args[++i];
+			if (format != "mmws" && format != "ccmmws" && format != "sus" && format != "usc")
+			{
+				fprintf(stderr, "Unknown format: %s\n", format.c_str());
+				return false;
+			}
+
+			options.extension = "." + format;
+		}
+		else if ((arg == "-o" || arg == "--output") && hasValue)
+		{
+			options.outputDirectory = args[++i];
+		}
+		else if ((arg == "-i" || arg == "--index") && hasValue)
+		{
+			options.indexFile = args[++i];
+		}
+		else if ((arg == "-j" || arg == "--jobs") && hasValue)
+		{
+			options.threadCount = atoi(args[++i].c_str());
+		}
+		else if (arg == "--indent-usc")
+		{
+			options.minifyUsc = false;
+		}
+		else if (arg == "-q" || arg == "--quiet")
+		{
+			options.quiet = true;
+		}
+		else if (arg == "-h" || arg == "--help")
+		{
+			options.help = true;
+		}
+		else if (IO::startsWith(arg, "-"))
+		{
+			fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+			return false;
+		}
+		else
+		{
+			options.inputs.push_back(arg);
+		}
+	}
+
+	return options.help || !options.inputs.empty();
+}
+
+static int buildIndex(const CommandLineOptions& options)
+{
+	if (options.inputs.size() != 1)
+	{
+		fprintf(stderr, "--index takes exactly one directory\n");
+		return 2;
+	}
+
+	ChartLibrary library;
+	library.loadIndex(options.indexFile);
+
+	JobSystem::initialize(options.threadCount);
+	Stopwatch stopwatch;
+	library.scan(options.inputs.front());
+	const double totalSeconds = stopwatch.elapsed();
+	JobSystem::shutdown();
+
+	if (!options.quiet)
+	{
+		for (const ChartInfo& chart : library.getCharts())
+		{
+			const ScoreMetadata& metadata = chart.summary.metadata;
+			printf("%s: %s / %s", chart.filename.c_str(), metadata.title.c_str(),
+			       metadata.artist.c_str());
+			if (chart.hasCounts)
+				printf(" (%d taps, %d holds)", chart.summary.tapCount, chart.summary.holdCount);
+
+			printf("\n");
+		}
+	}
+
+	try
+	{
+		library.saveIndex(options.indexFile);
+	}
+	catch (const std::exception& error)
+	{
+		fprintf(stderr, "%s\n", error.what());
+		return 1;
+	}
+
+	printf("\n%zu charts indexed in %.2f s\n", library.getCharts().size(), totalSeconds);
+	return 0;
+}
+
+static int run(const std::vector<std::string>& args)
+{
+	CommandLineOptions options{};
+	const bool validCommandLine = parseCommandLine(args, options);
+	if (!validCommandLine || options.help)
+	{
+		printUsage(args.empty() ? "mmw-cli" : args[0].c_str());
+		return validCommandLine ? 0 : 2;
+	}
+
+	if (options.threadCount <= 0)
+		options.threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	if (!options.indexFile.empty())
+		return buildIndex(options);
+
+	ScoreWriteOptions writeOptions{};
+	writeOptions.susComment = susExportComment;
+	writeOptions.uscIndent = options.minifyUsc ? -1 : 4;
+
+	std::vector<BatchJob> jobs =
+	    BatchConverter::collectJobs(options.inputs, options.outputDirectory, options.extension);
+
+	Stopwatch stopwatch;
+	BatchConverter converter(options.threadCount, writeOptions);
+	std::vector<BatchResult> results = converter.run(
+	    jobs,
+	    [&](const BatchResult& result)
+	    {
+		    if (!result.succeeded)
+			    fprintf(stderr, "FAIL %9.2f ms  %s: %s\n", result.seconds * 1000,
+			            result.input.c_str(), result.error.c_str());
+		    else if (!options.quiet)
+			    printf("ok   %9.2f ms  %s (%zu notes)%s%s\n", result.seconds * 1000,
+			           result.input.c_str(), result.noteCount, result.output.empty() ? "" : " -> ",
+			           result.output.c_str());
+	    });
+	const double totalSeconds = stopwatch.elapsed();
+
+	size_t failedCount = 0;
+	double fileSeconds = 0;
+	const BatchResult* slowest = nullptr;
+	for (const BatchResult& result : results)
+	{
+		failedCount += !result.succeeded;
+		fileSeconds += result.seconds;
+		if (!slowest || result.seconds > slowest->seconds)
+			slowest = &result;
+	}
+
+	printf("\n%zu files, %zu succeeded, %zu failed in %.2f s with %d worker thread%s "
+	       "(%.2f s of file work)\n",
+	       results.size(), results.size() - failedCount, failedCount, totalSeconds,
+	       options.threadCount, options.threadCount == 1 ? "" : "s", fileSeconds);
+	if (slowest)
+		printf("Slowest: %s (%.2f ms)\n", slowest->input.c_str(), slowest->seconds * 1000);
+
+	return failedCount ? 1 : 0;
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv)
+{
+	// Convert the UTF-16 command line so non-ASCII paths survive
+	std::vector<std::string> args;
+	for (int i = 0; i < argc; ++i)
+		args.push_back(IO::wideStringToMb(argv[i]));
+
+	return run(args);
+}
+#else
+int main(int argc, char** argv) { return run(std::vector<std::string>(argv, argv + argc)); }
+#endif